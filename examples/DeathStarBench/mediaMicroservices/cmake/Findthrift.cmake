@@ -54,6 +54,9 @@ find_path(THRIFT_STATIC_LIB_PATH libthrift.a PATHS ${THRIFT_LIB_PATHS})
 
 # prefer the thrift version supplied in THRIFT_HOME
 find_library(THRIFT_LIB NAMES thrift HINTS ${THRIFT_LIB_PATHS})
+# TNonblockingServer lives in libthriftnb, which is built on libevent
+find_library(THRIFT_NB_LIB NAMES thriftnb HINTS ${THRIFT_LIB_PATHS})
+find_library(LIBEVENT_LIB NAMES event)
 
 find_program(THRIFT_COMPILER thrift
     ${THRIFT_ROOT}/bin
@@ -65,6 +68,7 @@ find_program(THRIFT_COMPILER thrift
 
 if (THRIFT_LIB)
   set(THRIFT_LIBS ${THRIFT_LIB})
+  set(THRIFT_SERVER_LIBS ${THRIFT_NB_LIB} ${THRIFT_LIB} ${LIBEVENT_LIB})
   set(THRIFT_STATIC_LIB ${THRIFT_STATIC_LIB_PATH}/libthrift.a)
   exec_program(${THRIFT_COMPILER}
       ARGS -version OUTPUT_VARIABLE THRIFT_VERSION RETURN_VALUE THRIFT_RETURN)
@@ -86,6 +90,8 @@ endif ()
 
 mark_as_advanced(
     THRIFT_LIB
+    THRIFT_NB_LIB
+    LIBEVENT_LIB
     THRIFT_COMPILER
     THRIFT_INCLUDE_DIR
     thriftstatic
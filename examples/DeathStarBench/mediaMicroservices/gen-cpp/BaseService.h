@@ -0,0 +1,265 @@
+/**
+ * Autogenerated by Thrift Compiler (0.12.0)
+ *
+ * DO NOT EDIT UNLESS YOU ARE SURE THAT YOU KNOW WHAT YOU ARE DOING
+ *  @generated
+ */
+#ifndef BaseService_H
+#define BaseService_H
+
+#include <thrift/TDispatchProcessor.h>
+#include <thrift/async/TConcurrentClientSyncInfo.h>
+#include "media_service_types.h"
+
+namespace media_service {
+
+#ifdef _MSC_VER
+  #pragma warning( push )
+  #pragma warning (disable : 4250 ) //inheriting methods via dominance 
+#endif
+
+class BaseServiceIf {
+ public:
+  virtual ~BaseServiceIf() {}
+  virtual void Ping() = 0;
+};
+
+class BaseServiceIfFactory {
+ public:
+  typedef BaseServiceIf Handler;
+
+  virtual ~BaseServiceIfFactory() {}
+
+  virtual BaseServiceIf* getHandler(const ::apache::thrift::TConnectionInfo& connInfo) = 0;
+  virtual void releaseHandler(BaseServiceIf* /* handler */) = 0;
+};
+
+class BaseServiceIfSingletonFactory : virtual public BaseServiceIfFactory {
+ public:
+  BaseServiceIfSingletonFactory(const ::apache::thrift::stdcxx::shared_ptr<BaseServiceIf>& iface) : iface_(iface) {}
+  virtual ~BaseServiceIfSingletonFactory() {}
+
+  virtual BaseServiceIf* getHandler(const ::apache::thrift::TConnectionInfo&) {
+    return iface_.get();
+  }
+  virtual void releaseHandler(BaseServiceIf* /* handler */) {}
+
+ protected:
+  ::apache::thrift::stdcxx::shared_ptr<BaseServiceIf> iface_;
+};
+
+class BaseServiceNull : virtual public BaseServiceIf {
+ public:
+  virtual ~BaseServiceNull() {}
+  void Ping() {
+    return;
+  }
+};
+
+
+class BaseService_Ping_args {
+ public:
+
+  BaseService_Ping_args(const BaseService_Ping_args&);
+  BaseService_Ping_args& operator=(const BaseService_Ping_args&);
+  BaseService_Ping_args() {
+  }
+
+  virtual ~BaseService_Ping_args() throw();
+
+  bool operator == (const BaseService_Ping_args & /* rhs */) const
+  {
+    return true;
+  }
+  bool operator != (const BaseService_Ping_args &rhs) const {
+    return !(*this == rhs);
+  }
+
+  bool operator < (const BaseService_Ping_args & ) const;
+
+  uint32_t read(::apache::thrift::protocol::TProtocol* iprot);
+  uint32_t write(::apache::thrift::protocol::TProtocol* oprot) const;
+
+};
+
+
+class BaseService_Ping_pargs {
+ public:
+
+
+  virtual ~BaseService_Ping_pargs() throw();
+
+  uint32_t write(::apache::thrift::protocol::TProtocol* oprot) const;
+
+};
+
+
+class BaseService_Ping_result {
+ public:
+
+  BaseService_Ping_result(const BaseService_Ping_result&);
+  BaseService_Ping_result& operator=(const BaseService_Ping_result&);
+  BaseService_Ping_result() {
+  }
+
+  virtual ~BaseService_Ping_result() throw();
+
+  bool operator == (const BaseService_Ping_result & /* rhs */) const
+  {
+    return true;
+  }
+  bool operator != (const BaseService_Ping_result &rhs) const {
+    return !(*this == rhs);
+  }
+
+  bool operator < (const BaseService_Ping_result & ) const;
+
+  uint32_t read(::apache::thrift::protocol::TProtocol* iprot);
+  uint32_t write(::apache::thrift::protocol::TProtocol* oprot) const;
+
+};
+
+
+class BaseService_Ping_presult {
+ public:
+
+
+  virtual ~BaseService_Ping_presult() throw();
+
+  uint32_t read(::apache::thrift::protocol::TProtocol* iprot);
+
+};
+
+class BaseServiceClient : virtual public BaseServiceIf {
+ public:
+  BaseServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
+    setProtocol(prot);
+  }
+  BaseServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
+    setProtocol(iprot,oprot);
+  }
+ private:
+  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
+  setProtocol(prot,prot);
+  }
+  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
+    piprot_=iprot;
+    poprot_=oprot;
+    iprot_ = iprot.get();
+    oprot_ = oprot.get();
+  }
+ public:
+  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getInputProtocol() {
+    return piprot_;
+  }
+  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getOutputProtocol() {
+    return poprot_;
+  }
+  void Ping();
+  void send_Ping();
+  void recv_Ping();
+ protected:
+  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> piprot_;
+  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> poprot_;
+  ::apache::thrift::protocol::TProtocol* iprot_;
+  ::apache::thrift::protocol::TProtocol* oprot_;
+};
+
+class BaseServiceProcessor : public ::apache::thrift::TDispatchProcessor {
+ protected:
+  ::apache::thrift::stdcxx::shared_ptr<BaseServiceIf> iface_;
+  virtual bool dispatchCall(::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, const std::string& fname, int32_t seqid, void* callContext);
+ private:
+  typedef  void (BaseServiceProcessor::*ProcessFunction)(int32_t, ::apache::thrift::protocol::TProtocol*, ::apache::thrift::protocol::TProtocol*, void*);
+  typedef std::map<std::string, ProcessFunction> ProcessMap;
+  ProcessMap processMap_;
+  void process_Ping(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext);
+ public:
+  BaseServiceProcessor(::apache::thrift::stdcxx::shared_ptr<BaseServiceIf> iface) :
+    iface_(iface) {
+    processMap_["Ping"] = &BaseServiceProcessor::process_Ping;
+  }
+
+  virtual ~BaseServiceProcessor() {}
+};
+
+class BaseServiceProcessorFactory : public ::apache::thrift::TProcessorFactory {
+ public:
+  BaseServiceProcessorFactory(const ::apache::thrift::stdcxx::shared_ptr< BaseServiceIfFactory >& handlerFactory) :
+      handlerFactory_(handlerFactory) {}
+
+  ::apache::thrift::stdcxx::shared_ptr< ::apache::thrift::TProcessor > getProcessor(const ::apache::thrift::TConnectionInfo& connInfo);
+
+ protected:
+  ::apache::thrift::stdcxx::shared_ptr< BaseServiceIfFactory > handlerFactory_;
+};
+
+class BaseServiceMultiface : virtual public BaseServiceIf {
+ public:
+  BaseServiceMultiface(std::vector<apache::thrift::stdcxx::shared_ptr<BaseServiceIf> >& ifaces) : ifaces_(ifaces) {
+  }
+  virtual ~BaseServiceMultiface() {}
+ protected:
+  std::vector<apache::thrift::stdcxx::shared_ptr<BaseServiceIf> > ifaces_;
+  BaseServiceMultiface() {}
+  void add(::apache::thrift::stdcxx::shared_ptr<BaseServiceIf> iface) {
+    ifaces_.push_back(iface);
+  }
+ public:
+  void Ping() {
+    size_t sz = ifaces_.size();
+    size_t i = 0;
+    for (; i < (sz - 1); ++i) {
+      ifaces_[i]->Ping();
+    }
+    ifaces_[i]->Ping();
+  }
+
+};
+
+// The 'concurrent' client is a thread safe client that correctly handles
+// out of order responses.  It is slower than the regular client, so should
+// only be used when you need to share a connection among multiple threads
+class BaseServiceConcurrentClient : virtual public BaseServiceIf {
+ public:
+  BaseServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
+    setProtocol(prot);
+  }
+  BaseServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
+    setProtocol(iprot,oprot);
+  }
+ private:
+  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
+  setProtocol(prot,prot);
+  }
+  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
+    piprot_=iprot;
+    poprot_=oprot;
+    iprot_ = iprot.get();
+    oprot_ = oprot.get();
+  }
+ public:
+  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getInputProtocol() {
+    return piprot_;
+  }
+  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getOutputProtocol() {
+    return poprot_;
+  }
+  void Ping();
+  int32_t send_Ping();
+  void recv_Ping(const int32_t seqid);
+ protected:
+  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> piprot_;
+  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> poprot_;
+  ::apache::thrift::protocol::TProtocol* iprot_;
+  ::apache::thrift::protocol::TProtocol* oprot_;
+  ::apache::thrift::async::TConcurrentClientSyncInfo sync_;
+};
+
+#ifdef _MSC_VER
+  #pragma warning( pop )
+#endif
+
+} // namespace
+
+#endif
@@ -10,6 +10,7 @@
 #include <thrift/TDispatchProcessor.h>
 #include <thrift/async/TConcurrentClientSyncInfo.h>
 #include "media_service_types.h"
+#include "BaseService.h"
 
 namespace media_service {
 
@@ -18,21 +19,21 @@ namespace media_service {
   #pragma warning (disable : 4250 ) //inheriting methods via dominance 
 #endif
 
-class CastInfoServiceIf {
+class CastInfoServiceIf : virtual public BaseServiceIf {
  public:
   virtual ~CastInfoServiceIf() {}
   virtual void WriteCastInfo(const int64_t req_id, const int64_t cast_info_id, const std::string& name, const bool gender, const std::string& intro, const std::map<std::string, std::string> & carrier) = 0;
   virtual void ReadCastInfo(std::vector<CastInfo> & _return, const int64_t req_id, const std::vector<int64_t> & cast_ids, const std::map<std::string, std::string> & carrier) = 0;
 };
 
-class CastInfoServiceIfFactory {
+class CastInfoServiceIfFactory : virtual public BaseServiceIfFactory {
  public:
   typedef CastInfoServiceIf Handler;
 
   virtual ~CastInfoServiceIfFactory() {}
 
   virtual CastInfoServiceIf* getHandler(const ::apache::thrift::TConnectionInfo& connInfo) = 0;
-  virtual void releaseHandler(CastInfoServiceIf* /* handler */) = 0;
+  virtual void releaseHandler(BaseServiceIf* /* handler */) = 0;
 };
 
 class CastInfoServiceIfSingletonFactory : virtual public CastInfoServiceIfFactory {
@@ -43,13 +44,13 @@ class CastInfoServiceIfSingletonFactory : virtual public CastInfoServiceIfFactor
   virtual CastInfoServiceIf* getHandler(const ::apache::thrift::TConnectionInfo&) {
     return iface_.get();
   }
-  virtual void releaseHandler(CastInfoServiceIf* /* handler */) {}
+  virtual void releaseHandler(BaseServiceIf* /* handler */) {}
 
  protected:
   ::apache::thrift::stdcxx::shared_ptr<CastInfoServiceIf> iface_;
 };
 
-class CastInfoServiceNull : virtual public CastInfoServiceIf {
+class CastInfoServiceNull : virtual public CastInfoServiceIf , virtual public BaseServiceNull {
  public:
   virtual ~CastInfoServiceNull() {}
   void WriteCastInfo(const int64_t /* req_id */, const int64_t /* cast_info_id */, const std::string& /* name */, const bool /* gender */, const std::string& /* intro */, const std::map<std::string, std::string> & /* carrier */) {
@@ -325,45 +326,20 @@ class CastInfoService_ReadCastInfo_presult {
 
 };
 
-class CastInfoServiceClient : virtual public CastInfoServiceIf {
+class CastInfoServiceClient : virtual public CastInfoServiceIf, public BaseServiceClient {
  public:
-  CastInfoServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-    setProtocol(prot);
-  }
-  CastInfoServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    setProtocol(iprot,oprot);
-  }
- private:
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-  setProtocol(prot,prot);
-  }
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    piprot_=iprot;
-    poprot_=oprot;
-    iprot_ = iprot.get();
-    oprot_ = oprot.get();
-  }
- public:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getInputProtocol() {
-    return piprot_;
-  }
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getOutputProtocol() {
-    return poprot_;
-  }
+  CastInfoServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) :
+    BaseServiceClient(prot, prot) {}
+  CastInfoServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) :    BaseServiceClient(iprot, oprot) {}
   void WriteCastInfo(const int64_t req_id, const int64_t cast_info_id, const std::string& name, const bool gender, const std::string& intro, const std::map<std::string, std::string> & carrier);
   void send_WriteCastInfo(const int64_t req_id, const int64_t cast_info_id, const std::string& name, const bool gender, const std::string& intro, const std::map<std::string, std::string> & carrier);
   void recv_WriteCastInfo();
   void ReadCastInfo(std::vector<CastInfo> & _return, const int64_t req_id, const std::vector<int64_t> & cast_ids, const std::map<std::string, std::string> & carrier);
   void send_ReadCastInfo(const int64_t req_id, const std::vector<int64_t> & cast_ids, const std::map<std::string, std::string> & carrier);
   void recv_ReadCastInfo(std::vector<CastInfo> & _return);
- protected:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> piprot_;
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> poprot_;
-  ::apache::thrift::protocol::TProtocol* iprot_;
-  ::apache::thrift::protocol::TProtocol* oprot_;
 };
 
-class CastInfoServiceProcessor : public ::apache::thrift::TDispatchProcessor {
+class CastInfoServiceProcessor : public BaseServiceProcessor {
  protected:
   ::apache::thrift::stdcxx::shared_ptr<CastInfoServiceIf> iface_;
   virtual bool dispatchCall(::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, const std::string& fname, int32_t seqid, void* callContext);
@@ -375,6 +351,7 @@ class CastInfoServiceProcessor : public ::apache::thrift::TDispatchProcessor {
   void process_ReadCastInfo(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext);
  public:
   CastInfoServiceProcessor(::apache::thrift::stdcxx::shared_ptr<CastInfoServiceIf> iface) :
+    BaseServiceProcessor(iface),
     iface_(iface) {
     processMap_["WriteCastInfo"] = &CastInfoServiceProcessor::process_WriteCastInfo;
     processMap_["ReadCastInfo"] = &CastInfoServiceProcessor::process_ReadCastInfo;
@@ -394,9 +371,13 @@ class CastInfoServiceProcessorFactory : public ::apache::thrift::TProcessorFacto
   ::apache::thrift::stdcxx::shared_ptr< CastInfoServiceIfFactory > handlerFactory_;
 };
 
-class CastInfoServiceMultiface : virtual public CastInfoServiceIf {
+class CastInfoServiceMultiface : virtual public CastInfoServiceIf, public BaseServiceMultiface {
  public:
   CastInfoServiceMultiface(std::vector<apache::thrift::stdcxx::shared_ptr<CastInfoServiceIf> >& ifaces) : ifaces_(ifaces) {
+    std::vector<apache::thrift::stdcxx::shared_ptr<CastInfoServiceIf> >::iterator iter;
+    for (iter = ifaces.begin(); iter != ifaces.end(); ++iter) {
+      BaseServiceMultiface::add(*iter);
+    }
   }
   virtual ~CastInfoServiceMultiface() {}
  protected:
@@ -430,43 +411,17 @@ class CastInfoServiceMultiface : virtual public CastInfoServiceIf {
 // The 'concurrent' client is a thread safe client that correctly handles
 // out of order responses.  It is slower than the regular client, so should
 // only be used when you need to share a connection among multiple threads
-class CastInfoServiceConcurrentClient : virtual public CastInfoServiceIf {
+class CastInfoServiceConcurrentClient : virtual public CastInfoServiceIf, public BaseServiceConcurrentClient {
  public:
-  CastInfoServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-    setProtocol(prot);
-  }
-  CastInfoServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    setProtocol(iprot,oprot);
-  }
- private:
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-  setProtocol(prot,prot);
-  }
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    piprot_=iprot;
-    poprot_=oprot;
-    iprot_ = iprot.get();
-    oprot_ = oprot.get();
-  }
- public:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getInputProtocol() {
-    return piprot_;
-  }
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getOutputProtocol() {
-    return poprot_;
-  }
+  CastInfoServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) :
+    BaseServiceConcurrentClient(prot, prot) {}
+  CastInfoServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) :    BaseServiceConcurrentClient(iprot, oprot) {}
   void WriteCastInfo(const int64_t req_id, const int64_t cast_info_id, const std::string& name, const bool gender, const std::string& intro, const std::map<std::string, std::string> & carrier);
   int32_t send_WriteCastInfo(const int64_t req_id, const int64_t cast_info_id, const std::string& name, const bool gender, const std::string& intro, const std::map<std::string, std::string> & carrier);
   void recv_WriteCastInfo(const int32_t seqid);
   void ReadCastInfo(std::vector<CastInfo> & _return, const int64_t req_id, const std::vector<int64_t> & cast_ids, const std::map<std::string, std::string> & carrier);
   int32_t send_ReadCastInfo(const int64_t req_id, const std::vector<int64_t> & cast_ids, const std::map<std::string, std::string> & carrier);
   void recv_ReadCastInfo(std::vector<CastInfo> & _return, const int32_t seqid);
- protected:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> piprot_;
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> poprot_;
-  ::apache::thrift::protocol::TProtocol* iprot_;
-  ::apache::thrift::protocol::TProtocol* oprot_;
-  ::apache::thrift::async::TConcurrentClientSyncInfo sync_;
 };
 
 #ifdef _MSC_VER
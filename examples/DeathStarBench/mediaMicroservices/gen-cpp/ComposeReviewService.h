@@ -10,6 +10,7 @@
 #include <thrift/TDispatchProcessor.h>
 #include <thrift/async/TConcurrentClientSyncInfo.h>
 #include "media_service_types.h"
+#include "BaseService.h"
 
 namespace media_service {
 
@@ -18,7 +19,7 @@ namespace media_service {
   #pragma warning (disable : 4250 ) //inheriting methods via dominance 
 #endif
 
-class ComposeReviewServiceIf {
+class ComposeReviewServiceIf : virtual public BaseServiceIf {
  public:
   virtual ~ComposeReviewServiceIf() {}
   virtual void UploadText(const int64_t req_id, const std::string& text, const std::map<std::string, std::string> & carrier) = 0;
@@ -28,14 +29,14 @@ class ComposeReviewServiceIf {
   virtual void UploadUserId(const int64_t req_id, const int64_t user_id, const std::map<std::string, std::string> & carrier) = 0;
 };
 
-class ComposeReviewServiceIfFactory {
+class ComposeReviewServiceIfFactory : virtual public BaseServiceIfFactory {
  public:
   typedef ComposeReviewServiceIf Handler;
 
   virtual ~ComposeReviewServiceIfFactory() {}
 
   virtual ComposeReviewServiceIf* getHandler(const ::apache::thrift::TConnectionInfo& connInfo) = 0;
-  virtual void releaseHandler(ComposeReviewServiceIf* /* handler */) = 0;
+  virtual void releaseHandler(BaseServiceIf* /* handler */) = 0;
 };
 
 class ComposeReviewServiceIfSingletonFactory : virtual public ComposeReviewServiceIfFactory {
@@ -46,13 +47,13 @@ class ComposeReviewServiceIfSingletonFactory : virtual public ComposeReviewServi
   virtual ComposeReviewServiceIf* getHandler(const ::apache::thrift::TConnectionInfo&) {
     return iface_.get();
   }
-  virtual void releaseHandler(ComposeReviewServiceIf* /* handler */) {}
+  virtual void releaseHandler(BaseServiceIf* /* handler */) {}
 
  protected:
   ::apache::thrift::stdcxx::shared_ptr<ComposeReviewServiceIf> iface_;
 };
 
-class ComposeReviewServiceNull : virtual public ComposeReviewServiceIf {
+class ComposeReviewServiceNull : virtual public ComposeReviewServiceIf , virtual public BaseServiceNull {
  public:
   virtual ~ComposeReviewServiceNull() {}
   void UploadText(const int64_t /* req_id */, const std::string& /* text */, const std::map<std::string, std::string> & /* carrier */) {
@@ -662,31 +663,11 @@ class ComposeReviewService_UploadUserId_presult {
 
 };
 
-class ComposeReviewServiceClient : virtual public ComposeReviewServiceIf {
+class ComposeReviewServiceClient : virtual public ComposeReviewServiceIf, public BaseServiceClient {
  public:
-  ComposeReviewServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-    setProtocol(prot);
-  }
-  ComposeReviewServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    setProtocol(iprot,oprot);
-  }
- private:
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-  setProtocol(prot,prot);
-  }
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    piprot_=iprot;
-    poprot_=oprot;
-    iprot_ = iprot.get();
-    oprot_ = oprot.get();
-  }
- public:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getInputProtocol() {
-    return piprot_;
-  }
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getOutputProtocol() {
-    return poprot_;
-  }
+  ComposeReviewServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) :
+    BaseServiceClient(prot, prot) {}
+  ComposeReviewServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) :    BaseServiceClient(iprot, oprot) {}
   void UploadText(const int64_t req_id, const std::string& text, const std::map<std::string, std::string> & carrier);
   void send_UploadText(const int64_t req_id, const std::string& text, const std::map<std::string, std::string> & carrier);
   void recv_UploadText();
@@ -702,14 +683,9 @@ class ComposeReviewServiceClient : virtual public ComposeReviewServiceIf {
   void UploadUserId(const int64_t req_id, const int64_t user_id, const std::map<std::string, std::string> & carrier);
   void send_UploadUserId(const int64_t req_id, const int64_t user_id, const std::map<std::string, std::string> & carrier);
   void recv_UploadUserId();
- protected:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> piprot_;
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> poprot_;
-  ::apache::thrift::protocol::TProtocol* iprot_;
-  ::apache::thrift::protocol::TProtocol* oprot_;
 };
 
-class ComposeReviewServiceProcessor : public ::apache::thrift::TDispatchProcessor {
+class ComposeReviewServiceProcessor : public BaseServiceProcessor {
  protected:
   ::apache::thrift::stdcxx::shared_ptr<ComposeReviewServiceIf> iface_;
   virtual bool dispatchCall(::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, const std::string& fname, int32_t seqid, void* callContext);
@@ -724,6 +700,7 @@ class ComposeReviewServiceProcessor : public ::apache::thrift::TDispatchProcesso
   void process_UploadUserId(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext);
  public:
   ComposeReviewServiceProcessor(::apache::thrift::stdcxx::shared_ptr<ComposeReviewServiceIf> iface) :
+    BaseServiceProcessor(iface),
     iface_(iface) {
     processMap_["UploadText"] = &ComposeReviewServiceProcessor::process_UploadText;
     processMap_["UploadRating"] = &ComposeReviewServiceProcessor::process_UploadRating;
@@ -746,9 +723,13 @@ class ComposeReviewServiceProcessorFactory : public ::apache::thrift::TProcessor
   ::apache::thrift::stdcxx::shared_ptr< ComposeReviewServiceIfFactory > handlerFactory_;
 };
 
-class ComposeReviewServiceMultiface : virtual public ComposeReviewServiceIf {
+class ComposeReviewServiceMultiface : virtual public ComposeReviewServiceIf, public BaseServiceMultiface {
  public:
   ComposeReviewServiceMultiface(std::vector<apache::thrift::stdcxx::shared_ptr<ComposeReviewServiceIf> >& ifaces) : ifaces_(ifaces) {
+    std::vector<apache::thrift::stdcxx::shared_ptr<ComposeReviewServiceIf> >::iterator iter;
+    for (iter = ifaces.begin(); iter != ifaces.end(); ++iter) {
+      BaseServiceMultiface::add(*iter);
+    }
   }
   virtual ~ComposeReviewServiceMultiface() {}
  protected:
@@ -808,31 +789,11 @@ class ComposeReviewServiceMultiface : virtual public ComposeReviewServiceIf {
 // The 'concurrent' client is a thread safe client that correctly handles
 // out of order responses.  It is slower than the regular client, so should
 // only be used when you need to share a connection among multiple threads
-class ComposeReviewServiceConcurrentClient : virtual public ComposeReviewServiceIf {
+class ComposeReviewServiceConcurrentClient : virtual public ComposeReviewServiceIf, public BaseServiceConcurrentClient {
  public:
-  ComposeReviewServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-    setProtocol(prot);
-  }
-  ComposeReviewServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    setProtocol(iprot,oprot);
-  }
- private:
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-  setProtocol(prot,prot);
-  }
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    piprot_=iprot;
-    poprot_=oprot;
-    iprot_ = iprot.get();
-    oprot_ = oprot.get();
-  }
- public:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getInputProtocol() {
-    return piprot_;
-  }
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getOutputProtocol() {
-    return poprot_;
-  }
+  ComposeReviewServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) :
+    BaseServiceConcurrentClient(prot, prot) {}
+  ComposeReviewServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) :    BaseServiceConcurrentClient(iprot, oprot) {}
   void UploadText(const int64_t req_id, const std::string& text, const std::map<std::string, std::string> & carrier);
   int32_t send_UploadText(const int64_t req_id, const std::string& text, const std::map<std::string, std::string> & carrier);
   void recv_UploadText(const int32_t seqid);
@@ -848,12 +809,6 @@ class ComposeReviewServiceConcurrentClient : virtual public ComposeReviewService
   void UploadUserId(const int64_t req_id, const int64_t user_id, const std::map<std::string, std::string> & carrier);
   int32_t send_UploadUserId(const int64_t req_id, const int64_t user_id, const std::map<std::string, std::string> & carrier);
   void recv_UploadUserId(const int32_t seqid);
- protected:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> piprot_;
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> poprot_;
-  ::apache::thrift::protocol::TProtocol* iprot_;
-  ::apache::thrift::protocol::TProtocol* oprot_;
-  ::apache::thrift::async::TConcurrentClientSyncInfo sync_;
 };
 
 #ifdef _MSC_VER
@@ -10,6 +10,7 @@
 #include <thrift/TDispatchProcessor.h>
 #include <thrift/async/TConcurrentClientSyncInfo.h>
 #include "media_service_types.h"
+#include "BaseService.h"
 
 namespace media_service {
 
@@ -18,21 +19,21 @@ namespace media_service {
   #pragma warning (disable : 4250 ) //inheriting methods via dominance 
 #endif
 
-class MovieIdServiceIf {
+class MovieIdServiceIf : virtual public BaseServiceIf {
  public:
   virtual ~MovieIdServiceIf() {}
   virtual void UploadMovieId(const int64_t req_id, const std::string& title, const int32_t rating, const std::map<std::string, std::string> & carrier) = 0;
   virtual void RegisterMovieId(const int64_t req_id, const std::string& title, const std::string& movie_id, const std::map<std::string, std::string> & carrier) = 0;
 };
 
-class MovieIdServiceIfFactory {
+class MovieIdServiceIfFactory : virtual public BaseServiceIfFactory {
  public:
   typedef MovieIdServiceIf Handler;
 
   virtual ~MovieIdServiceIfFactory() {}
 
   virtual MovieIdServiceIf* getHandler(const ::apache::thrift::TConnectionInfo& connInfo) = 0;
-  virtual void releaseHandler(MovieIdServiceIf* /* handler */) = 0;
+  virtual void releaseHandler(BaseServiceIf* /* handler */) = 0;
 };
 
 class MovieIdServiceIfSingletonFactory : virtual public MovieIdServiceIfFactory {
@@ -43,13 +44,13 @@ class MovieIdServiceIfSingletonFactory : virtual public MovieIdServiceIfFactory
   virtual MovieIdServiceIf* getHandler(const ::apache::thrift::TConnectionInfo&) {
     return iface_.get();
   }
-  virtual void releaseHandler(MovieIdServiceIf* /* handler */) {}
+  virtual void releaseHandler(BaseServiceIf* /* handler */) {}
 
  protected:
   ::apache::thrift::stdcxx::shared_ptr<MovieIdServiceIf> iface_;
 };
 
-class MovieIdServiceNull : virtual public MovieIdServiceIf {
+class MovieIdServiceNull : virtual public MovieIdServiceIf , virtual public BaseServiceNull {
  public:
   virtual ~MovieIdServiceNull() {}
   void UploadMovieId(const int64_t /* req_id */, const std::string& /* title */, const int32_t /* rating */, const std::map<std::string, std::string> & /* carrier */) {
@@ -310,45 +311,20 @@ class MovieIdService_RegisterMovieId_presult {
 
 };
 
-class MovieIdServiceClient : virtual public MovieIdServiceIf {
+class MovieIdServiceClient : virtual public MovieIdServiceIf, public BaseServiceClient {
  public:
-  MovieIdServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-    setProtocol(prot);
-  }
-  MovieIdServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    setProtocol(iprot,oprot);
-  }
- private:
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-  setProtocol(prot,prot);
-  }
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    piprot_=iprot;
-    poprot_=oprot;
-    iprot_ = iprot.get();
-    oprot_ = oprot.get();
-  }
- public:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getInputProtocol() {
-    return piprot_;
-  }
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getOutputProtocol() {
-    return poprot_;
-  }
+  MovieIdServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) :
+    BaseServiceClient(prot, prot) {}
+  MovieIdServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) :    BaseServiceClient(iprot, oprot) {}
   void UploadMovieId(const int64_t req_id, const std::string& title, const int32_t rating, const std::map<std::string, std::string> & carrier);
   void send_UploadMovieId(const int64_t req_id, const std::string& title, const int32_t rating, const std::map<std::string, std::string> & carrier);
   void recv_UploadMovieId();
   void RegisterMovieId(const int64_t req_id, const std::string& title, const std::string& movie_id, const std::map<std::string, std::string> & carrier);
   void send_RegisterMovieId(const int64_t req_id, const std::string& title, const std::string& movie_id, const std::map<std::string, std::string> & carrier);
   void recv_RegisterMovieId();
- protected:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> piprot_;
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> poprot_;
-  ::apache::thrift::protocol::TProtocol* iprot_;
-  ::apache::thrift::protocol::TProtocol* oprot_;
 };
 
-class MovieIdServiceProcessor : public ::apache::thrift::TDispatchProcessor {
+class MovieIdServiceProcessor : public BaseServiceProcessor {
  protected:
   ::apache::thrift::stdcxx::shared_ptr<MovieIdServiceIf> iface_;
   virtual bool dispatchCall(::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, const std::string& fname, int32_t seqid, void* callContext);
@@ -360,6 +336,7 @@ class MovieIdServiceProcessor : public ::apache::thrift::TDispatchProcessor {
   void process_RegisterMovieId(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext);
  public:
   MovieIdServiceProcessor(::apache::thrift::stdcxx::shared_ptr<MovieIdServiceIf> iface) :
+    BaseServiceProcessor(iface),
     iface_(iface) {
     processMap_["UploadMovieId"] = &MovieIdServiceProcessor::process_UploadMovieId;
     processMap_["RegisterMovieId"] = &MovieIdServiceProcessor::process_RegisterMovieId;
@@ -379,9 +356,13 @@ class MovieIdServiceProcessorFactory : public ::apache::thrift::TProcessorFactor
   ::apache::thrift::stdcxx::shared_ptr< MovieIdServiceIfFactory > handlerFactory_;
 };
 
-class MovieIdServiceMultiface : virtual public MovieIdServiceIf {
+class MovieIdServiceMultiface : virtual public MovieIdServiceIf, public BaseServiceMultiface {
  public:
   MovieIdServiceMultiface(std::vector<apache::thrift::stdcxx::shared_ptr<MovieIdServiceIf> >& ifaces) : ifaces_(ifaces) {
+    std::vector<apache::thrift::stdcxx::shared_ptr<MovieIdServiceIf> >::iterator iter;
+    for (iter = ifaces.begin(); iter != ifaces.end(); ++iter) {
+      BaseServiceMultiface::add(*iter);
+    }
   }
   virtual ~MovieIdServiceMultiface() {}
  protected:
@@ -414,43 +395,17 @@ class MovieIdServiceMultiface : virtual public MovieIdServiceIf {
 // The 'concurrent' client is a thread safe client that correctly handles
 // out of order responses.  It is slower than the regular client, so should
 // only be used when you need to share a connection among multiple threads
-class MovieIdServiceConcurrentClient : virtual public MovieIdServiceIf {
+class MovieIdServiceConcurrentClient : virtual public MovieIdServiceIf, public BaseServiceConcurrentClient {
  public:
-  MovieIdServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-    setProtocol(prot);
-  }
-  MovieIdServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    setProtocol(iprot,oprot);
-  }
- private:
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-  setProtocol(prot,prot);
-  }
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    piprot_=iprot;
-    poprot_=oprot;
-    iprot_ = iprot.get();
-    oprot_ = oprot.get();
-  }
- public:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getInputProtocol() {
-    return piprot_;
-  }
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getOutputProtocol() {
-    return poprot_;
-  }
+  MovieIdServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) :
+    BaseServiceConcurrentClient(prot, prot) {}
+  MovieIdServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) :    BaseServiceConcurrentClient(iprot, oprot) {}
   void UploadMovieId(const int64_t req_id, const std::string& title, const int32_t rating, const std::map<std::string, std::string> & carrier);
   int32_t send_UploadMovieId(const int64_t req_id, const std::string& title, const int32_t rating, const std::map<std::string, std::string> & carrier);
   void recv_UploadMovieId(const int32_t seqid);
   void RegisterMovieId(const int64_t req_id, const std::string& title, const std::string& movie_id, const std::map<std::string, std::string> & carrier);
   int32_t send_RegisterMovieId(const int64_t req_id, const std::string& title, const std::string& movie_id, const std::map<std::string, std::string> & carrier);
   void recv_RegisterMovieId(const int32_t seqid);
- protected:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> piprot_;
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> poprot_;
-  ::apache::thrift::protocol::TProtocol* iprot_;
-  ::apache::thrift::protocol::TProtocol* oprot_;
-  ::apache::thrift::async::TConcurrentClientSyncInfo sync_;
 };
 
 #ifdef _MSC_VER
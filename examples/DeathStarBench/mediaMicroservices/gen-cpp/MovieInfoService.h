@@ -10,6 +10,7 @@
 #include <thrift/TDispatchProcessor.h>
 #include <thrift/async/TConcurrentClientSyncInfo.h>
 #include "media_service_types.h"
+#include "BaseService.h"
 
 namespace media_service {
 
@@ -18,7 +19,7 @@ namespace media_service {
   #pragma warning (disable : 4250 ) //inheriting methods via dominance 
 #endif
 
-class MovieInfoServiceIf {
+class MovieInfoServiceIf : virtual public BaseServiceIf {
  public:
   virtual ~MovieInfoServiceIf() {}
   virtual void WriteMovieInfo(const int64_t req_id, const std::string& movie_id, const std::string& title, const std::vector<Cast> & casts, const int64_t plot_id, const std::vector<std::string> & thumbnail_ids, const std::vector<std::string> & photo_ids, const std::vector<std::string> & video_ids, const std::string& avg_rating, const int32_t num_rating, const std::map<std::string, std::string> & carrier) = 0;
@@ -26,14 +27,14 @@ class MovieInfoServiceIf {
   virtual void UpdateRating(const int64_t req_id, const std::string& movie_id, const int32_t sum_uncommitted_rating, const int32_t num_uncommitted_rating, const std::map<std::string, std::string> & carrier) = 0;
 };
 
-class MovieInfoServiceIfFactory {
+class MovieInfoServiceIfFactory : virtual public BaseServiceIfFactory {
  public:
   typedef MovieInfoServiceIf Handler;
 
   virtual ~MovieInfoServiceIfFactory() {}
 
   virtual MovieInfoServiceIf* getHandler(const ::apache::thrift::TConnectionInfo& connInfo) = 0;
-  virtual void releaseHandler(MovieInfoServiceIf* /* handler */) = 0;
+  virtual void releaseHandler(BaseServiceIf* /* handler */) = 0;
 };
 
 class MovieInfoServiceIfSingletonFactory : virtual public MovieInfoServiceIfFactory {
@@ -44,13 +45,13 @@ class MovieInfoServiceIfSingletonFactory : virtual public MovieInfoServiceIfFact
   virtual MovieInfoServiceIf* getHandler(const ::apache::thrift::TConnectionInfo&) {
     return iface_.get();
   }
-  virtual void releaseHandler(MovieInfoServiceIf* /* handler */) {}
+  virtual void releaseHandler(BaseServiceIf* /* handler */) {}
 
  protected:
   ::apache::thrift::stdcxx::shared_ptr<MovieInfoServiceIf> iface_;
 };
 
-class MovieInfoServiceNull : virtual public MovieInfoServiceIf {
+class MovieInfoServiceNull : virtual public MovieInfoServiceIf , virtual public BaseServiceNull {
  public:
   virtual ~MovieInfoServiceNull() {}
   void WriteMovieInfo(const int64_t /* req_id */, const std::string& /* movie_id */, const std::string& /* title */, const std::vector<Cast> & /* casts */, const int64_t /* plot_id */, const std::vector<std::string> & /* thumbnail_ids */, const std::vector<std::string> & /* photo_ids */, const std::vector<std::string> & /* video_ids */, const std::string& /* avg_rating */, const int32_t /* num_rating */, const std::map<std::string, std::string> & /* carrier */) {
@@ -496,31 +497,11 @@ class MovieInfoService_UpdateRating_presult {
 
 };
 
-class MovieInfoServiceClient : virtual public MovieInfoServiceIf {
+class MovieInfoServiceClient : virtual public MovieInfoServiceIf, public BaseServiceClient {
  public:
-  MovieInfoServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-    setProtocol(prot);
-  }
-  MovieInfoServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    setProtocol(iprot,oprot);
-  }
- private:
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-  setProtocol(prot,prot);
-  }
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    piprot_=iprot;
-    poprot_=oprot;
-    iprot_ = iprot.get();
-    oprot_ = oprot.get();
-  }
- public:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getInputProtocol() {
-    return piprot_;
-  }
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getOutputProtocol() {
-    return poprot_;
-  }
+  MovieInfoServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) :
+    BaseServiceClient(prot, prot) {}
+  MovieInfoServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) :    BaseServiceClient(iprot, oprot) {}
   void WriteMovieInfo(const int64_t req_id, const std::string& movie_id, const std::string& title, const std::vector<Cast> & casts, const int64_t plot_id, const std::vector<std::string> & thumbnail_ids, const std::vector<std::string> & photo_ids, const std::vector<std::string> & video_ids, const std::string& avg_rating, const int32_t num_rating, const std::map<std::string, std::string> & carrier);
   void send_WriteMovieInfo(const int64_t req_id, const std::string& movie_id, const std::string& title, const std::vector<Cast> & casts, const int64_t plot_id, const std::vector<std::string> & thumbnail_ids, const std::vector<std::string> & photo_ids, const std::vector<std::string> & video_ids, const std::string& avg_rating, const int32_t num_rating, const std::map<std::string, std::string> & carrier);
   void recv_WriteMovieInfo();
@@ -530,14 +511,9 @@ class MovieInfoServiceClient : virtual public MovieInfoServiceIf {
   void UpdateRating(const int64_t req_id, const std::string& movie_id, const int32_t sum_uncommitted_rating, const int32_t num_uncommitted_rating, const std::map<std::string, std::string> & carrier);
   void send_UpdateRating(const int64_t req_id, const std::string& movie_id, const int32_t sum_uncommitted_rating, const int32_t num_uncommitted_rating, const std::map<std::string, std::string> & carrier);
   void recv_UpdateRating();
- protected:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> piprot_;
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> poprot_;
-  ::apache::thrift::protocol::TProtocol* iprot_;
-  ::apache::thrift::protocol::TProtocol* oprot_;
 };
 
-class MovieInfoServiceProcessor : public ::apache::thrift::TDispatchProcessor {
+class MovieInfoServiceProcessor : public BaseServiceProcessor {
  protected:
   ::apache::thrift::stdcxx::shared_ptr<MovieInfoServiceIf> iface_;
   virtual bool dispatchCall(::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, const std::string& fname, int32_t seqid, void* callContext);
@@ -550,6 +526,7 @@ class MovieInfoServiceProcessor : public ::apache::thrift::TDispatchProcessor {
   void process_UpdateRating(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext);
  public:
   MovieInfoServiceProcessor(::apache::thrift::stdcxx::shared_ptr<MovieInfoServiceIf> iface) :
+    BaseServiceProcessor(iface),
     iface_(iface) {
     processMap_["WriteMovieInfo"] = &MovieInfoServiceProcessor::process_WriteMovieInfo;
     processMap_["ReadMovieInfo"] = &MovieInfoServiceProcessor::process_ReadMovieInfo;
@@ -570,9 +547,13 @@ class MovieInfoServiceProcessorFactory : public ::apache::thrift::TProcessorFact
   ::apache::thrift::stdcxx::shared_ptr< MovieInfoServiceIfFactory > handlerFactory_;
 };
 
-class MovieInfoServiceMultiface : virtual public MovieInfoServiceIf {
+class MovieInfoServiceMultiface : virtual public MovieInfoServiceIf, public BaseServiceMultiface {
  public:
   MovieInfoServiceMultiface(std::vector<apache::thrift::stdcxx::shared_ptr<MovieInfoServiceIf> >& ifaces) : ifaces_(ifaces) {
+    std::vector<apache::thrift::stdcxx::shared_ptr<MovieInfoServiceIf> >::iterator iter;
+    for (iter = ifaces.begin(); iter != ifaces.end(); ++iter) {
+      BaseServiceMultiface::add(*iter);
+    }
   }
   virtual ~MovieInfoServiceMultiface() {}
  protected:
@@ -615,31 +596,11 @@ class MovieInfoServiceMultiface : virtual public MovieInfoServiceIf {
 // The 'concurrent' client is a thread safe client that correctly handles
 // out of order responses.  It is slower than the regular client, so should
 // only be used when you need to share a connection among multiple threads
-class MovieInfoServiceConcurrentClient : virtual public MovieInfoServiceIf {
+class MovieInfoServiceConcurrentClient : virtual public MovieInfoServiceIf, public BaseServiceConcurrentClient {
  public:
-  MovieInfoServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-    setProtocol(prot);
-  }
-  MovieInfoServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    setProtocol(iprot,oprot);
-  }
- private:
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-  setProtocol(prot,prot);
-  }
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    piprot_=iprot;
-    poprot_=oprot;
-    iprot_ = iprot.get();
-    oprot_ = oprot.get();
-  }
- public:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getInputProtocol() {
-    return piprot_;
-  }
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getOutputProtocol() {
-    return poprot_;
-  }
+  MovieInfoServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) :
+    BaseServiceConcurrentClient(prot, prot) {}
+  MovieInfoServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) :    BaseServiceConcurrentClient(iprot, oprot) {}
   void WriteMovieInfo(const int64_t req_id, const std::string& movie_id, const std::string& title, const std::vector<Cast> & casts, const int64_t plot_id, const std::vector<std::string> & thumbnail_ids, const std::vector<std::string> & photo_ids, const std::vector<std::string> & video_ids, const std::string& avg_rating, const int32_t num_rating, const std::map<std::string, std::string> & carrier);
   int32_t send_WriteMovieInfo(const int64_t req_id, const std::string& movie_id, const std::string& title, const std::vector<Cast> & casts, const int64_t plot_id, const std::vector<std::string> & thumbnail_ids, const std::vector<std::string> & photo_ids, const std::vector<std::string> & video_ids, const std::string& avg_rating, const int32_t num_rating, const std::map<std::string, std::string> & carrier);
   void recv_WriteMovieInfo(const int32_t seqid);
@@ -649,12 +610,6 @@ class MovieInfoServiceConcurrentClient : virtual public MovieInfoServiceIf {
   void UpdateRating(const int64_t req_id, const std::string& movie_id, const int32_t sum_uncommitted_rating, const int32_t num_uncommitted_rating, const std::map<std::string, std::string> & carrier);
   int32_t send_UpdateRating(const int64_t req_id, const std::string& movie_id, const int32_t sum_uncommitted_rating, const int32_t num_uncommitted_rating, const std::map<std::string, std::string> & carrier);
   void recv_UpdateRating(const int32_t seqid);
- protected:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> piprot_;
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> poprot_;
-  ::apache::thrift::protocol::TProtocol* iprot_;
-  ::apache::thrift::protocol::TProtocol* oprot_;
-  ::apache::thrift::async::TConcurrentClientSyncInfo sync_;
 };
 
 #ifdef _MSC_VER
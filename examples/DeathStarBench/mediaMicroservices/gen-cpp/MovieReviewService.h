@@ -10,6 +10,7 @@
 #include <thrift/TDispatchProcessor.h>
 #include <thrift/async/TConcurrentClientSyncInfo.h>
 #include "media_service_types.h"
+#include "BaseService.h"
 
 namespace media_service {
 
@@ -18,21 +19,21 @@ namespace media_service {
   #pragma warning (disable : 4250 ) //inheriting methods via dominance 
 #endif
 
-class MovieReviewServiceIf {
+class MovieReviewServiceIf : virtual public BaseServiceIf {
  public:
   virtual ~MovieReviewServiceIf() {}
   virtual void UploadMovieReview(const int64_t req_id, const std::string& movie_id, const int64_t review_id, const int64_t timestamp, const std::map<std::string, std::string> & carrier) = 0;
   virtual void ReadMovieReviews(std::vector<Review> & _return, const int64_t req_id, const std::string& movie_id, const int32_t start, const int32_t stop, const std::map<std::string, std::string> & carrier) = 0;
 };
 
-class MovieReviewServiceIfFactory {
+class MovieReviewServiceIfFactory : virtual public BaseServiceIfFactory {
  public:
   typedef MovieReviewServiceIf Handler;
 
   virtual ~MovieReviewServiceIfFactory() {}
 
   virtual MovieReviewServiceIf* getHandler(const ::apache::thrift::TConnectionInfo& connInfo) = 0;
-  virtual void releaseHandler(MovieReviewServiceIf* /* handler */) = 0;
+  virtual void releaseHandler(BaseServiceIf* /* handler */) = 0;
 };
 
 class MovieReviewServiceIfSingletonFactory : virtual public MovieReviewServiceIfFactory {
@@ -43,13 +44,13 @@ class MovieReviewServiceIfSingletonFactory : virtual public MovieReviewServiceIf
   virtual MovieReviewServiceIf* getHandler(const ::apache::thrift::TConnectionInfo&) {
     return iface_.get();
   }
-  virtual void releaseHandler(MovieReviewServiceIf* /* handler */) {}
+  virtual void releaseHandler(BaseServiceIf* /* handler */) {}
 
  protected:
   ::apache::thrift::stdcxx::shared_ptr<MovieReviewServiceIf> iface_;
 };
 
-class MovieReviewServiceNull : virtual public MovieReviewServiceIf {
+class MovieReviewServiceNull : virtual public MovieReviewServiceIf , virtual public BaseServiceNull {
  public:
   virtual ~MovieReviewServiceNull() {}
   void UploadMovieReview(const int64_t /* req_id */, const std::string& /* movie_id */, const int64_t /* review_id */, const int64_t /* timestamp */, const std::map<std::string, std::string> & /* carrier */) {
@@ -332,45 +333,20 @@ class MovieReviewService_ReadMovieReviews_presult {
 
 };
 
-class MovieReviewServiceClient : virtual public MovieReviewServiceIf {
+class MovieReviewServiceClient : virtual public MovieReviewServiceIf, public BaseServiceClient {
  public:
-  MovieReviewServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-    setProtocol(prot);
-  }
-  MovieReviewServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    setProtocol(iprot,oprot);
-  }
- private:
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-  setProtocol(prot,prot);
-  }
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    piprot_=iprot;
-    poprot_=oprot;
-    iprot_ = iprot.get();
-    oprot_ = oprot.get();
-  }
- public:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getInputProtocol() {
-    return piprot_;
-  }
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getOutputProtocol() {
-    return poprot_;
-  }
+  MovieReviewServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) :
+    BaseServiceClient(prot, prot) {}
+  MovieReviewServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) :    BaseServiceClient(iprot, oprot) {}
   void UploadMovieReview(const int64_t req_id, const std::string& movie_id, const int64_t review_id, const int64_t timestamp, const std::map<std::string, std::string> & carrier);
   void send_UploadMovieReview(const int64_t req_id, const std::string& movie_id, const int64_t review_id, const int64_t timestamp, const std::map<std::string, std::string> & carrier);
   void recv_UploadMovieReview();
   void ReadMovieReviews(std::vector<Review> & _return, const int64_t req_id, const std::string& movie_id, const int32_t start, const int32_t stop, const std::map<std::string, std::string> & carrier);
   void send_ReadMovieReviews(const int64_t req_id, const std::string& movie_id, const int32_t start, const int32_t stop, const std::map<std::string, std::string> & carrier);
   void recv_ReadMovieReviews(std::vector<Review> & _return);
- protected:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> piprot_;
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> poprot_;
-  ::apache::thrift::protocol::TProtocol* iprot_;
-  ::apache::thrift::protocol::TProtocol* oprot_;
 };
 
-class MovieReviewServiceProcessor : public ::apache::thrift::TDispatchProcessor {
+class MovieReviewServiceProcessor : public BaseServiceProcessor {
  protected:
   ::apache::thrift::stdcxx::shared_ptr<MovieReviewServiceIf> iface_;
   virtual bool dispatchCall(::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, const std::string& fname, int32_t seqid, void* callContext);
@@ -382,6 +358,7 @@ class MovieReviewServiceProcessor : public ::apache::thrift::TDispatchProcessor
   void process_ReadMovieReviews(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext);
  public:
   MovieReviewServiceProcessor(::apache::thrift::stdcxx::shared_ptr<MovieReviewServiceIf> iface) :
+    BaseServiceProcessor(iface),
     iface_(iface) {
     processMap_["UploadMovieReview"] = &MovieReviewServiceProcessor::process_UploadMovieReview;
     processMap_["ReadMovieReviews"] = &MovieReviewServiceProcessor::process_ReadMovieReviews;
@@ -401,9 +378,13 @@ class MovieReviewServiceProcessorFactory : public ::apache::thrift::TProcessorFa
   ::apache::thrift::stdcxx::shared_ptr< MovieReviewServiceIfFactory > handlerFactory_;
 };
 
-class MovieReviewServiceMultiface : virtual public MovieReviewServiceIf {
+class MovieReviewServiceMultiface : virtual public MovieReviewServiceIf, public BaseServiceMultiface {
  public:
   MovieReviewServiceMultiface(std::vector<apache::thrift::stdcxx::shared_ptr<MovieReviewServiceIf> >& ifaces) : ifaces_(ifaces) {
+    std::vector<apache::thrift::stdcxx::shared_ptr<MovieReviewServiceIf> >::iterator iter;
+    for (iter = ifaces.begin(); iter != ifaces.end(); ++iter) {
+      BaseServiceMultiface::add(*iter);
+    }
   }
   virtual ~MovieReviewServiceMultiface() {}
  protected:
@@ -437,43 +418,17 @@ class MovieReviewServiceMultiface : virtual public MovieReviewServiceIf {
 // The 'concurrent' client is a thread safe client that correctly handles
 // out of order responses.  It is slower than the regular client, so should
 // only be used when you need to share a connection among multiple threads
-class MovieReviewServiceConcurrentClient : virtual public MovieReviewServiceIf {
+class MovieReviewServiceConcurrentClient : virtual public MovieReviewServiceIf, public BaseServiceConcurrentClient {
  public:
-  MovieReviewServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-    setProtocol(prot);
-  }
-  MovieReviewServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    setProtocol(iprot,oprot);
-  }
- private:
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-  setProtocol(prot,prot);
-  }
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    piprot_=iprot;
-    poprot_=oprot;
-    iprot_ = iprot.get();
-    oprot_ = oprot.get();
-  }
- public:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getInputProtocol() {
-    return piprot_;
-  }
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getOutputProtocol() {
-    return poprot_;
-  }
+  MovieReviewServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) :
+    BaseServiceConcurrentClient(prot, prot) {}
+  MovieReviewServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) :    BaseServiceConcurrentClient(iprot, oprot) {}
   void UploadMovieReview(const int64_t req_id, const std::string& movie_id, const int64_t review_id, const int64_t timestamp, const std::map<std::string, std::string> & carrier);
   int32_t send_UploadMovieReview(const int64_t req_id, const std::string& movie_id, const int64_t review_id, const int64_t timestamp, const std::map<std::string, std::string> & carrier);
   void recv_UploadMovieReview(const int32_t seqid);
   void ReadMovieReviews(std::vector<Review> & _return, const int64_t req_id, const std::string& movie_id, const int32_t start, const int32_t stop, const std::map<std::string, std::string> & carrier);
   int32_t send_ReadMovieReviews(const int64_t req_id, const std::string& movie_id, const int32_t start, const int32_t stop, const std::map<std::string, std::string> & carrier);
   void recv_ReadMovieReviews(std::vector<Review> & _return, const int32_t seqid);
- protected:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> piprot_;
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> poprot_;
-  ::apache::thrift::protocol::TProtocol* iprot_;
-  ::apache::thrift::protocol::TProtocol* oprot_;
-  ::apache::thrift::async::TConcurrentClientSyncInfo sync_;
 };
 
 #ifdef _MSC_VER
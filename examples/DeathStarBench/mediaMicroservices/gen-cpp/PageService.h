@@ -10,6 +10,7 @@
 #include <thrift/TDispatchProcessor.h>
 #include <thrift/async/TConcurrentClientSyncInfo.h>
 #include "media_service_types.h"
+#include "BaseService.h"
 
 namespace media_service {
 
@@ -18,20 +19,20 @@ namespace media_service {
   #pragma warning (disable : 4250 ) //inheriting methods via dominance 
 #endif
 
-class PageServiceIf {
+class PageServiceIf : virtual public BaseServiceIf {
  public:
   virtual ~PageServiceIf() {}
   virtual void ReadPage(Page& _return, const int64_t req_id, const std::string& movie_id, const int32_t review_start, const int32_t review_stop, const std::map<std::string, std::string> & carrier) = 0;
 };
 
-class PageServiceIfFactory {
+class PageServiceIfFactory : virtual public BaseServiceIfFactory {
  public:
   typedef PageServiceIf Handler;
 
   virtual ~PageServiceIfFactory() {}
 
   virtual PageServiceIf* getHandler(const ::apache::thrift::TConnectionInfo& connInfo) = 0;
-  virtual void releaseHandler(PageServiceIf* /* handler */) = 0;
+  virtual void releaseHandler(BaseServiceIf* /* handler */) = 0;
 };
 
 class PageServiceIfSingletonFactory : virtual public PageServiceIfFactory {
@@ -42,13 +43,13 @@ class PageServiceIfSingletonFactory : virtual public PageServiceIfFactory {
   virtual PageServiceIf* getHandler(const ::apache::thrift::TConnectionInfo&) {
     return iface_.get();
   }
-  virtual void releaseHandler(PageServiceIf* /* handler */) {}
+  virtual void releaseHandler(BaseServiceIf* /* handler */) {}
 
  protected:
   ::apache::thrift::stdcxx::shared_ptr<PageServiceIf> iface_;
 };
 
-class PageServiceNull : virtual public PageServiceIf {
+class PageServiceNull : virtual public PageServiceIf , virtual public BaseServiceNull {
  public:
   virtual ~PageServiceNull() {}
   void ReadPage(Page& /* _return */, const int64_t /* req_id */, const std::string& /* movie_id */, const int32_t /* review_start */, const int32_t /* review_stop */, const std::map<std::string, std::string> & /* carrier */) {
@@ -196,42 +197,17 @@ class PageService_ReadPage_presult {
 
 };
 
-class PageServiceClient : virtual public PageServiceIf {
+class PageServiceClient : virtual public PageServiceIf, public BaseServiceClient {
  public:
-  PageServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-    setProtocol(prot);
-  }
-  PageServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    setProtocol(iprot,oprot);
-  }
- private:
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-  setProtocol(prot,prot);
-  }
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    piprot_=iprot;
-    poprot_=oprot;
-    iprot_ = iprot.get();
-    oprot_ = oprot.get();
-  }
- public:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getInputProtocol() {
-    return piprot_;
-  }
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getOutputProtocol() {
-    return poprot_;
-  }
+  PageServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) :
+    BaseServiceClient(prot, prot) {}
+  PageServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) :    BaseServiceClient(iprot, oprot) {}
   void ReadPage(Page& _return, const int64_t req_id, const std::string& movie_id, const int32_t review_start, const int32_t review_stop, const std::map<std::string, std::string> & carrier);
   void send_ReadPage(const int64_t req_id, const std::string& movie_id, const int32_t review_start, const int32_t review_stop, const std::map<std::string, std::string> & carrier);
   void recv_ReadPage(Page& _return);
- protected:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> piprot_;
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> poprot_;
-  ::apache::thrift::protocol::TProtocol* iprot_;
-  ::apache::thrift::protocol::TProtocol* oprot_;
 };
 
-class PageServiceProcessor : public ::apache::thrift::TDispatchProcessor {
+class PageServiceProcessor : public BaseServiceProcessor {
  protected:
   ::apache::thrift::stdcxx::shared_ptr<PageServiceIf> iface_;
   virtual bool dispatchCall(::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, const std::string& fname, int32_t seqid, void* callContext);
@@ -242,6 +218,7 @@ class PageServiceProcessor : public ::apache::thrift::TDispatchProcessor {
   void process_ReadPage(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext);
  public:
   PageServiceProcessor(::apache::thrift::stdcxx::shared_ptr<PageServiceIf> iface) :
+    BaseServiceProcessor(iface),
     iface_(iface) {
     processMap_["ReadPage"] = &PageServiceProcessor::process_ReadPage;
   }
@@ -260,9 +237,13 @@ class PageServiceProcessorFactory : public ::apache::thrift::TProcessorFactory {
   ::apache::thrift::stdcxx::shared_ptr< PageServiceIfFactory > handlerFactory_;
 };
 
-class PageServiceMultiface : virtual public PageServiceIf {
+class PageServiceMultiface : virtual public PageServiceIf, public BaseServiceMultiface {
  public:
   PageServiceMultiface(std::vector<apache::thrift::stdcxx::shared_ptr<PageServiceIf> >& ifaces) : ifaces_(ifaces) {
+    std::vector<apache::thrift::stdcxx::shared_ptr<PageServiceIf> >::iterator iter;
+    for (iter = ifaces.begin(); iter != ifaces.end(); ++iter) {
+      BaseServiceMultiface::add(*iter);
+    }
   }
   virtual ~PageServiceMultiface() {}
  protected:
@@ -287,40 +268,14 @@ class PageServiceMultiface : virtual public PageServiceIf {
 // The 'concurrent' client is a thread safe client that correctly handles
 // out of order responses.  It is slower than the regular client, so should
 // only be used when you need to share a connection among multiple threads
-class PageServiceConcurrentClient : virtual public PageServiceIf {
+class PageServiceConcurrentClient : virtual public PageServiceIf, public BaseServiceConcurrentClient {
  public:
-  PageServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-    setProtocol(prot);
-  }
-  PageServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    setProtocol(iprot,oprot);
-  }
- private:
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-  setProtocol(prot,prot);
-  }
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    piprot_=iprot;
-    poprot_=oprot;
-    iprot_ = iprot.get();
-    oprot_ = oprot.get();
-  }
- public:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getInputProtocol() {
-    return piprot_;
-  }
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getOutputProtocol() {
-    return poprot_;
-  }
+  PageServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) :
+    BaseServiceConcurrentClient(prot, prot) {}
+  PageServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) :    BaseServiceConcurrentClient(iprot, oprot) {}
   void ReadPage(Page& _return, const int64_t req_id, const std::string& movie_id, const int32_t review_start, const int32_t review_stop, const std::map<std::string, std::string> & carrier);
   int32_t send_ReadPage(const int64_t req_id, const std::string& movie_id, const int32_t review_start, const int32_t review_stop, const std::map<std::string, std::string> & carrier);
   void recv_ReadPage(Page& _return, const int32_t seqid);
- protected:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> piprot_;
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> poprot_;
-  ::apache::thrift::protocol::TProtocol* iprot_;
-  ::apache::thrift::protocol::TProtocol* oprot_;
-  ::apache::thrift::async::TConcurrentClientSyncInfo sync_;
 };
 
 #ifdef _MSC_VER
@@ -10,6 +10,7 @@
 #include <thrift/TDispatchProcessor.h>
 #include <thrift/async/TConcurrentClientSyncInfo.h>
 #include "media_service_types.h"
+#include "BaseService.h"
 
 namespace media_service {
 
@@ -18,21 +19,21 @@ namespace media_service {
   #pragma warning (disable : 4250 ) //inheriting methods via dominance 
 #endif
 
-class PlotServiceIf {
+class PlotServiceIf : virtual public BaseServiceIf {
  public:
   virtual ~PlotServiceIf() {}
   virtual void WritePlot(const int64_t req_id, const int64_t plot_id, const std::string& plot, const std::map<std::string, std::string> & carrier) = 0;
   virtual void ReadPlot(std::string& _return, const int64_t req_id, const int64_t plot_id, const std::map<std::string, std::string> & carrier) = 0;
 };
 
-class PlotServiceIfFactory {
+class PlotServiceIfFactory : virtual public BaseServiceIfFactory {
  public:
   typedef PlotServiceIf Handler;
 
   virtual ~PlotServiceIfFactory() {}
 
   virtual PlotServiceIf* getHandler(const ::apache::thrift::TConnectionInfo& connInfo) = 0;
-  virtual void releaseHandler(PlotServiceIf* /* handler */) = 0;
+  virtual void releaseHandler(BaseServiceIf* /* handler */) = 0;
 };
 
 class PlotServiceIfSingletonFactory : virtual public PlotServiceIfFactory {
@@ -43,13 +44,13 @@ class PlotServiceIfSingletonFactory : virtual public PlotServiceIfFactory {
   virtual PlotServiceIf* getHandler(const ::apache::thrift::TConnectionInfo&) {
     return iface_.get();
   }
-  virtual void releaseHandler(PlotServiceIf* /* handler */) {}
+  virtual void releaseHandler(BaseServiceIf* /* handler */) {}
 
  protected:
   ::apache::thrift::stdcxx::shared_ptr<PlotServiceIf> iface_;
 };
 
-class PlotServiceNull : virtual public PlotServiceIf {
+class PlotServiceNull : virtual public PlotServiceIf , virtual public BaseServiceNull {
  public:
   virtual ~PlotServiceNull() {}
   void WritePlot(const int64_t /* req_id */, const int64_t /* plot_id */, const std::string& /* plot */, const std::map<std::string, std::string> & /* carrier */) {
@@ -311,45 +312,20 @@ class PlotService_ReadPlot_presult {
 
 };
 
-class PlotServiceClient : virtual public PlotServiceIf {
+class PlotServiceClient : virtual public PlotServiceIf, public BaseServiceClient {
  public:
-  PlotServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-    setProtocol(prot);
-  }
-  PlotServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    setProtocol(iprot,oprot);
-  }
- private:
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-  setProtocol(prot,prot);
-  }
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    piprot_=iprot;
-    poprot_=oprot;
-    iprot_ = iprot.get();
-    oprot_ = oprot.get();
-  }
- public:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getInputProtocol() {
-    return piprot_;
-  }
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getOutputProtocol() {
-    return poprot_;
-  }
+  PlotServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) :
+    BaseServiceClient(prot, prot) {}
+  PlotServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) :    BaseServiceClient(iprot, oprot) {}
   void WritePlot(const int64_t req_id, const int64_t plot_id, const std::string& plot, const std::map<std::string, std::string> & carrier);
   void send_WritePlot(const int64_t req_id, const int64_t plot_id, const std::string& plot, const std::map<std::string, std::string> & carrier);
   void recv_WritePlot();
   void ReadPlot(std::string& _return, const int64_t req_id, const int64_t plot_id, const std::map<std::string, std::string> & carrier);
   void send_ReadPlot(const int64_t req_id, const int64_t plot_id, const std::map<std::string, std::string> & carrier);
   void recv_ReadPlot(std::string& _return);
- protected:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> piprot_;
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> poprot_;
-  ::apache::thrift::protocol::TProtocol* iprot_;
-  ::apache::thrift::protocol::TProtocol* oprot_;
 };
 
-class PlotServiceProcessor : public ::apache::thrift::TDispatchProcessor {
+class PlotServiceProcessor : public BaseServiceProcessor {
  protected:
   ::apache::thrift::stdcxx::shared_ptr<PlotServiceIf> iface_;
   virtual bool dispatchCall(::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, const std::string& fname, int32_t seqid, void* callContext);
@@ -361,6 +337,7 @@ class PlotServiceProcessor : public ::apache::thrift::TDispatchProcessor {
   void process_ReadPlot(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext);
  public:
   PlotServiceProcessor(::apache::thrift::stdcxx::shared_ptr<PlotServiceIf> iface) :
+    BaseServiceProcessor(iface),
     iface_(iface) {
     processMap_["WritePlot"] = &PlotServiceProcessor::process_WritePlot;
     processMap_["ReadPlot"] = &PlotServiceProcessor::process_ReadPlot;
@@ -380,9 +357,13 @@ class PlotServiceProcessorFactory : public ::apache::thrift::TProcessorFactory {
   ::apache::thrift::stdcxx::shared_ptr< PlotServiceIfFactory > handlerFactory_;
 };
 
-class PlotServiceMultiface : virtual public PlotServiceIf {
+class PlotServiceMultiface : virtual public PlotServiceIf, public BaseServiceMultiface {
  public:
   PlotServiceMultiface(std::vector<apache::thrift::stdcxx::shared_ptr<PlotServiceIf> >& ifaces) : ifaces_(ifaces) {
+    std::vector<apache::thrift::stdcxx::shared_ptr<PlotServiceIf> >::iterator iter;
+    for (iter = ifaces.begin(); iter != ifaces.end(); ++iter) {
+      BaseServiceMultiface::add(*iter);
+    }
   }
   virtual ~PlotServiceMultiface() {}
  protected:
@@ -416,43 +397,17 @@ class PlotServiceMultiface : virtual public PlotServiceIf {
 // The 'concurrent' client is a thread safe client that correctly handles
 // out of order responses.  It is slower than the regular client, so should
 // only be used when you need to share a connection among multiple threads
-class PlotServiceConcurrentClient : virtual public PlotServiceIf {
+class PlotServiceConcurrentClient : virtual public PlotServiceIf, public BaseServiceConcurrentClient {
  public:
-  PlotServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-    setProtocol(prot);
-  }
-  PlotServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    setProtocol(iprot,oprot);
-  }
- private:
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-  setProtocol(prot,prot);
-  }
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    piprot_=iprot;
-    poprot_=oprot;
-    iprot_ = iprot.get();
-    oprot_ = oprot.get();
-  }
- public:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getInputProtocol() {
-    return piprot_;
-  }
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getOutputProtocol() {
-    return poprot_;
-  }
+  PlotServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) :
+    BaseServiceConcurrentClient(prot, prot) {}
+  PlotServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) :    BaseServiceConcurrentClient(iprot, oprot) {}
   void WritePlot(const int64_t req_id, const int64_t plot_id, const std::string& plot, const std::map<std::string, std::string> & carrier);
   int32_t send_WritePlot(const int64_t req_id, const int64_t plot_id, const std::string& plot, const std::map<std::string, std::string> & carrier);
   void recv_WritePlot(const int32_t seqid);
   void ReadPlot(std::string& _return, const int64_t req_id, const int64_t plot_id, const std::map<std::string, std::string> & carrier);
   int32_t send_ReadPlot(const int64_t req_id, const int64_t plot_id, const std::map<std::string, std::string> & carrier);
   void recv_ReadPlot(std::string& _return, const int32_t seqid);
- protected:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> piprot_;
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> poprot_;
-  ::apache::thrift::protocol::TProtocol* iprot_;
-  ::apache::thrift::protocol::TProtocol* oprot_;
-  ::apache::thrift::async::TConcurrentClientSyncInfo sync_;
 };
 
 #ifdef _MSC_VER
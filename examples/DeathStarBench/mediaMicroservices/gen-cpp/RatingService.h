@@ -10,6 +10,7 @@
 #include <thrift/TDispatchProcessor.h>
 #include <thrift/async/TConcurrentClientSyncInfo.h>
 #include "media_service_types.h"
+#include "BaseService.h"
 
 namespace media_service {
 
@@ -18,20 +19,20 @@ namespace media_service {
   #pragma warning (disable : 4250 ) //inheriting methods via dominance 
 #endif
 
-class RatingServiceIf {
+class RatingServiceIf : virtual public BaseServiceIf {
  public:
   virtual ~RatingServiceIf() {}
   virtual void UploadRating(const int64_t req_id, const std::string& movie_id, const int32_t rating, const std::map<std::string, std::string> & carrier) = 0;
 };
 
-class RatingServiceIfFactory {
+class RatingServiceIfFactory : virtual public BaseServiceIfFactory {
  public:
   typedef RatingServiceIf Handler;
 
   virtual ~RatingServiceIfFactory() {}
 
   virtual RatingServiceIf* getHandler(const ::apache::thrift::TConnectionInfo& connInfo) = 0;
-  virtual void releaseHandler(RatingServiceIf* /* handler */) = 0;
+  virtual void releaseHandler(BaseServiceIf* /* handler */) = 0;
 };
 
 class RatingServiceIfSingletonFactory : virtual public RatingServiceIfFactory {
@@ -42,13 +43,13 @@ class RatingServiceIfSingletonFactory : virtual public RatingServiceIfFactory {
   virtual RatingServiceIf* getHandler(const ::apache::thrift::TConnectionInfo&) {
     return iface_.get();
   }
-  virtual void releaseHandler(RatingServiceIf* /* handler */) {}
+  virtual void releaseHandler(BaseServiceIf* /* handler */) {}
 
  protected:
   ::apache::thrift::stdcxx::shared_ptr<RatingServiceIf> iface_;
 };
 
-class RatingServiceNull : virtual public RatingServiceIf {
+class RatingServiceNull : virtual public RatingServiceIf , virtual public BaseServiceNull {
  public:
   virtual ~RatingServiceNull() {}
   void UploadRating(const int64_t /* req_id */, const std::string& /* movie_id */, const int32_t /* rating */, const std::map<std::string, std::string> & /* carrier */) {
@@ -181,42 +182,17 @@ class RatingService_UploadRating_presult {
 
 };
 
-class RatingServiceClient : virtual public RatingServiceIf {
+class RatingServiceClient : virtual public RatingServiceIf, public BaseServiceClient {
  public:
-  RatingServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-    setProtocol(prot);
-  }
-  RatingServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    setProtocol(iprot,oprot);
-  }
- private:
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-  setProtocol(prot,prot);
-  }
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    piprot_=iprot;
-    poprot_=oprot;
-    iprot_ = iprot.get();
-    oprot_ = oprot.get();
-  }
- public:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getInputProtocol() {
-    return piprot_;
-  }
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getOutputProtocol() {
-    return poprot_;
-  }
+  RatingServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) :
+    BaseServiceClient(prot, prot) {}
+  RatingServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) :    BaseServiceClient(iprot, oprot) {}
   void UploadRating(const int64_t req_id, const std::string& movie_id, const int32_t rating, const std::map<std::string, std::string> & carrier);
   void send_UploadRating(const int64_t req_id, const std::string& movie_id, const int32_t rating, const std::map<std::string, std::string> & carrier);
   void recv_UploadRating();
- protected:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> piprot_;
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> poprot_;
-  ::apache::thrift::protocol::TProtocol* iprot_;
-  ::apache::thrift::protocol::TProtocol* oprot_;
 };
 
-class RatingServiceProcessor : public ::apache::thrift::TDispatchProcessor {
+class RatingServiceProcessor : public BaseServiceProcessor {
  protected:
   ::apache::thrift::stdcxx::shared_ptr<RatingServiceIf> iface_;
   virtual bool dispatchCall(::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, const std::string& fname, int32_t seqid, void* callContext);
@@ -227,6 +203,7 @@ class RatingServiceProcessor : public ::apache::thrift::TDispatchProcessor {
   void process_UploadRating(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext);
  public:
   RatingServiceProcessor(::apache::thrift::stdcxx::shared_ptr<RatingServiceIf> iface) :
+    BaseServiceProcessor(iface),
     iface_(iface) {
     processMap_["UploadRating"] = &RatingServiceProcessor::process_UploadRating;
   }
@@ -245,9 +222,13 @@ class RatingServiceProcessorFactory : public ::apache::thrift::TProcessorFactory
   ::apache::thrift::stdcxx::shared_ptr< RatingServiceIfFactory > handlerFactory_;
 };
 
-class RatingServiceMultiface : virtual public RatingServiceIf {
+class RatingServiceMultiface : virtual public RatingServiceIf, public BaseServiceMultiface {
  public:
   RatingServiceMultiface(std::vector<apache::thrift::stdcxx::shared_ptr<RatingServiceIf> >& ifaces) : ifaces_(ifaces) {
+    std::vector<apache::thrift::stdcxx::shared_ptr<RatingServiceIf> >::iterator iter;
+    for (iter = ifaces.begin(); iter != ifaces.end(); ++iter) {
+      BaseServiceMultiface::add(*iter);
+    }
   }
   virtual ~RatingServiceMultiface() {}
  protected:
@@ -271,40 +252,14 @@ class RatingServiceMultiface : virtual public RatingServiceIf {
 // The 'concurrent' client is a thread safe client that correctly handles
 // out of order responses.  It is slower than the regular client, so should
 // only be used when you need to share a connection among multiple threads
-class RatingServiceConcurrentClient : virtual public RatingServiceIf {
+class RatingServiceConcurrentClient : virtual public RatingServiceIf, public BaseServiceConcurrentClient {
  public:
-  RatingServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-    setProtocol(prot);
-  }
-  RatingServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    setProtocol(iprot,oprot);
-  }
- private:
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-  setProtocol(prot,prot);
-  }
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    piprot_=iprot;
-    poprot_=oprot;
-    iprot_ = iprot.get();
-    oprot_ = oprot.get();
-  }
- public:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getInputProtocol() {
-    return piprot_;
-  }
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getOutputProtocol() {
-    return poprot_;
-  }
+  RatingServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) :
+    BaseServiceConcurrentClient(prot, prot) {}
+  RatingServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) :    BaseServiceConcurrentClient(iprot, oprot) {}
   void UploadRating(const int64_t req_id, const std::string& movie_id, const int32_t rating, const std::map<std::string, std::string> & carrier);
   int32_t send_UploadRating(const int64_t req_id, const std::string& movie_id, const int32_t rating, const std::map<std::string, std::string> & carrier);
   void recv_UploadRating(const int32_t seqid);
- protected:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> piprot_;
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> poprot_;
-  ::apache::thrift::protocol::TProtocol* iprot_;
-  ::apache::thrift::protocol::TProtocol* oprot_;
-  ::apache::thrift::async::TConcurrentClientSyncInfo sync_;
 };
 
 #ifdef _MSC_VER
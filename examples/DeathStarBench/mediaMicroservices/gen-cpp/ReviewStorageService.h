@@ -10,6 +10,7 @@
 #include <thrift/TDispatchProcessor.h>
 #include <thrift/async/TConcurrentClientSyncInfo.h>
 #include "media_service_types.h"
+#include "BaseService.h"
 
 namespace media_service {
 
@@ -18,21 +19,21 @@ namespace media_service {
   #pragma warning (disable : 4250 ) //inheriting methods via dominance 
 #endif
 
-class ReviewStorageServiceIf {
+class ReviewStorageServiceIf : virtual public BaseServiceIf {
  public:
   virtual ~ReviewStorageServiceIf() {}
   virtual void StoreReview(const int64_t req_id, const Review& review, const std::map<std::string, std::string> & carrier) = 0;
   virtual void ReadReviews(std::vector<Review> & _return, const int64_t req_id, const std::vector<int64_t> & review_ids, const std::map<std::string, std::string> & carrier) = 0;
 };
 
-class ReviewStorageServiceIfFactory {
+class ReviewStorageServiceIfFactory : virtual public BaseServiceIfFactory {
  public:
   typedef ReviewStorageServiceIf Handler;
 
   virtual ~ReviewStorageServiceIfFactory() {}
 
   virtual ReviewStorageServiceIf* getHandler(const ::apache::thrift::TConnectionInfo& connInfo) = 0;
-  virtual void releaseHandler(ReviewStorageServiceIf* /* handler */) = 0;
+  virtual void releaseHandler(BaseServiceIf* /* handler */) = 0;
 };
 
 class ReviewStorageServiceIfSingletonFactory : virtual public ReviewStorageServiceIfFactory {
@@ -43,13 +44,13 @@ class ReviewStorageServiceIfSingletonFactory : virtual public ReviewStorageServi
   virtual ReviewStorageServiceIf* getHandler(const ::apache::thrift::TConnectionInfo&) {
     return iface_.get();
   }
-  virtual void releaseHandler(ReviewStorageServiceIf* /* handler */) {}
+  virtual void releaseHandler(BaseServiceIf* /* handler */) {}
 
  protected:
   ::apache::thrift::stdcxx::shared_ptr<ReviewStorageServiceIf> iface_;
 };
 
-class ReviewStorageServiceNull : virtual public ReviewStorageServiceIf {
+class ReviewStorageServiceNull : virtual public ReviewStorageServiceIf , virtual public BaseServiceNull {
  public:
   virtual ~ReviewStorageServiceNull() {}
   void StoreReview(const int64_t /* req_id */, const Review& /* review */, const std::map<std::string, std::string> & /* carrier */) {
@@ -304,45 +305,20 @@ class ReviewStorageService_ReadReviews_presult {
 
 };
 
-class ReviewStorageServiceClient : virtual public ReviewStorageServiceIf {
+class ReviewStorageServiceClient : virtual public ReviewStorageServiceIf, public BaseServiceClient {
  public:
-  ReviewStorageServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-    setProtocol(prot);
-  }
-  ReviewStorageServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    setProtocol(iprot,oprot);
-  }
- private:
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-  setProtocol(prot,prot);
-  }
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    piprot_=iprot;
-    poprot_=oprot;
-    iprot_ = iprot.get();
-    oprot_ = oprot.get();
-  }
- public:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getInputProtocol() {
-    return piprot_;
-  }
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getOutputProtocol() {
-    return poprot_;
-  }
+  ReviewStorageServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) :
+    BaseServiceClient(prot, prot) {}
+  ReviewStorageServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) :    BaseServiceClient(iprot, oprot) {}
   void StoreReview(const int64_t req_id, const Review& review, const std::map<std::string, std::string> & carrier);
   void send_StoreReview(const int64_t req_id, const Review& review, const std::map<std::string, std::string> & carrier);
   void recv_StoreReview();
   void ReadReviews(std::vector<Review> & _return, const int64_t req_id, const std::vector<int64_t> & review_ids, const std::map<std::string, std::string> & carrier);
   void send_ReadReviews(const int64_t req_id, const std::vector<int64_t> & review_ids, const std::map<std::string, std::string> & carrier);
   void recv_ReadReviews(std::vector<Review> & _return);
- protected:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> piprot_;
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> poprot_;
-  ::apache::thrift::protocol::TProtocol* iprot_;
-  ::apache::thrift::protocol::TProtocol* oprot_;
 };
 
-class ReviewStorageServiceProcessor : public ::apache::thrift::TDispatchProcessor {
+class ReviewStorageServiceProcessor : public BaseServiceProcessor {
  protected:
   ::apache::thrift::stdcxx::shared_ptr<ReviewStorageServiceIf> iface_;
   virtual bool dispatchCall(::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, const std::string& fname, int32_t seqid, void* callContext);
@@ -354,6 +330,7 @@ class ReviewStorageServiceProcessor : public ::apache::thrift::TDispatchProcesso
   void process_ReadReviews(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext);
  public:
   ReviewStorageServiceProcessor(::apache::thrift::stdcxx::shared_ptr<ReviewStorageServiceIf> iface) :
+    BaseServiceProcessor(iface),
     iface_(iface) {
     processMap_["StoreReview"] = &ReviewStorageServiceProcessor::process_StoreReview;
     processMap_["ReadReviews"] = &ReviewStorageServiceProcessor::process_ReadReviews;
@@ -373,9 +350,13 @@ class ReviewStorageServiceProcessorFactory : public ::apache::thrift::TProcessor
   ::apache::thrift::stdcxx::shared_ptr< ReviewStorageServiceIfFactory > handlerFactory_;
 };
 
-class ReviewStorageServiceMultiface : virtual public ReviewStorageServiceIf {
+class ReviewStorageServiceMultiface : virtual public ReviewStorageServiceIf, public BaseServiceMultiface {
  public:
   ReviewStorageServiceMultiface(std::vector<apache::thrift::stdcxx::shared_ptr<ReviewStorageServiceIf> >& ifaces) : ifaces_(ifaces) {
+    std::vector<apache::thrift::stdcxx::shared_ptr<ReviewStorageServiceIf> >::iterator iter;
+    for (iter = ifaces.begin(); iter != ifaces.end(); ++iter) {
+      BaseServiceMultiface::add(*iter);
+    }
   }
   virtual ~ReviewStorageServiceMultiface() {}
  protected:
@@ -409,43 +390,17 @@ class ReviewStorageServiceMultiface : virtual public ReviewStorageServiceIf {
 // The 'concurrent' client is a thread safe client that correctly handles
 // out of order responses.  It is slower than the regular client, so should
 // only be used when you need to share a connection among multiple threads
-class ReviewStorageServiceConcurrentClient : virtual public ReviewStorageServiceIf {
+class ReviewStorageServiceConcurrentClient : virtual public ReviewStorageServiceIf, public BaseServiceConcurrentClient {
  public:
-  ReviewStorageServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-    setProtocol(prot);
-  }
-  ReviewStorageServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    setProtocol(iprot,oprot);
-  }
- private:
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-  setProtocol(prot,prot);
-  }
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    piprot_=iprot;
-    poprot_=oprot;
-    iprot_ = iprot.get();
-    oprot_ = oprot.get();
-  }
- public:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getInputProtocol() {
-    return piprot_;
-  }
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getOutputProtocol() {
-    return poprot_;
-  }
+  ReviewStorageServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) :
+    BaseServiceConcurrentClient(prot, prot) {}
+  ReviewStorageServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) :    BaseServiceConcurrentClient(iprot, oprot) {}
   void StoreReview(const int64_t req_id, const Review& review, const std::map<std::string, std::string> & carrier);
   int32_t send_StoreReview(const int64_t req_id, const Review& review, const std::map<std::string, std::string> & carrier);
   void recv_StoreReview(const int32_t seqid);
   void ReadReviews(std::vector<Review> & _return, const int64_t req_id, const std::vector<int64_t> & review_ids, const std::map<std::string, std::string> & carrier);
   int32_t send_ReadReviews(const int64_t req_id, const std::vector<int64_t> & review_ids, const std::map<std::string, std::string> & carrier);
   void recv_ReadReviews(std::vector<Review> & _return, const int32_t seqid);
- protected:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> piprot_;
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> poprot_;
-  ::apache::thrift::protocol::TProtocol* iprot_;
-  ::apache::thrift::protocol::TProtocol* oprot_;
-  ::apache::thrift::async::TConcurrentClientSyncInfo sync_;
 };
 
 #ifdef _MSC_VER
@@ -10,6 +10,7 @@
 #include <thrift/TDispatchProcessor.h>
 #include <thrift/async/TConcurrentClientSyncInfo.h>
 #include "media_service_types.h"
+#include "BaseService.h"
 
 namespace media_service {
 
@@ -18,20 +19,21 @@ namespace media_service {
   #pragma warning (disable : 4250 ) //inheriting methods via dominance 
 #endif
 
-class UniqueIdServiceIf {
+class UniqueIdServiceIf : virtual public BaseServiceIf {
  public:
   virtual ~UniqueIdServiceIf() {}
   virtual void UploadUniqueId(const int64_t req_id, const std::map<std::string, std::string> & carrier) = 0;
+  virtual int64_t LeaseUniqueIds(const int64_t req_id, const int32_t count, const std::map<std::string, std::string> & carrier) = 0;
 };
 
-class UniqueIdServiceIfFactory {
+class UniqueIdServiceIfFactory : virtual public BaseServiceIfFactory {
  public:
   typedef UniqueIdServiceIf Handler;
 
   virtual ~UniqueIdServiceIfFactory() {}
 
   virtual UniqueIdServiceIf* getHandler(const ::apache::thrift::TConnectionInfo& connInfo) = 0;
-  virtual void releaseHandler(UniqueIdServiceIf* /* handler */) = 0;
+  virtual void releaseHandler(BaseServiceIf* /* handler */) = 0;
 };
 
 class UniqueIdServiceIfSingletonFactory : virtual public UniqueIdServiceIfFactory {
@@ -42,18 +44,22 @@ class UniqueIdServiceIfSingletonFactory : virtual public UniqueIdServiceIfFactor
   virtual UniqueIdServiceIf* getHandler(const ::apache::thrift::TConnectionInfo&) {
     return iface_.get();
   }
-  virtual void releaseHandler(UniqueIdServiceIf* /* handler */) {}
+  virtual void releaseHandler(BaseServiceIf* /* handler */) {}
 
  protected:
   ::apache::thrift::stdcxx::shared_ptr<UniqueIdServiceIf> iface_;
 };
 
-class UniqueIdServiceNull : virtual public UniqueIdServiceIf {
+class UniqueIdServiceNull : virtual public UniqueIdServiceIf , virtual public BaseServiceNull {
  public:
   virtual ~UniqueIdServiceNull() {}
   void UploadUniqueId(const int64_t /* req_id */, const std::map<std::string, std::string> & /* carrier */) {
     return;
   }
+  int64_t LeaseUniqueIds(const int64_t /* req_id */, const int32_t /* count */, const std::map<std::string, std::string> & /* carrier */) {
+    int64_t _return = 0;
+    return _return;
+  }
 };
 
 typedef struct _UniqueIdService_UploadUniqueId_args__isset {
@@ -167,42 +173,146 @@ class UniqueIdService_UploadUniqueId_presult {
 
 };
 
-class UniqueIdServiceClient : virtual public UniqueIdServiceIf {
+typedef struct _UniqueIdService_LeaseUniqueIds_args__isset {
+  _UniqueIdService_LeaseUniqueIds_args__isset() : req_id(false), count(false), carrier(false) {}
+  bool req_id :1;
+  bool count :1;
+  bool carrier :1;
+} _UniqueIdService_LeaseUniqueIds_args__isset;
+
+class UniqueIdService_LeaseUniqueIds_args {
  public:
-  UniqueIdServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-    setProtocol(prot);
-  }
-  UniqueIdServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    setProtocol(iprot,oprot);
+
+  UniqueIdService_LeaseUniqueIds_args(const UniqueIdService_LeaseUniqueIds_args&);
+  UniqueIdService_LeaseUniqueIds_args& operator=(const UniqueIdService_LeaseUniqueIds_args&);
+  UniqueIdService_LeaseUniqueIds_args() : req_id(0), count(0) {
   }
- private:
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-  setProtocol(prot,prot);
+
+  virtual ~UniqueIdService_LeaseUniqueIds_args() throw();
+  int64_t req_id;
+  int32_t count;
+  std::map<std::string, std::string>  carrier;
+
+  _UniqueIdService_LeaseUniqueIds_args__isset __isset;
+
+  void __set_req_id(const int64_t val);
+
+  void __set_count(const int32_t val);
+
+  void __set_carrier(const std::map<std::string, std::string> & val);
+
+  bool operator == (const UniqueIdService_LeaseUniqueIds_args & rhs) const
+  {
+    if (!(req_id == rhs.req_id))
+      return false;
+    if (!(count == rhs.count))
+      return false;
+    if (!(carrier == rhs.carrier))
+      return false;
+    return true;
   }
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    piprot_=iprot;
-    poprot_=oprot;
-    iprot_ = iprot.get();
-    oprot_ = oprot.get();
+  bool operator != (const UniqueIdService_LeaseUniqueIds_args &rhs) const {
+    return !(*this == rhs);
   }
+
+  bool operator < (const UniqueIdService_LeaseUniqueIds_args & ) const;
+
+  uint32_t read(::apache::thrift::protocol::TProtocol* iprot);
+  uint32_t write(::apache::thrift::protocol::TProtocol* oprot) const;
+
+};
+
+
+class UniqueIdService_LeaseUniqueIds_pargs {
+ public:
+
+
+  virtual ~UniqueIdService_LeaseUniqueIds_pargs() throw();
+  const int64_t* req_id;
+  const int32_t* count;
+  const std::map<std::string, std::string> * carrier;
+
+  uint32_t write(::apache::thrift::protocol::TProtocol* oprot) const;
+
+};
+
+typedef struct _UniqueIdService_LeaseUniqueIds_result__isset {
+  _UniqueIdService_LeaseUniqueIds_result__isset() : success(false), se(false) {}
+  bool success :1;
+  bool se :1;
+} _UniqueIdService_LeaseUniqueIds_result__isset;
+
+class UniqueIdService_LeaseUniqueIds_result {
  public:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getInputProtocol() {
-    return piprot_;
+
+  UniqueIdService_LeaseUniqueIds_result(const UniqueIdService_LeaseUniqueIds_result&);
+  UniqueIdService_LeaseUniqueIds_result& operator=(const UniqueIdService_LeaseUniqueIds_result&);
+  UniqueIdService_LeaseUniqueIds_result() : success(0) {
   }
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getOutputProtocol() {
-    return poprot_;
+
+  virtual ~UniqueIdService_LeaseUniqueIds_result() throw();
+  int64_t success;
+  ServiceException se;
+
+  _UniqueIdService_LeaseUniqueIds_result__isset __isset;
+
+  void __set_success(const int64_t val);
+
+  void __set_se(const ServiceException& val);
+
+  bool operator == (const UniqueIdService_LeaseUniqueIds_result & rhs) const
+  {
+    if (!(success == rhs.success))
+      return false;
+    if (!(se == rhs.se))
+      return false;
+    return true;
   }
+  bool operator != (const UniqueIdService_LeaseUniqueIds_result &rhs) const {
+    return !(*this == rhs);
+  }
+
+  bool operator < (const UniqueIdService_LeaseUniqueIds_result & ) const;
+
+  uint32_t read(::apache::thrift::protocol::TProtocol* iprot);
+  uint32_t write(::apache::thrift::protocol::TProtocol* oprot) const;
+
+};
+
+typedef struct _UniqueIdService_LeaseUniqueIds_presult__isset {
+  _UniqueIdService_LeaseUniqueIds_presult__isset() : success(false), se(false) {}
+  bool success :1;
+  bool se :1;
+} _UniqueIdService_LeaseUniqueIds_presult__isset;
+
+class UniqueIdService_LeaseUniqueIds_presult {
+ public:
+
+
+  virtual ~UniqueIdService_LeaseUniqueIds_presult() throw();
+  int64_t* success;
+  ServiceException se;
+
+  _UniqueIdService_LeaseUniqueIds_presult__isset __isset;
+
+  uint32_t read(::apache::thrift::protocol::TProtocol* iprot);
+
+};
+
+class UniqueIdServiceClient : virtual public UniqueIdServiceIf, public BaseServiceClient {
+ public:
+  UniqueIdServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) :
+    BaseServiceClient(prot, prot) {}
+  UniqueIdServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) :    BaseServiceClient(iprot, oprot) {}
   void UploadUniqueId(const int64_t req_id, const std::map<std::string, std::string> & carrier);
   void send_UploadUniqueId(const int64_t req_id, const std::map<std::string, std::string> & carrier);
   void recv_UploadUniqueId();
- protected:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> piprot_;
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> poprot_;
-  ::apache::thrift::protocol::TProtocol* iprot_;
-  ::apache::thrift::protocol::TProtocol* oprot_;
+  int64_t LeaseUniqueIds(const int64_t req_id, const int32_t count, const std::map<std::string, std::string> & carrier);
+  void send_LeaseUniqueIds(const int64_t req_id, const int32_t count, const std::map<std::string, std::string> & carrier);
+  int64_t recv_LeaseUniqueIds();
 };
 
-class UniqueIdServiceProcessor : public ::apache::thrift::TDispatchProcessor {
+class UniqueIdServiceProcessor : public BaseServiceProcessor {
  protected:
   ::apache::thrift::stdcxx::shared_ptr<UniqueIdServiceIf> iface_;
   virtual bool dispatchCall(::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, const std::string& fname, int32_t seqid, void* callContext);
@@ -211,10 +321,13 @@ class UniqueIdServiceProcessor : public ::apache::thrift::TDispatchProcessor {
   typedef std::map<std::string, ProcessFunction> ProcessMap;
   ProcessMap processMap_;
   void process_UploadUniqueId(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext);
+  void process_LeaseUniqueIds(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext);
  public:
   UniqueIdServiceProcessor(::apache::thrift::stdcxx::shared_ptr<UniqueIdServiceIf> iface) :
+    BaseServiceProcessor(iface),
     iface_(iface) {
     processMap_["UploadUniqueId"] = &UniqueIdServiceProcessor::process_UploadUniqueId;
+    processMap_["LeaseUniqueIds"] = &UniqueIdServiceProcessor::process_LeaseUniqueIds;
   }
 
   virtual ~UniqueIdServiceProcessor() {}
@@ -231,9 +344,13 @@ class UniqueIdServiceProcessorFactory : public ::apache::thrift::TProcessorFacto
   ::apache::thrift::stdcxx::shared_ptr< UniqueIdServiceIfFactory > handlerFactory_;
 };
 
-class UniqueIdServiceMultiface : virtual public UniqueIdServiceIf {
+class UniqueIdServiceMultiface : virtual public UniqueIdServiceIf, public BaseServiceMultiface {
  public:
   UniqueIdServiceMultiface(std::vector<apache::thrift::stdcxx::shared_ptr<UniqueIdServiceIf> >& ifaces) : ifaces_(ifaces) {
+    std::vector<apache::thrift::stdcxx::shared_ptr<UniqueIdServiceIf> >::iterator iter;
+    for (iter = ifaces.begin(); iter != ifaces.end(); ++iter) {
+      BaseServiceMultiface::add(*iter);
+    }
   }
   virtual ~UniqueIdServiceMultiface() {}
  protected:
@@ -252,45 +369,31 @@ class UniqueIdServiceMultiface : virtual public UniqueIdServiceIf {
     ifaces_[i]->UploadUniqueId(req_id, carrier);
   }
 
+  int64_t LeaseUniqueIds(const int64_t req_id, const int32_t count, const std::map<std::string, std::string> & carrier) {
+    size_t sz = ifaces_.size();
+    size_t i = 0;
+    for (; i < (sz - 1); ++i) {
+      ifaces_[i]->LeaseUniqueIds(req_id, count, carrier);
+    }
+    return ifaces_[i]->LeaseUniqueIds(req_id, count, carrier);
+  }
+
 };
 
 // The 'concurrent' client is a thread safe client that correctly handles
 // out of order responses.  It is slower than the regular client, so should
 // only be used when you need to share a connection among multiple threads
-class UniqueIdServiceConcurrentClient : virtual public UniqueIdServiceIf {
- public:
-  UniqueIdServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-    setProtocol(prot);
-  }
-  UniqueIdServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    setProtocol(iprot,oprot);
-  }
- private:
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-  setProtocol(prot,prot);
-  }
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    piprot_=iprot;
-    poprot_=oprot;
-    iprot_ = iprot.get();
-    oprot_ = oprot.get();
-  }
+class UniqueIdServiceConcurrentClient : virtual public UniqueIdServiceIf, public BaseServiceConcurrentClient {
  public:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getInputProtocol() {
-    return piprot_;
-  }
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getOutputProtocol() {
-    return poprot_;
-  }
+  UniqueIdServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) :
+    BaseServiceConcurrentClient(prot, prot) {}
+  UniqueIdServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) :    BaseServiceConcurrentClient(iprot, oprot) {}
   void UploadUniqueId(const int64_t req_id, const std::map<std::string, std::string> & carrier);
   int32_t send_UploadUniqueId(const int64_t req_id, const std::map<std::string, std::string> & carrier);
   void recv_UploadUniqueId(const int32_t seqid);
- protected:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> piprot_;
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> poprot_;
-  ::apache::thrift::protocol::TProtocol* iprot_;
-  ::apache::thrift::protocol::TProtocol* oprot_;
-  ::apache::thrift::async::TConcurrentClientSyncInfo sync_;
+  int64_t LeaseUniqueIds(const int64_t req_id, const int32_t count, const std::map<std::string, std::string> & carrier);
+  int32_t send_LeaseUniqueIds(const int64_t req_id, const int32_t count, const std::map<std::string, std::string> & carrier);
+  int64_t recv_LeaseUniqueIds(const int32_t seqid);
 };
 
 #ifdef _MSC_VER
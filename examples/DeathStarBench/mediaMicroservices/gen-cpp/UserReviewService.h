@@ -10,6 +10,7 @@
 #include <thrift/TDispatchProcessor.h>
 #include <thrift/async/TConcurrentClientSyncInfo.h>
 #include "media_service_types.h"
+#include "BaseService.h"
 
 namespace media_service {
 
@@ -18,21 +19,21 @@ namespace media_service {
   #pragma warning (disable : 4250 ) //inheriting methods via dominance 
 #endif
 
-class UserReviewServiceIf {
+class UserReviewServiceIf : virtual public BaseServiceIf {
  public:
   virtual ~UserReviewServiceIf() {}
   virtual void UploadUserReview(const int64_t req_id, const int64_t user_id, const int64_t review_id, const int64_t timestamp, const std::map<std::string, std::string> & carrier) = 0;
   virtual void ReadUserReviews(std::vector<Review> & _return, const int64_t req_id, const int64_t user_id, const int32_t start, const int32_t stop, const std::map<std::string, std::string> & carrier) = 0;
 };
 
-class UserReviewServiceIfFactory {
+class UserReviewServiceIfFactory : virtual public BaseServiceIfFactory {
  public:
   typedef UserReviewServiceIf Handler;
 
   virtual ~UserReviewServiceIfFactory() {}
 
   virtual UserReviewServiceIf* getHandler(const ::apache::thrift::TConnectionInfo& connInfo) = 0;
-  virtual void releaseHandler(UserReviewServiceIf* /* handler */) = 0;
+  virtual void releaseHandler(BaseServiceIf* /* handler */) = 0;
 };
 
 class UserReviewServiceIfSingletonFactory : virtual public UserReviewServiceIfFactory {
@@ -43,13 +44,13 @@ class UserReviewServiceIfSingletonFactory : virtual public UserReviewServiceIfFa
   virtual UserReviewServiceIf* getHandler(const ::apache::thrift::TConnectionInfo&) {
     return iface_.get();
   }
-  virtual void releaseHandler(UserReviewServiceIf* /* handler */) {}
+  virtual void releaseHandler(BaseServiceIf* /* handler */) {}
 
  protected:
   ::apache::thrift::stdcxx::shared_ptr<UserReviewServiceIf> iface_;
 };
 
-class UserReviewServiceNull : virtual public UserReviewServiceIf {
+class UserReviewServiceNull : virtual public UserReviewServiceIf , virtual public BaseServiceNull {
  public:
   virtual ~UserReviewServiceNull() {}
   void UploadUserReview(const int64_t /* req_id */, const int64_t /* user_id */, const int64_t /* review_id */, const int64_t /* timestamp */, const std::map<std::string, std::string> & /* carrier */) {
@@ -332,45 +333,20 @@ class UserReviewService_ReadUserReviews_presult {
 
 };
 
-class UserReviewServiceClient : virtual public UserReviewServiceIf {
+class UserReviewServiceClient : virtual public UserReviewServiceIf, public BaseServiceClient {
  public:
-  UserReviewServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-    setProtocol(prot);
-  }
-  UserReviewServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    setProtocol(iprot,oprot);
-  }
- private:
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-  setProtocol(prot,prot);
-  }
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    piprot_=iprot;
-    poprot_=oprot;
-    iprot_ = iprot.get();
-    oprot_ = oprot.get();
-  }
- public:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getInputProtocol() {
-    return piprot_;
-  }
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getOutputProtocol() {
-    return poprot_;
-  }
+  UserReviewServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) :
+    BaseServiceClient(prot, prot) {}
+  UserReviewServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) :    BaseServiceClient(iprot, oprot) {}
   void UploadUserReview(const int64_t req_id, const int64_t user_id, const int64_t review_id, const int64_t timestamp, const std::map<std::string, std::string> & carrier);
   void send_UploadUserReview(const int64_t req_id, const int64_t user_id, const int64_t review_id, const int64_t timestamp, const std::map<std::string, std::string> & carrier);
   void recv_UploadUserReview();
   void ReadUserReviews(std::vector<Review> & _return, const int64_t req_id, const int64_t user_id, const int32_t start, const int32_t stop, const std::map<std::string, std::string> & carrier);
   void send_ReadUserReviews(const int64_t req_id, const int64_t user_id, const int32_t start, const int32_t stop, const std::map<std::string, std::string> & carrier);
   void recv_ReadUserReviews(std::vector<Review> & _return);
- protected:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> piprot_;
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> poprot_;
-  ::apache::thrift::protocol::TProtocol* iprot_;
-  ::apache::thrift::protocol::TProtocol* oprot_;
 };
 
-class UserReviewServiceProcessor : public ::apache::thrift::TDispatchProcessor {
+class UserReviewServiceProcessor : public BaseServiceProcessor {
  protected:
   ::apache::thrift::stdcxx::shared_ptr<UserReviewServiceIf> iface_;
   virtual bool dispatchCall(::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, const std::string& fname, int32_t seqid, void* callContext);
@@ -382,6 +358,7 @@ class UserReviewServiceProcessor : public ::apache::thrift::TDispatchProcessor {
   void process_ReadUserReviews(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext);
  public:
   UserReviewServiceProcessor(::apache::thrift::stdcxx::shared_ptr<UserReviewServiceIf> iface) :
+    BaseServiceProcessor(iface),
     iface_(iface) {
     processMap_["UploadUserReview"] = &UserReviewServiceProcessor::process_UploadUserReview;
     processMap_["ReadUserReviews"] = &UserReviewServiceProcessor::process_ReadUserReviews;
@@ -401,9 +378,13 @@ class UserReviewServiceProcessorFactory : public ::apache::thrift::TProcessorFac
   ::apache::thrift::stdcxx::shared_ptr< UserReviewServiceIfFactory > handlerFactory_;
 };
 
-class UserReviewServiceMultiface : virtual public UserReviewServiceIf {
+class UserReviewServiceMultiface : virtual public UserReviewServiceIf, public BaseServiceMultiface {
  public:
   UserReviewServiceMultiface(std::vector<apache::thrift::stdcxx::shared_ptr<UserReviewServiceIf> >& ifaces) : ifaces_(ifaces) {
+    std::vector<apache::thrift::stdcxx::shared_ptr<UserReviewServiceIf> >::iterator iter;
+    for (iter = ifaces.begin(); iter != ifaces.end(); ++iter) {
+      BaseServiceMultiface::add(*iter);
+    }
   }
   virtual ~UserReviewServiceMultiface() {}
  protected:
@@ -437,43 +418,17 @@ class UserReviewServiceMultiface : virtual public UserReviewServiceIf {
 // The 'concurrent' client is a thread safe client that correctly handles
 // out of order responses.  It is slower than the regular client, so should
 // only be used when you need to share a connection among multiple threads
-class UserReviewServiceConcurrentClient : virtual public UserReviewServiceIf {
+class UserReviewServiceConcurrentClient : virtual public UserReviewServiceIf, public BaseServiceConcurrentClient {
  public:
-  UserReviewServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-    setProtocol(prot);
-  }
-  UserReviewServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    setProtocol(iprot,oprot);
-  }
- private:
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-  setProtocol(prot,prot);
-  }
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    piprot_=iprot;
-    poprot_=oprot;
-    iprot_ = iprot.get();
-    oprot_ = oprot.get();
-  }
- public:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getInputProtocol() {
-    return piprot_;
-  }
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getOutputProtocol() {
-    return poprot_;
-  }
+  UserReviewServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) :
+    BaseServiceConcurrentClient(prot, prot) {}
+  UserReviewServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) :    BaseServiceConcurrentClient(iprot, oprot) {}
   void UploadUserReview(const int64_t req_id, const int64_t user_id, const int64_t review_id, const int64_t timestamp, const std::map<std::string, std::string> & carrier);
   int32_t send_UploadUserReview(const int64_t req_id, const int64_t user_id, const int64_t review_id, const int64_t timestamp, const std::map<std::string, std::string> & carrier);
   void recv_UploadUserReview(const int32_t seqid);
   void ReadUserReviews(std::vector<Review> & _return, const int64_t req_id, const int64_t user_id, const int32_t start, const int32_t stop, const std::map<std::string, std::string> & carrier);
   int32_t send_ReadUserReviews(const int64_t req_id, const int64_t user_id, const int32_t start, const int32_t stop, const std::map<std::string, std::string> & carrier);
   void recv_ReadUserReviews(std::vector<Review> & _return, const int32_t seqid);
- protected:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> piprot_;
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> poprot_;
-  ::apache::thrift::protocol::TProtocol* iprot_;
-  ::apache::thrift::protocol::TProtocol* oprot_;
-  ::apache::thrift::async::TConcurrentClientSyncInfo sync_;
 };
 
 #ifdef _MSC_VER
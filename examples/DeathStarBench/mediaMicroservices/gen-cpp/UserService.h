@@ -10,6 +10,7 @@
 #include <thrift/TDispatchProcessor.h>
 #include <thrift/async/TConcurrentClientSyncInfo.h>
 #include "media_service_types.h"
+#include "BaseService.h"
 
 namespace media_service {
 
@@ -18,7 +19,7 @@ namespace media_service {
   #pragma warning (disable : 4250 ) //inheriting methods via dominance 
 #endif
 
-class UserServiceIf {
+class UserServiceIf : virtual public BaseServiceIf {
  public:
   virtual ~UserServiceIf() {}
   virtual void RegisterUser(const int64_t req_id, const std::string& first_name, const std::string& last_name, const std::string& username, const std::string& password, const std::map<std::string, std::string> & carrier) = 0;
@@ -26,16 +27,17 @@ class UserServiceIf {
   virtual void Login(std::string& _return, const int64_t req_id, const std::string& username, const std::string& password, const std::map<std::string, std::string> & carrier) = 0;
   virtual void UploadUserWithUserId(const int64_t req_id, const int64_t user_id, const std::map<std::string, std::string> & carrier) = 0;
   virtual void UploadUserWithUsername(const int64_t req_id, const std::string& username, const std::map<std::string, std::string> & carrier) = 0;
+  virtual int64_t VerifyToken(const int64_t req_id, const std::string& token, const std::map<std::string, std::string> & carrier) = 0;
 };
 
-class UserServiceIfFactory {
+class UserServiceIfFactory : virtual public BaseServiceIfFactory {
  public:
   typedef UserServiceIf Handler;
 
   virtual ~UserServiceIfFactory() {}
 
   virtual UserServiceIf* getHandler(const ::apache::thrift::TConnectionInfo& connInfo) = 0;
-  virtual void releaseHandler(UserServiceIf* /* handler */) = 0;
+  virtual void releaseHandler(BaseServiceIf* /* handler */) = 0;
 };
 
 class UserServiceIfSingletonFactory : virtual public UserServiceIfFactory {
@@ -46,13 +48,13 @@ class UserServiceIfSingletonFactory : virtual public UserServiceIfFactory {
   virtual UserServiceIf* getHandler(const ::apache::thrift::TConnectionInfo&) {
     return iface_.get();
   }
-  virtual void releaseHandler(UserServiceIf* /* handler */) {}
+  virtual void releaseHandler(BaseServiceIf* /* handler */) {}
 
  protected:
   ::apache::thrift::stdcxx::shared_ptr<UserServiceIf> iface_;
 };
 
-class UserServiceNull : virtual public UserServiceIf {
+class UserServiceNull : virtual public UserServiceIf , virtual public BaseServiceNull {
  public:
   virtual ~UserServiceNull() {}
   void RegisterUser(const int64_t /* req_id */, const std::string& /* first_name */, const std::string& /* last_name */, const std::string& /* username */, const std::string& /* password */, const std::map<std::string, std::string> & /* carrier */) {
@@ -70,6 +72,10 @@ class UserServiceNull : virtual public UserServiceIf {
   void UploadUserWithUsername(const int64_t /* req_id */, const std::string& /* username */, const std::map<std::string, std::string> & /* carrier */) {
     return;
   }
+  int64_t VerifyToken(const int64_t /* req_id */, const std::string& /* token */, const std::map<std::string, std::string> & /* carrier */) {
+    int64_t _return = 0;
+    return _return;
+  }
 };
 
 typedef struct _UserService_RegisterUser_args__isset {
@@ -726,31 +732,137 @@ class UserService_UploadUserWithUsername_presult {
 
 };
 
-class UserServiceClient : virtual public UserServiceIf {
+typedef struct _UserService_VerifyToken_args__isset {
+  _UserService_VerifyToken_args__isset() : req_id(false), token(false), carrier(false) {}
+  bool req_id :1;
+  bool token :1;
+  bool carrier :1;
+} _UserService_VerifyToken_args__isset;
+
+class UserService_VerifyToken_args {
  public:
-  UserServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-    setProtocol(prot);
-  }
-  UserServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    setProtocol(iprot,oprot);
+
+  UserService_VerifyToken_args(const UserService_VerifyToken_args&);
+  UserService_VerifyToken_args& operator=(const UserService_VerifyToken_args&);
+  UserService_VerifyToken_args() : req_id(0), token() {
   }
- private:
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-  setProtocol(prot,prot);
+
+  virtual ~UserService_VerifyToken_args() throw();
+  int64_t req_id;
+  std::string token;
+  std::map<std::string, std::string>  carrier;
+
+  _UserService_VerifyToken_args__isset __isset;
+
+  void __set_req_id(const int64_t val);
+
+  void __set_token(const std::string& val);
+
+  void __set_carrier(const std::map<std::string, std::string> & val);
+
+  bool operator == (const UserService_VerifyToken_args & rhs) const
+  {
+    if (!(req_id == rhs.req_id))
+      return false;
+    if (!(token == rhs.token))
+      return false;
+    if (!(carrier == rhs.carrier))
+      return false;
+    return true;
   }
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    piprot_=iprot;
-    poprot_=oprot;
-    iprot_ = iprot.get();
-    oprot_ = oprot.get();
+  bool operator != (const UserService_VerifyToken_args &rhs) const {
+    return !(*this == rhs);
   }
+
+  bool operator < (const UserService_VerifyToken_args & ) const;
+
+  uint32_t read(::apache::thrift::protocol::TProtocol* iprot);
+  uint32_t write(::apache::thrift::protocol::TProtocol* oprot) const;
+
+};
+
+
+class UserService_VerifyToken_pargs {
  public:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getInputProtocol() {
-    return piprot_;
+
+
+  virtual ~UserService_VerifyToken_pargs() throw();
+  const int64_t* req_id;
+  const std::string* token;
+  const std::map<std::string, std::string> * carrier;
+
+  uint32_t write(::apache::thrift::protocol::TProtocol* oprot) const;
+
+};
+
+typedef struct _UserService_VerifyToken_result__isset {
+  _UserService_VerifyToken_result__isset() : success(false), se(false) {}
+  bool success :1;
+  bool se :1;
+} _UserService_VerifyToken_result__isset;
+
+class UserService_VerifyToken_result {
+ public:
+
+  UserService_VerifyToken_result(const UserService_VerifyToken_result&);
+  UserService_VerifyToken_result& operator=(const UserService_VerifyToken_result&);
+  UserService_VerifyToken_result() : success(0) {
+  }
+
+  virtual ~UserService_VerifyToken_result() throw();
+  int64_t success;
+  ServiceException se;
+
+  _UserService_VerifyToken_result__isset __isset;
+
+  void __set_success(const int64_t val);
+
+  void __set_se(const ServiceException& val);
+
+  bool operator == (const UserService_VerifyToken_result & rhs) const
+  {
+    if (!(success == rhs.success))
+      return false;
+    if (!(se == rhs.se))
+      return false;
+    return true;
   }
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getOutputProtocol() {
-    return poprot_;
+  bool operator != (const UserService_VerifyToken_result &rhs) const {
+    return !(*this == rhs);
   }
+
+  bool operator < (const UserService_VerifyToken_result & ) const;
+
+  uint32_t read(::apache::thrift::protocol::TProtocol* iprot);
+  uint32_t write(::apache::thrift::protocol::TProtocol* oprot) const;
+
+};
+
+typedef struct _UserService_VerifyToken_presult__isset {
+  _UserService_VerifyToken_presult__isset() : success(false), se(false) {}
+  bool success :1;
+  bool se :1;
+} _UserService_VerifyToken_presult__isset;
+
+class UserService_VerifyToken_presult {
+ public:
+
+
+  virtual ~UserService_VerifyToken_presult() throw();
+  int64_t* success;
+  ServiceException se;
+
+  _UserService_VerifyToken_presult__isset __isset;
+
+  uint32_t read(::apache::thrift::protocol::TProtocol* iprot);
+
+};
+
+class UserServiceClient : virtual public UserServiceIf, public BaseServiceClient {
+ public:
+  UserServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) :
+    BaseServiceClient(prot, prot) {}
+  UserServiceClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) :    BaseServiceClient(iprot, oprot) {}
   void RegisterUser(const int64_t req_id, const std::string& first_name, const std::string& last_name, const std::string& username, const std::string& password, const std::map<std::string, std::string> & carrier);
   void send_RegisterUser(const int64_t req_id, const std::string& first_name, const std::string& last_name, const std::string& username, const std::string& password, const std::map<std::string, std::string> & carrier);
   void recv_RegisterUser();
@@ -766,14 +878,12 @@ class UserServiceClient : virtual public UserServiceIf {
   void UploadUserWithUsername(const int64_t req_id, const std::string& username, const std::map<std::string, std::string> & carrier);
   void send_UploadUserWithUsername(const int64_t req_id, const std::string& username, const std::map<std::string, std::string> & carrier);
   void recv_UploadUserWithUsername();
- protected:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> piprot_;
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> poprot_;
-  ::apache::thrift::protocol::TProtocol* iprot_;
-  ::apache::thrift::protocol::TProtocol* oprot_;
+  int64_t VerifyToken(const int64_t req_id, const std::string& token, const std::map<std::string, std::string> & carrier);
+  void send_VerifyToken(const int64_t req_id, const std::string& token, const std::map<std::string, std::string> & carrier);
+  int64_t recv_VerifyToken();
 };
 
-class UserServiceProcessor : public ::apache::thrift::TDispatchProcessor {
+class UserServiceProcessor : public BaseServiceProcessor {
  protected:
   ::apache::thrift::stdcxx::shared_ptr<UserServiceIf> iface_;
   virtual bool dispatchCall(::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, const std::string& fname, int32_t seqid, void* callContext);
@@ -786,14 +896,17 @@ class UserServiceProcessor : public ::apache::thrift::TDispatchProcessor {
   void process_Login(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext);
   void process_UploadUserWithUserId(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext);
   void process_UploadUserWithUsername(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext);
+  void process_VerifyToken(int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, ::apache::thrift::protocol::TProtocol* oprot, void* callContext);
  public:
   UserServiceProcessor(::apache::thrift::stdcxx::shared_ptr<UserServiceIf> iface) :
+    BaseServiceProcessor(iface),
     iface_(iface) {
     processMap_["RegisterUser"] = &UserServiceProcessor::process_RegisterUser;
     processMap_["RegisterUserWithId"] = &UserServiceProcessor::process_RegisterUserWithId;
     processMap_["Login"] = &UserServiceProcessor::process_Login;
     processMap_["UploadUserWithUserId"] = &UserServiceProcessor::process_UploadUserWithUserId;
     processMap_["UploadUserWithUsername"] = &UserServiceProcessor::process_UploadUserWithUsername;
+    processMap_["VerifyToken"] = &UserServiceProcessor::process_VerifyToken;
   }
 
   virtual ~UserServiceProcessor() {}
@@ -810,9 +923,13 @@ class UserServiceProcessorFactory : public ::apache::thrift::TProcessorFactory {
   ::apache::thrift::stdcxx::shared_ptr< UserServiceIfFactory > handlerFactory_;
 };
 
-class UserServiceMultiface : virtual public UserServiceIf {
+class UserServiceMultiface : virtual public UserServiceIf, public BaseServiceMultiface {
  public:
   UserServiceMultiface(std::vector<apache::thrift::stdcxx::shared_ptr<UserServiceIf> >& ifaces) : ifaces_(ifaces) {
+    std::vector<apache::thrift::stdcxx::shared_ptr<UserServiceIf> >::iterator iter;
+    for (iter = ifaces.begin(); iter != ifaces.end(); ++iter) {
+      BaseServiceMultiface::add(*iter);
+    }
   }
   virtual ~UserServiceMultiface() {}
  protected:
@@ -868,36 +985,25 @@ class UserServiceMultiface : virtual public UserServiceIf {
     ifaces_[i]->UploadUserWithUsername(req_id, username, carrier);
   }
 
+  int64_t VerifyToken(const int64_t req_id, const std::string& token, const std::map<std::string, std::string> & carrier) {
+    size_t sz = ifaces_.size();
+    size_t i = 0;
+    for (; i < (sz - 1); ++i) {
+      ifaces_[i]->VerifyToken(req_id, token, carrier);
+    }
+    return ifaces_[i]->VerifyToken(req_id, token, carrier);
+  }
+
 };
 
 // The 'concurrent' client is a thread safe client that correctly handles
 // out of order responses.  It is slower than the regular client, so should
 // only be used when you need to share a connection among multiple threads
-class UserServiceConcurrentClient : virtual public UserServiceIf {
- public:
-  UserServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-    setProtocol(prot);
-  }
-  UserServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    setProtocol(iprot,oprot);
-  }
- private:
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) {
-  setProtocol(prot,prot);
-  }
-  void setProtocol(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) {
-    piprot_=iprot;
-    poprot_=oprot;
-    iprot_ = iprot.get();
-    oprot_ = oprot.get();
-  }
+class UserServiceConcurrentClient : virtual public UserServiceIf, public BaseServiceConcurrentClient {
  public:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getInputProtocol() {
-    return piprot_;
-  }
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> getOutputProtocol() {
-    return poprot_;
-  }
+  UserServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> prot) :
+    BaseServiceConcurrentClient(prot, prot) {}
+  UserServiceConcurrentClient(apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> iprot, apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> oprot) :    BaseServiceConcurrentClient(iprot, oprot) {}
   void RegisterUser(const int64_t req_id, const std::string& first_name, const std::string& last_name, const std::string& username, const std::string& password, const std::map<std::string, std::string> & carrier);
   int32_t send_RegisterUser(const int64_t req_id, const std::string& first_name, const std::string& last_name, const std::string& username, const std::string& password, const std::map<std::string, std::string> & carrier);
   void recv_RegisterUser(const int32_t seqid);
@@ -913,12 +1019,9 @@ class UserServiceConcurrentClient : virtual public UserServiceIf {
   void UploadUserWithUsername(const int64_t req_id, const std::string& username, const std::map<std::string, std::string> & carrier);
   int32_t send_UploadUserWithUsername(const int64_t req_id, const std::string& username, const std::map<std::string, std::string> & carrier);
   void recv_UploadUserWithUsername(const int32_t seqid);
- protected:
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> piprot_;
-  apache::thrift::stdcxx::shared_ptr< ::apache::thrift::protocol::TProtocol> poprot_;
-  ::apache::thrift::protocol::TProtocol* iprot_;
-  ::apache::thrift::protocol::TProtocol* oprot_;
-  ::apache::thrift::async::TConcurrentClientSyncInfo sync_;
+  int64_t VerifyToken(const int64_t req_id, const std::string& token, const std::map<std::string, std::string> & carrier);
+  int32_t send_VerifyToken(const int64_t req_id, const std::string& token, const std::map<std::string, std::string> & carrier);
+  int64_t recv_VerifyToken(const int32_t seqid);
 };
 
 #ifdef _MSC_VER
@@ -45,6 +45,11 @@ class UserServiceHandler : virtual public UserServiceIf {
     printf("UploadUserWithUsername\n");
   }
 
+  int64_t VerifyToken(const int64_t req_id, const std::string& token, const std::map<std::string, std::string> & carrier) {
+    // Your implementation goes here
+    printf("VerifyToken\n");
+  }
+
 };
 
 int main(int argc, char **argv) {
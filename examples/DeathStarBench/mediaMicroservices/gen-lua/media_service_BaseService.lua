@@ -0,0 +1,146 @@
+--
+-- Autogenerated by Thrift
+--
+-- DO NOT EDIT UNLESS YOU ARE SURE THAT YOU KNOW WHAT YOU ARE DOING
+-- @generated
+--
+
+
+local Thrift = require 'Thrift'
+local TType = Thrift.TType
+local TMessageType = Thrift.TMessageType
+local __TObject = Thrift.__TObject
+local TApplicationException = Thrift.TApplicationException
+local __TClient = Thrift.__TClient
+local __TProcessor = Thrift.__TProcessor
+local ttype = Thrift.ttype
+local ttable_size = Thrift.ttable_size
+local media_service_ttypes = require 'media_service_ttypes'
+
+-- HELPER FUNCTIONS AND STRUCTURES
+
+local Ping_args = __TObject:new{
+
+}
+
+function Ping_args:read(iprot)
+  iprot:readStructBegin()
+  while true do
+    local fname, ftype, fid = iprot:readFieldBegin()
+    if ftype == TType.STOP then
+      break
+    else
+      iprot:skip(ftype)
+    end
+    iprot:readFieldEnd()
+  end
+  iprot:readStructEnd()
+end
+
+function Ping_args:write(oprot)
+  oprot:writeStructBegin('Ping_args')
+  oprot:writeFieldStop()
+  oprot:writeStructEnd()
+end
+
+local Ping_result = __TObject:new{
+
+}
+
+function Ping_result:read(iprot)
+  iprot:readStructBegin()
+  while true do
+    local fname, ftype, fid = iprot:readFieldBegin()
+    if ftype == TType.STOP then
+      break
+    else
+      iprot:skip(ftype)
+    end
+    iprot:readFieldEnd()
+  end
+  iprot:readStructEnd()
+end
+
+function Ping_result:write(oprot)
+  oprot:writeStructBegin('Ping_result')
+  oprot:writeFieldStop()
+  oprot:writeStructEnd()
+end
+
+local BaseServiceClient = __TObject.new(__TClient, {
+  __type = 'BaseServiceClient'
+})
+
+function BaseServiceClient:Ping()
+  self:send_Ping()
+  self:recv_Ping()
+end
+
+function BaseServiceClient:send_Ping()
+  self.oprot:writeMessageBegin('Ping', TMessageType.CALL, self._seqid)
+  local args = Ping_args:new{}
+  args:write(self.oprot)
+  self.oprot:writeMessageEnd()
+  self.oprot.trans:flush()
+end
+
+function BaseServiceClient:recv_Ping()
+  local fname, mtype, rseqid = self.iprot:readMessageBegin()
+  if mtype == TMessageType.EXCEPTION then
+    local x = TApplicationException:new{}
+    x:read(self.iprot)
+    self.iprot:readMessageEnd()
+    error(x)
+  end
+  local result = Ping_result:new{}
+  result:read(self.iprot)
+  self.iprot:readMessageEnd()
+end
+local BaseServiceIface = __TObject:new{
+  __type = 'BaseServiceIface'
+}
+
+
+local BaseServiceProcessor = __TObject.new(__TProcessor
+, {
+ __type = 'BaseServiceProcessor'
+})
+
+function BaseServiceProcessor:process(iprot, oprot, server_ctx)
+  local name, mtype, seqid = iprot:readMessageBegin()
+  local func_name = 'process_' .. name
+  if not self[func_name] or ttype(self[func_name]) ~= 'function' then
+    iprot:skip(TType.STRUCT)
+    iprot:readMessageEnd()
+    x = TApplicationException:new{
+      errorCode = TApplicationException.UNKNOWN_METHOD
+    }
+    oprot:writeMessageBegin(name, TMessageType.EXCEPTION, seqid)
+    x:write(oprot)
+    oprot:writeMessageEnd()
+    oprot.trans:flush()
+  else
+    self[func_name](self, seqid, iprot, oprot, server_ctx)
+  end
+end
+
+function BaseServiceProcessor:process_Ping(seqid, iprot, oprot, server_ctx)
+  local args = Ping_args:new{}
+  local reply_type = TMessageType.REPLY
+  args:read(iprot)
+  iprot:readMessageEnd()
+  local result = Ping_result:new{}
+  local status, res = pcall(self.handler.Ping, self.handler)
+  if not status then
+    reply_type = TMessageType.EXCEPTION
+    result = TApplicationException:new{message = res}
+  else
+    result.success = res
+  end
+  oprot:writeMessageBegin('Ping', reply_type, seqid)
+  result:write(oprot)
+  oprot:writeMessageEnd()
+  oprot.trans:flush()
+end
+
+return BaseServiceClient
\ No newline at end of file
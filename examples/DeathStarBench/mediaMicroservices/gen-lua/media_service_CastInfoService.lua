@@ -16,6 +16,7 @@ local __TProcessor = Thrift.__TProcessor
 local ttype = Thrift.ttype
 local ttable_size = Thrift.ttable_size
 local media_service_ttypes = require 'media_service_ttypes'
+local BaseServiceClient = require 'media_service_BaseService'
 local ServiceException = media_service_ttypes.ServiceException
 local CastInfo = media_service_ttypes.CastInfo
 
@@ -304,7 +305,7 @@ function ReadCastInfo_result:write(oprot)
   oprot:writeStructEnd()
 end
 
-local CastInfoServiceClient = __TObject.new(__TClient, {
+local CastInfoServiceClient = __TObject.new(BaseServiceClient, {
   __type = 'CastInfoServiceClient'
 })
 
@@ -8,8 +8,9 @@
 
 require 'Thrift'
 require 'media_service_ttypes'
+local BaseServiceClient = require 'media_service_BaseService'
 
-ComposeReviewServiceClient = __TObject.new(__TClient, {
+ComposeReviewServiceClient = __TObject.new(BaseServiceClient, {
   __type = 'ComposeReviewServiceClient'
 })
 
@@ -15,6 +15,7 @@ local __TProcessor = Thrift.__TProcessor
 local ttype = Thrift.ttype
 local ttable_size = Thrift.ttable_size
 local media_service_ttypes = require 'media_service_ttypes'
+local BaseServiceClient = require 'media_service_BaseService'
 local ServiceException = media_service_ttypes.ServiceException
 
 -- HELPER FUNCTIONS AND STRUCTURES
@@ -257,7 +258,7 @@ function RegisterMovieId_result:write(oprot)
   oprot:writeStructEnd()
 end
 
-local MovieIdServiceClient = __TObject.new(__TClient, {
+local MovieIdServiceClient = __TObject.new(BaseServiceClient, {
   __type = 'MovieIdServiceClient'
 })
 
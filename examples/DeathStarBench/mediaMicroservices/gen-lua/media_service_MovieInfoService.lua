@@ -16,6 +16,7 @@ local __TProcessor = Thrift.__TProcessor
 local ttype = Thrift.ttype
 local ttable_size = Thrift.ttable_size
 local media_service_ttypes = require 'media_service_ttypes'
+local BaseServiceClient = require 'media_service_BaseService'
 local ServiceException = media_service_ttypes.ServiceException
 local MovieInfo = media_service_ttypes.MovieInfo
 local Cast = media_service_ttypes.Cast
@@ -517,7 +518,7 @@ function UpdateRating_result:write(oprot)
   oprot:writeStructEnd()
 end
 
-local MovieInfoServiceClient = __TObject.new(__TClient, {
+local MovieInfoServiceClient = __TObject.new(BaseServiceClient, {
   __type = 'MovieInfoServiceClient'
 })
 
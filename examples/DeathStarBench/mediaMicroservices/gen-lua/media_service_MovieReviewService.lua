@@ -16,6 +16,7 @@ local __TProcessor = Thrift.__TProcessor
 local ttype = Thrift.ttype
 local ttable_size = Thrift.ttable_size
 local media_service_ttypes = require 'media_service_ttypes'
+local BaseServiceClient = require 'media_service_BaseService'
 local ServiceException = media_service_ttypes.ServiceException
 local Review = media_service_ttypes.Review
 
@@ -306,7 +307,7 @@ function ReadMovieReviews_result:write(oprot)
   oprot:writeStructEnd()
 end
 
-local MovieReviewServiceClient = __TObject.new(__TClient, {
+local MovieReviewServiceClient = __TObject.new(BaseServiceClient, {
   __type = 'MovieReviewServiceClient'
 })
 
@@ -16,6 +16,7 @@ local __TProcessor = Thrift.__TProcessor
 local ttype = Thrift.ttype
 local ttable_size = Thrift.ttable_size
 local media_service_ttypes = require 'media_service_ttypes'
+local BaseServiceClient = require 'media_service_BaseService'
 local ServiceException = media_service_ttypes.ServiceException
 local Page = media_service_ttypes.Page
 
@@ -165,7 +166,7 @@ function ReadPage_result:write(oprot)
   oprot:writeStructEnd()
 end
 
-local PageServiceClient = __TObject.new(__TClient, {
+local PageServiceClient = __TObject.new(BaseServiceClient, {
   __type = 'PageServiceClient'
 })
 
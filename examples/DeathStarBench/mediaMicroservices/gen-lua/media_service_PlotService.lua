@@ -16,6 +16,7 @@ local __TProcessor = Thrift.__TProcessor
 local ttype = Thrift.ttype
 local ttable_size = Thrift.ttable_size
 local media_service_ttypes = require 'media_service_ttypes'
+local BaseServiceClient = require 'media_service_BaseService'
 local ServiceException = media_service_ttypes.ServiceException
 
 -- HELPER FUNCTIONS AND STRUCTURES
@@ -258,7 +259,7 @@ function ReadPlot_result:write(oprot)
   oprot:writeStructEnd()
 end
 
-local PlotServiceClient = __TObject.new(__TClient, {
+local PlotServiceClient = __TObject.new(BaseServiceClient, {
   __type = 'PlotServiceClient'
 })
 
@@ -8,8 +8,9 @@
 
 require 'Thrift'
 require 'media_service_ttypes'
+local BaseServiceClient = require 'media_service_BaseService'
 
-RatingServiceClient = __TObject.new(__TClient, {
+RatingServiceClient = __TObject.new(BaseServiceClient, {
   __type = 'RatingServiceClient'
 })
 
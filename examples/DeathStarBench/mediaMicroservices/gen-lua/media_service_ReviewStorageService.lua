@@ -8,8 +8,9 @@
 
 require 'Thrift'
 require 'media_service_ttypes'
+local BaseServiceClient = require 'media_service_BaseService'
 
-ReviewStorageServiceClient = __TObject.new(__TClient, {
+ReviewStorageServiceClient = __TObject.new(BaseServiceClient, {
   __type = 'ReviewStorageServiceClient'
 })
 
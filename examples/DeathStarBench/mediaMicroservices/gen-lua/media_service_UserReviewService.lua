@@ -16,6 +16,7 @@ local __TProcessor = Thrift.__TProcessor
 local ttype = Thrift.ttype
 local ttable_size = Thrift.ttable_size
 local media_service_ttypes = require 'media_service_ttypes'
+local BaseServiceClient = require 'media_service_BaseService'
 local ServiceException = media_service_ttypes.ServiceException
 local Review = media_service_ttypes.Review
 
@@ -306,7 +307,7 @@ function ReadUserReviews_result:write(oprot)
   oprot:writeStructEnd()
 end
 
-local UserReviewServiceClient = __TObject.new(__TClient, {
+local UserReviewServiceClient = __TObject.new(BaseServiceClient, {
   __type = 'UserReviewServiceClient'
 })
 
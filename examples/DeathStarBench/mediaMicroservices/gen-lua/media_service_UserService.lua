@@ -16,6 +16,7 @@ local __TProcessor = Thrift.__TProcessor
 local ttype = Thrift.ttype
 local ttable_size = Thrift.ttable_size
 local media_service_ttypes = require 'media_service_ttypes'
+local BaseServiceClient = require 'media_service_BaseService'
 local ServiceException = media_service_ttypes.ServiceException
 
 -- HELPER FUNCTIONS AND STRUCTURES
@@ -663,7 +664,126 @@ function UploadUserWithUsername_result:write(oprot)
   oprot:writeStructEnd()
 end
 
-local UserServiceClient = __TObject.new(__TClient, {
+local VerifyToken_args = __TObject:new{
+  req_id,
+  token,
+  carrier
+}
+
+function VerifyToken_args:read(iprot)
+  iprot:readStructBegin()
+  while true do
+    local fname, ftype, fid = iprot:readFieldBegin()
+    if ftype == TType.STOP then
+      break
+    elseif fid == 1 then
+      if ftype == TType.I64 then
+        self.req_id = iprot:readI64()
+      else
+        iprot:skip(ftype)
+      end
+    elseif fid == 2 then
+      if ftype == TType.STRING then
+        self.token = iprot:readString()
+      else
+        iprot:skip(ftype)
+      end
+    elseif fid == 3 then
+      if ftype == TType.MAP then
+        self.carrier = {}
+        local _ktype117, _vtype118, _size116 = iprot:readMapBegin()
+        for _i=1,_size116 do
+          local _key120 = iprot:readString()
+          local _val121 = iprot:readString()
+          self.carrier[_key120] = _val121
+        end
+        iprot:readMapEnd()
+      else
+        iprot:skip(ftype)
+      end
+    else
+      iprot:skip(ftype)
+    end
+    iprot:readFieldEnd()
+  end
+  iprot:readStructEnd()
+end
+
+function VerifyToken_args:write(oprot)
+  oprot:writeStructBegin('VerifyToken_args')
+  if self.req_id ~= nil then
+    oprot:writeFieldBegin('req_id', TType.I64, 1)
+    oprot:writeI64(self.req_id)
+    oprot:writeFieldEnd()
+  end
+  if self.token ~= nil then
+    oprot:writeFieldBegin('token', TType.STRING, 2)
+    oprot:writeString(self.token)
+    oprot:writeFieldEnd()
+  end
+  if self.carrier ~= nil then
+    oprot:writeFieldBegin('carrier', TType.MAP, 3)
+    oprot:writeMapBegin(TType.STRING, TType.STRING, ttable_size(self.carrier))
+    for kiter122,viter123 in pairs(self.carrier) do
+      oprot:writeString(kiter122)
+      oprot:writeString(viter123)
+    end
+    oprot:writeMapEnd()
+    oprot:writeFieldEnd()
+  end
+  oprot:writeFieldStop()
+  oprot:writeStructEnd()
+end
+
+local VerifyToken_result = __TObject:new{
+  success,
+  se
+}
+
+function VerifyToken_result:read(iprot)
+  iprot:readStructBegin()
+  while true do
+    local fname, ftype, fid = iprot:readFieldBegin()
+    if ftype == TType.STOP then
+      break
+    elseif fid == 0 then
+      if ftype == TType.I64 then
+        self.success = iprot:readI64()
+      else
+        iprot:skip(ftype)
+      end
+    elseif fid == 1 then
+      if ftype == TType.STRUCT then
+        self.se = ServiceException:new{}
+        self.se:read(iprot)
+      else
+        iprot:skip(ftype)
+      end
+    else
+      iprot:skip(ftype)
+    end
+    iprot:readFieldEnd()
+  end
+  iprot:readStructEnd()
+end
+
+function VerifyToken_result:write(oprot)
+  oprot:writeStructBegin('VerifyToken_result')
+  if self.success ~= nil then
+    oprot:writeFieldBegin('success', TType.I64, 0)
+    oprot:writeI64(self.success)
+    oprot:writeFieldEnd()
+  end
+  if self.se ~= nil then
+    oprot:writeFieldBegin('se', TType.STRUCT, 1)
+    self.se:write(oprot)
+    oprot:writeFieldEnd()
+  end
+  oprot:writeFieldStop()
+  oprot:writeStructEnd()
+end
+
+local UserServiceClient = __TObject.new(BaseServiceClient, {
   __type = 'UserServiceClient'
 })
 
@@ -838,6 +958,41 @@ function UserServiceClient:recv_UploadUserWithUsername(req_id, username, carrier
   end
 end
 
+function UserServiceClient:VerifyToken(req_id, token, carrier)
+  self:send_VerifyToken(req_id, token, carrier)
+  return self:recv_VerifyToken(req_id, token, carrier)
+end
+
+function UserServiceClient:send_VerifyToken(req_id, token, carrier)
+  self.oprot:writeMessageBegin('VerifyToken', TMessageType.CALL, self._seqid)
+  local args = VerifyToken_args:new{}
+  args.req_id = req_id
+  args.token = token
+  args.carrier = carrier
+  args:write(self.oprot)
+  self.oprot:writeMessageEnd()
+  self.oprot.trans:flush()
+end
+
+function UserServiceClient:recv_VerifyToken(req_id, token, carrier)
+  local fname, mtype, rseqid = self.iprot:readMessageBegin()
+  if mtype == TMessageType.EXCEPTION then
+    local x = TApplicationException:new{}
+    x:read(self.iprot)
+    self.iprot:readMessageEnd()
+    error(x)
+  end
+  local result = VerifyToken_result:new{}
+  result:read(self.iprot)
+  self.iprot:readMessageEnd()
+  if result.success ~= nil then
+    return result.success
+  elseif result.se then
+    error(result.se)
+  end
+  error(TApplicationException:new{errorCode = TApplicationException.MISSING_RESULT})
+end
+
 
 local UserServiceIface = __TObject:new{
   __type = 'UserServiceIface'
@@ -972,4 +1127,25 @@ function UserServiceProcessor:process_UploadUserWithUsername(seqid, iprot, oprot
   oprot.trans:flush()
 end
 
+function UserServiceProcessor:process_VerifyToken(seqid, iprot, oprot, server_ctx)
+  local args = VerifyToken_args:new{}
+  local reply_type = TMessageType.REPLY
+  args:read(iprot)
+  iprot:readMessageEnd()
+  local result = VerifyToken_result:new{}
+  local status, res = pcall(self.handler.VerifyToken, self.handler, args.req_id, args.token, args.carrier)
+  if not status then
+    reply_type = TMessageType.EXCEPTION
+    result = TApplicationException:new{message = res}
+  elseif ttype(res) == 'ServiceException' then
+    result.se = res
+  else
+    result.success = res
+  end
+  oprot:writeMessageBegin('VerifyToken', reply_type, seqid)
+  result:write(oprot)
+  oprot:writeMessageEnd()
+  oprot.trans:flush()
+end
+
 return UserServiceClient
\ No newline at end of file
@@ -11,6 +11,7 @@ from thrift.protocol.TProtocol import TProtocolException
 from thrift.TRecursive import fix_spec
 
 import sys
+import media_service.BaseService
 import logging
 from .ttypes import *
 from thrift.Thrift import TProcessor
@@ -18,7 +19,7 @@ from thrift.transport import TTransport
 all_structs = []
 
 
-class Iface(object):
+class Iface(media_service.BaseService.Iface):
     def WriteCastInfo(self, req_id, cast_info_id, name, gender, intro, carrier):
         """
         Parameters:
@@ -43,12 +44,9 @@ class Iface(object):
         pass
 
 
-class Client(Iface):
+class Client(media_service.BaseService.Client, Iface):
     def __init__(self, iprot, oprot=None):
-        self._iprot = self._oprot = iprot
-        if oprot is not None:
-            self._oprot = oprot
-        self._seqid = 0
+        media_service.BaseService.Client.__init__(self, iprot, oprot)
 
     def WriteCastInfo(self, req_id, cast_info_id, name, gender, intro, carrier):
         """
@@ -131,10 +129,9 @@ class Client(Iface):
         raise TApplicationException(TApplicationException.MISSING_RESULT, "ReadCastInfo failed: unknown result")
 
 
-class Processor(Iface, TProcessor):
+class Processor(media_service.BaseService.Processor, Iface, TProcessor):
     def __init__(self, handler):
-        self._handler = handler
-        self._processMap = {}
+        media_service.BaseService.Processor.__init__(self, handler)
         self._processMap["WriteCastInfo"] = Processor.process_WriteCastInfo
         self._processMap["ReadCastInfo"] = Processor.process_ReadCastInfo
 
@@ -11,6 +11,7 @@ from thrift.protocol.TProtocol import TProtocolException
 from thrift.TRecursive import fix_spec
 
 import sys
+import media_service.BaseService
 import logging
 from .ttypes import *
 from thrift.Thrift import TProcessor
@@ -18,7 +19,7 @@ from thrift.transport import TTransport
 all_structs = []
 
 
-class Iface(object):
+class Iface(media_service.BaseService.Iface):
     def UploadMovieId(self, req_id, title, rating, carrier):
         """
         Parameters:
@@ -42,12 +43,9 @@ class Iface(object):
         pass
 
 
-class Client(Iface):
+class Client(media_service.BaseService.Client, Iface):
     def __init__(self, iprot, oprot=None):
-        self._iprot = self._oprot = iprot
-        if oprot is not None:
-            self._oprot = oprot
-        self._seqid = 0
+        media_service.BaseService.Client.__init__(self, iprot, oprot)
 
     def UploadMovieId(self, req_id, title, rating, carrier):
         """
@@ -126,10 +124,9 @@ class Client(Iface):
         return
 
 
-class Processor(Iface, TProcessor):
+class Processor(media_service.BaseService.Processor, Iface, TProcessor):
     def __init__(self, handler):
-        self._handler = handler
-        self._processMap = {}
+        media_service.BaseService.Processor.__init__(self, handler)
         self._processMap["UploadMovieId"] = Processor.process_UploadMovieId
         self._processMap["RegisterMovieId"] = Processor.process_RegisterMovieId
 
@@ -11,6 +11,7 @@ from thrift.protocol.TProtocol import TProtocolException
 from thrift.TRecursive import fix_spec
 
 import sys
+import media_service.BaseService
 import logging
 from .ttypes import *
 from thrift.Thrift import TProcessor
@@ -18,7 +19,7 @@ from thrift.transport import TTransport
 all_structs = []
 
 
-class Iface(object):
+class Iface(media_service.BaseService.Iface):
     def WriteMovieInfo(self, req_id, movie_id, title, casts, plot_id, thumbnail_ids, photo_ids, video_ids, avg_rating, num_rating, carrier):
         """
         Parameters:
@@ -60,12 +61,9 @@ class Iface(object):
         pass
 
 
-class Client(Iface):
+class Client(media_service.BaseService.Client, Iface):
     def __init__(self, iprot, oprot=None):
-        self._iprot = self._oprot = iprot
-        if oprot is not None:
-            self._oprot = oprot
-        self._seqid = 0
+        media_service.BaseService.Client.__init__(self, iprot, oprot)
 
     def WriteMovieInfo(self, req_id, movie_id, title, casts, plot_id, thumbnail_ids, photo_ids, video_ids, avg_rating, num_rating, carrier):
         """
@@ -198,10 +196,9 @@ class Client(Iface):
         return
 
 
-class Processor(Iface, TProcessor):
+class Processor(media_service.BaseService.Processor, Iface, TProcessor):
     def __init__(self, handler):
-        self._handler = handler
-        self._processMap = {}
+        media_service.BaseService.Processor.__init__(self, handler)
         self._processMap["WriteMovieInfo"] = Processor.process_WriteMovieInfo
         self._processMap["ReadMovieInfo"] = Processor.process_ReadMovieInfo
         self._processMap["UpdateRating"] = Processor.process_UpdateRating
@@ -1 +1 @@
-__all__ = ['ttypes', 'constants', 'UniqueIdService', 'MovieIdService', 'TextService', 'RatingService', 'UserService', 'ComposeReviewService', 'ReviewStorageService', 'MovieReviewService', 'UserReviewService', 'CastInfoService', 'PlotService', 'MovieInfoService', 'PageService']
+__all__ = ['ttypes', 'constants', 'BaseService', 'UniqueIdService', 'MovieIdService', 'TextService', 'RatingService', 'UserService', 'ComposeReviewService', 'ReviewStorageService', 'MovieReviewService', 'UserReviewService', 'CastInfoService', 'PlotService', 'MovieInfoService', 'PageService']
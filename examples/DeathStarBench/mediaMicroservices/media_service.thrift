@@ -68,14 +68,27 @@ exception ServiceException {
   2: string message;
 }
 
-service UniqueIdService {
+// Every service answers Ping so client pools can probe idle connections
+// without side effects.
+service BaseService {
+  void Ping()
+}
+
+service UniqueIdService extends BaseService {
   void UploadUniqueId (
       1: i64 req_id,
       2: map<string, string> carrier
   ) throws (1: ServiceException se)
+  // Reserves count consecutive IDs and returns the first one; the caller
+  // owns [first, first + count).
+  i64 LeaseUniqueIds (
+      1: i64 req_id,
+      2: i32 count,
+      3: map<string, string> carrier
+  ) throws (1: ServiceException se)
 }
 
-service MovieIdService {
+service MovieIdService extends BaseService {
   void UploadMovieId(
       1: i64 req_id,
       2: string title,
@@ -91,7 +104,7 @@ service MovieIdService {
   ) throws (1: ServiceException se)
 }
 
-service TextService {
+service TextService extends BaseService {
   void UploadText (
       1: i64 req_id,
       2: string text,
@@ -99,7 +112,7 @@ service TextService {
   ) throws (1: ServiceException se)
 }
 
-service RatingService {
+service RatingService extends BaseService {
   void UploadRating (
       1: i64 req_id,
       2: string movie_id,
@@ -108,7 +121,7 @@ service RatingService {
   ) throws (1: ServiceException se)
 }
 
-service UserService {
+service UserService extends BaseService {
   void RegisterUser (
       1: i64 req_id,
       2: string first_name,
@@ -146,9 +159,17 @@ service UserService {
       2: string username,
       3: map<string, string> carrier
   ) throws (1: ServiceException se)
+
+  // Checks the signature and expiry of a token issued by Login and returns
+  // its user_id; throws SE_UNAUTHORIZED if it is invalid or expired.
+  i64 VerifyToken(
+      1: i64 req_id,
+      2: string token,
+      3: map<string, string> carrier
+  ) throws (1: ServiceException se)
 }
 
-service ComposeReviewService {
+service ComposeReviewService extends BaseService {
   void UploadText(
       1: i64 req_id,
       2: string text,
@@ -176,7 +197,7 @@ service ComposeReviewService {
   ) throws (1: ServiceException se)
 }
 
-service ReviewStorageService {
+service ReviewStorageService extends BaseService {
   void StoreReview(
       1: i64 req_id,
       2: Review review,
@@ -190,7 +211,7 @@ service ReviewStorageService {
   ) throws (1: ServiceException se)
 }
 
-service MovieReviewService {
+service MovieReviewService extends BaseService {
   void UploadMovieReview(
       1: i64 req_id,
       2: string movie_id,
@@ -208,7 +229,7 @@ service MovieReviewService {
   ) throws (1: ServiceException se)
 }
 
-service UserReviewService {
+service UserReviewService extends BaseService {
   void UploadUserReview(
       1: i64 req_id,
       2: i64 user_id,
@@ -226,7 +247,7 @@ service UserReviewService {
   ) throws (1: ServiceException se)
 }
 
-service CastInfoService {
+service CastInfoService extends BaseService {
   void WriteCastInfo(
       1: i64 req_id,
       2: i64 cast_info_id,
@@ -243,7 +264,7 @@ service CastInfoService {
   ) throws (1: ServiceException se)
 }
 
-service PlotService {
+service PlotService extends BaseService {
   void WritePlot(
       1: i64 req_id,
       2: i64 plot_id,
@@ -258,7 +279,7 @@ service PlotService {
   ) throws (1: ServiceException se)
 }
 
-service MovieInfoService {
+service MovieInfoService extends BaseService {
   void WriteMovieInfo(
     1: i64 req_id,
     2: string movie_id,
@@ -288,7 +309,7 @@ service MovieInfoService {
   ) throws (1: ServiceException se)
 }
 
-service PageService {
+service PageService extends BaseService {
   Page ReadPage(
     1: i64 req_id,
     2: string movie_id,
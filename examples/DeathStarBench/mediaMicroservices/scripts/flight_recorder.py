@@ -0,0 +1,85 @@
+import argparse
+import datetime
+import struct
+import sys
+
+# Reads the flight recorder file of a service, see src/FlightRecorder.h. It
+# works on the file of a running service as well as on one left behind by a
+# crash, e.g.
+#   python3 flight_recorder.py /tmp/movie-id-service.flight --slowest 20
+
+HEADER = struct.Struct("=8sIIQQqq32s")
+RECORD = struct.Struct("=qQQqIIiIHHi32s")
+EVENT = struct.Struct("=16siIIB3x")
+PHASES = ["idle", "handler", "pool_wait", "memcached", "mongo", "redis",
+          "thrift", "task_wait"]
+ERROR_CODES = ["SE_THRIFT_CONNPOOL_TIMEOUT", "SE_THRIFT_CONN_ERROR",
+               "SE_UNAUTHORIZED", "SE_MEMCACHED_ERROR", "SE_MONGODB_ERROR",
+               "SE_REDIS_ERROR", "SE_THRIFT_HANDLER_ERROR"]
+
+parser = argparse.ArgumentParser()
+parser.add_argument("path", type=str)
+parser.add_argument("--method", action="store", dest="method", type=str)
+parser.add_argument("--errors", action="store_true", dest="errors")
+parser.add_argument("--slowest", action="store", dest="slowest", type=int)
+args = parser.parse_args()
+
+with open(args.path, "rb") as file:
+  data = file.read()
+
+magic, version, slot_size, num_slots, head, pid, started_us, service = \
+    HEADER.unpack_from(data, 0)
+if magic != b"MSFLIGHT" or version != 2:
+  sys.exit("%s is not a version 2 flight recorder file" % args.path)
+
+def cstr(raw):
+  return raw.split(b"\0", 1)[0].decode(errors="replace")
+
+def failure(status, error_code):
+  if not status:
+    return ""
+  if error_code < 0:
+    return " FAILED"
+  if error_code < len(ERROR_CODES):
+    return " FAILED " + ERROR_CODES[error_code]
+  return " FAILED error_code=%d" % error_code
+
+def timestamp(us):
+  return datetime.datetime.fromtimestamp(us / 1e6).isoformat()
+
+print("%s pid %d started %s, %d requests recorded, %d kept" % (
+    cstr(service), pid, timestamp(started_us), head, min(head, num_slots)))
+
+records = []
+for n in range(max(0, head - num_slots), head):
+  offset = 4096 + (n % num_slots) * slot_size
+  seq, = struct.unpack_from("=Q", data, offset)
+  if seq == 0:
+    continue
+  if seq & 1:
+    print("slot %d was being written" % (n % num_slots))
+    continue
+  fields = RECORD.unpack_from(data, offset + 8)
+  events = [EVENT.unpack_from(data, offset + 8 + RECORD.size + i * EVENT.size)
+            for i in range(fields[8])]
+  records.append((fields, events))
+
+if args.method:
+  records = [r for r in records if cstr(r[0][11]) == args.method]
+if args.errors:
+  records = [r for r in records
+             if r[0][6] != 0 or any(e[1] == -2 for e in r[1])]
+if args.slowest:
+  records = sorted(records, key=lambda r: -r[0][4])[:args.slowest]
+
+for fields, events in records:
+  (req_id, trace_high, trace_low, start_us, duration_us, cpu_us, status, tid,
+   num_events, dropped_events, error_code, method) = fields
+  print("%s %s req_id=%d trace=%016x%016x tid=%d %d us (cpu %d us)%s%s" % (
+      timestamp(start_us), cstr(method), req_id, trace_high, trace_low, tid,
+      duration_us, cpu_us, failure(status, error_code),
+      " +%d events" % dropped_events if dropped_events else ""))
+  for op, result, event_start, event_duration, phase in events:
+    print("  +%6d us %-9s %-16s %6d us result=%d" % (
+        event_start, PHASES[phase] if phase < len(PHASES) else phase,
+        cstr(op), event_duration, result))
@@ -0,0 +1,141 @@
+#ifndef MEDIA_MICROSERVICES_AFFINITYCLIENTPOOL_H
+#define MEDIA_MICROSERVICES_AFFINITYCLIENTPOOL_H
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ClientPool.h"
+
+// Points per replica on the hash ring. More points spread the keys more
+// evenly and move fewer of them when a replica is added or removed.
+#define AFFINITY_RING_POINTS_PER_REPLICA 128
+
+namespace media_service
+{
+
+  /*
+   * A ClientPool per replica of a service, selected by consistent hashing
+   * on a request key. All calls made with the same key reach the same
+   * replica, which lets ComposeReviewService gather the components of a
+   * review in process. With a single replica it behaves like a plain
+   * ClientPool.
+   *
+   * The ring is built from "addr:port" strings, so every caller that is
+   * given the same replica list routes a key to the same replica.
+   */
+  template <class TClient>
+  class AffinityClientPool
+  {
+  public:
+    AffinityClientPool(const std::string &client_type,
+                       const std::vector<std::pair<std::string, int>> &replicas,
+                       int min_size, int max_size, int timeout_ms);
+
+    AffinityClientPool(const AffinityClientPool &) = delete;
+    AffinityClientPool &operator=(const AffinityClientPool &) = delete;
+
+    TClient *Pop(int64_t key);
+    void Push(int64_t key, TClient *client);
+    void Remove(int64_t key, TClient *client);
+
+  private:
+    ClientPool<TClient> *_PoolOf(int64_t key);
+
+    std::vector<std::unique_ptr<ClientPool<TClient>>> _pools;
+    // (point, pool index), sorted by point.
+    std::vector<std::pair<uint64_t, size_t>> _ring;
+  };
+
+  // FNV-1a followed by a finalizer; unlike std::hash it is the same in every
+  // build, which the callers rely on to agree on the ring.
+  static uint64_t _AffinityHash(const std::string &str)
+  {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (unsigned char c : str)
+    {
+      h ^= c;
+      h *= 0x100000001b3ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+  }
+
+  static uint64_t _AffinityHash(int64_t key)
+  {
+    uint64_t h = static_cast<uint64_t>(key);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+  }
+
+  template <class TClient>
+  AffinityClientPool<TClient>::AffinityClientPool(
+      const std::string &client_type,
+      const std::vector<std::pair<std::string, int>> &replicas,
+      int min_size, int max_size, int timeout_ms)
+  {
+    for (size_t i = 0; i < replicas.size(); ++i)
+    {
+      auto &addr = replicas[i].first;
+      int port = replicas[i].second;
+      _pools.emplace_back(new ClientPool<TClient>(
+          client_type, addr, port, min_size, max_size, timeout_ms));
+      std::string name = addr + ":" + std::to_string(port);
+      for (int j = 0; j < AFFINITY_RING_POINTS_PER_REPLICA; ++j)
+      {
+        _ring.emplace_back(_AffinityHash(name + "#" + std::to_string(j)), i);
+      }
+    }
+    std::sort(_ring.begin(), _ring.end());
+    if (replicas.size() > 1)
+    {
+      LOG(info) << client_type << " routes by key over " << replicas.size()
+                << " replicas";
+    }
+  }
+
+  template <class TClient>
+  ClientPool<TClient> *AffinityClientPool<TClient>::_PoolOf(int64_t key)
+  {
+    if (_pools.size() == 1)
+    {
+      return _pools[0].get();
+    }
+    auto point = std::make_pair(_AffinityHash(key), size_t(0));
+    auto it = std::lower_bound(_ring.begin(), _ring.end(), point);
+    if (it == _ring.end())
+    {
+      it = _ring.begin();
+    }
+    return _pools[it->second].get();
+  }
+
+  template <class TClient>
+  TClient *AffinityClientPool<TClient>::Pop(int64_t key)
+  {
+    return _PoolOf(key)->Pop();
+  }
+
+  template <class TClient>
+  void AffinityClientPool<TClient>::Push(int64_t key, TClient *client)
+  {
+    _PoolOf(key)->Push(client);
+  }
+
+  template <class TClient>
+  void AffinityClientPool<TClient>::Remove(int64_t key, TClient *client)
+  {
+    _PoolOf(key)->Remove(client);
+  }
+
+} // namespace media_service
+
+#endif // MEDIA_MICROSERVICES_AFFINITYCLIENTPOOL_H
@@ -13,8 +13,11 @@
 #include "../../gen-cpp/CastInfoService.h"
 #include "../ClientPool.h"
 #include "../ThriftClient.h"
+#include "../Executor.h"
+#include "../MemcachedPool.h"
 #include "../logger.h"
 #include "../tracing.h"
+#include "../probes.h"
 
 namespace media_service {
 
@@ -25,6 +28,8 @@ class CastInfoHandler : public CastInfoServiceIf {
       mongoc_client_pool_t *);
   ~CastInfoHandler() override = default;
 
+  void Ping() override {}
+
   void WriteCastInfo(int64_t req_id, int64_t cast_info_id,
       const std::string &name, bool gender, const std::string &intro,
       const std::map<std::string, std::string>& carrier) override;
@@ -52,14 +57,8 @@ void CastInfoHandler::WriteCastInfo(
     const std::string &intro,
     const std::map<std::string, std::string> &carrier) {
   // Initialize a span
-  TextMapReader reader(carrier);
-  std::map<std::string, std::string> writer_text_map;
-  TextMapWriter writer(writer_text_map);
-  auto parent_span = opentracing::Tracer::Global()->Extract(reader);
-  auto span = opentracing::Tracer::Global()->StartSpan(
-      "WriteCastInfo",
-      { opentracing::ChildOf(parent_span->get()) });
-  opentracing::Tracer::Global()->Inject(span->context(), writer);
+  auto span = TraceSpan::Start("WriteCastInfo", carrier);
+  RequestProbe probe(req_id, "WriteCastInfo", span.GetTraceId());
 
   bson_t *new_doc = bson_new();
   BSON_APPEND_INT64(new_doc, "cast_info_id", cast_info_id);
@@ -73,7 +72,7 @@ void CastInfoHandler::WriteCastInfo(
     ServiceException se;
     se.errorCode = ErrorCode::SE_MONGODB_ERROR;
     se.message = "Failed to pop a client from MongoDB pool";
-    throw se;
+    throw RequestError(se);
   }
   auto collection = mongoc_client_get_collection(
       mongodb_client, "cast-info", "cast-info");
@@ -82,15 +81,16 @@ void CastInfoHandler::WriteCastInfo(
     se.errorCode = ErrorCode::SE_MONGODB_ERROR;
     se.message = "Failed to create collection cast-info from DB cast-info";
     mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
-    throw se;
+    throw RequestError(se);
   }
 
   bson_error_t error;
-  auto insert_span = opentracing::Tracer::Global()->StartSpan(
-      "MongoInsertCastInfo", { opentracing::ChildOf(&span->context()) });
+  auto insert_span = span.Child("MongoInsertCastInfo");
+  CallProbe insert_probe(ProbeBackend::mongo, req_id, "MongoInsertCastInfo");
   bool plotinsert = mongoc_collection_insert_one (
       collection, new_doc, nullptr, nullptr, &error);
-  insert_span->Finish();
+  insert_span.Finish();
+  insert_probe.End();
   if (!plotinsert) {
     LOG(error) << "Error: Failed to insert cast-info to MongoDB: "
                << error.message;
@@ -100,14 +100,14 @@ void CastInfoHandler::WriteCastInfo(
     bson_destroy(new_doc);
     mongoc_collection_destroy(collection);
     mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
-    throw se;
+    throw RequestError(se);
   }
 
   bson_destroy(new_doc);
   mongoc_collection_destroy(collection);
   mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
 
-  span->Finish();
+  span.Finish();
 }
 
 void CastInfoHandler::ReadCastInfo(
@@ -117,14 +117,8 @@ void CastInfoHandler::ReadCastInfo(
     const std::map<std::string, std::string> &carrier) {
 
   // Initialize a span
-  TextMapReader reader(carrier);
-  std::map<std::string, std::string> writer_text_map;
-  TextMapWriter writer(writer_text_map);
-  auto parent_span = opentracing::Tracer::Global()->Extract(reader);
-  auto span = opentracing::Tracer::Global()->StartSpan(
-      "ReadCastInfo",
-      { opentracing::ChildOf(parent_span->get()) });
-  opentracing::Tracer::Global()->Inject(span->context(), writer);
+  auto span = TraceSpan::Start("ReadCastInfo", carrier);
+  RequestProbe probe(req_id, "ReadCastInfo", span.GetTraceId());
 
   if (cast_info_ids.empty()) {
     return;
@@ -135,31 +129,35 @@ void CastInfoHandler::ReadCastInfo(
     ServiceException se;
     se.errorCode = ErrorCode::SE_THRIFT_HANDLER_ERROR;
     se.message = "cast_info_ids are duplicated";
-    throw se;
+    throw RequestError(se);
   }
 
   std::map<int64_t, CastInfo> return_map;
   memcached_return_t memcached_rc;
-  auto memcached_client = memcached_pool_pop(
+  auto memcached_client = MemcachedPoolPop(
       _memcached_client_pool, true, &memcached_rc);
   if (!memcached_client) {
     ServiceException se;
     se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
     se.message = "Failed to pop a client from memcached pool";
-    throw se;
+    throw RequestError(se);
   }
   char** keys;
   size_t *key_sizes;
   keys = new char* [cast_info_ids.size()];
   key_sizes = new size_t [cast_info_ids.size()];
   int idx = 0;
+  size_t keys_length = 0;
   for (auto &cast_info_id : cast_info_ids) {
     std::string key_str = std::to_string(cast_info_id);
     keys[idx] = new char [key_str.length() + 1];
     strcpy(keys[idx], key_str.c_str());
     key_sizes[idx] = key_str.length();
+    keys_length += key_str.length();
     idx++;
   }
+  CallProbe get_probe(ProbeBackend::memcached, req_id, "MmcMgetCastInfo");
+  get_probe.AddBytes(keys_length, 0);
   memcached_rc = memcached_mget(memcached_client, keys, key_sizes, cast_info_ids.size());
   if (memcached_rc != MEMCACHED_SUCCESS) {
     LOG(error) << "Cannot get cast_info_ids of request " << req_id << ": "
@@ -167,8 +165,8 @@ void CastInfoHandler::ReadCastInfo(
     ServiceException se;
     se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
     se.message = memcached_strerror(memcached_client, memcached_rc);
-    memcached_pool_push(_memcached_client_pool, memcached_client);
-    throw se;
+    MemcachedPoolPush(_memcached_client_pool, memcached_client);
+    throw RequestError(se);
   }
 
   char return_key[MEMCACHED_MAX_KEY];
@@ -176,8 +174,7 @@ void CastInfoHandler::ReadCastInfo(
   char *return_value;
   size_t return_value_length;
   uint32_t flags;
-  auto get_span = opentracing::Tracer::Global()->StartSpan(
-      "MmcMgetCastInfo", { opentracing::ChildOf(&span->context()) });
+  auto get_span = span.Child("MmcMgetCastInfo");
   while (true) {
     return_value = memcached_fetch(memcached_client, return_key,
         &return_key_length, &return_value_length, &flags, &memcached_rc);
@@ -188,13 +185,14 @@ void CastInfoHandler::ReadCastInfo(
     if (memcached_rc != MEMCACHED_SUCCESS) {
       free(return_value);
       memcached_quit(memcached_client);
-      memcached_pool_push(_memcached_client_pool, memcached_client);
+      MemcachedPoolPush(_memcached_client_pool, memcached_client);
       LOG(error) << "Cannot get components of request " << req_id;
       ServiceException se;
       se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
       se.message =  "Cannot get usernames of request " + std::to_string(req_id);
-      throw se;
+      throw RequestError(se);
     }
+    get_probe.AddBytes(0, return_key_length + return_value_length);
     CastInfo new_cast_info;
     json cast_info_json = json::parse(std::string(
         return_value, return_value + return_value_length));
@@ -206,16 +204,17 @@ void CastInfoHandler::ReadCastInfo(
     cast_info_ids_not_cached.erase(new_cast_info.cast_info_id);
     free(return_value);
   }
-  get_span->Finish();
+  get_span.Finish();
+  get_probe.End(return_map.size());
   memcached_quit(memcached_client);
-  memcached_pool_push(_memcached_client_pool, memcached_client);
+  MemcachedPoolPush(_memcached_client_pool, memcached_client);
   for (int i = 0; i < cast_info_ids.size(); ++i) {
     delete keys[i];
   }
   delete[] keys;
   delete[] key_sizes;
 
-  std::vector<std::future<void>> set_futures;
+  std::vector<TaskFuture<void>> set_futures;
   std::map<int64_t, std::string> cast_info_json_map;
 
   // Find the rest in MongoDB
@@ -242,7 +241,7 @@ void CastInfoHandler::ReadCastInfo(
       ServiceException se;
       se.errorCode = ErrorCode::SE_MONGODB_ERROR;
       se.message = "Failed to pop a client from MongoDB pool";
-      throw se;
+      throw RequestError(se);
     }
     auto collection = mongoc_client_get_collection(
         mongodb_client, "cast-info", "cast-info");
@@ -251,15 +250,15 @@ void CastInfoHandler::ReadCastInfo(
       se.errorCode = ErrorCode::SE_MONGODB_ERROR;
       se.message = "Failed to create collection user from DB user";
       mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
-      throw se;
+      throw RequestError(se);
     }
 
     mongoc_cursor_t *cursor = mongoc_collection_find_with_opts(
         collection, query, nullptr, nullptr);
     const bson_t *doc;
 
-    auto find_span = opentracing::Tracer::Global()->StartSpan(
-        "MongoFindCastInfo", {opentracing::ChildOf(&span->context())});
+    auto find_span = span.Child("MongoFindCastInfo");
+    CallProbe find_probe(ProbeBackend::mongo, req_id, "MongoFindCastInfo");
 
     while (true) {
       bool found = mongoc_cursor_next(cursor, &doc);
@@ -279,7 +278,8 @@ void CastInfoHandler::ReadCastInfo(
       return_map.insert({new_cast_info.cast_info_id, new_cast_info});
       bson_free(cast_info_json_char);
     }
-    find_span->Finish();
+    find_span.Finish();
+    find_probe.End(cast_info_json_map.size());
     bson_error_t error;
     if (mongoc_cursor_error(cursor, &error)) {
       LOG(warning) << error.message;
@@ -290,7 +290,7 @@ void CastInfoHandler::ReadCastInfo(
       ServiceException se;
       se.errorCode = ErrorCode::SE_MONGODB_ERROR;
       se.message = error.message;
-      throw se;
+      throw RequestError(se);
     }
     bson_destroy(query);
     mongoc_cursor_destroy(cursor);
@@ -298,19 +298,19 @@ void CastInfoHandler::ReadCastInfo(
     mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
 
     // Upload cast-info to memcached
-    set_futures.emplace_back(std::async(std::launch::async, [&]() {
+    set_futures.emplace_back(Executor::Global().Submit([&]() {
       memcached_return_t _rc;
-      auto _memcached_client = memcached_pool_pop(
+      auto _memcached_client = MemcachedPoolPop(
           _memcached_client_pool, true, &_rc);
       if (!_memcached_client) {
         LOG(error) << "Failed to pop a client from memcached pool";
         ServiceException se;
         se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
         se.message = "Failed to pop a client from memcached pool";
-        throw se;
+        throw RequestError(se);
       }
-      auto set_span = opentracing::Tracer::Global()->StartSpan(
-          "MmcSetCastInfo", {opentracing::ChildOf(&span->context())});
+      auto set_span = span.Child("MmcSetCastInfo");
+      CallProbe set_probe(ProbeBackend::memcached, req_id, "MmcSetCastInfo");
       for (auto & it : cast_info_json_map) {
         std::string id_str = std::to_string(it.first);
         _rc = memcached_set(
@@ -321,9 +321,11 @@ void CastInfoHandler::ReadCastInfo(
             it.second.length(),
             static_cast<time_t>(0),
             static_cast<uint32_t>(0));
+        set_probe.AddBytes(id_str.length() + it.second.length(), 0);
       }
-      memcached_pool_push(_memcached_client_pool, _memcached_client);
-      set_span->Finish();
+      MemcachedPoolPush(_memcached_client_pool, _memcached_client);
+      set_span.Finish();
+      set_probe.End();
     }));
   }
 
@@ -337,7 +339,7 @@ void CastInfoHandler::ReadCastInfo(
     ServiceException se;
     se.errorCode = ErrorCode::SE_THRIFT_HANDLER_ERROR;
     se.message = "cast-info-service return set incomplete";
-    throw se;
+    throw RequestError(se);
   }
 
   for (auto &cast_info_id : cast_info_ids) {
@@ -1,19 +1,12 @@
-#include <thrift/protocol/TBinaryProtocol.h>
-#include <thrift/server/TThreadedServer.h>
-#include <thrift/transport/TServerSocket.h>
-#include <thrift/transport/TBufferTransports.h>
 #include <signal.h>
 
 #include "../utils.h"
+#include "../utils_thrift.h"
 #include "../utils_memcached.h"
 #include "../utils_mongodb.h"
 #include "CastInfoHandler.h"
 
 using json = nlohmann::json;
-using apache::thrift::server::TThreadedServer;
-using apache::thrift::transport::TServerSocket;
-using apache::thrift::transport::TFramedTransportFactory;
-using apache::thrift::protocol::TBinaryProtocolFactory;
 using namespace media_service;
 
 void sigintHandler(int sig) {
@@ -31,7 +24,6 @@ int main(int argc, char *argv[]) {
     exit(EXIT_FAILURE);
   }
 
-  int port = config_json["cast-info-service"]["port"];
 
   memcached_pool_st *memcached_client_pool =
       init_memcached_client_pool(config_json, "cast-info",
@@ -58,16 +50,15 @@ int main(int argc, char *argv[]) {
   }
   mongoc_client_pool_push(mongodb_client_pool, mongodb_client);
 
-  TThreadedServer server(
+  start_observability(config_json, "cast-info-service");
+  init_executor(config_json, "cast-info-service");
+  auto server = init_thrift_server(
+      config_json, "cast-info-service",
       std::make_shared<CastInfoServiceProcessor>(
       std::make_shared<CastInfoHandler>(
-              memcached_client_pool, mongodb_client_pool)),
-      std::make_shared<TServerSocket>("0.0.0.0", port),
-      std::make_shared<TFramedTransportFactory>(),
-      std::make_shared<TBinaryProtocolFactory>()
-  );
+              memcached_client_pool, mongodb_client_pool)));
   std::cout << "Starting the cast-service server ..." << std::endl;
-  server.serve();
+  server->serve();
 }
 
 
@@ -1,19 +1,51 @@
 #ifndef MEDIA_MICROSERVICES_CLIENTPOOL_H
 #define MEDIA_MICROSERVICES_CLIENTPOOL_H
 
-#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <memory>
 #include <mutex>
 #include <condition_variable>
-#include <deque>
 #include <chrono>
 #include <string>
-#include <thread> // Include this header for std::this_thread
+#include <thread>
+#include <vector>
 
+#include "Metrics.h"
+#include "ProfiledMutex.h"
 #include "logger.h"
+#include "probes.h"
 
 namespace media_service
 {
 
+  /*
+   * Idle clients are kept in per-thread shards. Each shard is a lock-free
+   * Treiber stack of nodes taken from a fixed node array. A client is given
+   * its node when it joins the pool and keeps it, recorded in _pool_node,
+   * until it is removed, so Pop() and Push() on the fast path are a single
+   * CAS on the caller's own shard. A thread whose shard is empty steals from
+   * the other shards before it waits.
+   * Stack heads carry a 32-bit tag next to the node index to rule out ABA.
+   * The mutex and condition variable are only used by callers that have to
+   * block until a client is returned; the mutex is profiled as lock
+   * "client_pool/<client_type>".
+   *
+   * Connections are never opened on the request path. A connector thread per
+   * pool keeps at least min_size connected clients and opens new ones when
+   * Pop() callers are waiting on an empty pool. Broken clients handed back
+   * by Push() are dropped and replaced by the connector. When the backend
+   * cannot be reached the connector backs off exponentially and Pop() fails
+   * fast instead of waiting out its deadline.
+   *
+   * The connector also validates idle clients: those idle for longer than
+   * CLIENT_POOL_VALIDATE_IDLE_MS are pinged and evicted if the ping fails,
+   * and one client per pass that has been connected for longer than its
+   * _keepalive_ms is retired, so clients opened together are not all
+   * reconnected at once. It takes out one client at a time and tops the
+   * pool up between two pings, so Pop() only ever misses the client being
+   * pinged and refills are not held up by a slow backend.
+   */
   template <class TClient>
   class ClientPool
   {
@@ -24,32 +56,89 @@ namespace media_service
 
     ClientPool(const ClientPool &) = delete;
     ClientPool &operator=(const ClientPool &) = delete;
-    ClientPool(ClientPool &&) = default;
-    ClientPool &operator=(ClientPool &&) = default;
 
     TClient *Pop();
+    TClient *Pop(int timeout_ms);
     void Push(TClient *);
     void Push(TClient *, int);
     void Remove(TClient *);
     void Keepalive(TClient *);
 
   private:
-    std::deque<TClient *> _pool;
+    struct Node
+    {
+      TClient *client;
+      std::atomic<uint32_t> next;
+    };
+
+    // Padded to a cache line so threads on different shards do not contend.
+    struct Shard
+    {
+      std::atomic<uint64_t> head{0};
+      char pad[64 - sizeof(std::atomic<uint64_t>)];
+    };
+
+    void _StackPush(std::atomic<uint64_t> *head, uint32_t idx);
+    bool _StackPop(std::atomic<uint64_t> *head, uint32_t *idx);
+    bool _AddNode(TClient *client);
+    void _PushIdle(TClient *client);
+    TClient *_PopIdle();
+    bool _ReserveSlot();
+    void _NotifyWaiters();
+    size_t _ThreadShard() const;
+    void _WakeConnector();
+    void _WithdrawDemand();
+    TClient *_NewConnectedClient();
+    bool _FillPool();
+    bool _ValidateIdle(bool *may_retire);
+    void _ConnectorLoop();
+
     std::string _addr;
     std::string _client_type;
     int _port;
     int _min_pool_size{};
     int _max_pool_size{};
-    int _curr_pool_size{};
+    std::atomic<int> _curr_pool_size{0};
     int _timeout_ms;
-    std::mutex _mtx;
-    std::condition_variable _cv;
+
+    uint32_t _num_nodes{};
+    std::unique_ptr<Node[]> _nodes;
+    std::atomic<uint64_t> _spare_head{0};
+    size_t _num_shards{};
+    std::unique_ptr<Shard[]> _shards;
+
+    std::atomic<int> _num_waiters{0};
+    ProfiledMutex _mtx;
+    std::condition_variable_any _cv;
+
+    // Number of clients waiting Pop() callers still expect the connector to
+    // open.
+    std::atomic<int> _demand{0};
+    std::atomic<bool> _backend_down{false};
+    bool _connector_wakeup = false;
+    bool _stop = false;
+    std::chrono::milliseconds _backoff;
+    std::mutex _connector_mtx;
+    std::condition_variable _connector_cv;
+    std::thread _connector;
+
+    // Every Pop() records its wait, 0 if it did not block.
+    HdrHistogram *_wait_histogram;
+    std::vector<uint64_t> _gauge_ids;
   };
 
+  // How often the connector re-checks min_size without being woken up, and
+  // the bounds of its reconnect backoff while the backend is unreachable.
+  constexpr std::chrono::milliseconds CLIENT_POOL_MAINTAIN_INTERVAL(1000);
+  constexpr std::chrono::milliseconds CLIENT_POOL_MIN_BACKOFF(100);
+  constexpr std::chrono::milliseconds CLIENT_POOL_MAX_BACKOFF(5000);
+  constexpr long CLIENT_POOL_VALIDATE_IDLE_MS = 5000;
+
   template <class TClient>
   ClientPool<TClient>::ClientPool(const std::string &client_type,
                                   const std::string &addr, int port, int min_pool_size,
                                   int max_pool_size, int timeout_ms)
+      : _mtx("client_pool/" + client_type)
   {
     _addr = addr;
     _port = port;
@@ -58,107 +147,284 @@ namespace media_service
     _timeout_ms = timeout_ms;
     _client_type = client_type;
 
-    for (int i = 0; i < min_pool_size; ++i)
+    // One node per client that can ever exist, all of them spare at first.
+    _num_nodes = static_cast<uint32_t>(
+        std::max(std::max(min_pool_size, max_pool_size), 1));
+    _nodes.reset(new Node[_num_nodes]);
+    for (uint32_t i = 0; i < _num_nodes; ++i)
+    {
+      _nodes[i].client = nullptr;
+      _StackPush(&_spare_head, i);
+    }
+
+    // Round the shard count up to a power of two so a thread's slot can be
+    // masked into a shard index.
+    size_t num_cpus = std::max(std::thread::hardware_concurrency(), 1u);
+    _num_shards = 1;
+    while (_num_shards < num_cpus && _num_shards < _num_nodes)
     {
-      TClient *client = new TClient(addr, port);
-      _pool.emplace_back(client);
+      _num_shards <<= 1;
     }
-    _curr_pool_size = min_pool_size;
+    _shards.reset(new Shard[_num_shards]);
+
+    auto labels = MetricLabels({{"pool", client_type}});
+    auto &metrics = Metrics::Global();
+    _wait_histogram = metrics.GetHistogram(
+        "media_client_pool_wait_seconds",
+        "Time ClientPool::Pop() waited for a client.", labels);
+    _gauge_ids.push_back(metrics.AddGauge(
+        "media_client_pool_size", "Clients a pool has open.", labels,
+        [this]()
+        { return _curr_pool_size.load(); }));
+    _gauge_ids.push_back(metrics.AddGauge(
+        "media_client_pool_max_size", "Clients a pool may open.", labels,
+        [this]()
+        { return _max_pool_size; }));
+    _gauge_ids.push_back(metrics.AddGauge(
+        "media_client_pool_waiters", "Pop() callers waiting for a client.",
+        labels, [this]()
+        { return _num_waiters.load(); }));
+
+    _backoff = CLIENT_POOL_MIN_BACKOFF;
+    _connector = std::thread(&ClientPool<TClient>::_ConnectorLoop, this);
   }
 
   template <class TClient>
   ClientPool<TClient>::~ClientPool()
   {
-    while (!_pool.empty())
+    for (auto id : _gauge_ids)
+    {
+      Metrics::Global().RemoveGauge(id);
+    }
     {
-      delete _pool.front();
-      _pool.pop_front();
+      std::lock_guard<std::mutex> lock(_connector_mtx);
+      _stop = true;
+    }
+    _connector_cv.notify_one();
+    _connector.join();
+
+    TClient *client;
+    while ((client = _PopIdle()) != nullptr)
+    {
+      delete client;
     }
   }
 
   template <class TClient>
-  TClient *ClientPool<TClient>::Pop()
+  void ClientPool<TClient>::_StackPush(std::atomic<uint64_t> *head,
+                                       uint32_t idx)
   {
-    TClient *client = nullptr;
-    std::unique_lock<std::mutex> cv_lock(_mtx);
+    uint64_t old_head = head->load();
+    uint64_t new_head;
+    do
     {
-      while (_pool.size() == 0)
+      _nodes[idx].next.store(static_cast<uint32_t>(old_head),
+                             std::memory_order_relaxed);
+      new_head = (((old_head >> 32) + 1) << 32) | (idx + 1);
+    } while (!head->compare_exchange_weak(old_head, new_head));
+  }
+
+  template <class TClient>
+  bool ClientPool<TClient>::_StackPop(std::atomic<uint64_t> *head,
+                                      uint32_t *idx)
+  {
+    uint64_t old_head = head->load();
+    while (static_cast<uint32_t>(old_head) != 0)
+    {
+      uint32_t top = static_cast<uint32_t>(old_head) - 1;
+      uint32_t next = _nodes[top].next.load(std::memory_order_relaxed);
+      uint64_t new_head = (((old_head >> 32) + 1) << 32) | next;
+      if (head->compare_exchange_weak(old_head, new_head))
       {
-        // Create a new client if current pool size is less than the max pool size.
-        if (_curr_pool_size < _max_pool_size)
-        {
-          try
-          {
-            client = new TClient(_addr, _port);
-            _curr_pool_size++;
-            break;
-          }
-          catch (...)
-          {
-            cv_lock.unlock();
-            return nullptr;
-          }
-        }
-        else
-        {
-          auto wait_time = std::chrono::system_clock::now() +
-                           std::chrono::milliseconds(_timeout_ms);
-          bool wait_success = _cv.wait_until(cv_lock, wait_time,
-                                             [this]
-                                             { return _pool.size() > 0; });
-          if (!wait_success)
-          {
-            LOG(warning) << "ClientPool pop timeout";
-            cv_lock.unlock();
-            return nullptr;
-          }
-        }
+        *idx = top;
+        return true;
       }
-      if (!client)
+    }
+    return false;
+  }
+
+  template <class TClient>
+  size_t ClientPool<TClient>::_ThreadShard() const
+  {
+    // Threads are spread over the shards round-robin the first time they
+    // touch any pool, and keep that slot for their lifetime.
+    static std::atomic<unsigned> next_thread_slot{0};
+    thread_local unsigned thread_slot = next_thread_slot.fetch_add(1);
+    return thread_slot & (_num_shards - 1);
+  }
+
+  // Gives a client that joins the pool its node.
+  template <class TClient>
+  bool ClientPool<TClient>::_AddNode(TClient *client)
+  {
+    uint32_t idx;
+    if (!_StackPop(&_spare_head, &idx))
+    {
+      return false;
+    }
+    _nodes[idx].client = client;
+    client->_pool_node = idx;
+    return true;
+  }
+
+  template <class TClient>
+  void ClientPool<TClient>::_PushIdle(TClient *client)
+  {
+    _StackPush(&_shards[_ThreadShard()].head, client->_pool_node);
+  }
+
+  template <class TClient>
+  TClient *ClientPool<TClient>::_PopIdle()
+  {
+    size_t own = _ThreadShard();
+    for (size_t i = 0; i < _num_shards; ++i)
+    {
+      uint32_t idx;
+      // Start with the caller's own shard, then steal from the others.
+      if (_StackPop(&_shards[(own + i) & (_num_shards - 1)].head, &idx))
+      {
+        return _nodes[idx].client;
+      }
+    }
+    return nullptr;
+  }
+
+  template <class TClient>
+  bool ClientPool<TClient>::_ReserveSlot()
+  {
+    int curr = _curr_pool_size.load();
+    while (curr < _max_pool_size)
+    {
+      if (_curr_pool_size.compare_exchange_weak(curr, curr + 1))
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  template <class TClient>
+  void ClientPool<TClient>::_NotifyWaiters()
+  {
+    if (_num_waiters.load() > 0)
+    {
+      // Taking the lock orders this notification after a waiter's last check
+      // of the shards, so the wakeup cannot be lost.
       {
-        client = _pool.front();
-        _pool.pop_front();
+        std::lock_guard<ProfiledMutex> lock(_mtx);
       }
+      _cv.notify_one();
+    }
+  }
 
-    } // cv_lock(_mtx)
-    cv_lock.unlock();
+  template <class TClient>
+  void ClientPool<TClient>::_WakeConnector()
+  {
+    {
+      std::lock_guard<std::mutex> lock(_connector_mtx);
+      _connector_wakeup = true;
+    }
+    _connector_cv.notify_one();
+  }
 
-    if (client)
+  template <class TClient>
+  void ClientPool<TClient>::_WithdrawDemand()
+  {
+    int demand = _demand.load();
+    while (demand > 0 && !_demand.compare_exchange_weak(demand, demand - 1))
+    {
+    }
+  }
+
+  template <class TClient>
+  TClient *ClientPool<TClient>::Pop()
+  {
+    return Pop(_timeout_ms);
+  }
+
+  template <class TClient>
+  TClient *ClientPool<TClient>::Pop(int timeout_ms)
+  {
+    // Only read the clock once the caller has to wait.
+    std::chrono::steady_clock::time_point deadline;
+    bool waiting = false;
+    uint32_t saved_phase = REQUEST_PHASE_IDLE;
+    uint64_t wait_start = 0;
+    TClient *client = nullptr;
+    while (true)
     {
-      int retries = 3; // Number of retries
-      while (retries > 0)
+      client = _PopIdle();
+      if (client && !client->IsConnected())
+      {
+        // The connection went away while the client was idle; let the
+        // connector open a replacement.
+        Remove(client);
+        continue;
+      }
+      if (client || _backend_down.load())
+      {
+        break;
+      }
+
+      std::unique_lock<ProfiledMutex> cv_lock(_mtx);
+      if (!waiting)
+      {
+        waiting = true;
+        deadline = std::chrono::steady_clock::now() +
+                   std::chrono::milliseconds(timeout_ms);
+        saved_phase = ProbePoolWaitStart(_client_type.c_str());
+        wait_start = ReadCycles();
+        _num_waiters++;
+        _demand++;
+        _WakeConnector();
+      }
+      client = _PopIdle();
+      if (client)
       {
-        try
+        cv_lock.unlock();
+        if (!client->IsConnected())
         {
-          client->Connect();
-          break;
+          Remove(client);
+          continue;
         }
-        catch (const apache::thrift::transport::TTransportException &e)
+        break;
+      }
+      if (_backend_down.load() ||
+          _cv.wait_until(cv_lock, deadline) == std::cv_status::timeout)
+      {
+        client = _PopIdle();
+        if (client && !client->IsConnected())
         {
-          LOG(error) << "Failed to connect " + _client_type + ". Retries left: " << retries;
-          std::this_thread::sleep_for(std::chrono::seconds(1)); // Wait before retrying
-          retries--;
-          if (retries == 0)
-          {
-            LOG(error) << "Max retries reached for " + _client_type;
-            // Remove the problematic client and try to create a new one
-            Remove(client);
-            client = new TClient(_addr, _port);
-            try
-            {
-              client->Connect();
-              break;
-            }
-            catch (...)
-            {
-              delete client;
-              cv_lock.lock();
-              _curr_pool_size--;
-              cv_lock.unlock();
-              return nullptr;
-            }
-          }
+          cv_lock.unlock();
+          Remove(client);
+          client = nullptr;
         }
+        break;
+      }
+    }
+
+    if (waiting)
+    {
+      _num_waiters--;
+      _WithdrawDemand();
+      uint64_t wait_end = ReadCycles();
+      ProbePoolWaitEnd(_client_type.c_str(), client != nullptr, saved_phase,
+                       wait_start, wait_end);
+      _wait_histogram->Record(CyclesToMicroseconds(wait_end - wait_start));
+    }
+    else
+    {
+      _wait_histogram->Record(0);
+    }
+    if (!client)
+    {
+      if (_backend_down.load())
+      {
+        LOG(error) << "Failed to connect " << _client_type << ": backend is down";
+      }
+      else
+      {
+        LOG(warning) << "ClientPool pop timeout";
       }
     }
     return client;
@@ -167,30 +433,51 @@ namespace media_service
   template <class TClient>
   void ClientPool<TClient>::Push(TClient *client)
   {
-    std::unique_lock<std::mutex> cv_lock(_mtx);
-    client->KeepAlive();
-    _pool.push_back(client);
-    cv_lock.unlock();
-    _cv.notify_one();
+    if (!client->IsConnected())
+    {
+      Remove(client);
+      return;
+    }
+    client->_last_used_timestamp =
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    _PushIdle(client);
+    _NotifyWaiters();
   }
 
+  // Gives a client that lost its connection up to timeout_ms to reconnect
+  // before handing it back, instead of leaving the replacement to the
+  // connector.
   template <class TClient>
   void ClientPool<TClient>::Push(TClient *client, int timeout_ms)
   {
-    std::unique_lock<std::mutex> cv_lock(_mtx);
-    client->KeepAlive(timeout_ms);
-    _pool.push_back(client);
-    cv_lock.unlock();
-    _cv.notify_one();
+    if (!client->IsConnected())
+    {
+      try
+      {
+        client->KeepAlive(timeout_ms);
+      }
+      catch (...)
+      {
+      }
+    }
+    Push(client);
   }
 
   template <class TClient>
   void ClientPool<TClient>::Remove(TClient *client)
   {
-    std::unique_lock<std::mutex> lock(_mtx);
+    // The node goes back before the size drops, so a reserved slot always
+    // finds a spare node.
+    _nodes[client->_pool_node].client = nullptr;
+    _StackPush(&_spare_head, client->_pool_node);
     delete client;
     _curr_pool_size--;
-    lock.unlock();
+    if (_curr_pool_size.load() < _min_pool_size || _num_waiters.load() > 0)
+    {
+      _WakeConnector();
+    }
   }
 
   template <class TClient>
@@ -209,284 +496,222 @@ namespace media_service
     }
   }
 
+  template <class TClient>
+  TClient *ClientPool<TClient>::_NewConnectedClient()
+  {
+    TClient *client = nullptr;
+    try
+    {
+      client = new TClient(_addr, _port);
+      client->Connect();
+    }
+    catch (...)
+    {
+    }
+    if (client && !client->IsConnected())
+    {
+      delete client;
+      client = nullptr;
+    }
+    if (client)
+    {
+      client->_last_used_timestamp =
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              std::chrono::system_clock::now().time_since_epoch())
+              .count();
+    }
+    return client;
+  }
+
+  template <class TClient>
+  bool ClientPool<TClient>::_FillPool()
+  {
+    // While the backend is marked down, one connection is attempted per
+    // backoff period even without demand, so Pop() stops failing fast as
+    // soon as the backend is back.
+    while (_curr_pool_size.load() < _min_pool_size || _demand.load() > 0 ||
+           _backend_down.load())
+    {
+      if (!_ReserveSlot())
+      {
+        // Every client is in use; callers wait for one to be pushed back.
+        _backend_down = false;
+        break;
+      }
+      TClient *client = _NewConnectedClient();
+      if (!client)
+      {
+        _curr_pool_size--;
+        return false;
+      }
+      _WithdrawDemand();
+      if (!_AddNode(client))
+      {
+        LOG(error) << "No free slot left in " << _client_type << " pool";
+        delete client;
+        _curr_pool_size--;
+        break;
+      }
+      _PushIdle(client);
+      _backend_down = false;
+      _NotifyWaiters();
+    }
+    return true;
+  }
+
+  // Pings or retires the next idle client that is due in the current pass
+  // and returns false once none is left. *may_retire is cleared after the
+  // one retirement of the pass.
+  template <class TClient>
+  bool ClientPool<TClient>::_ValidateIdle(bool *may_retire)
+  {
+    long now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::system_clock::now().time_since_epoch())
+                   .count();
+    for (size_t i = 0; i < _num_shards; ++i)
+    {
+      // Detach the shard's stack and push its clients straight back, except
+      // the first one that is due, which is checked on its own.
+      std::atomic<uint64_t> *head = &_shards[i].head;
+      uint64_t old_head = head->load();
+      while (static_cast<uint32_t>(old_head) != 0 &&
+             !head->compare_exchange_weak(old_head,
+                                          ((old_head >> 32) + 1) << 32))
+      {
+      }
+      uint32_t next = static_cast<uint32_t>(old_head);
+      uint32_t due = 0;
+      bool retire = false;
+      while (next != 0)
+      {
+        uint32_t idx = next - 1;
+        next = _nodes[idx].next.load(std::memory_order_relaxed);
+        TClient *client = _nodes[idx].client;
+        if (due == 0 && *may_retire &&
+            now - client->_connect_timestamp > client->_keepalive_ms)
+        {
+          due = idx + 1;
+          retire = true;
+        }
+        else if (due == 0 && now - client->_last_used_timestamp >
+                                 CLIENT_POOL_VALIDATE_IDLE_MS)
+        {
+          due = idx + 1;
+        }
+        else
+        {
+          _StackPush(head, idx);
+        }
+      }
+      if (static_cast<uint32_t>(old_head) != 0)
+      {
+        _NotifyWaiters();
+      }
+      if (due == 0)
+      {
+        continue;
+      }
+
+      uint32_t idx = due - 1;
+      TClient *client = _nodes[idx].client;
+      bool keep = false;
+      if (retire)
+      {
+        *may_retire = false;
+      }
+      else
+      {
+        keep = client->Ping();
+        if (keep)
+        {
+          client->_last_used_timestamp = now;
+        }
+        else
+        {
+          LOG(warning) << "Evicting unresponsive " << _client_type
+                       << " client";
+        }
+      }
+
+      if (keep)
+      {
+        _StackPush(head, idx);
+        _NotifyWaiters();
+      }
+      else
+      {
+        Remove(client);
+      }
+      return true;
+    }
+    return false;
+  }
+
+  template <class TClient>
+  void ClientPool<TClient>::_ConnectorLoop()
+  {
+    std::unique_lock<std::mutex> lock(_connector_mtx);
+    auto next_attempt = std::chrono::steady_clock::now();
+    auto next_validation = next_attempt + CLIENT_POOL_MAINTAIN_INTERVAL;
+    bool validating = false;
+    bool may_retire = false;
+    while (!_stop)
+    {
+      if (std::chrono::steady_clock::now() < next_attempt)
+      {
+        // Backing off; wakeups from Pop() are ignored until the next attempt.
+        _connector_cv.wait_until(lock, next_attempt, [this]
+                                 { return _stop; });
+        continue;
+      }
+
+      _connector_wakeup = false;
+      lock.unlock();
+      if (!validating && std::chrono::steady_clock::now() >= next_validation)
+      {
+        validating = true;
+        may_retire = true;
+      }
+      // One client per iteration, so that _FillPool() runs between pings.
+      if (validating && !_ValidateIdle(&may_retire))
+      {
+        validating = false;
+        next_validation = std::chrono::steady_clock::now() +
+                          CLIENT_POOL_MAINTAIN_INTERVAL;
+      }
+      bool ok = _FillPool();
+      lock.lock();
+
+      if (ok)
+      {
+        _backoff = CLIENT_POOL_MIN_BACKOFF;
+        if (!validating)
+        {
+          _connector_cv.wait_for(lock, CLIENT_POOL_MAINTAIN_INTERVAL, [this]
+                                 { return _stop || _connector_wakeup; });
+        }
+      }
+      else
+      {
+        if (!_backend_down.exchange(true))
+        {
+          LOG(error) << "Failed to connect " << _client_type << " at "
+                     << _addr << ":" << _port << ", retrying in "
+                     << _backoff.count() << " ms";
+        }
+        ProbePoolConnectRetry(_client_type.c_str(), _addr.c_str(), _port,
+                              _backoff.count());
+        // Release every waiter so it fails fast instead of timing out.
+        {
+          std::lock_guard<ProfiledMutex> cv_lock(_mtx);
+        }
+        _cv.notify_all();
+        next_attempt = std::chrono::steady_clock::now() + _backoff;
+        _backoff = std::min(_backoff * 2, CLIENT_POOL_MAX_BACKOFF);
+      }
+    }
+  }
+
 } // namespace media_service
 
 #endif // MEDIA_MICROSERVICES_CLIENTPOOL_H
-
-// #ifndef MEDIA_MICROSERVICES_CLIENTPOOL_H
-// #define MEDIA_MICROSERVICES_CLIENTPOOL_H
-
-// #include <vector>
-// #include <mutex>
-// #include <condition_variable>
-// #include <deque>
-// #include <chrono>
-// #include <string>
-// #include <thread>
-
-// #include "logger.h"
-
-// namespace media_service
-// {
-
-//   template <class TClient>
-//   class ClientPool
-//   {
-//   public:
-//     ClientPool(const std::string &client_type, const std::string &addr,
-//                int port, int min_size, int max_size, int timeout_ms);
-//     ~ClientPool();
-
-//     ClientPool(const ClientPool &) = delete;
-//     ClientPool &operator=(const ClientPool &) = delete;
-//     ClientPool(ClientPool &&) = default;
-//     ClientPool &operator=(ClientPool &&) = default;
-
-//     TClient *Pop();
-//     void Push(TClient *);
-//     void Push(TClient *, int);
-//     void Remove(TClient *);
-//     void Keepalive(TClient *);
-
-//   private:
-//     std::deque<TClient *> _pool;
-//     std::string _addr;
-//     std::string _client_type;
-//     int _port;
-//     int _min_pool_size{};
-//     int _max_pool_size{};
-//     int _curr_pool_size{};
-//     int _timeout_ms;
-//     std::mutex _mtx;
-//     std::condition_variable _cv;
-//   };
-
-//   template <class TClient>
-//   ClientPool<TClient>::ClientPool(const std::string &client_type,
-//                                   const std::string &addr, int port, int min_pool_size,
-//                                   int max_pool_size, int timeout_ms)
-//   {
-//     _addr = addr;
-//     _port = port;
-//     _min_pool_size = min_pool_size;
-//     _max_pool_size = max_pool_size;
-//     _timeout_ms = timeout_ms;
-//     _client_type = client_type;
-
-//     for (int i = 0; i < min_pool_size; ++i)
-//     {
-//       TClient *client = new TClient(addr, port);
-//       _pool.emplace_back(client);
-//     }
-//     _curr_pool_size = min_pool_size;
-//   }
-
-//   template <class TClient>
-//   ClientPool<TClient>::~ClientPool()
-//   {
-//     while (!_pool.empty())
-//     {
-//       delete _pool.front();
-//       _pool.pop_front();
-//     }
-//   }
-
-//   template <class TClient>
-//   TClient *ClientPool<TClient>::Pop()
-//   {
-//     TClient *client = nullptr;
-//     std::unique_lock<std::mutex> cv_lock(_mtx);
-//     {
-//       while (_pool.size() == 0)
-//       {
-//         // Create a new client if current pool size is less than the max pool size.
-//         if (_curr_pool_size < _max_pool_size)
-//         {
-//           try
-//           {
-//             client = new TClient(_addr, _port);
-//             _curr_pool_size++;
-//             break;
-//           }
-//           catch (...)
-//           {
-//             cv_lock.unlock();
-//             return nullptr;
-//           }
-//         }
-//         else
-//         {
-//           auto wait_time = std::chrono::system_clock::now() +
-//                            std::chrono::milliseconds(_timeout_ms);
-//           bool wait_success = _cv.wait_until(cv_lock, wait_time,
-//                                              [this]
-//                                              { return _pool.size() > 0; });
-//           if (!wait_success)
-//           {
-//             LOG(warning) << "ClientPool pop timeout";
-//             cv_lock.unlock();
-//             return nullptr;
-//           }
-//         }
-//       }
-//       if (!client)
-//       {
-//         client = _pool.front();
-//         _pool.pop_front();
-//       }
-//     }
-//     cv_lock.unlock();
-
-//     if (client)
-//     {
-//       int retries = 3; // Number of retries
-//       while (retries > 0)
-//       {
-//         try
-//         {
-//           client->Connect();
-//           break;
-//         }
-//         catch (const apache::thrift::transport::TTransportException &e)
-//         {
-//           LOG(error) << "Failed to connect " + _client_type + ". Retries left: " << retries;
-//           std::this_thread::sleep_for(std::chrono::seconds(1)); // Wait before retrying
-//           retries--;
-//           if (retries == 0)
-//           {
-//             LOG(error) << "Max retries reached for " + _client_type;
-//             // Remove the problematic client and try to create a new one
-//             Remove(client);
-//             client = new TClient(_addr, _port);
-//             try
-//             {
-//               client->Connect();
-//               break;
-//             }
-//             catch (...)
-//             {
-//               delete client;
-//               cv_lock.lock();
-//               _curr_pool_size--;
-//               cv_lock.unlock();
-//               return nullptr;
-//             }
-//           }
-//         }
-//       }
-//     }
-//     return client;
-//   }
-
-//   // template <class TClient>
-//   // TClient *ClientPool<TClient>::Pop()
-//   // {
-//   //   TClient *client = nullptr;
-//   //   std::unique_lock<std::mutex> cv_lock(_mtx);
-//   //   {
-//   //     while (_pool.size() == 0)
-//   //     {
-//   //       // Create a new a client if current pool size is less than
-//   //       // the max pool size.
-//   //       if (_curr_pool_size < _max_pool_size)
-//   //       {
-//   //         try
-//   //         {
-//   //           client = new TClient(_addr, _port);
-//   //           _curr_pool_size++;
-//   //           break;
-//   //         }
-//   //         catch (...)
-//   //         {
-//   //           cv_lock.unlock();
-//   //           return nullptr;
-//   //         }
-//   //       }
-//   //       else
-//   //       {
-//   //         auto wait_time = std::chrono::system_clock::now() +
-//   //                          std::chrono::milliseconds(_timeout_ms);
-//   //         bool wait_success = _cv.wait_until(cv_lock, wait_time,
-//   //                                            [this]
-//   //                                            { return _pool.size() > 0; });
-//   //         if (!wait_success)
-//   //         {
-//   //           LOG(warning) << "ClientPool pop timeout";
-//   //           cv_lock.unlock();
-//   //           return nullptr;
-//   //         }
-//   //       }
-//   //     }
-//   //     if (!client)
-//   //     {
-//   //       client = _pool.front();
-//   //       _pool.pop_front();
-//   //     }
-
-//   //   } // cv_lock(_mtx)
-//   //   cv_lock.unlock();
-
-//   //   if (client)
-//   //   {
-//   //     try
-//   //     {
-//   //       client->Connect();
-//   //     }
-//   //     catch (...)
-//   //     {
-//   //       LOG(error) << "Failed to connect " + _client_type;
-//   //       _pool.push_back(client);
-//   //       throw;
-//   //     }
-//   //   }
-//   //   return client;
-//   // }
-
-//   template <class TClient>
-//   void ClientPool<TClient>::Push(TClient *client)
-//   {
-//     std::unique_lock<std::mutex> cv_lock(_mtx);
-//     client->KeepAlive();
-//     _pool.push_back(client);
-//     cv_lock.unlock();
-//     _cv.notify_one();
-//   }
-
-//   template <class TClient>
-//   void ClientPool<TClient>::Push(TClient *client, int timeout_ms)
-//   {
-//     std::unique_lock<std::mutex> cv_lock(_mtx);
-//     client->KeepAlive(timeout_ms);
-//     _pool.push_back(client);
-//     cv_lock.unlock();
-//     _cv.notify_one();
-//   }
-
-//   template <class TClient>
-//   void ClientPool<TClient>::Remove(TClient *client)
-//   {
-//     std::unique_lock<std::mutex> lock(_mtx);
-//     delete client;
-//     _curr_pool_size--;
-//     lock.unlock();
-//   }
-
-//   template <class TClient>
-//   void ClientPool<TClient>::Keepalive(TClient *client)
-//   {
-//     long curr_timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
-//                               std::chrono::system_clock::now().time_since_epoch())
-//                               .count();
-//     if (curr_timestamp - client->_connect_timestamp > client->_keepalive_ms)
-//     {
-//       Remove(client);
-//     }
-//     else
-//     {
-//       Push(client);
-//     }
-//   }
-
-// } // namespace media_service
-
-// #endif // MEDIA_MICROSERVICES_CLIENTPOOL_H
\ No newline at end of file
@@ -14,10 +14,12 @@
 #include "../../gen-cpp/ReviewStorageService.h"
 #include "../../gen-cpp/UserReviewService.h"
 #include "../../gen-cpp/MovieReviewService.h"
-#include "../ClientPool.h"
-#include "../ThriftClient.h"
+#include "../ThriftAsyncClient.h"
+#include "../MemcachedPool.h"
 #include "../logger.h"
+#include "RendezvousTable.h"
 #include "../tracing.h"
+#include "../probes.h"
 
 namespace media_service
 {
@@ -33,11 +35,15 @@ namespace media_service
   public:
     ComposeReviewHandler(
         memcached_pool_st *,
-        ClientPool<ThriftClient<ReviewStorageServiceClient>> *,
-        ClientPool<ThriftClient<UserReviewServiceClient>> *,
-        ClientPool<ThriftClient<MovieReviewServiceClient>> *);
+        ThriftAsyncClient<ReviewStorageServiceConcurrentClient> *,
+        ThriftAsyncClient<UserReviewServiceConcurrentClient> *,
+        ThriftAsyncClient<MovieReviewServiceConcurrentClient> *,
+        RendezvousTable *,
+        bool);
     ~ComposeReviewHandler() override = default;
 
+    void Ping() override {}
+
     void UploadText(int64_t, const std::string &,
                     const std::map<std::string, std::string> &) override;
     void UploadRating(int64_t, int32_t,
@@ -51,28 +57,160 @@ namespace media_service
 
   private:
     memcached_pool_st *_memcached_client_pool;
-    ClientPool<ThriftClient<ReviewStorageServiceClient>>
-        *_review_storage_client_pool;
-    ClientPool<ThriftClient<UserReviewServiceClient>>
-        *_user_review_client_pool;
-    ClientPool<ThriftClient<MovieReviewServiceClient>>
-        *_movie_review_client_pool;
+    ThriftAsyncClient<ReviewStorageServiceConcurrentClient>
+        *_review_storage_client;
+    ThriftAsyncClient<UserReviewServiceConcurrentClient>
+        *_user_review_client;
+    ThriftAsyncClient<MovieReviewServiceConcurrentClient>
+        *_movie_review_client;
+    // Gathers the components in process instead of memcached when set.
+    RendezvousTable *_rendezvous_table;
+    // Stores a component and bumps the counter in one round trip when set.
+    bool _memcached_pipeline;
+    template <class TSetter>
+    bool _UploadComponent(int64_t, ReviewComponent, TSetter, const char *,
+                          const std::string &,
+                          const std::map<std::string, std::string> &);
+    uint64_t _UploadComponentPipelined(int64_t, const std::string &,
+                                       const std::string &);
     void _ComposeAndUpload(int64_t, const std::map<std::string, std::string> &);
+    void _UploadReview(int64_t, Review &,
+                       const std::map<std::string, std::string> &);
   };
 
   ComposeReviewHandler::ComposeReviewHandler(
       memcached_pool_st *memcached_client_pool,
-      ClientPool<ThriftClient<ReviewStorageServiceClient>>
-          *review_storage_client_pool,
-      ClientPool<ThriftClient<UserReviewServiceClient>>
-          *user_review_client_pool,
-      ClientPool<ThriftClient<MovieReviewServiceClient>>
-          *movie_review_client_pool)
+      ThriftAsyncClient<ReviewStorageServiceConcurrentClient>
+          *review_storage_client,
+      ThriftAsyncClient<UserReviewServiceConcurrentClient>
+          *user_review_client,
+      ThriftAsyncClient<MovieReviewServiceConcurrentClient>
+          *movie_review_client,
+      RendezvousTable *rendezvous_table,
+      bool memcached_pipeline)
   {
     _memcached_client_pool = memcached_client_pool;
-    _review_storage_client_pool = review_storage_client_pool;
-    _user_review_client_pool = user_review_client_pool;
-    _movie_review_client_pool = movie_review_client_pool;
+    _review_storage_client = review_storage_client;
+    _user_review_client = user_review_client;
+    _movie_review_client = movie_review_client;
+    _rendezvous_table = rendezvous_table;
+    _memcached_pipeline = memcached_pipeline;
+  }
+
+  /*
+   * The upload modes other than the original add/add/increment sequence.
+   * With the rendezvous table, set fills the component into the partial
+   * review; with memcached_pipeline, value is stored under
+   * "<req_id>:<component>". Either way the upload that completes the review
+   * composes and uploads it. Returns false if neither mode is enabled.
+   */
+  template <class TSetter>
+  bool ComposeReviewHandler::_UploadComponent(
+      int64_t req_id, ReviewComponent component, TSetter set,
+      const char *name, const std::string &value,
+      const std::map<std::string, std::string> &writer_text_map)
+  {
+    if (_rendezvous_table)
+    {
+      Review new_review;
+      if (_rendezvous_table->Upload(req_id, component, set, &new_review))
+      {
+        _UploadReview(req_id, new_review, writer_text_map);
+      }
+      return true;
+    }
+
+    if (_memcached_pipeline)
+    {
+      if (_UploadComponentPipelined(req_id, name, value) >= NUM_COMPONENTS)
+      {
+        _ComposeAndUpload(req_id, writer_text_map);
+      }
+      return true;
+    }
+    return false;
+  }
+
+  /*
+   * Pipelined variant of the add/add/increment sequence. The component is
+   * written with a quiet set (NOREPLY, SETQ in the binary protocol), which
+   * is only buffered, and the counter with memcached_increment_with_initial(),
+   * which creates it on first use. The increment flushes the set, so both go
+   * out in one write and one reply comes back in one round trip. A failed
+   * SETQ does answer, and that answer is read in place of the increment's,
+   * so any error from the increment fails both and the connection is reset.
+   * Returns the counter value.
+   *
+   * Unlike add, the set cannot tell a repeated upload (a caller retrying
+   * after a transport error) from the first one, so a repeat counts twice.
+   * _ComposeAndUpload() makes up for that: in this mode any upload that
+   * sees the counter at NUM_COMPONENTS or above composes, but only if all
+   * components are present and it wins the req_id:composed claim.
+   */
+  uint64_t ComposeReviewHandler::_UploadComponentPipelined(
+      int64_t req_id, const std::string &component, const std::string &value)
+  {
+    memcached_return_t memcached_rc;
+    memcached_st *memcached_client = MemcachedPoolPop(
+        _memcached_client_pool, true, &memcached_rc);
+    if (!memcached_client)
+    {
+      ServiceException se;
+      se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
+      se.message = "Failed to pop a client from memcached pool";
+      throw RequestError(se);
+    }
+
+    std::string key_counter = std::to_string(req_id) + ":counter";
+    std::string key_component = std::to_string(req_id) + ":" + component;
+    memcached_behavior_set(memcached_client, MEMCACHED_BEHAVIOR_NOREPLY, 1);
+    memcached_behavior_set(
+        memcached_client, MEMCACHED_BEHAVIOR_BUFFER_REQUESTS, 1);
+    memcached_rc = memcached_set(
+        memcached_client,
+        key_component.c_str(),
+        key_component.size(),
+        value.c_str(),
+        value.size(),
+        MMC_EXP_TIME, 0);
+    memcached_behavior_set(
+        memcached_client, MEMCACHED_BEHAVIOR_BUFFER_REQUESTS, 0);
+    memcached_behavior_set(memcached_client, MEMCACHED_BEHAVIOR_NOREPLY, 0);
+    if (memcached_rc != MEMCACHED_BUFFERED &&
+        memcached_rc != MEMCACHED_SUCCESS)
+    {
+      LOG(error) << "Cannot store " << component << " of request " << req_id
+                 << " Error code: "
+                 << memcached_strerror(memcached_client, memcached_rc);
+      ServiceException se;
+      se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
+      se.message = memcached_strerror(memcached_client, memcached_rc);
+      memcached_quit(memcached_client);
+      MemcachedPoolPush(_memcached_client_pool, memcached_client);
+      throw RequestError(se);
+    }
+
+    uint64_t counter_value;
+    memcached_rc = memcached_increment_with_initial(
+        memcached_client,
+        key_counter.c_str(),
+        key_counter.size(),
+        1, 1, MMC_EXP_TIME, &counter_value);
+    if (memcached_rc != MEMCACHED_SUCCESS)
+    {
+      LOG(error) << "Cannot store " << component << " and increment the "
+                 << "counter of request " << req_id << " Error code: "
+                 << memcached_strerror(memcached_client, memcached_rc);
+      ServiceException se;
+      se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
+      se.message = memcached_strerror(memcached_client, memcached_rc);
+      // Drops whatever reply of the pair is still unread.
+      memcached_quit(memcached_client);
+      MemcachedPoolPush(_memcached_client_pool, memcached_client);
+      throw RequestError(se);
+    }
+    MemcachedPoolPush(_memcached_client_pool, memcached_client);
+    return counter_value;
   }
 
   void ComposeReviewHandler::_ComposeAndUpload(
@@ -101,16 +239,17 @@ namespace media_service
 
     // Compose a review from the components obtained from memcached
     memcached_return_t rc;
-    auto client = memcached_pool_pop(_memcached_client_pool, true, &rc);
+    auto client = MemcachedPoolPop(_memcached_client_pool, true, &rc);
     if (!client)
     {
       ServiceException se;
       se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
       se.message = "Failed to pop a client from memcached pool";
-      throw se;
+      throw RequestError(se);
     }
 
     Review new_review;
+    int num_received = 0;
     rc = memcached_mget(client, keys, key_sizes, NUM_COMPONENTS);
     if (rc != MEMCACHED_SUCCESS)
     {
@@ -119,8 +258,8 @@ namespace media_service
       ServiceException se;
       se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
       se.message = memcached_strerror(client, rc);
-      memcached_pool_push(_memcached_client_pool, client);
-      throw se;
+      MemcachedPoolPush(_memcached_client_pool, client);
+      throw RequestError(se);
     }
 
     char return_key[MEMCACHED_MAX_KEY];
@@ -143,15 +282,16 @@ namespace media_service
       {
         free(return_value);
         memcached_quit(client);
-        memcached_pool_push(_memcached_client_pool, client);
+        MemcachedPoolPush(_memcached_client_pool, client);
         LOG(error) << "Cannot get components of request " << req_id;
         ServiceException se;
         se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
         se.message = "Cannot get components of request " + std::to_string(req_id);
-        throw se;
+        throw RequestError(se);
       }
       std::string key_str(return_key, return_key + return_key_length);
       std::string value_str(return_value, return_value + return_value_length);
+      num_received++;
       if (key_str == key_unique_id)
       {
         new_review.review_id = std::stoul(value_str);
@@ -183,252 +323,115 @@ namespace media_service
                      std::to_string(req_id);
         free(return_value);
         memcached_quit(client);
-        memcached_pool_push(_memcached_client_pool, client);
-        throw se;
+        MemcachedPoolPush(_memcached_client_pool, client);
+        throw RequestError(se);
       }
       free(return_value);
     }
 
+    if (_memcached_pipeline)
+    {
+      // The counter may have been pushed to NUM_COMPONENTS by a repeated
+      // upload; the missing component's upload will try again.
+      if (num_received < NUM_COMPONENTS)
+      {
+        memcached_quit(client);
+        MemcachedPoolPush(_memcached_client_pool, client);
+        return;
+      }
+      std::string key_composed = std::to_string(req_id) + ":composed";
+      rc = memcached_add(client, key_composed.c_str(), key_composed.size(),
+                         "1", 1, MMC_EXP_TIME, 0);
+      if (rc != MEMCACHED_SUCCESS)
+      {
+        if (rc != MEMCACHED_DATA_EXISTS && rc != MEMCACHED_NOTSTORED)
+        {
+          LOG(error) << "Cannot claim the composition of request " << req_id
+                     << ": " << memcached_strerror(client, rc);
+        }
+        memcached_quit(client);
+        MemcachedPoolPush(_memcached_client_pool, client);
+        return;
+      }
+    }
+
     memcached_quit(client);
-    memcached_pool_push(_memcached_client_pool, client);
+    MemcachedPoolPush(_memcached_client_pool, client);
 
+    _UploadReview(req_id, new_review, writer_text_map);
+  }
+
+  void ComposeReviewHandler::_UploadReview(
+      int64_t req_id, Review &new_review,
+      const std::map<std::string, std::string> &writer_text_map)
+  {
     new_review.timestamp = duration_cast<milliseconds>(
                                system_clock::now().time_since_epoch())
                                .count();
     new_review.req_id = req_id;
 
-    std::future<void> review_future;
-    std::future<void> user_review_future;
-    std::future<void> movie_review_future;
-
-    // review_future = std::async(std::launch::async, [&](){
-    //   auto review_storage_client_wrapper = _review_storage_client_pool->Pop();
-    //   if (!review_storage_client_wrapper) {
-    //     ServiceException se;
-    //     se.errorCode = ErrorCode::SE_THRIFT_CONN_ERROR;
-    //     se.message = "Failed to connected to review-storage-service";
-    //     throw se;
-    //   }
-    //   auto review_storage_client = review_storage_client_wrapper->GetClient();
-    //   try {
-    //     review_storage_client->StoreReview(req_id, new_review, writer_text_map);
-    //   } catch (...) {
-    //     _review_storage_client_pool->Push(review_storage_client_wrapper);
-    //     LOG(error) << "Failed to upload review to review-storage-service";
-    //     throw;
-    //   }
-    //   _review_storage_client_pool->Push(review_storage_client_wrapper);
-    // });
-
-    review_future = std::async(std::launch::async, [&]()
-                               {
-    auto review_storage_client_wrapper = _review_storage_client_pool->Pop();
-    if (!review_storage_client_wrapper) {
-        ServiceException se;
-        se.errorCode = ErrorCode::SE_THRIFT_CONN_ERROR;
-        se.message = "Failed to connect to review-storage-service";
-        throw se;
-    }
-    auto review_storage_client = review_storage_client_wrapper->GetClient();
-    bool success = false;
-    int retry_count = 3; // Number of retries
-
-    while (!success && retry_count > 0) {
-        try {
-            review_storage_client->StoreReview(req_id, new_review, writer_text_map);
-            success = true;
-        } catch (const apache::thrift::transport::TTransportException &e) {
-            LOG(error) << "Transport exception: " << e.what() << ". Retries left: " << retry_count;
-            retry_count--;
-
-            // Handle specific "Broken pipe" scenario or any transport exception
-            if (retry_count > 0) {
-                // Remove the problematic client from the pool and try to get a new one
-                _review_storage_client_pool->Remove(review_storage_client_wrapper);
-                review_storage_client_wrapper = _review_storage_client_pool->Pop();
-                if (!review_storage_client_wrapper) {
-                    ServiceException se;
-                    se.errorCode = ErrorCode::SE_THRIFT_CONN_ERROR;
-                    se.message = "Failed to reconnect to review-storage-service";
-                    throw se;
-                }
-                review_storage_client = review_storage_client_wrapper->GetClient();
-            } else {
-                // If no retries left, push back the client and rethrow the exception
-                _review_storage_client_pool->Push(review_storage_client_wrapper);
-                LOG(error) << "Failed to upload review to review-storage-service after retries";
-                throw;
-            }
-        } catch (const std::exception &e) {
-            // Catch other standard exceptions and log them
-            LOG(error) << "Standard exception: " << e.what();
-            _review_storage_client_pool->Push(review_storage_client_wrapper);
-            throw;
-        } catch (...) {
-            // Catch any other exceptions and log them
-            LOG(error) << "Unknown exception caught";
-            _review_storage_client_pool->Push(review_storage_client_wrapper);
-            throw;
-        }
-    }
-    _review_storage_client_pool->Push(review_storage_client_wrapper); });
-
-    // user_review_future = std::async(std::launch::async, [&]()
-    //                                 {
-    // auto user_review_client_wrapper = _user_review_client_pool->Pop();
-    // if (!user_review_client_wrapper) {
-    //   ServiceException se;
-    //   se.errorCode = ErrorCode::SE_THRIFT_CONN_ERROR;
-    //   se.message = "Failed to connected to user-review-service";
-    //   throw se;
-    // }
-    // auto user_review_client = user_review_client_wrapper->GetClient();
-    // try {
-    //   user_review_client->UploadUserReview(req_id, new_review.user_id,
-    //       new_review.review_id, new_review.timestamp, writer_text_map);
-    // } catch (...) {
-    //   _user_review_client_pool->Push(user_review_client_wrapper);
-    //   LOG(error) << "Failed to upload review to user-review-service";
-    //   throw;
-    // }
-    // _user_review_client_pool->Push(user_review_client_wrapper); });
-
-    user_review_future = std::async(std::launch::async, [&]()
-                                    {
-    auto user_review_client_wrapper = _user_review_client_pool->Pop();
-    if (!user_review_client_wrapper) {
-        ServiceException se;
-        se.errorCode = ErrorCode::SE_THRIFT_CONN_ERROR;
-        se.message = "Failed to connect to user-review-service";
-        throw se;
+    // The three uploads are pipelined over the async clients' connections.
+    // The send closures capture by value because a failed-over call may be
+    // sent again.
+    auto review_future = _review_storage_client->Call(
+        [=](ReviewStorageServiceConcurrentClient *client)
+        {
+          return client->send_StoreReview(req_id, new_review, writer_text_map);
+        },
+        [](ReviewStorageServiceConcurrentClient *client, int32_t seqid)
+        {
+          client->recv_StoreReview(seqid);
+        });
+
+    auto user_review_future = _user_review_client->Call(
+        [=](UserReviewServiceConcurrentClient *client)
+        {
+          return client->send_UploadUserReview(
+              req_id, new_review.user_id, new_review.review_id,
+              new_review.timestamp, writer_text_map);
+        },
+        [](UserReviewServiceConcurrentClient *client, int32_t seqid)
+        {
+          client->recv_UploadUserReview(seqid);
+        });
+
+    auto movie_review_future = _movie_review_client->Call(
+        [=](MovieReviewServiceConcurrentClient *client)
+        {
+          return client->send_UploadMovieReview(
+              req_id, new_review.movie_id, new_review.review_id,
+              new_review.timestamp, writer_text_map);
+        },
+        [](MovieReviewServiceConcurrentClient *client, int32_t seqid)
+        {
+          client->recv_UploadMovieReview(seqid);
+        });
+
+    try
+    {
+      review_future.get();
     }
-    auto user_review_client = user_review_client_wrapper->GetClient();
-    bool success = false;
-    int retry_count = 3; // Number of retries
-
-    while (!success && retry_count > 0) {
-        try {
-            user_review_client->UploadUserReview(req_id, new_review.user_id,
-                new_review.review_id, new_review.timestamp, writer_text_map);
-            success = true;
-        } catch (const apache::thrift::transport::TTransportException &e) {
-            LOG(error) << "Transport exception: " << e.what() << ". Retries left: " << retry_count;
-            retry_count--;
-
-            // Handle specific "Broken pipe" scenario or any transport exception
-            if (retry_count > 0) {
-                // Remove the problematic client from the pool and try to get a new one
-                _user_review_client_pool->Remove(user_review_client_wrapper);
-                user_review_client_wrapper = _user_review_client_pool->Pop();
-                if (!user_review_client_wrapper) {
-                    ServiceException se;
-                    se.errorCode = ErrorCode::SE_THRIFT_CONN_ERROR;
-                    se.message = "Failed to reconnect to user-review-service";
-                    throw se;
-                }
-                user_review_client = user_review_client_wrapper->GetClient();
-            } else {
-                // If no retries left, push back the client and rethrow the exception
-                _user_review_client_pool->Push(user_review_client_wrapper);
-                LOG(error) << "Failed to upload review to user-review-service after retries";
-                throw;
-            }
-        } catch (const std::exception &e) {
-            // Catch other standard exceptions and log them
-            LOG(error) << "Standard exception: " << e.what();
-            _user_review_client_pool->Push(user_review_client_wrapper);
-            throw;
-        } catch (...) {
-            // Catch any other exceptions and log them
-            LOG(error) << "Unknown exception caught";
-            _user_review_client_pool->Push(user_review_client_wrapper);
-            throw;
-        }
+    catch (...)
+    {
+      LOG(error) << "Failed to upload review to review-storage-service";
+      throw;
     }
-    _user_review_client_pool->Push(user_review_client_wrapper); });
-
-    // movie_review_future = std::async(std::launch::async, [&]()
-    //                                  {
-    // auto movie_review_client_wrapper = _movie_review_client_pool->Pop();
-    // if (!movie_review_client_wrapper) {
-    //   ServiceException se;
-    //   se.errorCode = ErrorCode::SE_THRIFT_CONN_ERROR;
-    //   se.message = "Failed to connected to movie-review-service";
-    //   throw se;
-    // }
-    // auto movie_review_client = movie_review_client_wrapper->GetClient();
-    // try {
-    //   movie_review_client->UploadMovieReview(req_id, new_review.movie_id,
-    //       new_review.review_id, new_review.timestamp, writer_text_map);
-    // } catch (...) {
-    //   _movie_review_client_pool->Push(movie_review_client_wrapper);
-    //   LOG(error) << "Failed to upload review to movie-review-service";
-    //   throw;
-    // }
-    // _movie_review_client_pool->Push(movie_review_client_wrapper); });
-
-    movie_review_future = std::async(std::launch::async, [&]()
-                                     {
-    auto movie_review_client_wrapper = _movie_review_client_pool->Pop();
-    if (!movie_review_client_wrapper) {
-        ServiceException se;
-        se.errorCode = ErrorCode::SE_THRIFT_CONN_ERROR;
-        se.message = "Failed to connect to movie-review-service";
-        throw se;
+    try
+    {
+      user_review_future.get();
     }
-    auto movie_review_client = movie_review_client_wrapper->GetClient();
-    bool success = false;
-    int retry_count = 3; // Number of retries
-
-    while (!success && retry_count > 0) {
-        try {
-            movie_review_client->UploadMovieReview(req_id, new_review.movie_id,
-                new_review.review_id, new_review.timestamp, writer_text_map);
-            success = true;
-        } catch (const apache::thrift::transport::TTransportException &e) {
-            LOG(error) << "Transport exception: " << e.what() << ". Retries left: " << retry_count;
-            retry_count--;
-
-            // Handle specific "Broken pipe" scenario or any transport exception
-            if (retry_count > 0) {
-                // Remove the problematic client from the pool and try to get a new one
-                _movie_review_client_pool->Remove(movie_review_client_wrapper);
-                movie_review_client_wrapper = _movie_review_client_pool->Pop();
-                if (!movie_review_client_wrapper) {
-                    ServiceException se;
-                    se.errorCode = ErrorCode::SE_THRIFT_CONN_ERROR;
-                    se.message = "Failed to reconnect to movie-review-service";
-                    throw se;
-                }
-                movie_review_client = movie_review_client_wrapper->GetClient();
-            } else {
-                // If no retries left, push back the client and rethrow the exception
-                _movie_review_client_pool->Push(movie_review_client_wrapper);
-                LOG(error) << "Failed to upload review to movie-review-service after retries";
-                throw;
-            }
-        } catch (const std::exception &e) {
-            // Catch other standard exceptions and log them
-            LOG(error) << "Standard exception: " << e.what();
-            _movie_review_client_pool->Push(movie_review_client_wrapper);
-            throw;
-        } catch (...) {
-            // Catch any other exceptions and log them
-            LOG(error) << "Unknown exception caught";
-            _movie_review_client_pool->Push(movie_review_client_wrapper);
-            throw;
-        }
+    catch (...)
+    {
+      LOG(error) << "Failed to upload review to user-review-service";
+      throw;
     }
-    _movie_review_client_pool->Push(movie_review_client_wrapper); });
-
     try
     {
-      review_future.get();
-      user_review_future.get();
       movie_review_future.get();
     }
     catch (...)
     {
+      LOG(error) << "Failed to upload review to movie-review-service";
       throw;
     }
   }
@@ -440,18 +443,23 @@ namespace media_service
   {
 
     // Initialize a span
-    TextMapReader reader(carrier);
-    std::map<std::string, std::string> writer_text_map;
-    TextMapWriter writer(writer_text_map);
-    auto parent_span = opentracing::Tracer::Global()->Extract(reader);
-    auto span = opentracing::Tracer::Global()->StartSpan(
-        "UploadMovieId",
-        {opentracing::ChildOf(parent_span->get())});
-    opentracing::Tracer::Global()->Inject(span->context(), writer);
+    auto span = TraceSpan::Start("UploadMovieId", carrier);
+    RequestProbe probe(req_id, "UploadMovieId", span.GetTraceId());
+    auto &writer_text_map = span.Carrier();
+
+    if (_UploadComponent(
+            req_id, REVIEW_COMPONENT_MOVIE_ID,
+            [&](Review *review)
+            { review->movie_id = movie_id; },
+            "movie_id", movie_id, writer_text_map))
+    {
+      span.Finish();
+      return;
+    }
 
     memcached_return_t memcached_rc;
     std::string key_counter = std::to_string(req_id) + ":counter";
-    memcached_st *memcached_client = memcached_pool_pop(
+    memcached_st *memcached_client = MemcachedPoolPop(
         _memcached_client_pool, true, &memcached_rc);
 
     // Initialize the counter to 0 if there it is not in the memcached
@@ -471,8 +479,8 @@ namespace media_service
       ServiceException se;
       se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
       se.message = memcached_strerror(memcached_client, memcached_rc);
-      memcached_pool_push(_memcached_client_pool, memcached_client);
-      throw se;
+      MemcachedPoolPush(_memcached_client_pool, memcached_client);
+      throw RequestError(se);
     }
 
     // Store movie_id to memcached
@@ -504,8 +512,8 @@ namespace media_service
         ServiceException se;
         se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
         se.message = memcached_strerror(memcached_client, memcached_rc);
-        memcached_pool_push(_memcached_client_pool, memcached_client);
-        throw se;
+        MemcachedPoolPush(_memcached_client_pool, memcached_client);
+        throw RequestError(se);
       }
       counter_value = std::stoul(counter_value_str);
       free(counter_value_str);
@@ -516,8 +524,8 @@ namespace media_service
       ServiceException se;
       se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
       se.message = memcached_strerror(memcached_client, memcached_rc);
-      memcached_pool_push(_memcached_client_pool, memcached_client);
-      throw se;
+      MemcachedPoolPush(_memcached_client_pool, memcached_client);
+      throw RequestError(se);
     }
     else
     {
@@ -534,13 +542,13 @@ namespace media_service
         ServiceException se;
         se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
         se.message = memcached_strerror(memcached_client, memcached_rc);
-        memcached_pool_push(_memcached_client_pool, memcached_client);
-        throw se;
+        MemcachedPoolPush(_memcached_client_pool, memcached_client);
+        throw RequestError(se);
       }
     }
     LOG(debug) << "req_id " << req_id
                << " caching movie_id to Memcached finished";
-    memcached_pool_push(_memcached_client_pool, memcached_client);
+    MemcachedPoolPush(_memcached_client_pool, memcached_client);
 
     // If this thread is the last one uploading the review components,
     // it is in charge of compose the request and upload to the microservices in
@@ -549,7 +557,7 @@ namespace media_service
     {
       _ComposeAndUpload(req_id, writer_text_map);
     }
-    span->Finish();
+    span.Finish();
   }
 
   void ComposeReviewHandler::UploadUserId(
@@ -558,18 +566,23 @@ namespace media_service
   {
 
     // Initialize a span
-    TextMapReader reader(carrier);
-    std::map<std::string, std::string> writer_text_map;
-    TextMapWriter writer(writer_text_map);
-    auto parent_span = opentracing::Tracer::Global()->Extract(reader);
-    auto span = opentracing::Tracer::Global()->StartSpan(
-        "UploadUserId",
-        {opentracing::ChildOf(parent_span->get())});
-    opentracing::Tracer::Global()->Inject(span->context(), writer);
+    auto span = TraceSpan::Start("UploadUserId", carrier);
+    RequestProbe probe(req_id, "UploadUserId", span.GetTraceId());
+    auto &writer_text_map = span.Carrier();
+
+    if (_UploadComponent(
+            req_id, REVIEW_COMPONENT_USER_ID,
+            [&](Review *review)
+            { review->user_id = user_id; },
+            "user_id", std::to_string(user_id), writer_text_map))
+    {
+      span.Finish();
+      return;
+    }
 
     memcached_return_t memcached_rc;
     std::string key_counter = std::to_string(req_id) + ":counter";
-    memcached_st *memcached_client = memcached_pool_pop(
+    memcached_st *memcached_client = MemcachedPoolPop(
         _memcached_client_pool, true, &memcached_rc);
 
     // Initialize the counter to 0 if there it is not in the memcached
@@ -589,8 +602,8 @@ namespace media_service
       ServiceException se;
       se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
       se.message = memcached_strerror(memcached_client, memcached_rc);
-      memcached_pool_push(_memcached_client_pool, memcached_client);
-      throw se;
+      MemcachedPoolPush(_memcached_client_pool, memcached_client);
+      throw RequestError(se);
     }
 
     // Store user_id to memcached
@@ -623,8 +636,8 @@ namespace media_service
         ServiceException se;
         se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
         se.message = memcached_strerror(memcached_client, memcached_rc);
-        memcached_pool_push(_memcached_client_pool, memcached_client);
-        throw se;
+        MemcachedPoolPush(_memcached_client_pool, memcached_client);
+        throw RequestError(se);
       }
       counter_value = std::stoul(counter_value_str);
       free(counter_value_str);
@@ -637,8 +650,8 @@ namespace media_service
       ServiceException se;
       se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
       se.message = memcached_strerror(memcached_client, memcached_rc);
-      memcached_pool_push(_memcached_client_pool, memcached_client);
-      throw se;
+      MemcachedPoolPush(_memcached_client_pool, memcached_client);
+      throw RequestError(se);
     }
     else
     {
@@ -655,12 +668,12 @@ namespace media_service
         ServiceException se;
         se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
         se.message = memcached_strerror(memcached_client, memcached_rc);
-        memcached_pool_push(_memcached_client_pool, memcached_client);
-        throw se;
+        MemcachedPoolPush(_memcached_client_pool, memcached_client);
+        throw RequestError(se);
       }
     }
     LOG(debug) << "req_id " << req_id << "caching user to Memcached finished";
-    memcached_pool_push(_memcached_client_pool, memcached_client);
+    MemcachedPoolPush(_memcached_client_pool, memcached_client);
 
     // If this thread is the last one uploading the review components,
     // it is in charge of compose the request and upload to the microservices in
@@ -669,7 +682,7 @@ namespace media_service
     {
       _ComposeAndUpload(req_id, writer_text_map);
     }
-    span->Finish();
+    span.Finish();
   }
 
   void ComposeReviewHandler::UploadUniqueId(
@@ -678,18 +691,23 @@ namespace media_service
   {
 
     // Initialize a span
-    TextMapReader reader(carrier);
-    std::map<std::string, std::string> writer_text_map;
-    TextMapWriter writer(writer_text_map);
-    auto parent_span = opentracing::Tracer::Global()->Extract(reader);
-    auto span = opentracing::Tracer::Global()->StartSpan(
-        "UploadUniqueId",
-        {opentracing::ChildOf(parent_span->get())});
-    opentracing::Tracer::Global()->Inject(span->context(), writer);
+    auto span = TraceSpan::Start("UploadUniqueId", carrier);
+    RequestProbe probe(req_id, "UploadUniqueId", span.GetTraceId());
+    auto &writer_text_map = span.Carrier();
+
+    if (_UploadComponent(
+            req_id, REVIEW_COMPONENT_UNIQUE_ID,
+            [&](Review *review)
+            { review->review_id = review_id; },
+            "review_id", std::to_string(review_id), writer_text_map))
+    {
+      span.Finish();
+      return;
+    }
 
     memcached_return_t memcached_rc;
     std::string key_counter = std::to_string(req_id) + ":counter";
-    memcached_st *memcached_client = memcached_pool_pop(
+    memcached_st *memcached_client = MemcachedPoolPop(
         _memcached_client_pool, true, &memcached_rc);
 
     // Initialize the counter to 0 if there it is not in the memcached
@@ -709,8 +727,8 @@ namespace media_service
       ServiceException se;
       se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
       se.message = memcached_strerror(memcached_client, memcached_rc);
-      memcached_pool_push(_memcached_client_pool, memcached_client);
-      throw se;
+      MemcachedPoolPush(_memcached_client_pool, memcached_client);
+      throw RequestError(se);
     }
 
     // Store review_id to memcached
@@ -744,8 +762,8 @@ namespace media_service
         ServiceException se;
         se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
         se.message = memcached_strerror(memcached_client, memcached_rc);
-        memcached_pool_push(_memcached_client_pool, memcached_client);
-        throw se;
+        MemcachedPoolPush(_memcached_client_pool, memcached_client);
+        throw RequestError(se);
       }
       counter_value = std::stoul(counter_value_str);
       free(counter_value_str);
@@ -756,8 +774,8 @@ namespace media_service
       ServiceException se;
       se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
       se.message = memcached_strerror(memcached_client, memcached_rc);
-      memcached_pool_push(_memcached_client_pool, memcached_client);
-      throw se;
+      MemcachedPoolPush(_memcached_client_pool, memcached_client);
+      throw RequestError(se);
     }
     else
     {
@@ -774,14 +792,14 @@ namespace media_service
         ServiceException se;
         se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
         se.message = memcached_strerror(memcached_client, memcached_rc);
-        memcached_pool_push(_memcached_client_pool, memcached_client);
-        throw se;
+        MemcachedPoolPush(_memcached_client_pool, memcached_client);
+        throw RequestError(se);
       }
     }
     LOG(debug) << "req_id " << req_id
                << " caching review_id to Memcached finished";
 
-    memcached_pool_push(_memcached_client_pool, memcached_client);
+    MemcachedPoolPush(_memcached_client_pool, memcached_client);
 
     // If this thread is the last one uploading the review components,
     // it is in charge of compose the request and upload to the microservices in
@@ -790,7 +808,7 @@ namespace media_service
     {
       _ComposeAndUpload(req_id, writer_text_map);
     }
-    span->Finish();
+    span.Finish();
   }
 
   void ComposeReviewHandler::UploadText(
@@ -800,18 +818,23 @@ namespace media_service
   {
 
     // Initialize a span
-    TextMapReader reader(carrier);
-    std::map<std::string, std::string> writer_text_map;
-    TextMapWriter writer(writer_text_map);
-    auto parent_span = opentracing::Tracer::Global()->Extract(reader);
-    auto span = opentracing::Tracer::Global()->StartSpan(
-        "UploadText",
-        {opentracing::ChildOf(parent_span->get())});
-    opentracing::Tracer::Global()->Inject(span->context(), writer);
+    auto span = TraceSpan::Start("UploadText", carrier);
+    RequestProbe probe(req_id, "UploadText", span.GetTraceId());
+    auto &writer_text_map = span.Carrier();
+
+    if (_UploadComponent(
+            req_id, REVIEW_COMPONENT_TEXT,
+            [&](Review *review)
+            { review->text = text; },
+            "text", text, writer_text_map))
+    {
+      span.Finish();
+      return;
+    }
 
     memcached_return_t memcached_rc;
     std::string key_counter = std::to_string(req_id) + ":counter";
-    memcached_st *memcached_client = memcached_pool_pop(
+    memcached_st *memcached_client = MemcachedPoolPop(
         _memcached_client_pool, true, &memcached_rc);
 
     // Initialize the counter to 0 if there it is not in the memcached
@@ -831,8 +854,8 @@ namespace media_service
       ServiceException se;
       se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
       se.message = memcached_strerror(memcached_client, memcached_rc);
-      memcached_pool_push(_memcached_client_pool, memcached_client);
-      throw se;
+      MemcachedPoolPush(_memcached_client_pool, memcached_client);
+      throw RequestError(se);
     }
 
     // Store text to memcached
@@ -864,8 +887,8 @@ namespace media_service
         ServiceException se;
         se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
         se.message = memcached_strerror(memcached_client, memcached_rc);
-        memcached_pool_push(_memcached_client_pool, memcached_client);
-        throw se;
+        MemcachedPoolPush(_memcached_client_pool, memcached_client);
+        throw RequestError(se);
       }
       counter_value = std::stoul(counter_value_str);
       free(counter_value_str);
@@ -876,8 +899,8 @@ namespace media_service
       ServiceException se;
       se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
       se.message = memcached_strerror(memcached_client, memcached_rc);
-      memcached_pool_push(_memcached_client_pool, memcached_client);
-      throw se;
+      MemcachedPoolPush(_memcached_client_pool, memcached_client);
+      throw RequestError(se);
     }
     else
     {
@@ -894,12 +917,12 @@ namespace media_service
         ServiceException se;
         se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
         se.message = memcached_strerror(memcached_client, memcached_rc);
-        memcached_pool_push(_memcached_client_pool, memcached_client);
-        throw se;
+        MemcachedPoolPush(_memcached_client_pool, memcached_client);
+        throw RequestError(se);
       }
     }
     LOG(debug) << "req_id " << req_id << "caching text to Memcached finished";
-    memcached_pool_push(_memcached_client_pool, memcached_client);
+    MemcachedPoolPush(_memcached_client_pool, memcached_client);
 
     // If this thread is the last one uploading the review components,
     // it is in charge of compose the request and upload to the microservices in
@@ -908,7 +931,7 @@ namespace media_service
     {
       _ComposeAndUpload(req_id, writer_text_map);
     }
-    span->Finish();
+    span.Finish();
   }
 
   void ComposeReviewHandler::UploadRating(
@@ -916,18 +939,23 @@ namespace media_service
   {
 
     // Initialize a span
-    TextMapReader reader(carrier);
-    std::map<std::string, std::string> writer_text_map;
-    TextMapWriter writer(writer_text_map);
-    auto parent_span = opentracing::Tracer::Global()->Extract(reader);
-    auto span = opentracing::Tracer::Global()->StartSpan(
-        "UploadRating",
-        {opentracing::ChildOf(parent_span->get())});
-    opentracing::Tracer::Global()->Inject(span->context(), writer);
+    auto span = TraceSpan::Start("UploadRating", carrier);
+    RequestProbe probe(req_id, "UploadRating", span.GetTraceId());
+    auto &writer_text_map = span.Carrier();
+
+    if (_UploadComponent(
+            req_id, REVIEW_COMPONENT_RATING,
+            [&](Review *review)
+            { review->rating = rating; },
+            "rating", std::to_string(rating), writer_text_map))
+    {
+      span.Finish();
+      return;
+    }
 
     memcached_return_t memcached_rc;
     std::string key_counter = std::to_string(req_id) + ":counter";
-    memcached_st *memcached_client = memcached_pool_pop(
+    memcached_st *memcached_client = MemcachedPoolPop(
         _memcached_client_pool, true, &memcached_rc);
 
     // Initialize the counter to 0 if there it is not in the memcached
@@ -946,8 +974,8 @@ namespace media_service
       ServiceException se;
       se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
       se.message = memcached_strerror(memcached_client, memcached_rc);
-      memcached_pool_push(_memcached_client_pool, memcached_client);
-      throw se;
+      MemcachedPoolPush(_memcached_client_pool, memcached_client);
+      throw RequestError(se);
     }
 
     // Store rating to memcached
@@ -982,8 +1010,8 @@ namespace media_service
         ServiceException se;
         se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
         se.message = memcached_strerror(memcached_client, memcached_rc);
-        memcached_pool_push(_memcached_client_pool, memcached_client);
-        throw se;
+        MemcachedPoolPush(_memcached_client_pool, memcached_client);
+        throw RequestError(se);
       }
     }
     else if (memcached_rc != MEMCACHED_SUCCESS)
@@ -992,8 +1020,8 @@ namespace media_service
       ServiceException se;
       se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
       se.message = memcached_strerror(memcached_client, memcached_rc);
-      memcached_pool_push(_memcached_client_pool, memcached_client);
-      throw se;
+      MemcachedPoolPush(_memcached_client_pool, memcached_client);
+      throw RequestError(se);
     }
     else
     {
@@ -1010,12 +1038,12 @@ namespace media_service
         ServiceException se;
         se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
         se.message = memcached_strerror(memcached_client, memcached_rc);
-        memcached_pool_push(_memcached_client_pool, memcached_client);
-        throw se;
+        MemcachedPoolPush(_memcached_client_pool, memcached_client);
+        throw RequestError(se);
       }
     }
     LOG(debug) << "req_id " << req_id << " caching rating to Memcached finished";
-    memcached_pool_push(_memcached_client_pool, memcached_client);
+    MemcachedPoolPush(_memcached_client_pool, memcached_client);
 
     // If this thread is the last one uploading the review components,
     // it is in charge of compose the request and upload to the microservices in
@@ -1024,7 +1052,7 @@ namespace media_service
     {
       _ComposeAndUpload(req_id, writer_text_map);
     }
-    span->Finish();
+    span.Finish();
   }
 
 } // namespace media_service
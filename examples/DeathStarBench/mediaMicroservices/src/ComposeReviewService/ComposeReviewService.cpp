@@ -1,18 +1,11 @@
-#include <thrift/protocol/TBinaryProtocol.h>
-#include <thrift/server/TThreadedServer.h>
-#include <thrift/transport/TServerSocket.h>
-#include <thrift/transport/TBufferTransports.h>
 #include <signal.h>
 
 #include "ComposeReviewHandler.h"
 #include "../utils.h"
+#include "../utils_thrift.h"
 #include "../utils_memcached.h"
 
 using json = nlohmann::json;
-using apache::thrift::server::TThreadedServer;
-using apache::thrift::transport::TServerSocket;
-using apache::thrift::transport::TFramedTransportFactory;
-using apache::thrift::protocol::TBinaryProtocolFactory;
 using namespace media_service;
 
 void sigintHandler(int sig) {
@@ -30,7 +23,6 @@ int main(int argc, char *argv[]) {
     exit(EXIT_FAILURE);
   }
 
-  int port = config_json["compose-review-service"]["port"];
   std::string review_storage_addr =
       config_json["review-storage-service"]["addr"];
   int review_storage_port = config_json["review-storage-service"]["port"];
@@ -41,12 +33,22 @@ int main(int argc, char *argv[]) {
   std::string movie_review_addr = config_json["movie-review-service"]["addr"];
   int movie_review_port = config_json["movie-review-service"]["port"];
 
-  ClientPool<ThriftClient<ReviewStorageServiceClient>> compose_client_pool(
-      "compose-review-service", review_storage_addr, review_storage_port, 0, 128, 1000);
-  ClientPool<ThriftClient<UserReviewServiceClient>> user_client_pool(
-      "user-review-service", user_review_addr, user_review_port, 0, 128, 1000);
-  ClientPool<ThriftClient<MovieReviewServiceClient>> movie_client_pool(
-      "movie-review-service", movie_review_addr, movie_review_port, 0, 128, 1000);
+  json async_json = config_json["compose-review-service"].value(
+      "async_client", json::object());
+  int async_connections = async_json.value(
+      "connections", THRIFT_ASYNC_DEFAULT_CONNECTIONS);
+  int async_timeout_ms = async_json.value(
+      "timeout_ms", THRIFT_ASYNC_DEFAULT_TIMEOUT_MS);
+
+  ThriftAsyncClient<ReviewStorageServiceConcurrentClient> compose_client(
+      "review-storage-service", review_storage_addr, review_storage_port,
+      async_connections, async_timeout_ms);
+  ThriftAsyncClient<UserReviewServiceConcurrentClient> user_client(
+      "user-review-service", user_review_addr, user_review_port,
+      async_connections, async_timeout_ms);
+  ThriftAsyncClient<MovieReviewServiceConcurrentClient> movie_client(
+      "movie-review-service", movie_review_addr, movie_review_port,
+      async_connections, async_timeout_ms);
 
 
   std::string mmc_addr = config_json["compose-review-memcached"]["addr"];
@@ -60,19 +62,40 @@ int main(int argc, char *argv[]) {
   auto memcached_client_pool = memcached_pool_create(
       memcached_client, MEMCACHED_POOL_MIN_SIZE, MEMCACHED_POOL_MAX_SIZE);
 
-  TThreadedServer server(
+  // With "rendezvous" enabled the components of a review are gathered in
+  // process. The callers route uploads by req_id, so this is safe with
+  // several replicas as long as they are all listed under "replicas".
+  std::unique_ptr<RendezvousTable> rendezvous_table;
+  json service_json = config_json["compose-review-service"];
+  if (service_json.contains("rendezvous") &&
+      service_json["rendezvous"].value("enabled", false)) {
+    int shards = service_json["rendezvous"].value("shards", 64);
+    int ttl_ms = service_json["rendezvous"].value("ttl_ms", MMC_EXP_TIME * 1000);
+    if (shards <= 0 || ttl_ms <= 0) {
+      LOG(fatal) << "Invalid rendezvous settings for compose-review-service";
+      exit(EXIT_FAILURE);
+    }
+    // Fails on an empty or duplicated "replicas" list, which the callers
+    // would otherwise hash onto.
+    auto replicas = get_service_replicas(config_json, "compose-review-service");
+    rendezvous_table.reset(new RendezvousTable(shards, ttl_ms));
+    LOG(info) << "Gathering review components in process, one of "
+              << replicas.size() << " replicas";
+  }
+
+  start_observability(config_json, "compose-review-service");
+  auto server = init_thrift_server(
+      config_json, "compose-review-service",
       std::make_shared<ComposeReviewServiceProcessor>(
           std::make_shared<ComposeReviewHandler>(
               memcached_client_pool,
-              &compose_client_pool,
-              &user_client_pool,
-              &movie_client_pool)),
-      std::make_shared<TServerSocket>("0.0.0.0", port),
-      std::make_shared<TFramedTransportFactory>(),
-      std::make_shared<TBinaryProtocolFactory>()
-  );
+              &compose_client,
+              &user_client,
+              &movie_client,
+              rendezvous_table.get(),
+              service_json.value("memcached_pipeline", false))));
   std::cout << "Starting the compose-review-service server ..." << std::endl;
-  server.serve();
+  server->serve();
 }
 
 
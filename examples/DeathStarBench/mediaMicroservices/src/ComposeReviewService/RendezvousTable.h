@@ -0,0 +1,168 @@
+#ifndef MEDIA_MICROSERVICES_RENDEZVOUSTABLE_H
+#define MEDIA_MICROSERVICES_RENDEZVOUSTABLE_H
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+#include "../../gen-cpp/media_service_types.h"
+#include "../logger.h"
+
+namespace media_service
+{
+
+  enum ReviewComponent
+  {
+    REVIEW_COMPONENT_UNIQUE_ID = 0,
+    REVIEW_COMPONENT_MOVIE_ID,
+    REVIEW_COMPONENT_USER_ID,
+    REVIEW_COMPONENT_TEXT,
+    REVIEW_COMPONENT_RATING,
+    REVIEW_COMPONENT_COUNT
+  };
+
+  /*
+   * In-process replacement for the memcached counters ComposeReviewHandler
+   * uses to gather the five components of a review. Partial reviews are
+   * kept in shards keyed by req_id; the upload that delivers the last
+   * component takes the composed review out of the table. Reviews that are
+   * still incomplete after ttl_ms are dropped, like the memcached keys
+   * expiring after MMC_EXP_TIME.
+   *
+   * This only works if all five uploads of a request reach the same
+   * replica, so the callers route them by req_id (see AffinityClientPool).
+   */
+  class RendezvousTable
+  {
+  public:
+    RendezvousTable(int num_shards, int ttl_ms);
+
+    RendezvousTable(const RendezvousTable &) = delete;
+    RendezvousTable &operator=(const RendezvousTable &) = delete;
+
+    // Stores one component with set(&partial_review). Returns true, with the
+    // composed review in *review, to the one caller that completes it. A
+    // component uploaded twice is ignored.
+    template <class TSetter>
+    bool Upload(int64_t req_id, ReviewComponent component, TSetter set,
+                Review *review);
+
+    size_t Size();
+
+  private:
+    struct Entry
+    {
+      Review review;
+      uint32_t received = 0;
+      std::chrono::steady_clock::time_point deadline;
+    };
+
+    // The trailing pad keeps neighbouring shards off each other's cache
+    // lines without over-aligning the array.
+    struct Shard
+    {
+      std::mutex mtx;
+      std::unordered_map<int64_t, Entry> entries;
+      // Deadlines in insertion order, which is also deadline order.
+      std::deque<std::pair<std::chrono::steady_clock::time_point, int64_t>>
+          expiry;
+      char pad[64];
+    };
+
+    Shard &_ShardOf(int64_t req_id);
+    void _Expire(Shard *shard, std::chrono::steady_clock::time_point now);
+
+    std::unique_ptr<Shard[]> _shards;
+    size_t _num_shards;
+    std::chrono::milliseconds _ttl;
+  };
+
+  constexpr uint32_t REVIEW_COMPONENTS_ALL =
+      (1u << REVIEW_COMPONENT_COUNT) - 1;
+
+  RendezvousTable::RendezvousTable(int num_shards, int ttl_ms)
+  {
+    _num_shards = static_cast<size_t>(std::max(num_shards, 1));
+    _shards.reset(new Shard[_num_shards]);
+    _ttl = std::chrono::milliseconds(ttl_ms);
+  }
+
+  RendezvousTable::Shard &RendezvousTable::_ShardOf(int64_t req_id)
+  {
+    // req_ids come from the frontend's RNG, but mix them anyway so that a
+    // sequential generator does not pile onto a few shards.
+    uint64_t h = static_cast<uint64_t>(req_id) * 0x9E3779B97F4A7C15ULL;
+    return _shards[(h >> 32) % _num_shards];
+  }
+
+  void RendezvousTable::_Expire(Shard *shard,
+                                std::chrono::steady_clock::time_point now)
+  {
+    while (!shard->expiry.empty() && shard->expiry.front().first <= now)
+    {
+      auto it = shard->entries.find(shard->expiry.front().second);
+      // The entry may be gone (completed) or belong to a later upload.
+      if (it != shard->entries.end() &&
+          it->second.deadline == shard->expiry.front().first)
+      {
+        LOG(warning) << "Components of request " << it->first
+                     << " expired before the review was complete";
+        shard->entries.erase(it);
+      }
+      shard->expiry.pop_front();
+    }
+  }
+
+  template <class TSetter>
+  bool RendezvousTable::Upload(int64_t req_id, ReviewComponent component,
+                               TSetter set, Review *review)
+  {
+    auto &shard = _ShardOf(req_id);
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    _Expire(&shard, now);
+
+    auto it = shard.entries.find(req_id);
+    if (it == shard.entries.end())
+    {
+      it = shard.entries.emplace(req_id, Entry()).first;
+      it->second.deadline = now + _ttl;
+      shard.expiry.emplace_back(it->second.deadline, req_id);
+    }
+    auto &entry = it->second;
+    uint32_t bit = 1u << component;
+    if (entry.received & bit)
+    {
+      LOG(warning) << "Component " << component << " of request " << req_id
+                   << " has already been stored";
+      return false;
+    }
+    set(&entry.review);
+    entry.received |= bit;
+    if (entry.received != REVIEW_COMPONENTS_ALL)
+    {
+      return false;
+    }
+    *review = std::move(entry.review);
+    shard.entries.erase(it);
+    return true;
+  }
+
+  size_t RendezvousTable::Size()
+  {
+    size_t size = 0;
+    for (size_t i = 0; i < _num_shards; ++i)
+    {
+      std::lock_guard<std::mutex> lock(_shards[i].mtx);
+      size += _shards[i].entries.size();
+    }
+    return size;
+  }
+
+} // namespace media_service
+
+#endif // MEDIA_MICROSERVICES_RENDEZVOUSTABLE_H
@@ -0,0 +1,481 @@
+#ifndef MEDIA_MICROSERVICES_EXECUTOR_H
+#define MEDIA_MICROSERVICES_EXECUTOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Metrics.h"
+#include "RequestBreakdown.h"
+#include "logger.h"
+
+// Defaults for the process-wide executor, used when a service has no
+// "executor" section in service-config.json. The tasks mostly block on
+// memcached, Redis and downstream Thrift calls, so there are several
+// workers per core.
+#define EXECUTOR_THREADS_PER_CORE 4
+#define EXECUTOR_MAX_THREADS 128
+#define EXECUTOR_DEFAULT_QUEUE_CAPACITY 4096
+
+namespace media_service
+{
+
+  /*
+   * Future returned by Executor::Submit(). Like the future of
+   * std::async(std::launch::async, ...), its destructor waits for the task,
+   * so a handler that throws before calling get() never leaves a task
+   * running against its stack frame. The handlers capture by reference and
+   * rely on this. Waits in get() and wait() count as
+   * REQUEST_PHASE_TASK_WAIT of the request.
+   */
+  template <class T>
+  class TaskFuture
+  {
+  public:
+    TaskFuture() = default;
+    explicit TaskFuture(std::future<T> future) : _future(std::move(future)) {}
+    TaskFuture(TaskFuture &&) = default;
+    TaskFuture &operator=(TaskFuture &&other)
+    {
+      _Join();
+      _future = std::move(other._future);
+      return *this;
+    }
+    ~TaskFuture() { _Join(); }
+
+    T get()
+    {
+      PhaseTimer timer(REQUEST_PHASE_TASK_WAIT);
+      return _future.get();
+    }
+    void wait() const
+    {
+      PhaseTimer timer(REQUEST_PHASE_TASK_WAIT);
+      _future.wait();
+    }
+    bool valid() const { return _future.valid(); }
+
+  private:
+    void _Join()
+    {
+      if (_future.valid())
+      {
+        _future.wait();
+      }
+    }
+
+    std::future<T> _future;
+  };
+
+  struct ExecutorStats
+  {
+    int num_threads;
+    long queue_depth;
+    long max_queue_depth;
+    long submitted;
+    long stolen;
+    // Tasks run on the submitting thread because the queues were full.
+    long ran_inline;
+    long completed;
+    // Time from Submit() until a worker picks the task up, and time spent
+    // running it, summed over completed tasks.
+    long total_wait_us;
+    long max_wait_us;
+    long total_run_us;
+  };
+
+  /*
+   * Bounded work-stealing executor shared by all handlers of a process. It
+   * replaces std::async(std::launch::async, ...), which created an OS
+   * thread for every sub-call of every request.
+   *
+   * Each worker owns a deque. Tasks submitted by a worker go to its own
+   * deque, tasks submitted by other threads (the Thrift server threads) are
+   * spread round-robin. A worker takes its newest task first and, when its
+   * deque is empty, steals the oldest task of another worker before it goes
+   * to sleep.
+   *
+   * At most queue_capacity tasks are queued at a time. Once that many are
+   * waiting, Submit() runs the task on the calling thread instead, so
+   * overload slows down the callers rather than growing the queues or the
+   * thread count. A task must not wait on another task of the executor.
+   */
+  class Executor
+  {
+  public:
+    Executor(int num_threads, int queue_capacity);
+    ~Executor();
+
+    Executor(const Executor &) = delete;
+    Executor &operator=(const Executor &) = delete;
+
+    // The process-wide executor. The first call creates it with the
+    // defaults unless InitExecutor() was called before.
+    static Executor &Global();
+
+    template <class F>
+    TaskFuture<typename std::result_of<F()>::type> Submit(F &&f);
+
+    ExecutorStats GetStats() const;
+
+  private:
+    struct Task
+    {
+      std::function<void()> run;
+      std::chrono::steady_clock::time_point enqueue_time;
+    };
+
+    // Allocated one by one; the trailing pad keeps the next allocation off
+    // the cache lines of this one's lock.
+    struct WorkerQueue
+    {
+      std::mutex mtx;
+      std::deque<Task> tasks;
+      char pad[64];
+    };
+
+    bool _Enqueue(std::function<void()> run);
+    bool _Dequeue(size_t self, Task *task);
+    void _WorkerLoop(size_t self);
+    void _Export();
+    std::string _ReportLine() const;
+
+    static std::atomic<Executor *> &_GlobalInstance();
+    static std::mutex &_GlobalMutex();
+    friend void InitExecutor(int num_threads, int queue_capacity);
+
+    std::vector<std::unique_ptr<WorkerQueue>> _queues;
+    std::vector<std::thread> _workers;
+    long _queue_capacity;
+    std::atomic<long> _queued{0};
+    std::atomic<size_t> _next_queue{0};
+
+    std::atomic<int> _num_sleeping{0};
+    bool _stop = false;
+    std::mutex _sleep_mtx;
+    std::condition_variable _sleep_cv;
+
+    std::atomic<long> _max_queued{0};
+    std::atomic<long> _submitted{0};
+    std::atomic<long> _stolen{0};
+    std::atomic<long> _ran_inline{0};
+    std::atomic<long> _completed{0};
+    std::atomic<long> _total_wait_us{0};
+    std::atomic<long> _max_wait_us{0};
+    std::atomic<long> _total_run_us{0};
+    // Only set for the process-wide executor, see _Export().
+    HdrHistogram *_wait_histogram = nullptr;
+    Counter *_rejected_counter = nullptr;
+  };
+
+  int DefaultExecutorThreads()
+  {
+    int num_threads = std::min(
+        static_cast<int>(std::thread::hardware_concurrency()) *
+            EXECUTOR_THREADS_PER_CORE,
+        EXECUTOR_MAX_THREADS);
+    return std::max(num_threads, EXECUTOR_THREADS_PER_CORE);
+  }
+
+  // Index of the calling worker within its executor, or -1 on other
+  // threads.
+  thread_local int executor_worker_index = -1;
+  thread_local const Executor *executor_worker_owner = nullptr;
+
+  static void _AtomicMax(std::atomic<long> *target, long value)
+  {
+    long curr = target->load(std::memory_order_relaxed);
+    while (value > curr &&
+           !target->compare_exchange_weak(curr, value,
+                                          std::memory_order_relaxed))
+    {
+    }
+  }
+
+  Executor::Executor(int num_threads, int queue_capacity)
+  {
+    num_threads = std::max(num_threads, 1);
+    _queue_capacity = std::max(queue_capacity, 1);
+    for (int i = 0; i < num_threads; ++i)
+    {
+      _queues.emplace_back(new WorkerQueue());
+    }
+    for (int i = 0; i < num_threads; ++i)
+    {
+      _workers.emplace_back(&Executor::_WorkerLoop, this, i);
+    }
+  }
+
+  Executor::~Executor()
+  {
+    {
+      std::lock_guard<std::mutex> lock(_sleep_mtx);
+      _stop = true;
+    }
+    _sleep_cv.notify_all();
+    for (auto &worker : _workers)
+    {
+      worker.join();
+    }
+  }
+
+  std::atomic<Executor *> &Executor::_GlobalInstance()
+  {
+    // Never destroyed, so tasks still running at exit() do not race the
+    // executor's destructor.
+    static std::atomic<Executor *> instance{nullptr};
+    return instance;
+  }
+
+  std::mutex &Executor::_GlobalMutex()
+  {
+    static std::mutex mtx;
+    return mtx;
+  }
+
+  // Sizes the process-wide executor. Must be called before the first
+  // Executor::Global(), i.e. in main() before the server starts.
+  void InitExecutor(int num_threads, int queue_capacity)
+  {
+    std::lock_guard<std::mutex> lock(Executor::_GlobalMutex());
+    auto &instance = Executor::_GlobalInstance();
+    if (instance.load())
+    {
+      LOG(warning) << "Executor already initialized";
+      return;
+    }
+    Executor *executor = new Executor(num_threads, queue_capacity);
+    executor->_Export();
+    instance.store(executor);
+    LOG(info) << "Executor started with " << num_threads << " threads and "
+              << queue_capacity << " queue slots";
+  }
+
+  Executor &Executor::Global()
+  {
+    Executor *instance = _GlobalInstance().load(std::memory_order_acquire);
+    if (!instance)
+    {
+      std::lock_guard<std::mutex> lock(_GlobalMutex());
+      instance = _GlobalInstance().load();
+      if (instance)
+      {
+        return *instance;
+      }
+      int num_threads = DefaultExecutorThreads();
+      instance = new Executor(num_threads, EXECUTOR_DEFAULT_QUEUE_CAPACITY);
+      instance->_Export();
+      _GlobalInstance().store(instance);
+      LOG(info) << "Executor started with " << num_threads << " threads and "
+                << EXECUTOR_DEFAULT_QUEUE_CAPACITY << " queue slots";
+    }
+    return *instance;
+  }
+
+  template <class F>
+  TaskFuture<typename std::result_of<F()>::type> Executor::Submit(F &&f)
+  {
+    using TResult = typename std::result_of<F()>::type;
+    // The task runs in the request context of the submitting thread.
+    auto task = std::make_shared<std::packaged_task<TResult()>>(
+        InheritRequestContext(std::forward<F>(f)));
+    TaskFuture<TResult> future(task->get_future());
+    _submitted.fetch_add(1, std::memory_order_relaxed);
+    if (!_Enqueue([task]()
+                  { (*task)(); }))
+    {
+      _ran_inline.fetch_add(1, std::memory_order_relaxed);
+      if (_rejected_counter)
+      {
+        _rejected_counter->Add();
+      }
+      (*task)();
+    }
+    return future;
+  }
+
+  bool Executor::_Enqueue(std::function<void()> run)
+  {
+    long queued = _queued.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (queued > _queue_capacity)
+    {
+      _queued.fetch_sub(1, std::memory_order_relaxed);
+      return false;
+    }
+    _AtomicMax(&_max_queued, queued);
+
+    size_t idx;
+    if (executor_worker_owner == this)
+    {
+      idx = static_cast<size_t>(executor_worker_index);
+    }
+    else
+    {
+      idx = _next_queue.fetch_add(1, std::memory_order_relaxed) %
+            _queues.size();
+    }
+    {
+      std::lock_guard<std::mutex> lock(_queues[idx]->mtx);
+      _queues[idx]->tasks.push_back(
+          Task{std::move(run), std::chrono::steady_clock::now()});
+    }
+
+    // Only take the sleep lock when a worker may be waiting on it; taking
+    // it orders the push before the sleeper re-checks _queued.
+    if (_num_sleeping.load() > 0)
+    {
+      {
+        std::lock_guard<std::mutex> lock(_sleep_mtx);
+      }
+      _sleep_cv.notify_one();
+    }
+    return true;
+  }
+
+  bool Executor::_Dequeue(size_t self, Task *task)
+  {
+    {
+      auto &own = *_queues[self];
+      std::lock_guard<std::mutex> lock(own.mtx);
+      if (!own.tasks.empty())
+      {
+        *task = std::move(own.tasks.back());
+        own.tasks.pop_back();
+        _queued.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+      }
+    }
+    for (size_t i = 1; i < _queues.size(); ++i)
+    {
+      auto &victim = *_queues[(self + i) % _queues.size()];
+      std::lock_guard<std::mutex> lock(victim.mtx);
+      if (!victim.tasks.empty())
+      {
+        *task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        _queued.fetch_sub(1, std::memory_order_relaxed);
+        _stolen.fetch_add(1, std::memory_order_relaxed);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void Executor::_WorkerLoop(size_t self)
+  {
+    executor_worker_index = static_cast<int>(self);
+    executor_worker_owner = this;
+    Task task;
+    while (true)
+    {
+      if (!_Dequeue(self, &task))
+      {
+        std::unique_lock<std::mutex> lock(_sleep_mtx);
+        _num_sleeping.fetch_add(1);
+        _sleep_cv.wait(lock, [this]
+                       { return _stop || _queued.load() > 0; });
+        _num_sleeping.fetch_sub(1);
+        if (_stop && _queued.load() <= 0)
+        {
+          return;
+        }
+        continue;
+      }
+
+      auto start = std::chrono::steady_clock::now();
+      long wait_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                         start - task.enqueue_time)
+                         .count();
+      // The packaged_task stores any exception in the future.
+      task.run();
+      long run_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+      task.run = nullptr;
+
+      _completed.fetch_add(1, std::memory_order_relaxed);
+      _total_wait_us.fetch_add(wait_us, std::memory_order_relaxed);
+      _total_run_us.fetch_add(run_us, std::memory_order_relaxed);
+      _AtomicMax(&_max_wait_us, wait_us);
+      if (_wait_histogram)
+      {
+        _wait_histogram->Record(wait_us);
+      }
+    }
+  }
+
+  // Publishes the queue of the process-wide executor as metrics and as a
+  // line of the SIGUSR1 breakdown report. That executor is never
+  // destroyed, so the callbacks can keep this.
+  void Executor::_Export()
+  {
+    auto &metrics = Metrics::Global();
+    _wait_histogram = metrics.GetHistogram(
+        "media_executor_queue_wait_seconds",
+        "Time Executor tasks waited in the queue for a worker.", "");
+    metrics.AddGauge("media_executor_threads", "Executor worker threads.", "",
+                     [this]()
+                     { return static_cast<double>(_workers.size()); });
+    metrics.AddGauge("media_executor_queue_capacity",
+                     "Executor tasks that can be queued at once.", "",
+                     [this]()
+                     { return static_cast<double>(_queue_capacity); });
+    metrics.AddGauge("media_executor_queue_depth",
+                     "Executor tasks waiting for a worker.", "",
+                     [this]()
+                     { return static_cast<double>(std::max(
+                           _queued.load(std::memory_order_relaxed), 0L)); });
+    _rejected_counter = metrics.GetCounter(
+        "media_executor_rejected_total",
+        "Tasks run on the submitting thread because the Executor queue was "
+        "full.",
+        "");
+    BreakdownRegistry::Global().AddReporter([this]()
+                                            { return _ReportLine(); });
+  }
+
+  std::string Executor::_ReportLine() const
+  {
+    ExecutorStats stats = GetStats();
+    char buf[256];
+    snprintf(buf, sizeof(buf),
+             "executor: %d threads, queue %ld of %ld (max %ld), %ld tasks, "
+             "%ld ran inline, mean wait %.3f ms, max wait %.3f ms",
+             stats.num_threads, stats.queue_depth, _queue_capacity,
+             stats.max_queue_depth, stats.submitted, stats.ran_inline,
+             stats.completed
+                 ? stats.total_wait_us / 1000.0 / stats.completed
+                 : 0.0,
+             stats.max_wait_us / 1000.0);
+    return buf;
+  }
+
+  ExecutorStats Executor::GetStats() const
+  {
+    ExecutorStats stats;
+    stats.num_threads = static_cast<int>(_workers.size());
+    stats.queue_depth = std::max(_queued.load(std::memory_order_relaxed), 0L);
+    stats.max_queue_depth = _max_queued.load(std::memory_order_relaxed);
+    stats.submitted = _submitted.load(std::memory_order_relaxed);
+    stats.stolen = _stolen.load(std::memory_order_relaxed);
+    stats.ran_inline = _ran_inline.load(std::memory_order_relaxed);
+    stats.completed = _completed.load(std::memory_order_relaxed);
+    stats.total_wait_us = _total_wait_us.load(std::memory_order_relaxed);
+    stats.max_wait_us = _max_wait_us.load(std::memory_order_relaxed);
+    stats.total_run_us = _total_run_us.load(std::memory_order_relaxed);
+    return stats;
+  }
+
+} // namespace media_service
+
+#endif // MEDIA_MICROSERVICES_EXECUTOR_H
@@ -0,0 +1,405 @@
+#ifndef MEDIA_MICROSERVICES_FLIGHTRECORDER_H
+#define MEDIA_MICROSERVICES_FLIGHTRECORDER_H
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cinttypes>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "RequestBreakdown.h"
+#include "SignalAction.h"
+#include "logger.h"
+
+#define FLIGHT_RECORDER_MAGIC "MSFLIGHT"
+#define FLIGHT_RECORDER_VERSION 2
+#define FLIGHT_RECORDER_DEFAULT_REQUESTS 4096
+#define FLIGHT_RECORDER_HEADER_SIZE 4096
+#define FLIGHT_RECORDER_METHOD_LEN 32
+
+namespace media_service
+{
+
+  /*
+   * The flight recorder file, version 2, native byte order. A header page
+   * followed by num_slots slots of slot_size bytes:
+   *
+   *   header  offset  size  field
+   *                0     8  magic        "MSFLIGHT"
+   *                8     4  version      FLIGHT_RECORDER_VERSION
+   *               12     4  slot_size    1024
+   *               16     8  num_slots
+   *               24     8  head         requests recorded so far; request
+   *                                      n is in slot n % num_slots
+   *               32     8  pid
+   *               40     8  started_us   system clock, us since the epoch
+   *               48    32  service      NUL-terminated
+   *
+   *   slot    offset  size  field
+   *                0     8  seq          0 if never written, odd while
+   *                                      being written
+   *                8  1016  FlightRecord
+   *
+   * A slot is written like a SpanRing slot: seq goes odd, the record is
+   * stored, seq goes even. A reader keeps a record only if seq was even and
+   * unchanged across the copy. After a crash, a slot with an odd seq was
+   * being written when the process died.
+   */
+  struct FlightEvent
+  {
+    char op[REQUEST_EVENT_OP_LEN]; // call site, pool or peer; may fill it
+    int32_t result;                // as in the *_end probes of probes.h
+    uint32_t start_us;             // since the start of the request
+    uint32_t duration_us;
+    uint8_t phase;                 // RequestPhase
+    uint8_t reserved[3];
+  };
+
+  static_assert(sizeof(FlightEvent) == 32, "FlightEvent layout changed");
+
+  struct FlightRecord
+  {
+    int64_t req_id;
+    uint64_t trace_id_high;
+    uint64_t trace_id_low;
+    int64_t start_us;      // system clock, us since the epoch
+    uint32_t duration_us;
+    uint32_t cpu_us;       // as in RequestBreakdown
+    int32_t status;        // 0, or 1 if the handler threw
+    uint32_t tid;
+    uint16_t num_events;
+    uint16_t dropped_events;
+    int32_t error_code;    // ErrorCode if it threw a ServiceException of
+                           // its own (see RequestError()), else -1
+    char method[FLIGHT_RECORDER_METHOD_LEN];
+    FlightEvent events[REQUEST_BREAKDOWN_EVENTS];
+  };
+
+  static_assert(sizeof(FlightRecord) == 1016, "FlightRecord layout changed");
+
+  struct FlightRecorderHeader
+  {
+    char magic[8];
+    uint32_t version;
+    uint32_t slot_size;
+    uint64_t num_slots;
+    std::atomic<uint64_t> head;
+    int64_t pid;
+    int64_t started_us;
+    char service[REQUEST_CONTEXT_SERVICE_LEN];
+  };
+
+  static_assert(offsetof(FlightRecorderHeader, head) == 24,
+                "FlightRecorderHeader layout changed");
+  static_assert(offsetof(FlightRecorderHeader, service) == 48,
+                "FlightRecorderHeader layout changed");
+
+  /*
+   * Keeps the timelines of the last num_slots requests in a memory-mapped
+   * file, so that they survive a crash and can be read by another process
+   * at any time, e.g. with scripts/flight_recorder.py. RequestProbe records
+   * every request when it ends: one fetch_add on the head and a 1 KiB copy
+   * into the page cache, no lock and no syscall. Writers racing for a slot
+   * after the ring wrapped around drop their record rather than wait.
+   */
+  class FlightRecorder
+  {
+  public:
+    // Maps path, moving a file from an earlier run to path + ".prev" first.
+    // Returns nullptr if the file cannot be created.
+    static FlightRecorder *Open(const std::string &path,
+                                const std::string &service,
+                                size_t num_requests);
+
+    // nullptr until StartFlightRecorder() succeeded.
+    static std::atomic<FlightRecorder *> &Global()
+    {
+      static std::atomic<FlightRecorder *> recorder{nullptr};
+      return recorder;
+    }
+
+    FlightRecorder(const FlightRecorder &) = delete;
+    FlightRecorder &operator=(const FlightRecorder &) = delete;
+
+    void Record(const char *method, int64_t req_id, int32_t status,
+                const RequestContext &context,
+                const RequestBreakdown &breakdown, uint64_t end_cycles);
+
+    // The records still in the file, oldest first.
+    std::vector<FlightRecord> Read() const;
+
+    // Writes Read() as text to path; returns the number of records.
+    int Dump(const std::string &path) const;
+
+    const std::string &Path() const { return _path; }
+
+  private:
+    static constexpr size_t kWords = sizeof(FlightRecord) / sizeof(uint64_t);
+
+    struct Slot
+    {
+      std::atomic<uint64_t> seq;
+      std::atomic<uint64_t> words[kWords];
+    };
+
+    static_assert(sizeof(Slot) == 1024, "FlightRecorder slot size changed");
+
+    FlightRecorder() = default;
+
+    std::string _path;
+    FlightRecorderHeader *_header = nullptr;
+    Slot *_slots = nullptr;
+    uint64_t _num_slots = 0;
+    // Maps cycles to the system clock.
+    uint64_t _base_cycles = 0;
+    int64_t _base_us = 0;
+  };
+
+  inline int64_t _SystemClockMicroseconds()
+  {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+  }
+
+  inline uint32_t _CurrentTid()
+  {
+    static thread_local uint32_t tid =
+        static_cast<uint32_t>(syscall(SYS_gettid));
+    return tid;
+  }
+
+  inline FlightRecorder *FlightRecorder::Open(const std::string &path,
+                                              const std::string &service,
+                                              size_t num_requests)
+  {
+    rename(path.c_str(), (path + ".prev").c_str());
+    size_t size = FLIGHT_RECORDER_HEADER_SIZE + num_requests * sizeof(Slot);
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || ftruncate(fd, size) != 0)
+    {
+      LOG(error) << "Cannot create flight recorder file " << path << ": "
+                 << strerror(errno);
+      if (fd >= 0)
+      {
+        close(fd);
+      }
+      return nullptr;
+    }
+    void *map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+      LOG(error) << "Cannot map flight recorder file " << path << ": "
+                 << strerror(errno);
+      return nullptr;
+    }
+
+    auto recorder = new FlightRecorder();
+    recorder->_path = path;
+    recorder->_header = static_cast<FlightRecorderHeader *>(map);
+    recorder->_slots = reinterpret_cast<Slot *>(
+        static_cast<char *>(map) + FLIGHT_RECORDER_HEADER_SIZE);
+    recorder->_num_slots = num_requests;
+    recorder->_base_cycles = ReadCycles();
+    recorder->_base_us = _SystemClockMicroseconds();
+
+    // The file is all zeros, which is also every slot's initial state.
+    FlightRecorderHeader *header = recorder->_header;
+    header->version = FLIGHT_RECORDER_VERSION;
+    header->slot_size = sizeof(Slot);
+    header->num_slots = num_requests;
+    header->head.store(0, std::memory_order_relaxed);
+    header->pid = getpid();
+    header->started_us = recorder->_base_us;
+    strncpy(header->service, service.c_str(),
+            REQUEST_CONTEXT_SERVICE_LEN - 1);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(header->magic, FLIGHT_RECORDER_MAGIC, sizeof(header->magic));
+    return recorder;
+  }
+
+  inline void FlightRecorder::Record(const char *method, int64_t req_id,
+                                     int32_t status,
+                                     const RequestContext &context,
+                                     const RequestBreakdown &breakdown,
+                                     uint64_t end_cycles)
+  {
+    uint64_t words[kWords];
+    auto record = reinterpret_cast<FlightRecord *>(words);
+    memset(record, 0, offsetof(FlightRecord, events));
+    double cycles_per_us = CyclesPerMicrosecond();
+    uint64_t start = breakdown.start_cycles;
+    uint64_t wall = end_cycles - start;
+    uint64_t own_blocked =
+        breakdown.own_blocked_cycles.load(std::memory_order_relaxed);
+    record->req_id = req_id;
+    record->trace_id_high = context.trace_id_high;
+    record->trace_id_low = context.trace_id_low;
+    record->start_us = _base_us + static_cast<int64_t>(
+        (static_cast<int64_t>(start - _base_cycles)) / cycles_per_us);
+    record->duration_us = static_cast<uint32_t>(wall / cycles_per_us);
+    record->cpu_us = static_cast<uint32_t>(
+        (wall > own_blocked ? wall - own_blocked : 0) / cycles_per_us);
+    record->status = status;
+    record->error_code =
+        status ? breakdown.error_code.load(std::memory_order_relaxed) : -1;
+    record->tid = _CurrentTid();
+    uint32_t num_events =
+        breakdown.num_events.load(std::memory_order_relaxed);
+    uint32_t kept = std::min(num_events,
+                             static_cast<uint32_t>(REQUEST_BREAKDOWN_EVENTS));
+    record->num_events = static_cast<uint16_t>(kept);
+    record->dropped_events = static_cast<uint16_t>(
+        std::min<uint32_t>(num_events - kept, UINT16_MAX));
+    strncpy(record->method, method, FLIGHT_RECORDER_METHOD_LEN - 1);
+    for (uint32_t i = 0; i < kept; i++)
+    {
+      const RequestEvent &from = breakdown.events[i];
+      FlightEvent &to = record->events[i];
+      memcpy(to.op, from.op, REQUEST_EVENT_OP_LEN);
+      to.result = from.result;
+      to.start_us = from.start_cycles > start
+                        ? static_cast<uint32_t>(
+                              (from.start_cycles - start) / cycles_per_us)
+                        : 0;
+      to.duration_us = static_cast<uint32_t>(
+          (from.end_cycles - from.start_cycles) / cycles_per_us);
+      to.phase = static_cast<uint8_t>(from.phase);
+      memset(to.reserved, 0, sizeof(to.reserved));
+    }
+    // Only the events in use are copied; the rest of the slot keeps what an
+    // older record left there, which readers skip using num_events.
+    size_t used_words =
+        (offsetof(FlightRecord, events) + kept * sizeof(FlightEvent)) /
+        sizeof(uint64_t);
+
+    uint64_t ticket =
+        _header->head.fetch_add(1, std::memory_order_relaxed);
+    Slot *slot = &_slots[ticket % _num_slots];
+    uint64_t seq = slot->seq.load(std::memory_order_relaxed);
+    if ((seq & 1) || !slot->seq.compare_exchange_strong(
+                         seq, seq + 1, std::memory_order_acquire))
+    {
+      return;
+    }
+    for (size_t i = 0; i < used_words; i++)
+    {
+      slot->words[i].store(words[i], std::memory_order_relaxed);
+    }
+    slot->seq.store(seq + 2, std::memory_order_release);
+  }
+
+  inline std::vector<FlightRecord> FlightRecorder::Read() const
+  {
+    std::vector<FlightRecord> records;
+    uint64_t head = _header->head.load(std::memory_order_acquire);
+    uint64_t first = head > _num_slots ? head - _num_slots : 0;
+    for (uint64_t n = first; n < head; n++)
+    {
+      const Slot *slot = &_slots[n % _num_slots];
+      uint64_t seq = slot->seq.load(std::memory_order_acquire);
+      if (seq == 0 || (seq & 1))
+      {
+        continue;
+      }
+      uint64_t words[kWords];
+      for (size_t i = 0; i < kWords; i++)
+      {
+        words[i] = slot->words[i].load(std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot->seq.load(std::memory_order_relaxed) != seq)
+      {
+        continue;
+      }
+      FlightRecord record;
+      memcpy(&record, words, sizeof(record));
+      records.push_back(record);
+    }
+    return records;
+  }
+
+  inline int FlightRecorder::Dump(const std::string &path) const
+  {
+    FILE *out = fopen(path.c_str(), "w");
+    if (!out)
+    {
+      LOG(error) << "Cannot write flight recorder dump " << path << ": "
+                 << strerror(errno);
+      return -1;
+    }
+    auto records = Read();
+    for (const auto &record : records)
+    {
+      fprintf(out,
+              "%" PRId64 " %s req_id=%" PRId64 " trace=%016" PRIx64
+              "%016" PRIx64 " tid=%u duration_us=%u cpu_us=%u status=%d"
+              " error_code=%d dropped_events=%u\n",
+              record.start_us, record.method, record.req_id,
+              record.trace_id_high, record.trace_id_low, record.tid,
+              record.duration_us, record.cpu_us, record.status,
+              record.error_code, record.dropped_events);
+      for (int i = 0; i < record.num_events; i++)
+      {
+        const FlightEvent &event = record.events[i];
+        fprintf(out, "  +%u us %s %.*s %u us result=%d\n", event.start_us,
+                RequestPhaseName(event.phase), REQUEST_EVENT_OP_LEN, event.op,
+                event.duration_us, event.result);
+      }
+    }
+    fclose(out);
+    return static_cast<int>(records.size());
+  }
+
+  /*
+   * Starts recording every request into path, and dumps the records as
+   * text to path + ".txt" whenever the process gets SIGUSR2:
+   *
+   *   kill -USR2 $(pidof MovieIdService)
+   */
+  inline bool StartFlightRecorder(const std::string &path,
+                                  const std::string &service,
+                                  size_t num_requests)
+  {
+    if (FlightRecorder::Global().load() || num_requests == 0)
+    {
+      return false;
+    }
+    CyclesPerMicrosecond();
+    FlightRecorder *recorder =
+        FlightRecorder::Open(path, service, num_requests);
+    if (!recorder)
+    {
+      return false;
+    }
+    FlightRecorder::Global().store(recorder, std::memory_order_release);
+    OnSignal(SIGUSR2, [recorder]() {
+      std::string dump_path = recorder->Path() + ".txt";
+      int count = recorder->Dump(dump_path);
+      if (count >= 0)
+      {
+        LOG(info) << "Dumped " << count << " flight recorder records to "
+                  << dump_path;
+      }
+    });
+    LOG(info) << "Recording the last " << num_requests << " requests in "
+              << path;
+    return true;
+  }
+
+} // namespace media_service
+
+#endif // MEDIA_MICROSERVICES_FLIGHTRECORDER_H
@@ -1,8 +1,14 @@
 #ifndef MEDIA_MICROSERVICES_GENERICCLIENT_H
 #define MEDIA_MICROSERVICES_GENERICCLIENT_H
 
+#include <chrono>
+#include <cstdint>
 #include <string>
 
+// Connections older than this are retired by ClientPool and reopened, so that
+// long-lived services spread over backend replicas that came up later.
+#define DEFAULT_KEEPALIVE_MS 600000
+
 namespace media_service {
 
 class GenericClient{
@@ -13,8 +19,24 @@ class GenericClient{
   virtual void KeepAlive(int) = 0;
   virtual void Disconnect() = 0;
   virtual bool IsConnected() = 0;
+  // Sends a lightweight request over the connection; returns false if the
+  // backend did not answer.
+  virtual bool Ping() = 0;
+
+  // Maintained by the client on Connect() and by ClientPool on Push(), in
+  // milliseconds since the epoch.
+  long _connect_timestamp = 0;
+  long _last_used_timestamp = 0;
+  long _keepalive_ms = DEFAULT_KEEPALIVE_MS;
+  // Node of the client in its ClientPool.
+  uint32_t _pool_node = 0;
 
  protected:
+  static long _CurrentTimestamp() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+  }
+
   std::string _addr;
   int _port;
 };
@@ -0,0 +1,168 @@
+#ifndef MEDIA_MICROSERVICES_LRUCACHE_H
+#define MEDIA_MICROSERVICES_LRUCACHE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ProfiledMutex.h"
+
+#define LRU_CACHE_DEFAULT_SHARDS 16
+
+namespace media_service
+{
+
+  /*
+   * In-process LRU cache from strings to V with a deadline per entry, split
+   * into shards by key hash so that concurrent lookups rarely meet on a
+   * lock. Each shard evicts its own least recently used entry once it holds
+   * capacity / shards entries. Deadlines are in whatever clock the caller
+   * passes as now; an entry past its deadline is dropped by the lookup that
+   * finds it. The shard locks are profiled as "lru_cache/<name>".
+   *
+   * A capacity of 0 disables the cache: Get() misses and Put() drops.
+   */
+  template <class V>
+  class LruCache
+  {
+  public:
+    LruCache(const std::string &name, size_t capacity,
+             size_t num_shards = LRU_CACHE_DEFAULT_SHARDS)
+    {
+      if (capacity == 0)
+      {
+        return;
+      }
+      num_shards = std::max<size_t>(1, std::min(num_shards, capacity));
+      _shard_capacity = (capacity + num_shards - 1) / num_shards;
+      for (size_t i = 0; i < num_shards; i++)
+      {
+        _shards.emplace_back(new Shard("lru_cache/" + name));
+      }
+    }
+
+    LruCache(const LruCache &) = delete;
+    LruCache &operator=(const LruCache &) = delete;
+
+    bool Enabled() const
+    {
+      return !_shards.empty();
+    }
+
+    bool Get(const std::string &key, int64_t now, V *value)
+    {
+      if (_shards.empty())
+      {
+        return false;
+      }
+      Shard &shard = _ShardOf(key);
+      std::lock_guard<ProfiledMutex> lock(shard.mtx);
+      auto it = shard.index.find(key);
+      if (it == shard.index.end())
+      {
+        return false;
+      }
+      auto entry = it->second;
+      if (entry->deadline <= now)
+      {
+        shard.entries.erase(entry);
+        shard.index.erase(it);
+        return false;
+      }
+      shard.entries.splice(shard.entries.begin(), shard.entries, entry);
+      *value = entry->value;
+      return true;
+    }
+
+    void Put(const std::string &key, const V &value, int64_t deadline)
+    {
+      if (_shards.empty())
+      {
+        return;
+      }
+      Shard &shard = _ShardOf(key);
+      std::lock_guard<ProfiledMutex> lock(shard.mtx);
+      auto it = shard.index.find(key);
+      if (it != shard.index.end())
+      {
+        it->second->value = value;
+        it->second->deadline = deadline;
+        shard.entries.splice(shard.entries.begin(), shard.entries,
+                             it->second);
+        return;
+      }
+      if (shard.index.size() >= _shard_capacity)
+      {
+        shard.index.erase(*shard.entries.back().key);
+        shard.entries.pop_back();
+      }
+      it = shard.index.emplace(key, shard.entries.end()).first;
+      shard.entries.push_front(Entry{&it->first, value, deadline});
+      it->second = shard.entries.begin();
+    }
+
+    void Erase(const std::string &key)
+    {
+      if (_shards.empty())
+      {
+        return;
+      }
+      Shard &shard = _ShardOf(key);
+      std::lock_guard<ProfiledMutex> lock(shard.mtx);
+      auto it = shard.index.find(key);
+      if (it != shard.index.end())
+      {
+        shard.entries.erase(it->second);
+        shard.index.erase(it);
+      }
+    }
+
+    size_t Size()
+    {
+      size_t size = 0;
+      for (auto &shard : _shards)
+      {
+        std::lock_guard<ProfiledMutex> lock(shard->mtx);
+        size += shard->index.size();
+      }
+      return size;
+    }
+
+  private:
+    struct Entry
+    {
+      // Points into the index node, which does not move.
+      const std::string *key;
+      V value;
+      int64_t deadline;
+    };
+
+    struct Shard
+    {
+      explicit Shard(const std::string &lock_name) : mtx(lock_name) {}
+
+      ProfiledMutex mtx;
+      // Most recently used first.
+      std::list<Entry> entries;
+      std::unordered_map<std::string, typename std::list<Entry>::iterator>
+          index;
+    };
+
+    Shard &_ShardOf(const std::string &key)
+    {
+      return *_shards[std::hash<std::string>()(key) % _shards.size()];
+    }
+
+    std::vector<std::unique_ptr<Shard>> _shards;
+    size_t _shard_capacity = 0;
+  };
+
+} // namespace media_service
+
+#endif // MEDIA_MICROSERVICES_LRUCACHE_H
@@ -0,0 +1,72 @@
+#ifndef MEDIA_MICROSERVICES_MEMCACHEDPOOL_H
+#define MEDIA_MICROSERVICES_MEMCACHEDPOOL_H
+
+#include <cstdint>
+
+#include <libmemcached/memcached.h>
+#include <libmemcached/util.h>
+
+#include "ProfiledMutex.h"
+#include "probes.h"
+
+namespace media_service
+{
+
+  /*
+   * memcached_pool_pop() and memcached_pool_push() of a libmemcached pool,
+   * profiled as lock "memcached_pool": a pop that finds the pool empty
+   * counts as contended and its wait is timed, and the hold time is how
+   * long the client was out of the pool. The pop time is kept in the
+   * client's user data, so a client may be pushed back by another thread.
+   * Contended pops also count as a pool wait of the request.
+   */
+  inline LockProfile &_MemcachedPoolProfile()
+  {
+    static LockProfile profile = GetLockProfile("memcached_pool");
+    return profile;
+  }
+
+  inline memcached_st *MemcachedPoolPop(memcached_pool_st *pool, bool block,
+                                        memcached_return_t *rc)
+  {
+    LockProfile &profile = _MemcachedPoolProfile();
+    memcached_st *client = memcached_pool_pop(pool, false, rc);
+    uint64_t popped = ReadCycles();
+    if (client)
+    {
+      profile.wait->Record(0);
+    }
+    else if (block && *rc == MEMCACHED_NOTFOUND)
+    {
+      profile.contentions->Add();
+      uint32_t saved_phase = ProbePoolWaitStart("memcached");
+      uint64_t start = popped;
+      client = memcached_pool_pop(pool, true, rc);
+      popped = ReadCycles();
+      ProbePoolWaitEnd("memcached", client != nullptr, saved_phase, start,
+                       popped);
+      profile.wait->Record(CyclesToMicroseconds(popped - start));
+    }
+    if (client)
+    {
+      memcached_set_user_data(
+          client, reinterpret_cast<void *>(static_cast<uintptr_t>(popped)));
+    }
+    return client;
+  }
+
+  inline memcached_return_t MemcachedPoolPush(memcached_pool_st *pool,
+                                              memcached_st *client)
+  {
+    auto popped = reinterpret_cast<uintptr_t>(memcached_get_user_data(client));
+    if (popped)
+    {
+      _MemcachedPoolProfile().hold->Record(
+          CyclesToMicroseconds(ReadCycles() - popped));
+    }
+    return memcached_pool_push(pool, client);
+  }
+
+} // namespace media_service
+
+#endif // MEDIA_MICROSERVICES_MEMCACHEDPOOL_H
@@ -0,0 +1,616 @@
+#ifndef MEDIA_MICROSERVICES_METRICS_H
+#define MEDIA_MICROSERVICES_METRICS_H
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "logger.h"
+
+// Used when a service has no "metrics_port" in service-config.json; 0
+// turns the endpoint off.
+#define METRICS_DEFAULT_PORT 9464
+
+// 2^HDR_SUB_BUCKET_BITS buckets per power of two keep every recorded value
+// within 1/32 (3.1%) of its bucket's bounds. Values are microseconds and
+// clamped to 2^HDR_MAX_VALUE_BITS, about 12 days.
+#define HDR_SUB_BUCKET_BITS 5
+#define HDR_MAX_VALUE_BITS 40
+
+namespace media_service
+{
+
+  /*
+   * Lock-free log-linear histogram in the style of HdrHistogram: values
+   * below 2^(HDR_SUB_BUCKET_BITS + 1) get a bucket each, and every larger
+   * power of two is split into 2^HDR_SUB_BUCKET_BITS equal buckets. Record()
+   * is at most two relaxed fetch_adds, and one for a zero, which hot paths
+   * such as ClientPool::Pop() record most of the time; the total count is
+   * summed from the buckets when read. Readers copy the counts without
+   * stopping writers, so a snapshot can be off by the values recorded
+   * meanwhile.
+   */
+  class HdrHistogram
+  {
+  public:
+    static constexpr int kSubBuckets = 1 << HDR_SUB_BUCKET_BITS;
+    static constexpr int kNumBuckets =
+        (HDR_MAX_VALUE_BITS - HDR_SUB_BUCKET_BITS) * kSubBuckets +
+        kSubBuckets;
+
+    HdrHistogram()
+    {
+      for (auto &count : _counts)
+      {
+        count.store(0, std::memory_order_relaxed);
+      }
+    }
+
+    HdrHistogram(const HdrHistogram &) = delete;
+    HdrHistogram &operator=(const HdrHistogram &) = delete;
+
+    void Record(int64_t value)
+    {
+      uint64_t v = value < 0 ? 0 : static_cast<uint64_t>(value);
+      _counts[_Index(v)].fetch_add(1, std::memory_order_relaxed);
+      if (v != 0)
+      {
+        _sum.fetch_add(v, std::memory_order_relaxed);
+      }
+    }
+
+    struct Snapshot
+    {
+      std::vector<uint64_t> counts;
+      uint64_t count;
+      uint64_t sum;
+
+      // Upper bound of the bucket holding the q-quantile, 0 if empty.
+      uint64_t Quantile(double q) const;
+      // Number of values at most le, to the precision of the buckets.
+      uint64_t CountAtMost(uint64_t le) const;
+    };
+
+    Snapshot Read() const
+    {
+      Snapshot snapshot;
+      snapshot.counts.resize(kNumBuckets);
+      snapshot.count = 0;
+      for (int i = 0; i < kNumBuckets; i++)
+      {
+        snapshot.counts[i] = _counts[i].load(std::memory_order_relaxed);
+        snapshot.count += snapshot.counts[i];
+      }
+      snapshot.sum = _sum.load(std::memory_order_relaxed);
+      return snapshot;
+    }
+
+    // Smallest value that falls into bucket index + 1.
+    static uint64_t BucketEnd(int index)
+    {
+      if (index < 2 * kSubBuckets)
+      {
+        return index + 1;
+      }
+      int shift = index / kSubBuckets - 1;
+      uint64_t sub = index - shift * kSubBuckets;
+      return (sub + 1) << shift;
+    }
+
+  private:
+    static int _Index(uint64_t v)
+    {
+      if (v >= (1ULL << HDR_MAX_VALUE_BITS))
+      {
+        return kNumBuckets - 1;
+      }
+      int msb = 63 - __builtin_clzll(v | 1);
+      int shift = std::max(msb - HDR_SUB_BUCKET_BITS, 0);
+      return shift * kSubBuckets + static_cast<int>(v >> shift);
+    }
+
+    std::atomic<uint64_t> _counts[kNumBuckets];
+    std::atomic<uint64_t> _sum{0};
+  };
+
+  inline uint64_t HdrHistogram::Snapshot::Quantile(double q) const
+  {
+    uint64_t total = 0;
+    for (auto c : counts)
+    {
+      total += c;
+    }
+    if (total == 0)
+    {
+      return 0;
+    }
+    uint64_t rank = std::max<uint64_t>(
+        1, static_cast<uint64_t>(q * static_cast<double>(total) + 0.5));
+    uint64_t seen = 0;
+    for (int i = 0; i < kNumBuckets; i++)
+    {
+      seen += counts[i];
+      if (seen >= rank)
+      {
+        return BucketEnd(i) - 1;
+      }
+    }
+    return BucketEnd(kNumBuckets - 1) - 1;
+  }
+
+  inline uint64_t HdrHistogram::Snapshot::CountAtMost(uint64_t le) const
+  {
+    uint64_t n = 0;
+    for (int i = 0; i < kNumBuckets && BucketEnd(i) - 1 <= le; i++)
+    {
+      n += counts[i];
+    }
+    return n;
+  }
+
+  class Counter
+  {
+  public:
+    void Add(uint64_t n = 1) { _value.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t Value() const { return _value.load(std::memory_order_relaxed); }
+
+  private:
+    std::atomic<uint64_t> _value{0};
+  };
+
+  /*
+   * The metrics of a process, rendered in the Prometheus text format by
+   * Render(). Metrics are created on first use and live as long as the
+   * process, so callers keep the returned pointers; creating one takes a
+   * mutex, updating one does not.
+   *
+   * Labels are passed rendered, e.g. MetricLabels({{"pool", name}}).
+   * Histogram values are microseconds and exported in seconds, with the
+   * bucket bounds of METRICS_BUCKETS_US and the quantiles of
+   * METRICS_QUANTILES as a separate gauge. Gauges are read from callbacks
+   * at scrape time; callbacks registered with the same name and labels are
+   * summed.
+   */
+  class Metrics
+  {
+  public:
+    static Metrics &Global();
+
+    Counter *GetCounter(const std::string &name, const std::string &help,
+                        const std::string &labels);
+    HdrHistogram *GetHistogram(const std::string &name,
+                               const std::string &help,
+                               const std::string &labels);
+    uint64_t AddGauge(const std::string &name, const std::string &help,
+                      const std::string &labels,
+                      std::function<double()> read);
+    void RemoveGauge(uint64_t id);
+
+    std::string Render() const;
+
+  private:
+    enum class Type
+    {
+      counter,
+      histogram,
+      gauge
+    };
+
+    struct Family
+    {
+      Type type;
+      std::string help;
+      std::map<std::string, std::unique_ptr<Counter>> counters;
+      std::map<std::string, std::unique_ptr<HdrHistogram>> histograms;
+      std::map<std::string, std::map<uint64_t, std::function<double()>>>
+          gauges;
+    };
+
+    Family &_Family(const std::string &name, const std::string &help,
+                    Type type);
+    static void _RenderHistogram(std::string *out, std::string *quantiles,
+                                 const std::string &name,
+                                 const std::string &labels,
+                                 const HdrHistogram &histogram);
+
+    mutable std::mutex _mtx;
+    std::map<std::string, Family> _families;
+    std::map<uint64_t, std::pair<std::string, std::string>> _gauge_ids;
+    uint64_t _next_gauge_id = 1;
+  };
+
+  // Prometheus bucket bounds in microseconds, and quantiles, of every
+  // histogram.
+  static const uint64_t METRICS_BUCKETS_US[] = {
+      100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000,
+      250000, 500000, 1000000, 2500000, 5000000, 10000000};
+  static const double METRICS_QUANTILES[] = {0.5, 0.9, 0.99, 0.999};
+
+  inline std::string MetricLabels(
+      const std::vector<std::pair<std::string, std::string>> &labels)
+  {
+    std::string out;
+    for (auto &label : labels)
+    {
+      if (!out.empty())
+      {
+        out += ',';
+      }
+      out += label.first;
+      out += "=\"";
+      for (char c : label.second)
+      {
+        if (c == '\\' || c == '"')
+        {
+          out += '\\';
+          out += c;
+        }
+        else if (c == '\n')
+        {
+          out += "\\n";
+        }
+        else
+        {
+          out += c;
+        }
+      }
+      out += '"';
+    }
+    return out;
+  }
+
+  inline Metrics &Metrics::Global()
+  {
+    // Never destroyed, so threads still recording at exit() are safe.
+    static Metrics *metrics = new Metrics();
+    return *metrics;
+  }
+
+  inline Metrics::Family &Metrics::_Family(const std::string &name,
+                                           const std::string &help, Type type)
+  {
+    auto it = _families.find(name);
+    if (it == _families.end())
+    {
+      it = _families.emplace(name, Family()).first;
+      it->second.type = type;
+      it->second.help = help;
+    }
+    else if (it->second.type != type)
+    {
+      LOG(error) << "Metric " << name << " registered with two types";
+    }
+    return it->second;
+  }
+
+  inline Counter *Metrics::GetCounter(const std::string &name,
+                                      const std::string &help,
+                                      const std::string &labels)
+  {
+    std::lock_guard<std::mutex> lock(_mtx);
+    auto &counter = _Family(name, help, Type::counter).counters[labels];
+    if (!counter)
+    {
+      counter.reset(new Counter());
+    }
+    return counter.get();
+  }
+
+  inline HdrHistogram *Metrics::GetHistogram(const std::string &name,
+                                             const std::string &help,
+                                             const std::string &labels)
+  {
+    std::lock_guard<std::mutex> lock(_mtx);
+    auto &histogram = _Family(name, help, Type::histogram).histograms[labels];
+    if (!histogram)
+    {
+      histogram.reset(new HdrHistogram());
+    }
+    return histogram.get();
+  }
+
+  inline uint64_t Metrics::AddGauge(const std::string &name,
+                                    const std::string &help,
+                                    const std::string &labels,
+                                    std::function<double()> read)
+  {
+    std::lock_guard<std::mutex> lock(_mtx);
+    uint64_t id = _next_gauge_id++;
+    _Family(name, help, Type::gauge).gauges[labels][id] = std::move(read);
+    _gauge_ids[id] = std::make_pair(name, labels);
+    return id;
+  }
+
+  inline void Metrics::RemoveGauge(uint64_t id)
+  {
+    std::lock_guard<std::mutex> lock(_mtx);
+    auto it = _gauge_ids.find(id);
+    if (it == _gauge_ids.end())
+    {
+      return;
+    }
+    auto &gauges = _families[it->second.first].gauges;
+    auto &callbacks = gauges[it->second.second];
+    callbacks.erase(id);
+    if (callbacks.empty())
+    {
+      gauges.erase(it->second.second);
+    }
+    _gauge_ids.erase(it);
+  }
+
+  inline void Metrics::_RenderHistogram(std::string *out,
+                                        std::string *quantiles,
+                                        const std::string &name,
+                                        const std::string &labels,
+                                        const HdrHistogram &histogram)
+  {
+    auto snapshot = histogram.Read();
+    std::string sep = labels.empty() ? "" : ",";
+    char buf[128];
+    for (uint64_t le : METRICS_BUCKETS_US)
+    {
+      snprintf(buf, sizeof(buf), "%g", le / 1e6);
+      *out += name + "_bucket{" + labels + sep + "le=\"" + buf + "\"} " +
+              std::to_string(snapshot.CountAtMost(le)) + "\n";
+    }
+    *out += name + "_bucket{" + labels + sep + "le=\"+Inf\"} " +
+            std::to_string(snapshot.count) + "\n";
+    snprintf(buf, sizeof(buf), "%.6f", snapshot.sum / 1e6);
+    *out += name + "_sum{" + labels + "} " + buf + "\n";
+    *out += name + "_count{" + labels + "} " +
+            std::to_string(snapshot.count) + "\n";
+    for (double q : METRICS_QUANTILES)
+    {
+      snprintf(buf, sizeof(buf), "%g\"} %.6f", q,
+               snapshot.Quantile(q) / 1e6);
+      *quantiles += name + "_quantile{" + labels + sep + "quantile=\"" +
+                    buf + "\n";
+    }
+  }
+
+  inline std::string Metrics::Render() const
+  {
+    std::lock_guard<std::mutex> lock(_mtx);
+    std::string out;
+    for (auto &entry : _families)
+    {
+      const std::string &name = entry.first;
+      const Family &family = entry.second;
+      switch (family.type)
+      {
+      case Type::counter:
+        out += "# HELP " + name + " " + family.help + "\n";
+        out += "# TYPE " + name + " counter\n";
+        for (auto &counter : family.counters)
+        {
+          out += name + "{" + counter.first + "} " +
+                 std::to_string(counter.second->Value()) + "\n";
+        }
+        break;
+      case Type::histogram:
+        out += "# HELP " + name + " " + family.help + "\n";
+        out += "# TYPE " + name + " histogram\n";
+        {
+          // The histogram type has no quantiles, so they are a gauge of
+          // their own.
+          std::string quantiles = "# HELP " + name + "_quantile " +
+                                  family.help + " Quantiles since start.\n" +
+                                  "# TYPE " + name + "_quantile gauge\n";
+          for (auto &histogram : family.histograms)
+          {
+            _RenderHistogram(&out, &quantiles, name, histogram.first,
+                             *histogram.second);
+          }
+          out += quantiles;
+        }
+        break;
+      case Type::gauge:
+        out += "# HELP " + name + " " + family.help + "\n";
+        out += "# TYPE " + name + " gauge\n";
+        for (auto &gauge : family.gauges)
+        {
+          double value = 0;
+          for (auto &read : gauge.second)
+          {
+            value += read.second();
+          }
+          char buf[64];
+          snprintf(buf, sizeof(buf), "%g", value);
+          out += name + "{" + gauge.first + "} " + buf + "\n";
+        }
+        break;
+      }
+    }
+    return out;
+  }
+
+  /*
+   * Metrics of an RPC method or a backend call site, looked up once per
+   * thread by the address of its name. The names are the string literals
+   * handed to RequestProbe and CallProbe, so a call site always passes the
+   * same pointer.
+   */
+  struct RpcMetrics
+  {
+    HdrHistogram *duration;
+    Counter *errors;
+  };
+
+  inline RpcMetrics &GetRpcMetrics(const char *method)
+  {
+    thread_local std::unordered_map<const char *, RpcMetrics> cache;
+    auto it = cache.find(method);
+    if (it == cache.end())
+    {
+      auto labels = MetricLabels({{"method", method}});
+      RpcMetrics metrics;
+      metrics.duration = Metrics::Global().GetHistogram(
+          "media_rpc_duration_seconds",
+          "Time spent in the handler of a Thrift method.", labels);
+      metrics.errors = Metrics::Global().GetCounter(
+          "media_rpc_errors_total",
+          "Calls of a Thrift method that ended with an exception.", labels);
+      it = cache.emplace(method, metrics).first;
+    }
+    return it->second;
+  }
+
+  struct BackendCallMetrics
+  {
+    HdrHistogram *duration;
+    Counter *errors;
+    Counter *hits;    // memcached reads only
+    Counter *misses;
+  };
+
+  inline BackendCallMetrics &GetBackendCallMetrics(const char *backend,
+                                                   const char *op)
+  {
+    thread_local std::unordered_map<const char *, BackendCallMetrics> cache;
+    auto it = cache.find(op);
+    if (it == cache.end())
+    {
+      auto labels = MetricLabels({{"backend", backend}, {"op", op}});
+      BackendCallMetrics metrics;
+      metrics.duration = Metrics::Global().GetHistogram(
+          "media_backend_call_duration_seconds",
+          "Time of a memcached, MongoDB or Redis call, by call site.",
+          labels);
+      metrics.errors = Metrics::Global().GetCounter(
+          "media_backend_call_errors_total",
+          "Backend calls that ended with an exception, by call site.",
+          labels);
+      metrics.hits = nullptr;
+      metrics.misses = nullptr;
+      if (!strcmp(backend, "memcached"))
+      {
+        metrics.hits = Metrics::Global().GetCounter(
+            "media_cache_lookups_total",
+            "memcached reads by call site and whether they found anything.",
+            MetricLabels({{"op", op}, {"result", "hit"}}));
+        metrics.misses = Metrics::Global().GetCounter(
+            "media_cache_lookups_total",
+            "memcached reads by call site and whether they found anything.",
+            MetricLabels({{"op", op}, {"result", "miss"}}));
+      }
+      it = cache.emplace(op, metrics).first;
+    }
+    return it->second;
+  }
+
+  inline void _ServeMetrics(int fd)
+  {
+    while (true)
+    {
+      int conn = accept(fd, nullptr, nullptr);
+      if (conn < 0)
+      {
+        continue;
+      }
+      timeval timeout{1, 0};
+      setsockopt(conn, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+      setsockopt(conn, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+      std::string request;
+      char buf[1024];
+      while (request.find("\r\n\r\n") == std::string::npos &&
+             request.size() < 8192)
+      {
+        ssize_t n = recv(conn, buf, sizeof(buf), 0);
+        if (n <= 0)
+        {
+          break;
+        }
+        request.append(buf, n);
+      }
+
+      // "GET /metrics?query HTTP/1.1"
+      std::string path;
+      if (request.compare(0, 4, "GET ") == 0)
+      {
+        path = request.substr(4, request.find_first_of(" ?\r\n", 4) - 4);
+      }
+      std::string status = "200 OK";
+      std::string body;
+      if (path == "/metrics")
+      {
+        body = Metrics::Global().Render();
+      }
+      else
+      {
+        status = "404 Not Found";
+        body = "Not found\n";
+      }
+      std::string response = "HTTP/1.1 " + status + "\r\n" +
+                             "Content-Type: text/plain; version=0.0.4\r\n" +
+                             "Content-Length: " +
+                             std::to_string(body.size()) + "\r\n" +
+                             "Connection: close\r\n\r\n" + body;
+      size_t sent = 0;
+      while (sent < response.size())
+      {
+        ssize_t n = send(conn, response.data() + sent, response.size() - sent,
+                         MSG_NOSIGNAL);
+        if (n <= 0)
+        {
+          break;
+        }
+        sent += n;
+      }
+      close(conn);
+    }
+  }
+
+  /*
+   * Serves Render() at http://<host>:<port>/metrics from a background
+   * thread. Requests are answered one at a time, which is plenty for a
+   * scraper. Returns false if the port cannot be bound.
+   */
+  inline bool StartMetricsServer(int port)
+  {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+      LOG(error) << "Cannot create the metrics socket: " << strerror(errno);
+      return false;
+    }
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    if (bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 ||
+        listen(fd, 16) != 0)
+    {
+      LOG(error) << "Cannot serve metrics on port " << port << ": "
+                 << strerror(errno);
+      close(fd);
+      return false;
+    }
+    std::thread(_ServeMetrics, fd).detach();
+    LOG(info) << "Serving metrics on port " << port;
+    return true;
+  }
+
+} // namespace media_service
+
+#endif // MEDIA_MICROSERVICES_METRICS_H
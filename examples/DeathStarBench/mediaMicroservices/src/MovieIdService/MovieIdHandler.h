@@ -13,10 +13,14 @@
 #include "../../gen-cpp/MovieIdService.h"
 #include "../../gen-cpp/ComposeReviewService.h"
 #include "../../gen-cpp/RatingService.h"
+#include "../AffinityClientPool.h"
 #include "../ClientPool.h"
 #include "../ThriftClient.h"
+#include "../Executor.h"
+#include "../MemcachedPool.h"
 #include "../logger.h"
 #include "../tracing.h"
+#include "../probes.h"
 
 namespace media_service
 {
@@ -27,9 +31,11 @@ namespace media_service
     MovieIdHandler(
         memcached_pool_st *,
         mongoc_client_pool_t *,
-        ClientPool<ThriftClient<ComposeReviewServiceClient>> *,
+        AffinityClientPool<ThriftClient<ComposeReviewServiceClient>> *,
         ClientPool<ThriftClient<RatingServiceClient>> *);
     ~MovieIdHandler() override = default;
+
+    void Ping() override {}
     void UploadMovieId(int64_t, const std::string &, int32_t,
                        const std::map<std::string, std::string> &) override;
     void RegisterMovieId(int64_t, const std::string &, const std::string &,
@@ -38,14 +44,14 @@ namespace media_service
   private:
     memcached_pool_st *_memcached_client_pool;
     mongoc_client_pool_t *_mongodb_client_pool;
-    ClientPool<ThriftClient<ComposeReviewServiceClient>> *_compose_client_pool;
+    AffinityClientPool<ThriftClient<ComposeReviewServiceClient>> *_compose_client_pool;
     ClientPool<ThriftClient<RatingServiceClient>> *_rating_client_pool;
   };
 
   MovieIdHandler::MovieIdHandler(
       memcached_pool_st *memcached_client_pool,
       mongoc_client_pool_t *mongodb_client_pool,
-      ClientPool<ThriftClient<ComposeReviewServiceClient>> *compose_client_pool,
+      AffinityClientPool<ThriftClient<ComposeReviewServiceClient>> *compose_client_pool,
       ClientPool<ThriftClient<RatingServiceClient>> *rating_client_pool)
   {
     _memcached_client_pool = memcached_client_pool;
@@ -62,32 +68,27 @@ namespace media_service
   {
 
     // Initialize a span
-    TextMapReader reader(carrier);
-    std::map<std::string, std::string> writer_text_map;
-    TextMapWriter writer(writer_text_map);
-    auto parent_span = opentracing::Tracer::Global()->Extract(reader);
-    auto span = opentracing::Tracer::Global()->StartSpan(
-        "UploadMovieId",
-        {opentracing::ChildOf(parent_span->get())});
-    opentracing::Tracer::Global()->Inject(span->context(), writer);
+    auto span = TraceSpan::Start("UploadMovieId", carrier);
+    RequestProbe probe(req_id, "UploadMovieId", span.GetTraceId());
+    auto &writer_text_map = span.Carrier();
 
     memcached_return_t memcached_rc;
-    memcached_st *memcached_client = memcached_pool_pop(
+    memcached_st *memcached_client = MemcachedPoolPop(
         _memcached_client_pool, true, &memcached_rc);
     if (!memcached_client)
     {
       ServiceException se;
       se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
       se.message = "Failed to pop a client from memcached pool";
-      throw se;
+      throw RequestError(se);
     }
 
     size_t movie_id_size;
     uint32_t memcached_flags;
     // Look for the movie id from memcached
 
-    auto get_span = opentracing::Tracer::Global()->StartSpan(
-        "MmcGetMovieId", {opentracing::ChildOf(&span->context())});
+    auto get_span = span.Child("MmcGetMovieId");
+    CallProbe get_probe(ProbeBackend::memcached, req_id, "MmcGetMovieId");
 
     char *movie_id_mmc = memcached_get(
         memcached_client,
@@ -101,11 +102,13 @@ namespace media_service
       ServiceException se;
       se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
       se.message = memcached_strerror(memcached_client, memcached_rc);
-      memcached_pool_push(_memcached_client_pool, memcached_client);
-      throw se;
+      MemcachedPoolPush(_memcached_client_pool, memcached_client);
+      throw RequestError(se);
     }
-    get_span->Finish();
-    memcached_pool_push(_memcached_client_pool, memcached_client);
+    get_span.Finish();
+    get_probe.AddBytes(title.length(), movie_id_mmc ? movie_id_size : 0);
+    get_probe.End(movie_id_mmc != nullptr);
+    MemcachedPoolPush(_memcached_client_pool, memcached_client);
     std::string movie_id_str;
 
     // If cached in memcached
@@ -128,7 +131,7 @@ namespace media_service
         se.errorCode = ErrorCode::SE_MONGODB_ERROR;
         se.message = "Failed to pop a client from MongoDB pool";
         free(movie_id_mmc);
-        throw se;
+        throw RequestError(se);
       }
       auto collection = mongoc_client_get_collection(
           mongodb_client, "movie-id", "movie-id");
@@ -140,19 +143,20 @@ namespace media_service
         se.message = "Failed to create collection user from DB movie-id";
         free(movie_id_mmc);
         mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
-        throw se;
+        throw RequestError(se);
       }
 
       bson_t *query = bson_new();
       BSON_APPEND_UTF8(query, "title", title.c_str());
 
-      auto find_span = opentracing::Tracer::Global()->StartSpan(
-          "MongoFindMovieId", {opentracing::ChildOf(&span->context())});
+      auto find_span = span.Child("MongoFindMovieId");
+      CallProbe find_probe(ProbeBackend::mongo, req_id, "MongoFindMovieId");
       mongoc_cursor_t *cursor = mongoc_collection_find_with_opts(
           collection, query, nullptr, nullptr);
       const bson_t *doc;
       bool found = mongoc_cursor_next(cursor, &doc);
-      find_span->Finish();
+      find_span.Finish();
+      find_probe.End(found);
 
       if (found)
       {
@@ -173,7 +177,7 @@ namespace media_service
           se.errorCode = ErrorCode::SE_THRIFT_HANDLER_ERROR;
           se.message = "Attribute movie_id is not find in MongoDB";
           free(movie_id_mmc);
-          throw se;
+          throw RequestError(se);
         }
       }
       else
@@ -187,7 +191,7 @@ namespace media_service
         se.errorCode = ErrorCode::SE_THRIFT_HANDLER_ERROR;
         se.message = "Movie " + title + " is not found in MongoDB";
         free(movie_id_mmc);
-        throw se;
+        throw RequestError(se);
       }
       bson_destroy(query);
       mongoc_cursor_destroy(cursor);
@@ -195,15 +199,15 @@ namespace media_service
       mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
     }
 
-    std::future<void> set_future;
-    std::future<void> movie_id_future;
-    std::future<void> rating_future;
-    set_future = std::async(std::launch::async, [&]()
+    TaskFuture<void> set_future;
+    TaskFuture<void> movie_id_future;
+    TaskFuture<void> rating_future;
+    set_future = Executor::Global().Submit([&]()
                             {
-    memcached_client = memcached_pool_pop(
+    memcached_client = MemcachedPoolPop(
         _memcached_client_pool, true, &memcached_rc);
-    auto set_span = opentracing::Tracer::Global()->StartSpan(
-        "MmcSetMovieId", { opentracing::ChildOf(&span->context()) });
+    auto set_span = span.Child("MmcSetMovieId");
+    CallProbe set_probe(ProbeBackend::memcached, req_id, "MmcSetMovieId");
     // Upload the movie id to memcached
     memcached_rc = memcached_set(
         memcached_client,
@@ -214,12 +218,14 @@ namespace media_service
         static_cast<time_t>(0),
         static_cast<uint32_t>(0)
     );
-    set_span->Finish();
+    set_span.Finish();
+    set_probe.AddBytes(title.length() + movie_id_str.length(), 0);
+    set_probe.End();
     if (memcached_rc != MEMCACHED_SUCCESS) {
       LOG(warning) << "Failed to set movie_id to Memcached: "
                    << memcached_strerror(memcached_client, memcached_rc);
     }
-    memcached_pool_push(_memcached_client_pool, memcached_client); });
+    MemcachedPoolPush(_memcached_client_pool, memcached_client); });
 
     // movie_id_future = std::async(std::launch::async, [&]()
     //                              {
@@ -240,14 +246,14 @@ namespace media_service
     // }
     // _compose_client_pool->Push(compose_client_wrapper); });
 
-    movie_id_future = std::async(std::launch::async, [&]()
+    movie_id_future = Executor::Global().Submit([&]()
                                  {
-    auto compose_client_wrapper = _compose_client_pool->Pop();
+    auto compose_client_wrapper = _compose_client_pool->Pop(req_id);
     if (!compose_client_wrapper) {
         ServiceException se;
         se.errorCode = ErrorCode::SE_THRIFT_CONN_ERROR;
         se.message = "Failed to connect to compose-review-service";
-        throw se;
+        throw RequestError(se);
     }
     auto compose_client = compose_client_wrapper->GetClient();
     bool success = false;
@@ -264,34 +270,34 @@ namespace media_service
             // Handle specific "Broken pipe" scenario or any transport exception
             if (retry_count > 0) {
                 // Remove the problematic client from the pool and try to get a new one
-                _compose_client_pool->Remove(compose_client_wrapper);
-                compose_client_wrapper = _compose_client_pool->Pop();
+                _compose_client_pool->Remove(req_id, compose_client_wrapper);
+                compose_client_wrapper = _compose_client_pool->Pop(req_id);
                 if (!compose_client_wrapper) {
                     ServiceException se;
                     se.errorCode = ErrorCode::SE_THRIFT_CONN_ERROR;
                     se.message = "Failed to reconnect to compose-review-service";
-                    throw se;
+                    throw RequestError(se);
                 }
                 compose_client = compose_client_wrapper->GetClient();
             } else {
                 // If no retries left, push back the client and rethrow the exception
-                _compose_client_pool->Push(compose_client_wrapper);
+                _compose_client_pool->Push(req_id, compose_client_wrapper);
                 LOG(error) << "Failed to upload movie_id to compose-review-service after retries";
                 throw;
             }
         } catch (const std::exception &e) {
             // Catch other standard exceptions and log them
             LOG(error) << "Standard exception: " << e.what();
-            _compose_client_pool->Push(compose_client_wrapper);
+            _compose_client_pool->Push(req_id, compose_client_wrapper);
             throw;
         } catch (...) {
             // Catch any other exceptions and log them
             LOG(error) << "Unknown exception caught";
-            _compose_client_pool->Push(compose_client_wrapper);
+            _compose_client_pool->Push(req_id, compose_client_wrapper);
             throw;
         }
     }
-    _compose_client_pool->Push(compose_client_wrapper); });
+    _compose_client_pool->Push(req_id, compose_client_wrapper); });
 
     // rating_future = std::async(std::launch::async, [&]() {
     //   auto rating_client_wrapper = _rating_client_pool->Pop();
@@ -312,14 +318,14 @@ namespace media_service
     //   _rating_client_pool->Push(rating_client_wrapper);
     // });
 
-    rating_future = std::async(std::launch::async, [&]()
+    rating_future = Executor::Global().Submit([&]()
                                {
     auto rating_client_wrapper = _rating_client_pool->Pop();
     if (!rating_client_wrapper) {
         ServiceException se;
         se.errorCode = ErrorCode::SE_THRIFT_CONN_ERROR;
         se.message = "Failed to connect to rating-service";
-        throw se;
+        throw RequestError(se);
     }
     auto rating_client = rating_client_wrapper->GetClient();
     bool success = false;
@@ -342,7 +348,7 @@ namespace media_service
                     ServiceException se;
                     se.errorCode = ErrorCode::SE_THRIFT_CONN_ERROR;
                     se.message = "Failed to reconnect to rating-service";
-                    throw se;
+                    throw RequestError(se);
                 }
                 rating_client = rating_client_wrapper->GetClient();
             } else {
@@ -414,7 +420,7 @@ namespace media_service
       throw;
     }
 
-    span->Finish();
+    span.Finish();
   }
 
   void MovieIdHandler::RegisterMovieId(
@@ -425,14 +431,8 @@ namespace media_service
   {
 
     // Initialize a span
-    TextMapReader reader(carrier);
-    std::map<std::string, std::string> writer_text_map;
-    TextMapWriter writer(writer_text_map);
-    auto parent_span = opentracing::Tracer::Global()->Extract(reader);
-    auto span = opentracing::Tracer::Global()->StartSpan(
-        "RegisterMovieId",
-        {opentracing::ChildOf(parent_span->get())});
-    opentracing::Tracer::Global()->Inject(span->context(), writer);
+    auto span = TraceSpan::Start("RegisterMovieId", carrier);
+    RequestProbe probe(req_id, "RegisterMovieId", span.GetTraceId());
 
     mongoc_client_t *mongodb_client = mongoc_client_pool_pop(
         _mongodb_client_pool);
@@ -441,7 +441,7 @@ namespace media_service
       ServiceException se;
       se.errorCode = ErrorCode::SE_MONGODB_ERROR;
       se.message = "Failed to pop a client from MongoDB pool";
-      throw se;
+      throw RequestError(se);
     }
     auto collection = mongoc_client_get_collection(
         mongodb_client, "movie-id", "movie-id");
@@ -451,20 +451,21 @@ namespace media_service
       se.errorCode = ErrorCode::SE_MONGODB_ERROR;
       se.message = "Failed to create collection movie_id from DB movie-id";
       mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
-      throw se;
+      throw RequestError(se);
     }
 
     // Check if the username has existed in the database
     bson_t *query = bson_new();
     BSON_APPEND_UTF8(query, "title", title.c_str());
 
-    auto find_span = opentracing::Tracer::Global()->StartSpan(
-        "MongoFindMovie", {opentracing::ChildOf(&span->context())});
+    auto find_span = span.Child("MongoFindMovie");
+    CallProbe find_probe(ProbeBackend::mongo, req_id, "MongoFindMovie");
     mongoc_cursor_t *cursor = mongoc_collection_find_with_opts(
         collection, query, nullptr, nullptr);
     const bson_t *doc;
     bool found = mongoc_cursor_next(cursor, &doc);
-    find_span->Finish();
+    find_span.Finish();
+    find_probe.End(found);
 
     if (found)
     {
@@ -475,7 +476,7 @@ namespace media_service
       mongoc_cursor_destroy(cursor);
       mongoc_collection_destroy(collection);
       mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
-      throw se;
+      throw RequestError(se);
     }
     else
     {
@@ -484,11 +485,12 @@ namespace media_service
       BSON_APPEND_UTF8(new_doc, "movie_id", movie_id.c_str());
       bson_error_t error;
 
-      auto insert_span = opentracing::Tracer::Global()->StartSpan(
-          "MongoInsertMovie", {opentracing::ChildOf(&span->context())});
+      auto insert_span = span.Child("MongoInsertMovie");
+      CallProbe insert_probe(ProbeBackend::mongo, req_id, "MongoInsertMovie");
       bool plotinsert = mongoc_collection_insert_one(
           collection, new_doc, nullptr, nullptr, &error);
-      insert_span->Finish();
+      insert_span.Finish();
+      insert_probe.End();
 
       if (!plotinsert)
       {
@@ -501,7 +503,7 @@ namespace media_service
         mongoc_cursor_destroy(cursor);
         mongoc_collection_destroy(collection);
         mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
-        throw se;
+        throw RequestError(se);
       }
       bson_destroy(new_doc);
     }
@@ -509,7 +511,7 @@ namespace media_service
     mongoc_collection_destroy(collection);
     mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
 
-    span->Finish();
+    span.Finish();
   }
 } // namespace media_service
 
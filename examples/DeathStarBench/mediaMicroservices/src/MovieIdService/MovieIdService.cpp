@@ -1,19 +1,12 @@
-#include <thrift/protocol/TBinaryProtocol.h>
-#include <thrift/server/TThreadedServer.h>
-#include <thrift/transport/TServerSocket.h>
-#include <thrift/transport/TBufferTransports.h>
 #include <signal.h>
 
 #include "../utils.h"
+#include "../utils_thrift.h"
 #include "../utils_memcached.h"
 #include "../utils_mongodb.h"
 #include "MovieIdHandler.h"
 
 using json = nlohmann::json;
-using apache::thrift::server::TThreadedServer;
-using apache::thrift::transport::TServerSocket;
-using apache::thrift::transport::TFramedTransportFactory;
-using apache::thrift::protocol::TBinaryProtocolFactory;
 using namespace media_service;
 
 void sigintHandler(int sig) {
@@ -31,9 +24,6 @@ int main(int argc, char *argv[]) {
     exit(EXIT_FAILURE);
   }
 
-  int port = config_json["movie-id-service"]["port"];
-  std::string compose_addr = config_json["compose-review-service"]["addr"];
-  int compose_port = config_json["compose-review-service"]["port"];
   std::string rating_addr = config_json["rating-service"]["addr"];
   int rating_port = config_json["rating-service"]["port"];
 
@@ -46,8 +36,11 @@ int main(int argc, char *argv[]) {
     return EXIT_FAILURE;
   }
 
-  ClientPool<ThriftClient<ComposeReviewServiceClient>> compose_client_pool(
-      "compose-review-client", compose_addr, compose_port, 0, 128, 1000);
+  AffinityClientPool<ThriftClient<ComposeReviewServiceClient>>
+      compose_client_pool(
+          "compose-review-client",
+          get_service_replicas(config_json, "compose-review-service"),
+          0, 128, 1000);
   ClientPool<ThriftClient<RatingServiceClient>> rating_client_pool(
       "rating-client", rating_addr, rating_port, 0, 128, 1000);
 
@@ -67,17 +60,16 @@ int main(int argc, char *argv[]) {
   }
   mongoc_client_pool_push(mongodb_client_pool, mongodb_client);
 
-  TThreadedServer server(
+  start_observability(config_json, "movie-id-service");
+  init_executor(config_json, "movie-id-service");
+  auto server = init_thrift_server(
+      config_json, "movie-id-service",
       std::make_shared<MovieIdServiceProcessor>(
       std::make_shared<MovieIdHandler>(
               memcached_client_pool, mongodb_client_pool,
-              &compose_client_pool, &rating_client_pool)),
-      std::make_shared<TServerSocket>("0.0.0.0", port),
-      std::make_shared<TFramedTransportFactory>(),
-      std::make_shared<TBinaryProtocolFactory>()
-  );
+              &compose_client_pool, &rating_client_pool)));
   std::cout << "Starting the movie-id-service server ..." << std::endl;
-  server.serve();
+  server->serve();
 }
 
 
@@ -11,8 +11,10 @@
 #include <nlohmann/json.hpp>
 
 #include "../../gen-cpp/MovieInfoService.h"
+#include "../MemcachedPool.h"
 #include "../logger.h"
 #include "../tracing.h"
+#include "../probes.h"
 
 namespace media_service {
 using json = nlohmann::json;
@@ -23,6 +25,8 @@ class MovieInfoHandler : public MovieInfoServiceIf {
       memcached_pool_st *,
       mongoc_client_pool_t *);
   ~MovieInfoHandler() override = default;
+
+  void Ping() override {}
   void ReadMovieInfo(MovieInfo& _return, int64_t req_id,
       const std::string& movie_id,
       const std::map<std::string, std::string> & carrier) override;
@@ -63,14 +67,8 @@ void MovieInfoHandler::WriteMovieInfo(
     int32_t num_rating,
     const std::map<std::string, std::string> &carrier) {
   // Initialize a span
-  TextMapReader reader(carrier);
-  std::map<std::string, std::string> writer_text_map;
-  TextMapWriter writer(writer_text_map);
-  auto parent_span = opentracing::Tracer::Global()->Extract(reader);
-  auto span = opentracing::Tracer::Global()->StartSpan(
-      "WriteMovieInfo",
-      { opentracing::ChildOf(parent_span->get()) });
-  opentracing::Tracer::Global()->Inject(span->context(), writer);
+  auto span = TraceSpan::Start("WriteMovieInfo", carrier);
+  RequestProbe probe(req_id, "WriteMovieInfo", span.GetTraceId());
 
   bson_t *new_doc = bson_new();
   BSON_APPEND_UTF8(new_doc, "movie_id", movie_id.c_str());
@@ -132,7 +130,7 @@ void MovieInfoHandler::WriteMovieInfo(
     ServiceException se;
     se.errorCode = ErrorCode::SE_MONGODB_ERROR;
     se.message = "Failed to pop a client from MongoDB pool";
-    throw se;
+    throw RequestError(se);
   }
   auto collection = mongoc_client_get_collection(
       mongodb_client, "movie-info", "movie-info");
@@ -141,14 +139,15 @@ void MovieInfoHandler::WriteMovieInfo(
     se.errorCode = ErrorCode::SE_MONGODB_ERROR;
     se.message = "Failed to create collection movie-info from DB movie-info";
     mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
-    throw se;
+    throw RequestError(se);
   }
   bson_error_t error;
-  auto insert_span = opentracing::Tracer::Global()->StartSpan(
-      "MongoInsertMovieInfo", { opentracing::ChildOf(&span->context()) });
+  auto insert_span = span.Child("MongoInsertMovieInfo");
+  CallProbe insert_probe(ProbeBackend::mongo, req_id, "MongoInsertMovieInfo");
   bool plotinsert = mongoc_collection_insert_one (
       collection, new_doc, nullptr, nullptr, &error);
-  insert_span->Finish();
+  insert_span.Finish();
+  insert_probe.End();
   if (!plotinsert) {
     LOG(error) << "Error: Failed to insert movie-info to MongoDB: "
                << error.message;
@@ -158,14 +157,14 @@ void MovieInfoHandler::WriteMovieInfo(
     bson_destroy(new_doc);
     mongoc_collection_destroy(collection);
     mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
-    throw se;
+    throw RequestError(se);
   }
 
   bson_destroy(new_doc);
   mongoc_collection_destroy(collection);
   mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
 
-  span->Finish();
+  span.Finish();
 }
 
 void MovieInfoHandler::ReadMovieInfo(
@@ -175,29 +174,23 @@ void MovieInfoHandler::ReadMovieInfo(
     const std::map<std::string, std::string> &carrier) {
 
   // Initialize a span
-  TextMapReader reader(carrier);
-  std::map<std::string, std::string> writer_text_map;
-  TextMapWriter writer(writer_text_map);
-  auto parent_span = opentracing::Tracer::Global()->Extract(reader);
-  auto span = opentracing::Tracer::Global()->StartSpan(
-      "ReadMovieInfo",
-      { opentracing::ChildOf(parent_span->get()) });
-  opentracing::Tracer::Global()->Inject(span->context(), writer);
+  auto span = TraceSpan::Start("ReadMovieInfo", carrier);
+  RequestProbe probe(req_id, "ReadMovieInfo", span.GetTraceId());
   
   memcached_return_t memcached_rc;
-  memcached_st *memcached_client = memcached_pool_pop(
+  memcached_st *memcached_client = MemcachedPoolPop(
       _memcached_client_pool, true, &memcached_rc);
   if (!memcached_client) {
     ServiceException se;
     se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
     se.message = "Failed to pop a client from memcached pool";
-    throw se;
+    throw RequestError(se);
   }
 
   size_t movie_info_mmc_size;
   uint32_t memcached_flags;
-  auto get_span = opentracing::Tracer::Global()->StartSpan(
-      "MmcGetMovieInfo", { opentracing::ChildOf(&span->context()) });
+  auto get_span = span.Child("MmcGetMovieInfo");
+  CallProbe get_probe(ProbeBackend::memcached, req_id, "MmcGetMovieInfo");
   char *movie_info_mmc = memcached_get(
       memcached_client,
       movie_id.c_str(),
@@ -209,11 +202,14 @@ void MovieInfoHandler::ReadMovieInfo(
     ServiceException se;
     se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
     se.message = memcached_strerror(memcached_client, memcached_rc);
-    memcached_pool_push(_memcached_client_pool, memcached_client);
-    throw se;
+    MemcachedPoolPush(_memcached_client_pool, memcached_client);
+    throw RequestError(se);
   }
-  memcached_pool_push(_memcached_client_pool, memcached_client);
-  get_span->Finish();
+  MemcachedPoolPush(_memcached_client_pool, memcached_client);
+  get_span.Finish();
+  get_probe.AddBytes(movie_id.length(),
+                     movie_info_mmc ? movie_info_mmc_size : 0);
+  get_probe.End(movie_info_mmc != nullptr);
 
   if (movie_info_mmc) {
     LOG(debug) << "Get movie-info " << movie_id << " cache hit from Memcached";
@@ -249,7 +245,7 @@ void MovieInfoHandler::ReadMovieInfo(
       ServiceException se;
       se.errorCode = ErrorCode::SE_MONGODB_ERROR;
       se.message = "Failed to pop a client from MongoDB pool";
-      throw se;
+      throw RequestError(se);
     }
 
     auto collection = mongoc_client_get_collection(
@@ -259,17 +255,18 @@ void MovieInfoHandler::ReadMovieInfo(
       se.errorCode = ErrorCode::SE_MONGODB_ERROR;
       se.message = "Failed to create collection user from DB user";
       mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
-      throw se;
+      throw RequestError(se);
     }
     bson_t *query = bson_new();
     BSON_APPEND_UTF8(query, "movie_id", movie_id.c_str());
-    auto find_span = opentracing::Tracer::Global()->StartSpan(
-        "MongoFindMovieInfo", { opentracing::ChildOf(&span->context()) });
+    auto find_span = span.Child("MongoFindMovieInfo");
+    CallProbe find_probe(ProbeBackend::mongo, req_id, "MongoFindMovieInfo");
     mongoc_cursor_t *cursor = mongoc_collection_find_with_opts(
         collection, query, nullptr, nullptr);
     const bson_t *doc;
     bool found = mongoc_cursor_next(cursor, &doc);
-    find_span->Finish();
+    find_span.Finish();
+    find_probe.End(found);
     if (!found) {
       bson_error_t error;
       if (mongoc_cursor_error (cursor, &error)) {
@@ -281,7 +278,7 @@ void MovieInfoHandler::ReadMovieInfo(
         ServiceException se;
         se.errorCode = ErrorCode::SE_MONGODB_ERROR;
         se.message = error.message;
-        throw se;
+        throw RequestError(se);
       } else {
         LOG(warning) << "Movie_id: " << movie_id << " doesn't exist in MongoDB";
         bson_destroy(query);
@@ -291,7 +288,7 @@ void MovieInfoHandler::ReadMovieInfo(
         ServiceException se;
         se.errorCode = ErrorCode::SE_THRIFT_HANDLER_ERROR;
         se.message = "Movie_id: " + movie_id + " doesn't exist in MongoDB";
-        throw se;
+        throw RequestError(se);
       }
     } else {
       LOG(debug) << "Movie_id: " << movie_id << " found in MongoDB";
@@ -324,16 +321,16 @@ void MovieInfoHandler::ReadMovieInfo(
       mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
 
       // upload movie-info to memcached
-      memcached_client = memcached_pool_pop(
+      memcached_client = MemcachedPoolPop(
           _memcached_client_pool, true, &memcached_rc);
       if (!memcached_client) {
         ServiceException se;
         se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
         se.message = "Failed to pop a client from memcached pool";
-        throw se;
+        throw RequestError(se);
       }
-      auto set_span = opentracing::Tracer::Global()->StartSpan(
-          "MmcSetMovieInfo", { opentracing::ChildOf(&span->context()) });
+      auto set_span = span.Child("MmcSetMovieInfo");
+      CallProbe set_probe(ProbeBackend::memcached, req_id, "MmcSetMovieInfo");
 
       memcached_rc = memcached_set(
           memcached_client,
@@ -347,12 +344,15 @@ void MovieInfoHandler::ReadMovieInfo(
         LOG(warning) << "Failed to set movie_info to Memcached: "
                      << memcached_strerror(memcached_client, memcached_rc);
       }
-      set_span->Finish();
+      set_span.Finish();
+      set_probe.AddBytes(
+          movie_id.length() + std::strlen(movie_info_json_char), 0);
+      set_probe.End();
       bson_free(movie_info_json_char);
-      memcached_pool_push(_memcached_client_pool, memcached_client);
+      MemcachedPoolPush(_memcached_client_pool, memcached_client);
     }
   }
-  span->Finish();
+  span.Finish();
 }
 
 void MovieInfoHandler::UpdateRating(
@@ -360,14 +360,8 @@ void MovieInfoHandler::UpdateRating(
     int32_t sum_uncommitted_rating, int32_t num_uncommitted_rating,
     const std::map<std::string, std::string> & carrier) {
   // Initialize a span
-  TextMapReader reader(carrier);
-  std::map<std::string, std::string> writer_text_map;
-  TextMapWriter writer(writer_text_map);
-  auto parent_span = opentracing::Tracer::Global()->Extract(reader);
-  auto span = opentracing::Tracer::Global()->StartSpan(
-      "UpdateRating",
-      { opentracing::ChildOf(parent_span->get()) });
-  opentracing::Tracer::Global()->Inject(span->context(), writer);
+  auto span = TraceSpan::Start("UpdateRating", carrier);
+  RequestProbe probe(req_id, "UpdateRating", span.GetTraceId());
 
   bson_t *query = bson_new();
   BSON_APPEND_UTF8(query, "movie_id", movie_id.c_str());
@@ -378,7 +372,7 @@ void MovieInfoHandler::UpdateRating(
     ServiceException se;
     se.errorCode = ErrorCode::SE_MONGODB_ERROR;
     se.message = "Failed to pop a client from MongoDB pool";
-    throw se;
+    throw RequestError(se);
   }
   auto collection = mongoc_client_get_collection(
       mongodb_client, "social-graph", "social-graph");
@@ -387,14 +381,15 @@ void MovieInfoHandler::UpdateRating(
     se.errorCode = ErrorCode::SE_MONGODB_ERROR;
     se.message = "Failed to create collection social_graph from MongoDB";
     mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
-    throw se;
+    throw RequestError(se);
   }
-  auto find_span = opentracing::Tracer::Global()->StartSpan(
-      "MongoFindMovieInfo", {opentracing::ChildOf(&span->context())});
+  auto find_span = span.Child("MongoFindMovieInfo");
+  CallProbe find_probe(ProbeBackend::mongo, req_id, "MongoFindMovieInfo");
   mongoc_cursor_t *cursor = mongoc_collection_find_with_opts(
       collection, query, nullptr, nullptr);
   const bson_t *doc;
   bool found = mongoc_cursor_next(cursor, &doc);
+  find_probe.End(found);
   if (found) {
     bson_iter_t iter_0;
     bson_iter_t iter_1;
@@ -417,8 +412,8 @@ void MovieInfoHandler::UpdateRating(
           "num_rating", BCON_INT32(num_rating), "}");
       bson_error_t error;
       bson_t reply;
-      auto update_span = opentracing::Tracer::Global()->StartSpan(
-          "MongoUpdateRating", {opentracing::ChildOf(&span->context())});
+      auto update_span = span.Child("MongoUpdateRating");
+      CallProbe update_probe(ProbeBackend::mongo, req_id, "MongoUpdateRating");
       bool updated = mongoc_collection_find_and_modify(
           collection,
           query,
@@ -441,28 +436,31 @@ void MovieInfoHandler::UpdateRating(
         bson_destroy(update);
         mongoc_collection_destroy(collection);
         mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
-        throw se;
+        throw RequestError(se);
       }
-      update_span->Finish();
+      update_span.Finish();
+      update_probe.End();
     }
   }
 
-  auto delete_span = opentracing::Tracer::Global()->StartSpan(
-      "MmcDelete", {opentracing::ChildOf(&span->context())});
+  auto delete_span = span.Child("MmcDelete");
+  CallProbe delete_probe(ProbeBackend::memcached, req_id, "MmcDelete");
   memcached_return_t memcached_rc;
-  memcached_st *memcached_client = memcached_pool_pop(
+  memcached_st *memcached_client = MemcachedPoolPop(
       _memcached_client_pool, true, &memcached_rc);
   if (!memcached_client) {
     ServiceException se;
     se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
     se.message = "Failed to pop a client from memcached pool";
-    throw se;
+    throw RequestError(se);
   }
   memcached_delete(memcached_client, movie_id.c_str(), movie_id.length(), 0);
-  memcached_pool_push(_memcached_client_pool, memcached_client);
-  delete_span->Finish();
+  MemcachedPoolPush(_memcached_client_pool, memcached_client);
+  delete_span.Finish();
+  delete_probe.AddBytes(movie_id.length(), 0);
+  delete_probe.End();
 
-  span->Finish();
+  span.Finish();
 }
 
 } // namespace media_service
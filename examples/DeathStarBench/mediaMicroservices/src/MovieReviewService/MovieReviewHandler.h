@@ -9,8 +9,10 @@
 
 #include "../../gen-cpp/MovieReviewService.h"
 #include "../../gen-cpp/ReviewStorageService.h"
+#include "../Executor.h"
 #include "../logger.h"
 #include "../tracing.h"
+#include "../probes.h"
 #include "../ClientPool.h"
 #include "../RedisClient.h"
 #include "../ThriftClient.h"
@@ -25,6 +27,8 @@ namespace media_service
         mongoc_client_pool_t *,
         ClientPool<ThriftClient<ReviewStorageServiceClient>> *);
     ~MovieReviewHandler() override = default;
+
+    void Ping() override {}
     void UploadMovieReview(int64_t, const std::string &, int64_t, int64_t,
                            const std::map<std::string, std::string> &) override;
     void ReadMovieReviews(std::vector<Review> &_return, int64_t req_id,
@@ -56,14 +60,8 @@ namespace media_service
   {
 
     // Initialize a span
-    TextMapReader reader(carrier);
-    std::map<std::string, std::string> writer_text_map;
-    TextMapWriter writer(writer_text_map);
-    auto parent_span = opentracing::Tracer::Global()->Extract(reader);
-    auto span = opentracing::Tracer::Global()->StartSpan(
-        "UploadMovieReview",
-        {opentracing::ChildOf(parent_span->get())});
-    opentracing::Tracer::Global()->Inject(span->context(), writer);
+    auto span = TraceSpan::Start("UploadMovieReview", carrier);
+    RequestProbe probe(req_id, "UploadMovieReview", span.GetTraceId());
 
     mongoc_client_t *mongodb_client = mongoc_client_pool_pop(
         _mongodb_client_pool);
@@ -72,7 +70,7 @@ namespace media_service
       ServiceException se;
       se.errorCode = ErrorCode::SE_MONGODB_ERROR;
       se.message = "Failed to pop a client from MongoDB pool";
-      throw se;
+      throw RequestError(se);
     }
 
     auto collection = mongoc_client_get_collection(
@@ -83,17 +81,18 @@ namespace media_service
       se.errorCode = ErrorCode::SE_MONGODB_ERROR;
       se.message = "Failed to create collection movie-review from DB movie-review";
       mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
-      throw se;
+      throw RequestError(se);
     }
 
     bson_t *query = bson_new();
     BSON_APPEND_UTF8(query, "movie_id", movie_id.c_str());
-    auto find_span = opentracing::Tracer::Global()->StartSpan(
-        "MongoFindMovie", {opentracing::ChildOf(&span->context())});
+    auto find_span = span.Child("MongoFindMovie");
+    CallProbe find_probe(ProbeBackend::mongo, req_id, "MongoFindMovie");
     mongoc_cursor_t *cursor = mongoc_collection_find_with_opts(
         collection, query, nullptr, nullptr);
     const bson_t *doc;
     bool found = mongoc_cursor_next(cursor, &doc);
+    find_probe.End(found);
     if (!found)
     {
       bson_t *new_doc = BCON_NEW(
@@ -102,11 +101,12 @@ namespace media_service
           "[", "{", "review_id", BCON_INT64(review_id),
           "timestamp", BCON_INT64(timestamp), "}", "]");
       bson_error_t error;
-      auto insert_span = opentracing::Tracer::Global()->StartSpan(
-          "MongoInsert", {opentracing::ChildOf(&span->context())});
+      auto insert_span = span.Child("MongoInsert");
+      CallProbe insert_probe(ProbeBackend::mongo, req_id, "MongoInsert");
       bool plotinsert = mongoc_collection_insert_one(
           collection, new_doc, nullptr, nullptr, &error);
-      insert_span->Finish();
+      insert_span.Finish();
+      insert_probe.End();
       if (!plotinsert)
       {
         LOG(error) << "Failed to insert movie review of movie " << movie_id
@@ -119,7 +119,7 @@ namespace media_service
         mongoc_cursor_destroy(cursor);
         mongoc_collection_destroy(collection);
         mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
-        throw se;
+        throw RequestError(se);
       }
       bson_destroy(new_doc);
     }
@@ -137,12 +137,13 @@ namespace media_service
           "}");
       bson_error_t error;
       bson_t reply;
-      auto update_span = opentracing::Tracer::Global()->StartSpan(
-          "MongoUpdate.", {opentracing::ChildOf(&span->context())});
+      auto update_span = span.Child("MongoUpdate.");
+      CallProbe update_probe(ProbeBackend::mongo, req_id, "MongoUpdate.");
       bool plotupdate = mongoc_collection_find_and_modify(
           collection, query, nullptr, update, nullptr, false, false,
           true, &reply, &error);
-      update_span->Finish();
+      update_span.Finish();
+      update_probe.End();
       if (!plotupdate)
       {
         LOG(error) << "Failed to update movie-review for movie " << movie_id
@@ -156,7 +157,7 @@ namespace media_service
         mongoc_cursor_destroy(cursor);
         mongoc_collection_destroy(collection);
         mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
-        throw se;
+        throw RequestError(se);
       }
       bson_destroy(update);
       bson_destroy(&reply);
@@ -172,11 +173,11 @@ namespace media_service
       ServiceException se;
       se.errorCode = ErrorCode::SE_REDIS_ERROR;
       se.message = "Cannot connected to Redis server";
-      throw se;
+      throw RequestError(se);
     }
     auto redis_client = redis_client_wrapper->GetClient();
-    auto redis_span = opentracing::Tracer::Global()->StartSpan(
-        "RedisUpdate", {opentracing::ChildOf(&span->context())});
+    auto redis_span = span.Child("RedisUpdate");
+    CallProbe redis_probe(ProbeBackend::redis, req_id, "RedisUpdate");
     auto num_reviews = redis_client->zcard(movie_id);
     redis_client->sync_commit();
     auto num_reviews_reply = num_reviews.get();
@@ -188,8 +189,9 @@ namespace media_service
       redis_client->sync_commit();
     }
     _redis_client_pool->Push(redis_client_wrapper);
-    redis_span->Finish();
-    span->Finish();
+    redis_span.Finish();
+    redis_probe.End();
+    span.Finish();
   }
 
   void MovieReviewHandler::ReadMovieReviews(
@@ -199,14 +201,9 @@ namespace media_service
   {
 
     // Initialize a span
-    TextMapReader reader(carrier);
-    std::map<std::string, std::string> writer_text_map;
-    TextMapWriter writer(writer_text_map);
-    auto parent_span = opentracing::Tracer::Global()->Extract(reader);
-    auto span = opentracing::Tracer::Global()->StartSpan(
-        "ReadMovieReviews",
-        {opentracing::ChildOf(parent_span->get())});
-    opentracing::Tracer::Global()->Inject(span->context(), writer);
+    auto span = TraceSpan::Start("ReadMovieReviews", carrier);
+    RequestProbe probe(req_id, "ReadMovieReviews", span.GetTraceId());
+    auto &writer_text_map = span.Carrier();
 
     if (stop <= start || start < 0)
     {
@@ -219,19 +216,22 @@ namespace media_service
       ServiceException se;
       se.errorCode = ErrorCode::SE_REDIS_ERROR;
       se.message = "Cannot connected to Redis server";
-      throw se;
+      throw RequestError(se);
     }
     auto redis_client = redis_client_wrapper->GetClient();
-    auto redis_span = opentracing::Tracer::Global()->StartSpan(
-        "RedisFind", {opentracing::ChildOf(&span->context())});
+    auto redis_span = span.Child("RedisFind");
+    CallProbe redis_probe(ProbeBackend::redis, req_id, "RedisFind");
     auto review_ids_future = redis_client->zrevrange(movie_id, start, stop - 1);
     redis_client->commit();
-    redis_span->Finish();
+    redis_span.Finish();
 
     cpp_redis::reply review_ids_reply;
     try
     {
       review_ids_reply = review_ids_future.get();
+      redis_probe.End(review_ids_reply.is_array()
+                          ? review_ids_reply.as_array().size()
+                          : 0);
     }
     catch (...)
     {
@@ -259,7 +259,7 @@ namespace media_service
         ServiceException se;
         se.errorCode = ErrorCode::SE_MONGODB_ERROR;
         se.message = "Failed to pop a client from MongoDB pool";
-        throw se;
+        throw RequestError(se);
       }
       auto collection = mongoc_client_get_collection(
           mongodb_client, "movie-review", "movie-review");
@@ -268,7 +268,7 @@ namespace media_service
         ServiceException se;
         se.errorCode = ErrorCode::SE_MONGODB_ERROR;
         se.message = "Failed to create collection movie-review from MongoDB";
-        throw se;
+        throw RequestError(se);
       }
 
       bson_t *query = BCON_NEW("movie_id", BCON_UTF8(movie_id.c_str()));
@@ -278,13 +278,14 @@ namespace media_service
           "$slice", "[",
           BCON_INT32(0), BCON_INT32(stop),
           "]", "}", "}");
-      auto find_span = opentracing::Tracer::Global()->StartSpan(
-          "MongoFindMovieReviews", {opentracing::ChildOf(&span->context())});
+      auto find_span = span.Child("MongoFindMovieReviews");
+      CallProbe find_probe(ProbeBackend::mongo, req_id, "MongoFindMovieReviews");
       mongoc_cursor_t *cursor = mongoc_collection_find_with_opts(
           collection, query, opts, nullptr);
-      find_span->Finish();
+      find_span.Finish();
       const bson_t *doc;
       bool found = mongoc_cursor_next(cursor, &doc);
+      find_probe.End(found);
       if (found)
       {
         bson_iter_t iter_0;
@@ -312,7 +313,7 @@ namespace media_service
           idx++;
         }
       }
-      find_span->Finish();
+      find_span.Finish();
       bson_destroy(opts);
       bson_destroy(query);
       mongoc_cursor_destroy(cursor);
@@ -343,8 +344,8 @@ namespace media_service
     //       return _return_reviews;
     //     });
 
-    std::future<std::vector<Review>> review_future = std::async(
-        std::launch::async, [&]()
+    TaskFuture<std::vector<Review>> review_future = Executor::Global().Submit(
+        [&]()
         {
         std::vector<Review> _return_reviews;
         auto review_client_wrapper = _review_client_pool->Pop();
@@ -352,7 +353,7 @@ namespace media_service
             ServiceException se;
             se.errorCode = ErrorCode::SE_THRIFT_CONN_ERROR;
             se.message = "Failed to connect to review-storage-service";
-            throw se;
+            throw RequestError(se);
         }
         auto review_client = review_client_wrapper->GetClient();
         bool success = false;
@@ -376,7 +377,7 @@ namespace media_service
                         ServiceException se;
                         se.errorCode = ErrorCode::SE_THRIFT_CONN_ERROR;
                         se.message = "Failed to reconnect to review-storage-service";
-                        throw se;
+                        throw RequestError(se);
                     }
                     review_client = review_client_wrapper->GetClient();
                 } else {
@@ -410,17 +411,18 @@ namespace media_service
         ServiceException se;
         se.errorCode = ErrorCode::SE_REDIS_ERROR;
         se.message = "Cannot connected to Redis server";
-        throw se;
+        throw RequestError(se);
       }
       redis_client = redis_client_wrapper->GetClient();
-      auto redis_update_span = opentracing::Tracer::Global()->StartSpan(
-          "RedisUpdate", {opentracing::ChildOf(&span->context())});
+      auto redis_update_span = span.Child("RedisUpdate");
+      CallProbe redis_update_probe(ProbeBackend::redis, req_id, "RedisUpdate");
       redis_client->del(std::vector<std::string>{movie_id});
       std::vector<std::string> options{"NX"};
       zadd_reply_future = redis_client->zadd(
           movie_id, options, redis_update_map);
       redis_client->commit();
-      redis_update_span->Finish();
+      redis_update_span.Finish();
+      redis_update_probe.End();
     }
 
     try
@@ -460,7 +462,7 @@ namespace media_service
       _redis_client_pool->Push(redis_client_wrapper);
     }
 
-    span->Finish();
+    span.Finish();
   }
 
 } // namespace media_service
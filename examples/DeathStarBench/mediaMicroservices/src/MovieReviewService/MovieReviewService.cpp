@@ -1,17 +1,10 @@
-#include <thrift/protocol/TBinaryProtocol.h>
-#include <thrift/server/TThreadedServer.h>
-#include <thrift/transport/TServerSocket.h>
-#include <thrift/transport/TBufferTransports.h>
 #include <signal.h>
 
 #include "MovieReviewHandler.h"
 #include "../utils.h"
+#include "../utils_thrift.h"
 #include "../utils_mongodb.h"
 
-using apache::thrift::server::TThreadedServer;
-using apache::thrift::transport::TServerSocket;
-using apache::thrift::transport::TFramedTransportFactory;
-using apache::thrift::protocol::TBinaryProtocolFactory;
 using media_service::MovieReviewHandler;
 using namespace media_service;
 
@@ -31,7 +24,6 @@ int main(int argc, char *argv[]) {
     exit(EXIT_FAILURE);
   }
 
-  int port = config_json["movie-review-service"]["port"];
   std::string redis_addr =
       config_json["movie-review-redis"]["addr"];
   int redis_port = config_json["movie-review-redis"]["port"];
@@ -65,17 +57,16 @@ int main(int argc, char *argv[]) {
   }
   mongoc_client_pool_push(mongodb_client_pool, mongodb_client);
 
-  TThreadedServer server(
+  start_observability(config_json, "movie-review-service");
+  init_executor(config_json, "movie-review-service");
+  auto server = init_thrift_server(
+      config_json, "movie-review-service",
       std::make_shared<MovieReviewServiceProcessor>(
           std::make_shared<MovieReviewHandler>(
               &redis_client_pool,
               mongodb_client_pool,
-              &review_storage_client_pool)),
-      std::make_shared<TServerSocket>("0.0.0.0", port),
-      std::make_shared<TFramedTransportFactory>(),
-      std::make_shared<TBinaryProtocolFactory>()
-  );
+              &review_storage_client_pool)));
   std::cout << "Starting the movie-review-service server ..." << std::endl;
-  server.serve();
+  server->serve();
 
 }
\ No newline at end of file
@@ -12,8 +12,8 @@
 #include "../../gen-cpp/PlotService.h"
 #include "../logger.h"
 #include "../tracing.h"
-#include "../ClientPool.h"
-#include "../ThriftClient.h"
+#include "../probes.h"
+#include "../ThriftAsyncClient.h"
 
 namespace media_service
 {
@@ -22,32 +22,34 @@ namespace media_service
   {
   public:
     PageHandler(
-        ClientPool<ThriftClient<MovieReviewServiceClient>> *,
-        ClientPool<ThriftClient<MovieInfoServiceClient>> *,
-        ClientPool<ThriftClient<CastInfoServiceClient>> *,
-        ClientPool<ThriftClient<PlotServiceClient>> *);
+        ThriftAsyncClient<MovieReviewServiceConcurrentClient> *,
+        ThriftAsyncClient<MovieInfoServiceConcurrentClient> *,
+        ThriftAsyncClient<CastInfoServiceConcurrentClient> *,
+        ThriftAsyncClient<PlotServiceConcurrentClient> *);
     ~PageHandler() override = default;
 
+    void Ping() override {}
+
     void ReadPage(Page &_return, int64_t req_id, const std::string &movie_id,
                   int32_t review_start, int32_t review_stop,
                   const std::map<std::string, std::string> &carrier) override;
 
   private:
-    ClientPool<ThriftClient<MovieReviewServiceClient>> *_movie_review_client_pool;
-    ClientPool<ThriftClient<MovieInfoServiceClient>> *_movie_info_client_pool;
-    ClientPool<ThriftClient<CastInfoServiceClient>> *_cast_info_client_pool;
-    ClientPool<ThriftClient<PlotServiceClient>> *_plot_client_pool;
+    ThriftAsyncClient<MovieReviewServiceConcurrentClient> *_movie_review_client;
+    ThriftAsyncClient<MovieInfoServiceConcurrentClient> *_movie_info_client;
+    ThriftAsyncClient<CastInfoServiceConcurrentClient> *_cast_info_client;
+    ThriftAsyncClient<PlotServiceConcurrentClient> *_plot_client;
   };
   PageHandler::PageHandler(
-      ClientPool<ThriftClient<MovieReviewServiceClient>> *movie_review_client_pool,
-      ClientPool<ThriftClient<MovieInfoServiceClient>> *movie_info_client_pool,
-      ClientPool<ThriftClient<CastInfoServiceClient>> *cast_info_client_pool,
-      ClientPool<ThriftClient<PlotServiceClient>> *plot_client_pool)
+      ThriftAsyncClient<MovieReviewServiceConcurrentClient> *movie_review_client,
+      ThriftAsyncClient<MovieInfoServiceConcurrentClient> *movie_info_client,
+      ThriftAsyncClient<CastInfoServiceConcurrentClient> *cast_info_client,
+      ThriftAsyncClient<PlotServiceConcurrentClient> *plot_client)
   {
-    _movie_review_client_pool = movie_review_client_pool;
-    _movie_info_client_pool = movie_info_client_pool;
-    _cast_info_client_pool = cast_info_client_pool;
-    _plot_client_pool = plot_client_pool;
+    _movie_review_client = movie_review_client;
+    _movie_info_client = movie_info_client;
+    _cast_info_client = cast_info_client;
+    _plot_client = plot_client;
   }
   void PageHandler::ReadPage(
       Page &_return,
@@ -59,175 +61,37 @@ namespace media_service
   {
 
     // Initialize a span
-    TextMapReader reader(carrier);
-    std::map<std::string, std::string> writer_text_map;
-    TextMapWriter writer(writer_text_map);
-    auto parent_span = opentracing::Tracer::Global()->Extract(reader);
-    auto span = opentracing::Tracer::Global()->StartSpan(
-        "ReadPage",
-        {opentracing::ChildOf(parent_span->get())});
-    opentracing::Tracer::Global()->Inject(span->context(), writer);
-
-    std::future<std::vector<Review>> movie_review_future;
-    std::future<MovieInfo> movie_info_future;
-    std::future<std::vector<CastInfo>> cast_info_future;
-    std::future<std::string> plot_future;
-
-    // movie_info_future = std::async(std::launch::async, [&](){
-    //   MovieInfo _reture_movie_info;
-    //   auto movie_info_client_wrapper = _movie_info_client_pool->Pop();
-    //   if (!movie_info_client_wrapper) {
-    //     ServiceException se;
-    //     se.errorCode = ErrorCode::SE_THRIFT_CONN_ERROR;
-    //     se.message = "Failed to connected to movie-info-service";
-    //     throw se;
-    //   }
-    //   auto movie_info_client = movie_info_client_wrapper->GetClient();
-    //   try {
-    //     movie_info_client->ReadMovieInfo(_reture_movie_info,
-    //         req_id, movie_id, writer_text_map);
-    //   } catch (...) {
-    //     _movie_info_client_pool->Push(movie_info_client_wrapper);
-    //     LOG(error) << "Failed to read movie_info to movie-info-service";
-    //     throw;
-    //   }
-    //   _movie_info_client_pool->Push(movie_info_client_wrapper);
-    //   return _reture_movie_info;
-    // });
-
-    movie_info_future = std::async(std::launch::async, [&]()
-                                   {
-    MovieInfo _return_movie_info;
-    auto movie_info_client_wrapper = _movie_info_client_pool->Pop();
-    if (!movie_info_client_wrapper) {
-        ServiceException se;
-        se.errorCode = ErrorCode::SE_THRIFT_CONN_ERROR;
-        se.message = "Failed to connect to movie-info-service";
-        throw se;
-    }
-    auto movie_info_client = movie_info_client_wrapper->GetClient();
-    bool success = false;
-    int retry_count = 3; // Number of retries
-
-    while (!success && retry_count > 0) {
-        try {
-            movie_info_client->ReadMovieInfo(_return_movie_info,
-                req_id, movie_id, writer_text_map);
-            success = true;
-        } catch (const apache::thrift::transport::TTransportException &e) {
-            LOG(error) << "Transport exception: " << e.what() << ". Retries left: " << retry_count;
-            retry_count--;
-
-            // Handle specific "Broken pipe" scenario or any transport exception
-            if (retry_count > 0) {
-                // Remove the problematic client from the pool and try to get a new one
-                _movie_info_client_pool->Remove(movie_info_client_wrapper);
-                movie_info_client_wrapper = _movie_info_client_pool->Pop();
-                if (!movie_info_client_wrapper) {
-                    ServiceException se;
-                    se.errorCode = ErrorCode::SE_THRIFT_CONN_ERROR;
-                    se.message = "Failed to reconnect to movie-info-service";
-                    throw se;
-                }
-                movie_info_client = movie_info_client_wrapper->GetClient();
-            } else {
-                // If no retries left, push back the client and rethrow the exception
-                _movie_info_client_pool->Push(movie_info_client_wrapper);
-                LOG(error) << "Failed to read movie_info from movie-info-service after retries";
-                throw;
-            }
-        } catch (const std::exception &e) {
-            // Catch other standard exceptions and log them
-            LOG(error) << "Standard exception: " << e.what();
-            _movie_info_client_pool->Push(movie_info_client_wrapper);
-            throw;
-        } catch (...) {
-            // Catch any other exceptions and log them
-            LOG(error) << "Unknown exception caught";
-            _movie_info_client_pool->Push(movie_info_client_wrapper);
-            throw;
-        }
-    }
-    _movie_info_client_pool->Push(movie_info_client_wrapper);
-    return _return_movie_info; });
-
-    // movie_review_future = std::async(std::launch::async, [&]()
-    //                                  {
-    // std::vector<Review> _return_movie_reviews;
-    // auto movie_review_client_wrapper = _movie_review_client_pool->Pop();
-    // if (!movie_review_client_wrapper) {
-    //   ServiceException se;
-    //   se.errorCode = ErrorCode::SE_THRIFT_CONN_ERROR;
-    //   se.message = "Failed to connected to movie-review-service";
-    //   throw se;
-    // }
-    // auto movie_review_client = movie_review_client_wrapper->GetClient();
-    // try {
-    //   movie_review_client->ReadMovieReviews(_return_movie_reviews,
-    //       req_id, movie_id, review_start, review_stop, writer_text_map);
-    // } catch (...) {
-    //   _movie_review_client_pool->Push(movie_review_client_wrapper);
-    //   LOG(error) << "Failed to read reviews to movie-review-service";
-    //   throw;
-    // }
-    // _movie_review_client_pool->Push(movie_review_client_wrapper);
-    // return _return_movie_reviews; });
-
-    movie_review_future = std::async(std::launch::async, [&]()
-                                     {
-    std::vector<Review> _return_movie_reviews;
-    auto movie_review_client_wrapper = _movie_review_client_pool->Pop();
-    if (!movie_review_client_wrapper) {
-        ServiceException se;
-        se.errorCode = ErrorCode::SE_THRIFT_CONN_ERROR;
-        se.message = "Failed to connect to movie-review-service";
-        throw se;
-    }
-    auto movie_review_client = movie_review_client_wrapper->GetClient();
-    bool success = false;
-    int retry_count = 3; // Number of retries
-
-    while (!success && retry_count > 0) {
-        try {
-            movie_review_client->ReadMovieReviews(_return_movie_reviews,
-                req_id, movie_id, review_start, review_stop, writer_text_map);
-            success = true;
-        } catch (const apache::thrift::transport::TTransportException &e) {
-            LOG(error) << "Transport exception: " << e.what() << ". Retries left: " << retry_count;
-            retry_count--;
-
-            // Handle specific "Broken pipe" scenario or any transport exception
-            if (retry_count > 0) {
-                // Remove the problematic client from the pool and try to get a new one
-                _movie_review_client_pool->Remove(movie_review_client_wrapper);
-                movie_review_client_wrapper = _movie_review_client_pool->Pop();
-                if (!movie_review_client_wrapper) {
-                    ServiceException se;
-                    se.errorCode = ErrorCode::SE_THRIFT_CONN_ERROR;
-                    se.message = "Failed to reconnect to movie-review-service";
-                    throw se;
-                }
-                movie_review_client = movie_review_client_wrapper->GetClient();
-            } else {
-                // If no retries left, push back the client and rethrow the exception
-                _movie_review_client_pool->Push(movie_review_client_wrapper);
-                LOG(error) << "Failed to read reviews from movie-review-service after retries";
-                throw;
-            }
-        } catch (const std::exception &e) {
-            // Catch other standard exceptions and log them
-            LOG(error) << "Standard exception: " << e.what();
-            _movie_review_client_pool->Push(movie_review_client_wrapper);
-            throw;
-        } catch (...) {
-            // Catch any other exceptions and log them
-            LOG(error) << "Unknown exception caught";
-            _movie_review_client_pool->Push(movie_review_client_wrapper);
-            throw;
-        }
-    }
-    _movie_review_client_pool->Push(movie_review_client_wrapper);
-    return _return_movie_reviews; });
+    auto span = TraceSpan::Start("ReadPage", carrier);
+    RequestProbe probe(req_id, "ReadPage", span.GetTraceId());
+    auto &writer_text_map = span.Carrier();
+
+    // The four reads are pipelined over the async clients' connections, so
+    // the fan-out needs neither a thread nor a connection per call. The send
+    // closures capture by value because a failed-over call may be sent again.
+    auto movie_info_future = _movie_info_client->Call<MovieInfo>(
+        [=](MovieInfoServiceConcurrentClient *client)
+        {
+          return client->send_ReadMovieInfo(req_id, movie_id, writer_text_map);
+        },
+        [](MovieInfoServiceConcurrentClient *client, int32_t seqid,
+           MovieInfo &movie_info)
+        {
+          client->recv_ReadMovieInfo(movie_info, seqid);
+        });
+
+    auto movie_review_future =
+        _movie_review_client->Call<std::vector<Review>>(
+            [=](MovieReviewServiceConcurrentClient *client)
+            {
+              return client->send_ReadMovieReviews(
+                  req_id, movie_id, review_start, review_stop,
+                  writer_text_map);
+            },
+            [](MovieReviewServiceConcurrentClient *client, int32_t seqid,
+               std::vector<Review> &reviews)
+            {
+              client->recv_ReadMovieReviews(reviews, seqid);
+            });
 
     try
     {
@@ -235,6 +99,7 @@ namespace media_service
     }
     catch (...)
     {
+      LOG(error) << "Failed to read movie_info from movie-info-service";
       throw;
     }
 
@@ -244,61 +109,58 @@ namespace media_service
       cast_info_ids.emplace_back(cast.cast_info_id);
     }
 
-    cast_info_future = std::async(std::launch::async, [&]()
-                                  {
-    std::vector<CastInfo> _return_cast_infos;
-    auto cast_info_client_wrapper = _cast_info_client_pool->Pop();
-    if (!cast_info_client_wrapper) {
-      ServiceException se;
-      se.errorCode = ErrorCode::SE_THRIFT_CONN_ERROR;
-      se.message = "Failed to connected to cast-info-service";
-      throw se;
+    auto cast_info_future = _cast_info_client->Call<std::vector<CastInfo>>(
+        [=](CastInfoServiceConcurrentClient *client)
+        {
+          return client->send_ReadCastInfo(req_id, cast_info_ids,
+                                           writer_text_map);
+        },
+        [](CastInfoServiceConcurrentClient *client, int32_t seqid,
+           std::vector<CastInfo> &cast_infos)
+        {
+          client->recv_ReadCastInfo(cast_infos, seqid);
+        });
+
+    int64_t plot_id = _return.movie_info.plot_id;
+    auto plot_future = _plot_client->Call<std::string>(
+        [=](PlotServiceConcurrentClient *client)
+        {
+          return client->send_ReadPlot(req_id, plot_id, writer_text_map);
+        },
+        [](PlotServiceConcurrentClient *client, int32_t seqid,
+           std::string &plot)
+        {
+          client->recv_ReadPlot(plot, seqid);
+        });
+
+    try
+    {
+      _return.reviews = movie_review_future.get();
     }
-    auto cast_info_client = cast_info_client_wrapper->GetClient();
-    try {
-      cast_info_client->ReadCastInfo(_return_cast_infos, req_id,
-          cast_info_ids, writer_text_map);
-    } catch (...) {
-      _cast_info_client_pool->Push(cast_info_client_wrapper);
-      LOG(error) << "Failed to read cast-info to cast-info-service";
+    catch (...)
+    {
+      LOG(error) << "Failed to read reviews from movie-review-service";
       throw;
     }
-    _cast_info_client_pool->Push(cast_info_client_wrapper);
-    return _return_cast_infos; });
-
-    plot_future = std::async(std::launch::async, [&]()
-                             {
-    std::string _return_plot;
-    auto plot_client_wrapper = _plot_client_pool->Pop();
-    if (!plot_client_wrapper) {
-      ServiceException se;
-      se.errorCode = ErrorCode::SE_THRIFT_CONN_ERROR;
-      se.message = "Failed to connected to plot-service";
-      throw se;
+    try
+    {
+      _return.plot = plot_future.get();
     }
-    auto plot_client = plot_client_wrapper->GetClient();
-    try {
-      plot_client->ReadPlot(_return_plot, req_id, _return.movie_info.plot_id,
-          writer_text_map);
-    } catch (...) {
-      _plot_client_pool->Push(plot_client_wrapper);
-      LOG(error) << "Failed to read plot to plot-service";
+    catch (...)
+    {
+      LOG(error) << "Failed to read plot from plot-service";
       throw;
     }
-    _plot_client_pool->Push(plot_client_wrapper);
-    return _return_plot; });
-
     try
     {
-      _return.reviews = movie_review_future.get();
-      _return.plot = plot_future.get();
       _return.cast_infos = cast_info_future.get();
     }
     catch (...)
     {
+      LOG(error) << "Failed to read cast-info from cast-info-service";
       throw;
     }
-    span->Finish();
+    span.Finish();
   }
 
 } // namespace media_service
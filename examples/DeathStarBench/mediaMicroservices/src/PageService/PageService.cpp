@@ -1,17 +1,10 @@
-#include <thrift/protocol/TBinaryProtocol.h>
-#include <thrift/server/TThreadedServer.h>
-#include <thrift/transport/TServerSocket.h>
-#include <thrift/transport/TBufferTransports.h>
 #include <signal.h>
 
 #include "../utils.h"
+#include "../utils_thrift.h"
 #include "PageHandler.h"
 
 using json = nlohmann::json;
-using apache::thrift::server::TThreadedServer;
-using apache::thrift::transport::TServerSocket;
-using apache::thrift::transport::TFramedTransportFactory;
-using apache::thrift::protocol::TBinaryProtocolFactory;
 using namespace media_service;
 
 void sigintHandler(int sig) {
@@ -29,7 +22,6 @@ int main(int argc, char *argv[]) {
     exit(EXIT_FAILURE);
   }
 
-  int port = config_json["page-service"]["port"];
   std::string cast_info_addr = config_json["cast-info-service"]["addr"];
   int cast_info_port = config_json["cast-info-service"]["port"];
   std::string movie_review_addr = config_json["movie-review-service"]["addr"];
@@ -39,29 +31,36 @@ int main(int argc, char *argv[]) {
   std::string plot_addr = config_json["plot-service"]["addr"];
   int plot_port = config_json["plot-service"]["port"];
 
-  ClientPool<ThriftClient<MovieInfoServiceClient>>
-      movie_info_client_pool("movie-info-client", movie_info_addr,
-                             movie_info_port, 0, 128, 1000);
-  ClientPool<ThriftClient<CastInfoServiceClient>>
-      cast_info_client_pool("cast-info-client", cast_info_addr,
-                            cast_info_port, 0, 128, 1000);
-  ClientPool<ThriftClient<MovieReviewServiceClient>>
-      movie_review_client_pool("movie-review-client", movie_review_addr,
-                               movie_review_port, 0, 128, 1000);
-  ClientPool<ThriftClient<PlotServiceClient>>
-      plot_client_pool("plot-client", plot_addr, plot_port, 0, 128, 1000);
+  json async_json = config_json["page-service"].value(
+      "async_client", json::object());
+  int async_connections = async_json.value(
+      "connections", THRIFT_ASYNC_DEFAULT_CONNECTIONS);
+  int async_timeout_ms = async_json.value(
+      "timeout_ms", THRIFT_ASYNC_DEFAULT_TIMEOUT_MS);
 
-  TThreadedServer server(
+  ThriftAsyncClient<MovieInfoServiceConcurrentClient>
+      movie_info_client("movie-info-client", movie_info_addr,
+                        movie_info_port, async_connections, async_timeout_ms);
+  ThriftAsyncClient<CastInfoServiceConcurrentClient>
+      cast_info_client("cast-info-client", cast_info_addr,
+                       cast_info_port, async_connections, async_timeout_ms);
+  ThriftAsyncClient<MovieReviewServiceConcurrentClient>
+      movie_review_client("movie-review-client", movie_review_addr,
+                          movie_review_port, async_connections,
+                          async_timeout_ms);
+  ThriftAsyncClient<PlotServiceConcurrentClient>
+      plot_client("plot-client", plot_addr, plot_port, async_connections,
+                  async_timeout_ms);
+
+  start_observability(config_json, "page-service");
+  auto server = init_thrift_server(
+      config_json, "page-service",
       std::make_shared<PageServiceProcessor>(
           std::make_shared<PageHandler>(
-              &movie_review_client_pool,
-              &movie_info_client_pool,
-              &cast_info_client_pool,
-              &plot_client_pool)),
-      std::make_shared<TServerSocket>("0.0.0.0", port),
-      std::make_shared<TFramedTransportFactory>(),
-      std::make_shared<TBinaryProtocolFactory>()
-  );
+              &movie_review_client,
+              &movie_info_client,
+              &cast_info_client,
+              &plot_client)));
   std::cout << "Starting the page-service server ..." << std::endl;
-  server.serve();
+  server->serve();
 }
\ No newline at end of file
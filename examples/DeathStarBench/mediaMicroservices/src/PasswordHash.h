@@ -0,0 +1,547 @@
+#ifndef MEDIA_MICROSERVICES_PASSWORDHASH_H
+#define MEDIA_MICROSERVICES_PASSWORDHASH_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <openssl/crypto.h>
+#include <openssl/sha.h>
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+#include "../third_party/PicoSHA2/picosha2.h"
+
+#define PASSWORD_DIGEST_SIZE 32
+// The multi-buffer backend hashes password + salt in a single SHA-256
+// block, so both must fit in 55 bytes; longer ones are hashed by OpenSSL.
+#define PASSWORD_HASH_MAX_BATCHED 55
+#define PASSWORD_HASH_BATCH_LANES 8
+// Batches a combining thread hashes for others before it hands over.
+#define PASSWORD_HASH_MAX_ROUNDS 4
+
+namespace media_service
+{
+
+  /*
+   * Backends of PasswordHasher, all computing SHA-256(password + salt):
+   *
+   *   openssl   SHA256_Update() on the two parts, no concatenation. OpenSSL
+   *             picks the SHA-NI code at run time where the CPU has it.
+   *   avx2      8-lane AVX2 multi-buffer SHA-256: concurrent verifications
+   *             are combined and hashed side by side. Only pays off on CPUs
+   *             without SHA-NI.
+   *   picosha2  the portable implementation the service used before.
+   */
+  enum class PasswordHashBackend
+  {
+    openssl,
+    avx2,
+    picosha2
+  };
+
+  struct PasswordDigest
+  {
+    uint8_t bytes[PASSWORD_DIGEST_SIZE];
+  };
+
+  inline bool _CpuHasShaExtensions()
+  {
+#if defined(__x86_64__)
+    if (__get_cpuid_max(0, nullptr) < 7)
+    {
+      return false;
+    }
+    unsigned int eax, ebx, ecx, edx;
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    return ebx & (1u << 29);
+#else
+    return false;
+#endif
+  }
+
+  inline bool _CpuHasAvx2()
+  {
+#if defined(__x86_64__)
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+  }
+
+  inline void _Sha256OpenSsl(const char *password, size_t password_len,
+                             const char *salt, size_t salt_len,
+                             PasswordDigest *digest)
+  {
+    // The SHA256_* calls are deprecated in OpenSSL 3 in favour of EVP, which
+    // costs a provider lookup per digest; they are kept for 1.0 and 1.1.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+    SHA256_CTX ctx;
+    SHA256_Init(&ctx);
+    SHA256_Update(&ctx, password, password_len);
+    SHA256_Update(&ctx, salt, salt_len);
+    SHA256_Final(digest->bytes, &ctx);
+#pragma GCC diagnostic pop
+  }
+
+  inline void _Sha256Picosha2(const char *password, size_t password_len,
+                              const char *salt, size_t salt_len,
+                              PasswordDigest *digest)
+  {
+    std::string message(password, password_len);
+    message.append(salt, salt_len);
+    picosha2::hash256(message.begin(), message.end(), digest->bytes,
+                      digest->bytes + PASSWORD_DIGEST_SIZE);
+  }
+
+#if defined(__x86_64__)
+  static const uint32_t _SHA256_K[64] = {
+      0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+      0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+      0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+      0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+      0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+      0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+      0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+      0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+      0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+      0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+      0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+  static const uint32_t _SHA256_H0[8] = {
+      0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+      0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+  __attribute__((target("avx2"))) inline __m256i _Rotr8x(__m256i x, int n)
+  {
+    return _mm256_or_si256(_mm256_srli_epi32(x, n),
+                           _mm256_slli_epi32(x, 32 - n));
+  }
+
+  /*
+   * SHA-256 of up to eight messages of at most PASSWORD_HASH_MAX_BATCHED
+   * bytes each, one per 32-bit lane of the AVX2 registers. Each message is
+   * the concatenation of two parts, like password and salt.
+   */
+  __attribute__((target("avx2"))) inline void _Sha256x8Avx2(
+      int n, const char *const first[], const size_t first_len[],
+      const char *const second[], const size_t second_len[],
+      PasswordDigest *const digests[])
+  {
+    // Pad every message into one block and load it as big-endian words.
+    alignas(32) uint32_t words[16][PASSWORD_HASH_BATCH_LANES];
+    memset(words, 0, sizeof(words));
+    for (int lane = 0; lane < n; lane++)
+    {
+      uint8_t block[64] = {0};
+      size_t len = first_len[lane] + second_len[lane];
+      memcpy(block, first[lane], first_len[lane]);
+      memcpy(block + first_len[lane], second[lane], second_len[lane]);
+      block[len] = 0x80;
+      uint64_t bits = static_cast<uint64_t>(len) * 8;
+      for (int i = 0; i < 8; i++)
+      {
+        block[63 - i] = static_cast<uint8_t>(bits >> (8 * i));
+      }
+      for (int i = 0; i < 16; i++)
+      {
+        words[i][lane] = static_cast<uint32_t>(block[4 * i]) << 24 |
+                         static_cast<uint32_t>(block[4 * i + 1]) << 16 |
+                         static_cast<uint32_t>(block[4 * i + 2]) << 8 |
+                         static_cast<uint32_t>(block[4 * i + 3]);
+      }
+    }
+
+    __m256i w[16];
+    for (int i = 0; i < 16; i++)
+    {
+      w[i] = _mm256_load_si256(reinterpret_cast<const __m256i *>(words[i]));
+    }
+    __m256i a = _mm256_set1_epi32(_SHA256_H0[0]);
+    __m256i b = _mm256_set1_epi32(_SHA256_H0[1]);
+    __m256i c = _mm256_set1_epi32(_SHA256_H0[2]);
+    __m256i d = _mm256_set1_epi32(_SHA256_H0[3]);
+    __m256i e = _mm256_set1_epi32(_SHA256_H0[4]);
+    __m256i f = _mm256_set1_epi32(_SHA256_H0[5]);
+    __m256i g = _mm256_set1_epi32(_SHA256_H0[6]);
+    __m256i h = _mm256_set1_epi32(_SHA256_H0[7]);
+
+    for (int t = 0; t < 64; t++)
+    {
+      __m256i wt;
+      if (t < 16)
+      {
+        wt = w[t];
+      }
+      else
+      {
+        // The message schedule, kept as a ring of the last 16 words.
+        __m256i w2 = w[(t - 2) & 15];
+        __m256i w15 = w[(t - 15) & 15];
+        __m256i s0 = _mm256_xor_si256(
+            _mm256_xor_si256(_Rotr8x(w15, 7), _Rotr8x(w15, 18)),
+            _mm256_srli_epi32(w15, 3));
+        __m256i s1 = _mm256_xor_si256(
+            _mm256_xor_si256(_Rotr8x(w2, 17), _Rotr8x(w2, 19)),
+            _mm256_srli_epi32(w2, 10));
+        wt = _mm256_add_epi32(
+            _mm256_add_epi32(w[t & 15], s0),
+            _mm256_add_epi32(w[(t - 7) & 15], s1));
+        w[t & 15] = wt;
+      }
+      __m256i sigma1 = _mm256_xor_si256(
+          _mm256_xor_si256(_Rotr8x(e, 6), _Rotr8x(e, 11)), _Rotr8x(e, 25));
+      __m256i ch = _mm256_xor_si256(_mm256_and_si256(e, f),
+                                    _mm256_andnot_si256(e, g));
+      __m256i t1 = _mm256_add_epi32(
+          _mm256_add_epi32(_mm256_add_epi32(h, sigma1), ch),
+          _mm256_add_epi32(_mm256_set1_epi32(_SHA256_K[t]), wt));
+      __m256i sigma0 = _mm256_xor_si256(
+          _mm256_xor_si256(_Rotr8x(a, 2), _Rotr8x(a, 13)), _Rotr8x(a, 22));
+      __m256i maj = _mm256_xor_si256(
+          _mm256_xor_si256(_mm256_and_si256(a, b), _mm256_and_si256(a, c)),
+          _mm256_and_si256(b, c));
+      __m256i t2 = _mm256_add_epi32(sigma0, maj);
+      h = g;
+      g = f;
+      f = e;
+      e = _mm256_add_epi32(d, t1);
+      d = c;
+      c = b;
+      b = a;
+      a = _mm256_add_epi32(t1, t2);
+    }
+
+    __m256i state[8] = {a, b, c, d, e, f, g, h};
+    alignas(32) uint32_t out[8][PASSWORD_HASH_BATCH_LANES];
+    for (int i = 0; i < 8; i++)
+    {
+      _mm256_store_si256(
+          reinterpret_cast<__m256i *>(out[i]),
+          _mm256_add_epi32(state[i], _mm256_set1_epi32(_SHA256_H0[i])));
+    }
+    for (int lane = 0; lane < n; lane++)
+    {
+      for (int i = 0; i < 8; i++)
+      {
+        uint32_t word = out[i][lane];
+        digests[lane]->bytes[4 * i] = static_cast<uint8_t>(word >> 24);
+        digests[lane]->bytes[4 * i + 1] = static_cast<uint8_t>(word >> 16);
+        digests[lane]->bytes[4 * i + 2] = static_cast<uint8_t>(word >> 8);
+        digests[lane]->bytes[4 * i + 3] = static_cast<uint8_t>(word);
+      }
+    }
+  }
+#endif
+
+  inline std::string PasswordDigestHex(const PasswordDigest &digest)
+  {
+    static const char hex[] = "0123456789abcdef";
+    std::string out(2 * PASSWORD_DIGEST_SIZE, '0');
+    for (int i = 0; i < PASSWORD_DIGEST_SIZE; i++)
+    {
+      out[2 * i] = hex[digest.bytes[i] >> 4];
+      out[2 * i + 1] = hex[digest.bytes[i] & 0xf];
+    }
+    return out;
+  }
+
+  // Parses the 64 hex digits stored for a user; false if malformed.
+  inline bool ParsePasswordDigestHex(const char *hex, size_t len,
+                                     PasswordDigest *digest)
+  {
+    if (len != 2 * PASSWORD_DIGEST_SIZE)
+    {
+      return false;
+    }
+    for (int i = 0; i < 2 * PASSWORD_DIGEST_SIZE; i++)
+    {
+      char ch = hex[i];
+      int nibble;
+      if (ch >= '0' && ch <= '9')
+      {
+        nibble = ch - '0';
+      }
+      else if (ch >= 'a' && ch <= 'f')
+      {
+        nibble = ch - 'a' + 10;
+      }
+      else if (ch >= 'A' && ch <= 'F')
+      {
+        nibble = ch - 'A' + 10;
+      }
+      else
+      {
+        return false;
+      }
+      if (i & 1)
+      {
+        digest->bytes[i / 2] |= static_cast<uint8_t>(nibble);
+      }
+      else
+      {
+        digest->bytes[i / 2] = static_cast<uint8_t>(nibble << 4);
+      }
+    }
+    return true;
+  }
+
+  /*
+   * Hashes and verifies passwords as SHA-256(password + salt), the format
+   * stored by UserService, with a backend chosen once at startup.
+   * Verify() compares binary digests in constant time and never formats
+   * hex.
+   *
+   * With the avx2 backend concurrent calls are combined: a caller queues
+   * its message and, if no other thread is hashing, becomes the combiner
+   * and hashes up to PASSWORD_HASH_BATCH_LANES queued messages at once
+   * until the queue is empty. Callers arriving meanwhile spin until their
+   * digest is ready, which takes well under a microsecond. A combiner
+   * hands over to the oldest queued caller after PASSWORD_HASH_MAX_ROUNDS
+   * batches, so it does not hash for others indefinitely. A lone caller is
+   * hashed by OpenSSL, as a batch of one would waste seven lanes.
+   */
+  class PasswordHasher
+  {
+  public:
+    static PasswordHasher &Global()
+    {
+      static PasswordHasher hasher;
+      return hasher;
+    }
+
+    // openssl where the CPU has SHA-NI or lacks AVX2, avx2 otherwise.
+    static PasswordHashBackend Detect()
+    {
+      if (!_CpuHasShaExtensions() && _CpuHasAvx2())
+      {
+        return PasswordHashBackend::avx2;
+      }
+      return PasswordHashBackend::openssl;
+    }
+
+    // name is "auto", "openssl", "avx2" or "picosha2". Returns false if the
+    // name is unknown or the CPU lacks AVX2.
+    bool SetBackend(const std::string &name);
+    PasswordHashBackend Backend() const { return _backend; }
+    const char *BackendName() const;
+
+    void Hash(const std::string &password, const char *salt, size_t salt_len,
+              PasswordDigest *digest);
+
+    // The hex digest to store for a new user.
+    std::string HashHex(const std::string &password, const std::string &salt)
+    {
+      PasswordDigest digest;
+      Hash(password, salt.data(), salt.size(), &digest);
+      return PasswordDigestHex(digest);
+    }
+
+    bool Verify(const std::string &password, const char *salt,
+                size_t salt_len, const PasswordDigest &stored)
+    {
+      PasswordDigest digest;
+      Hash(password, salt, salt_len, &digest);
+      return CRYPTO_memcmp(digest.bytes, stored.bytes,
+                           PASSWORD_DIGEST_SIZE) == 0;
+    }
+
+    bool Verify(const std::string &password, const char *salt,
+                size_t salt_len, const char *stored_hex, size_t stored_len)
+    {
+      PasswordDigest stored;
+      return ParsePasswordDigestHex(stored_hex, stored_len, &stored) &&
+             Verify(password, salt, salt_len, stored);
+    }
+
+  private:
+    struct Job
+    {
+      const char *password;
+      size_t password_len;
+      const char *salt;
+      size_t salt_len;
+      PasswordDigest *digest;
+      std::atomic<bool> done{false};
+      std::atomic<bool> lead{false};
+    };
+
+    PasswordHasher() : _backend(Detect()) {}
+
+    void _HashCombined(Job *job);
+    void _Combine(std::unique_lock<std::mutex> *lock);
+
+    PasswordHashBackend _backend;
+    std::mutex _mtx;
+    std::deque<Job *> _queue;
+    bool _combining = false;
+  };
+
+  inline bool PasswordHasher::SetBackend(const std::string &name)
+  {
+    if (name == "auto")
+    {
+      _backend = Detect();
+    }
+    else if (name == "openssl")
+    {
+      _backend = PasswordHashBackend::openssl;
+    }
+    else if (name == "avx2" && _CpuHasAvx2())
+    {
+      _backend = PasswordHashBackend::avx2;
+    }
+    else if (name == "picosha2")
+    {
+      _backend = PasswordHashBackend::picosha2;
+    }
+    else
+    {
+      return false;
+    }
+    return true;
+  }
+
+  inline const char *PasswordHasher::BackendName() const
+  {
+    switch (_backend)
+    {
+    case PasswordHashBackend::openssl:
+      return "openssl";
+    case PasswordHashBackend::avx2:
+      return "avx2";
+    case PasswordHashBackend::picosha2:
+      return "picosha2";
+    }
+    return "unknown";
+  }
+
+  inline void PasswordHasher::Hash(const std::string &password,
+                                   const char *salt, size_t salt_len,
+                                   PasswordDigest *digest)
+  {
+    switch (_backend)
+    {
+    case PasswordHashBackend::avx2:
+      if (password.size() + salt_len <= PASSWORD_HASH_MAX_BATCHED)
+      {
+        Job job;
+        job.password = password.data();
+        job.password_len = password.size();
+        job.salt = salt;
+        job.salt_len = salt_len;
+        job.digest = digest;
+        _HashCombined(&job);
+        return;
+      }
+      break;
+    case PasswordHashBackend::picosha2:
+      _Sha256Picosha2(password.data(), password.size(), salt, salt_len,
+                      digest);
+      return;
+    case PasswordHashBackend::openssl:
+      break;
+    }
+    _Sha256OpenSsl(password.data(), password.size(), salt, salt_len, digest);
+  }
+
+  inline void PasswordHasher::_HashCombined(Job *job)
+  {
+    std::unique_lock<std::mutex> lock(_mtx);
+    _queue.push_back(job);
+    if (!_combining)
+    {
+      _combining = true;
+      _Combine(&lock);
+      return;
+    }
+    lock.unlock();
+    for (int spins = 0; !job->done.load(std::memory_order_acquire); spins++)
+    {
+      if (job->lead.load(std::memory_order_acquire))
+      {
+        lock.lock();
+        _Combine(&lock);
+        return;
+      }
+      if (spins < 1000)
+      {
+#if defined(__x86_64__)
+        _mm_pause();
+#endif
+      }
+      else
+      {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  // Called with the lock held and _combining set; the job of the caller is
+  // at the front of the queue.
+  inline void PasswordHasher::_Combine(std::unique_lock<std::mutex> *lock)
+  {
+    for (int round = 0; !_queue.empty() && round < PASSWORD_HASH_MAX_ROUNDS;
+         round++)
+    {
+      Job *batch[PASSWORD_HASH_BATCH_LANES];
+      int n = 0;
+      while (n < PASSWORD_HASH_BATCH_LANES && !_queue.empty())
+      {
+        batch[n++] = _queue.front();
+        _queue.pop_front();
+      }
+      lock->unlock();
+      if (n == 1)
+      {
+        _Sha256OpenSsl(batch[0]->password, batch[0]->password_len,
+                       batch[0]->salt, batch[0]->salt_len, batch[0]->digest);
+      }
+      else
+      {
+#if defined(__x86_64__)
+        const char *passwords[PASSWORD_HASH_BATCH_LANES];
+        size_t password_lens[PASSWORD_HASH_BATCH_LANES];
+        const char *salts[PASSWORD_HASH_BATCH_LANES];
+        size_t salt_lens[PASSWORD_HASH_BATCH_LANES];
+        PasswordDigest *digests[PASSWORD_HASH_BATCH_LANES];
+        for (int i = 0; i < n; i++)
+        {
+          passwords[i] = batch[i]->password;
+          password_lens[i] = batch[i]->password_len;
+          salts[i] = batch[i]->salt;
+          salt_lens[i] = batch[i]->salt_len;
+          digests[i] = batch[i]->digest;
+        }
+        _Sha256x8Avx2(n, passwords, password_lens, salts, salt_lens, digests);
+#endif
+      }
+      // A job may go out of scope as soon as it is done.
+      for (int i = 0; i < n; i++)
+      {
+        batch[i]->done.store(true, std::memory_order_release);
+      }
+      lock->lock();
+    }
+    if (_queue.empty())
+    {
+      _combining = false;
+    }
+    else
+    {
+      _queue.front()->lead.store(true, std::memory_order_release);
+    }
+  }
+
+} // namespace media_service
+
+#endif // MEDIA_MICROSERVICES_PASSWORDHASH_H
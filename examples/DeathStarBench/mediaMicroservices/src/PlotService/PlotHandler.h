@@ -10,8 +10,10 @@
 #include <bson/bson.h>
 
 #include "../../gen-cpp/PlotService.h"
+#include "../MemcachedPool.h"
 #include "../logger.h"
 #include "../tracing.h"
+#include "../probes.h"
 
 namespace media_service {
 
@@ -22,6 +24,8 @@ class PlotHandler : public PlotServiceIf {
       mongoc_client_pool_t *);
   ~PlotHandler() override = default;
 
+  void Ping() override {}
+
   void WritePlot(int64_t req_id, int64_t plot_id, const std::string& plot,
       const std::map<std::string, std::string> & carrier) override;
   void ReadPlot(std::string& _return, int64_t req_id, int64_t plot_id,
@@ -46,31 +50,25 @@ void PlotHandler::ReadPlot(
     const std::map<std::string, std::string> & carrier) {
 
   // Initialize a span
-  TextMapReader reader(carrier);
-  std::map<std::string, std::string> writer_text_map;
-  TextMapWriter writer(writer_text_map);
-  auto parent_span = opentracing::Tracer::Global()->Extract(reader);
-  auto span = opentracing::Tracer::Global()->StartSpan(
-      "ReadPlot",
-      { opentracing::ChildOf(parent_span->get()) });
-  opentracing::Tracer::Global()->Inject(span->context(), writer);
+  auto span = TraceSpan::Start("ReadPlot", carrier);
+  RequestProbe probe(req_id, "ReadPlot", span.GetTraceId());
 
   memcached_return_t memcached_rc;
-  memcached_st *memcached_client = memcached_pool_pop(
+  memcached_st *memcached_client = MemcachedPoolPop(
       _memcached_client_pool, true, &memcached_rc);
   if (!memcached_client) {
     ServiceException se;
     se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
     se.message = "Failed to pop a client from memcached pool";
-    throw se;
+    throw RequestError(se);
   }
 
   size_t plot_size;
   uint32_t memcached_flags;
 
   // Look for the movie id from memcached
-  auto get_span = opentracing::Tracer::Global()->StartSpan(
-      "MmcGetPlot", { opentracing::ChildOf(&span->context()) });
+  auto get_span = span.Child("MmcGetPlot");
+  CallProbe get_probe(ProbeBackend::memcached, req_id, "MmcGetPlot");
   auto plot_id_str = std::to_string(plot_id);
 
   char* plot_mmc = memcached_get(
@@ -84,11 +82,13 @@ void PlotHandler::ReadPlot(
     ServiceException se;
     se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
     se.message = memcached_strerror(memcached_client, memcached_rc);
-    memcached_pool_push(_memcached_client_pool, memcached_client);
-    throw se;
+    MemcachedPoolPush(_memcached_client_pool, memcached_client);
+    throw RequestError(se);
   }
-  get_span->Finish();
-  memcached_pool_push(_memcached_client_pool, memcached_client);
+  get_span.Finish();
+  get_probe.AddBytes(plot_id_str.length(), plot_mmc ? plot_size : 0);
+  get_probe.End(plot_mmc != nullptr);
+  MemcachedPoolPush(_memcached_client_pool, memcached_client);
 
   // If cached in memcached
   if (plot_mmc) {
@@ -105,7 +105,7 @@ void PlotHandler::ReadPlot(
       se.errorCode = ErrorCode::SE_MONGODB_ERROR;
       se.message = "Failed to pop a client from MongoDB pool";
       free(plot_mmc);
-      throw se;
+      throw RequestError(se);
     }
     auto collection = mongoc_client_get_collection(
         mongodb_client, "plot", "plot");
@@ -115,19 +115,20 @@ void PlotHandler::ReadPlot(
       se.message = "Failed to create collection plot from DB plot";
       free(plot_mmc);
       mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
-      throw se;
+      throw RequestError(se);
     }
 
     bson_t *query = bson_new();
     BSON_APPEND_INT64(query, "plot_id", plot_id);
 
-    auto find_span = opentracing::Tracer::Global()->StartSpan(
-        "MongoFindPlot", { opentracing::ChildOf(&span->context()) });
+    auto find_span = span.Child("MongoFindPlot");
+    CallProbe find_probe(ProbeBackend::mongo, req_id, "MongoFindPlot");
     mongoc_cursor_t *cursor = mongoc_collection_find_with_opts(
         collection, query, nullptr, nullptr);
     const bson_t *doc;
     bool found = mongoc_cursor_next(cursor, &doc);
-    find_span->Finish();
+    find_span.Finish();
+    find_probe.End(found);
 
     if (found) {
       bson_iter_t iter;
@@ -140,12 +141,12 @@ void PlotHandler::ReadPlot(
         mongoc_cursor_destroy(cursor);
         mongoc_collection_destroy(collection);
         mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
-        memcached_client = memcached_pool_pop(
+        memcached_client = MemcachedPoolPop(
             _memcached_client_pool, true, &memcached_rc);
 
         // Upload the plot to memcached
-        auto set_span = opentracing::Tracer::Global()->StartSpan(
-            "MmcSetPlot", { opentracing::ChildOf(&span->context()) });
+        auto set_span = span.Child("MmcSetPlot");
+        CallProbe set_probe(ProbeBackend::memcached, req_id, "MmcSetPlot");
         memcached_rc = memcached_set(
             memcached_client,
             plot_id_str.c_str(),
@@ -155,13 +156,15 @@ void PlotHandler::ReadPlot(
             static_cast<time_t>(0),
             static_cast<uint32_t>(0)
         );
-        set_span->Finish();
+        set_span.Finish();
+        set_probe.AddBytes(plot_id_str.length() + _return.length(), 0);
+        set_probe.End();
 
         if (memcached_rc != MEMCACHED_SUCCESS) {
           LOG(warning) << "Failed to set plot to Memcached: "
               << memcached_strerror(memcached_client, memcached_rc);
         }
-        memcached_pool_push(_memcached_client_pool, memcached_client);
+        MemcachedPoolPush(_memcached_client_pool, memcached_client);
       } else {
         LOG(error) << "Attribute plot is not find in MongoDB";
         bson_destroy(query);
@@ -172,7 +175,7 @@ void PlotHandler::ReadPlot(
         se.errorCode = ErrorCode::SE_THRIFT_HANDLER_ERROR;
         se.message = "Attribute plot is not find in MongoDB";
         free(plot_mmc);
-        throw se;
+        throw RequestError(se);
       }
     } else {
       LOG(error) << "Plot_id " << plot_id << " is not found in MongoDB";
@@ -184,10 +187,10 @@ void PlotHandler::ReadPlot(
       se.errorCode = ErrorCode::SE_THRIFT_HANDLER_ERROR;
       se.message = "Plot_id " + plot_id_str + " is not found in MongoDB";
       free(plot_mmc);
-      throw se;
+      throw RequestError(se);
     }
   }
-  span->Finish();
+  span.Finish();
 }
 
 void PlotHandler::WritePlot(
@@ -196,14 +199,8 @@ void PlotHandler::WritePlot(
     const std::string &plot,
     const std::map<std::string, std::string> &carrier) {
   // Initialize a span
-  TextMapReader reader(carrier);
-  std::map<std::string, std::string> writer_text_map;
-  TextMapWriter writer(writer_text_map);
-  auto parent_span = opentracing::Tracer::Global()->Extract(reader);
-  auto span = opentracing::Tracer::Global()->StartSpan(
-      "WritePlot",
-      { opentracing::ChildOf(parent_span->get()) });
-  opentracing::Tracer::Global()->Inject(span->context(), writer);
+  auto span = TraceSpan::Start("WritePlot", carrier);
+  RequestProbe probe(req_id, "WritePlot", span.GetTraceId());
 
   bson_t *new_doc = bson_new();
   BSON_APPEND_INT64(new_doc, "plot_id", plot_id);
@@ -215,7 +212,7 @@ void PlotHandler::WritePlot(
     ServiceException se;
     se.errorCode = ErrorCode::SE_MONGODB_ERROR;
     se.message = "Failed to pop a client from MongoDB pool";
-    throw se;
+    throw RequestError(se);
   }
   auto collection = mongoc_client_get_collection(
       mongodb_client, "plot", "plot");
@@ -224,14 +221,15 @@ void PlotHandler::WritePlot(
     se.errorCode = ErrorCode::SE_MONGODB_ERROR;
     se.message = "Failed to create collection plot from DB plot";
     mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
-    throw se;
+    throw RequestError(se);
   }
   bson_error_t error;
-  auto insert_span = opentracing::Tracer::Global()->StartSpan(
-      "MongoInsertPlot", { opentracing::ChildOf(&span->context()) });
+  auto insert_span = span.Child("MongoInsertPlot");
+  CallProbe insert_probe(ProbeBackend::mongo, req_id, "MongoInsertPlot");
   bool plotinsert = mongoc_collection_insert_one (
       collection, new_doc, nullptr, nullptr, &error);
-  insert_span->Finish();
+  insert_span.Finish();
+  insert_probe.End();
   if (!plotinsert) {
     LOG(error) << "Error: Failed to insert plot to MongoDB: "
                << error.message;
@@ -241,14 +239,14 @@ void PlotHandler::WritePlot(
     bson_destroy(new_doc);
     mongoc_collection_destroy(collection);
     mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
-    throw se;
+    throw RequestError(se);
   }
 
   bson_destroy(new_doc);
   mongoc_collection_destroy(collection);
   mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
 
-  span->Finish();
+  span.Finish();
 }
 
 } // namespace media_service
@@ -1,19 +1,12 @@
-#include <thrift/protocol/TBinaryProtocol.h>
-#include <thrift/server/TThreadedServer.h>
-#include <thrift/transport/TServerSocket.h>
-#include <thrift/transport/TBufferTransports.h>
 #include <signal.h>
 
 #include "PlotHandler.h"
 #include "../utils.h"
+#include "../utils_thrift.h"
 #include "../utils_memcached.h"
 #include "../utils_mongodb.h"
 
 using json = nlohmann::json;
-using apache::thrift::server::TThreadedServer;
-using apache::thrift::transport::TServerSocket;
-using apache::thrift::transport::TFramedTransportFactory;
-using apache::thrift::protocol::TBinaryProtocolFactory;
 using namespace media_service;
 
 void sigintHandler(int sig) {
@@ -31,7 +24,6 @@ int main(int argc, char *argv[]) {
     exit(EXIT_FAILURE);
   }
 
-  int port = config_json["plot-service"]["port"];
 
   memcached_pool_st *memcached_client_pool =
       init_memcached_client_pool(config_json, "plot", 32, 128);
@@ -57,16 +49,14 @@ int main(int argc, char *argv[]) {
   }
   mongoc_client_pool_push(mongodb_client_pool, mongodb_client);
 
-  TThreadedServer server(
+  start_observability(config_json, "plot-service");
+  auto server = init_thrift_server(
+      config_json, "plot-service",
       std::make_shared<PlotServiceProcessor>(
       std::make_shared<PlotHandler>(
-              memcached_client_pool, mongodb_client_pool)),
-      std::make_shared<TServerSocket>("0.0.0.0", port),
-      std::make_shared<TFramedTransportFactory>(),
-      std::make_shared<TBinaryProtocolFactory>()
-  );
+              memcached_client_pool, mongodb_client_pool)));
   std::cout << "Starting the plot-service server ..." << std::endl;
-  server.serve();
+  server->serve();
 }
 
 
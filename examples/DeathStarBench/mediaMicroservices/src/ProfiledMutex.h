@@ -0,0 +1,111 @@
+#ifndef MEDIA_MICROSERVICES_PROFILEDMUTEX_H
+#define MEDIA_MICROSERVICES_PROFILEDMUTEX_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#include "Metrics.h"
+#include "RequestBreakdown.h"
+
+namespace media_service
+{
+
+  /*
+   * Contention metrics of a named lock, shared by every lock of that name,
+   * e.g. all shards of one LruCache, so they are recorded concurrently:
+   *
+   *   media_lock_wait_seconds{lock}       time to acquire it, 0 if it was
+   *                                       free; its _count is the number of
+   *                                       acquisitions
+   *   media_lock_hold_seconds{lock}       time it was held
+   *   media_lock_contentions_total{lock}  acquisitions that found it taken
+   */
+  struct LockProfile
+  {
+    HdrHistogram *wait;
+    HdrHistogram *hold;
+    Counter *contentions;
+  };
+
+  inline LockProfile GetLockProfile(const std::string &name)
+  {
+    // Calibrates the cycle counter now rather than under the first lock.
+    CyclesPerMicrosecond();
+    auto labels = MetricLabels({{"lock", name}});
+    auto &metrics = Metrics::Global();
+    LockProfile profile;
+    profile.wait = metrics.GetHistogram(
+        "media_lock_wait_seconds",
+        "Time a thread waited to acquire a lock, 0 if it was free.", labels);
+    profile.hold = metrics.GetHistogram(
+        "media_lock_hold_seconds", "Time a lock was held.", labels);
+    profile.contentions = metrics.GetCounter(
+        "media_lock_contentions_total",
+        "Acquisitions of a lock that found it taken.", labels);
+    return profile;
+  }
+
+  /*
+   * A std::mutex that records its waits and hold times in the LockProfile
+   * of its name. An acquisition tries the lock first and only reads the
+   * cycle counter before blocking if that fails, so a free lock costs one
+   * extra rdtsc to start the hold time. Other mutexes of the same name
+   * record into the same LockProfile at the same time, which is safe
+   * because HdrHistogram and Counter only use atomic adds; the hold time is
+   * recorded after unlocking so that it does not lengthen the hold. Use
+   * std::condition_variable_any to wait on it; the time spent waiting on
+   * the condition does not count as held.
+   */
+  class ProfiledMutex
+  {
+  public:
+    explicit ProfiledMutex(const std::string &name)
+        : _profile(GetLockProfile(name)) {}
+
+    ProfiledMutex(const ProfiledMutex &) = delete;
+    ProfiledMutex &operator=(const ProfiledMutex &) = delete;
+
+    void lock()
+    {
+      if (_mtx.try_lock())
+      {
+        _locked_cycles = ReadCycles();
+        _profile.wait->Record(0);
+        return;
+      }
+      uint64_t start = ReadCycles();
+      _mtx.lock();
+      _locked_cycles = ReadCycles();
+      _profile.contentions->Add();
+      _profile.wait->Record(CyclesToMicroseconds(_locked_cycles - start));
+    }
+
+    bool try_lock()
+    {
+      if (!_mtx.try_lock())
+      {
+        return false;
+      }
+      _locked_cycles = ReadCycles();
+      _profile.wait->Record(0);
+      return true;
+    }
+
+    void unlock()
+    {
+      uint64_t held = ReadCycles() - _locked_cycles;
+      _mtx.unlock();
+      _profile.hold->Record(CyclesToMicroseconds(held));
+    }
+
+  private:
+    std::mutex _mtx;
+    LockProfile _profile;
+    // Written by the holder only.
+    uint64_t _locked_cycles = 0;
+  };
+
+} // namespace media_service
+
+#endif // MEDIA_MICROSERVICES_PROFILEDMUTEX_H
@@ -7,11 +7,14 @@
 
 #include "../../gen-cpp/RatingService.h"
 #include "../../gen-cpp/ComposeReviewService.h"
+#include "../AffinityClientPool.h"
 #include "../ClientPool.h"
 #include "../ThriftClient.h"
 #include "../RedisClient.h"
+#include "../Executor.h"
 #include "../logger.h"
 #include "../tracing.h"
+#include "../probes.h"
 
 namespace media_service
 {
@@ -19,19 +22,21 @@ namespace media_service
   {
   public:
     RatingHandler(
-        ClientPool<ThriftClient<ComposeReviewServiceClient>> *,
+        AffinityClientPool<ThriftClient<ComposeReviewServiceClient>> *,
         ClientPool<RedisClient> *);
     ~RatingHandler() override = default;
+
+    void Ping() override {}
     void UploadRating(int64_t, const std::string &, int32_t,
                       const std::map<std::string, std::string> &) override;
 
   private:
-    ClientPool<ThriftClient<ComposeReviewServiceClient>> *_compose_client_pool;
+    AffinityClientPool<ThriftClient<ComposeReviewServiceClient>> *_compose_client_pool;
     ClientPool<RedisClient> *_redis_client_pool;
   };
 
   RatingHandler::RatingHandler(
-      ClientPool<ThriftClient<ComposeReviewServiceClient>> *compose_client_pool,
+      AffinityClientPool<ThriftClient<ComposeReviewServiceClient>> *compose_client_pool,
       ClientPool<RedisClient> *redis_client_pool)
   {
     _compose_client_pool = compose_client_pool;
@@ -45,17 +50,12 @@ namespace media_service
   {
 
     // Initialize a span
-    TextMapReader reader(carrier);
-    std::map<std::string, std::string> writer_text_map;
-    TextMapWriter writer(writer_text_map);
-    auto parent_span = opentracing::Tracer::Global()->Extract(reader);
-    auto span = opentracing::Tracer::Global()->StartSpan(
-        "UploadRating",
-        {opentracing::ChildOf(parent_span->get())});
-    opentracing::Tracer::Global()->Inject(span->context(), writer);
-
-    std::future<void> upload_future;
-    std::future<void> redis_future;
+    auto span = TraceSpan::Start("UploadRating", carrier);
+    RequestProbe probe(req_id, "UploadRating", span.GetTraceId());
+    auto &writer_text_map = span.Carrier();
+
+    TaskFuture<void> upload_future;
+    TaskFuture<void> redis_future;
 
     // upload_future = std::async(std::launch::async, [&](){
     //   auto compose_client_wrapper = _compose_client_pool->Pop();
@@ -76,14 +76,14 @@ namespace media_service
     //   _compose_client_pool->Push(compose_client_wrapper);
     // });
 
-    upload_future = std::async(std::launch::async, [&]()
+    upload_future = Executor::Global().Submit([&]()
                                {
-    auto compose_client_wrapper = _compose_client_pool->Pop();
+    auto compose_client_wrapper = _compose_client_pool->Pop(req_id);
     if (!compose_client_wrapper) {
         ServiceException se;
         se.errorCode = ErrorCode::SE_THRIFT_CONN_ERROR;
         se.message = "Failed to connect to compose-review-service";
-        throw se;
+        throw RequestError(se);
     }
     auto compose_client = compose_client_wrapper->GetClient();
     bool success = false;
@@ -100,51 +100,52 @@ namespace media_service
             // Handle specific "Broken pipe" scenario or any transport exception
             if (retry_count > 0) {
                 // Remove the problematic client from the pool and try to get a new one
-                _compose_client_pool->Remove(compose_client_wrapper);
-                compose_client_wrapper = _compose_client_pool->Pop();
+                _compose_client_pool->Remove(req_id, compose_client_wrapper);
+                compose_client_wrapper = _compose_client_pool->Pop(req_id);
                 if (!compose_client_wrapper) {
                     ServiceException se;
                     se.errorCode = ErrorCode::SE_THRIFT_CONN_ERROR;
                     se.message = "Failed to reconnect to compose-review-service";
-                    throw se;
+                    throw RequestError(se);
                 }
                 compose_client = compose_client_wrapper->GetClient();
             } else {
                 // If no retries left, push back the client and rethrow the exception
-                _compose_client_pool->Push(compose_client_wrapper);
+                _compose_client_pool->Push(req_id, compose_client_wrapper);
                 LOG(error) << "Failed to upload rating to compose-review-service after retries";
                 throw;
             }
         } catch (const std::exception &e) {
             // Catch other standard exceptions and log them
             LOG(error) << "Standard exception: " << e.what();
-            _compose_client_pool->Push(compose_client_wrapper);
+            _compose_client_pool->Push(req_id, compose_client_wrapper);
             throw;
         } catch (...) {
             // Catch any other exceptions and log them
             LOG(error) << "Unknown exception caught";
-            _compose_client_pool->Push(compose_client_wrapper);
+            _compose_client_pool->Push(req_id, compose_client_wrapper);
             throw;
         }
     }
-    _compose_client_pool->Push(compose_client_wrapper); });
+    _compose_client_pool->Push(req_id, compose_client_wrapper); });
 
-    redis_future = std::async(std::launch::async, [&]()
+    redis_future = Executor::Global().Submit([&]()
                               {
     auto redis_client_wrapper = _redis_client_pool->Pop();
     if (!redis_client_wrapper) {
       ServiceException se;
       se.errorCode = ErrorCode::SE_REDIS_ERROR;
       se.message = "Cannot connected to Redis server";
-      throw se;
+      throw RequestError(se);
     }
     auto redis_client = redis_client_wrapper->GetClient();
-    auto redis_span = opentracing::Tracer::Global()->StartSpan(
-        "RedisInsert", {opentracing::ChildOf(&span->context())});
+    auto redis_span = span.Child("RedisInsert");
+    CallProbe redis_probe(ProbeBackend::redis, req_id, "RedisInsert");
     redis_client->incrby(movie_id + ":uncommit_sum", rating);
     redis_client->incr(movie_id + ":uncommit_num");
     redis_client->sync_commit();
-    redis_span->Finish();
+    redis_span.Finish();
+    redis_probe.End();
     _redis_client_pool->Push(redis_client_wrapper); });
 
     try
@@ -166,7 +167,7 @@ namespace media_service
       LOG(error) << "Failed to update rating to rating-redis";
       throw;
     }
-    span->Finish();
+    span.Finish();
   }
 
 } // namespace media_service
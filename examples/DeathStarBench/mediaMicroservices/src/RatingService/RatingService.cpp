@@ -1,17 +1,9 @@
 #include <signal.h>
 
-#include <thrift/server/TThreadedServer.h>
-#include <thrift/protocol/TBinaryProtocol.h>
-#include <thrift/transport/TServerSocket.h>
-#include <thrift/transport/TBufferTransports.h>
-
 #include "../utils.h"
+#include "../utils_thrift.h"
 #include "RatingHandler.h"
 
-using apache::thrift::server::TThreadedServer;
-using apache::thrift::transport::TServerSocket;
-using apache::thrift::transport::TFramedTransportFactory;
-using apache::thrift::protocol::TBinaryProtocolFactory;
 using namespace media_service;
 
 void sigintHandler(int sig) {
@@ -29,29 +21,28 @@ int main(int argc, char *argv[]) {
     exit(EXIT_FAILURE);
   }
 
-  int port = config_json["rating-service"]["port"];
-  std::string compose_addr = config_json["compose-review-service"]["addr"];
-  int compose_port = config_json["compose-review-service"]["port"];
 
   std::string redis_addr = config_json["rating-redis"]["addr"];
   int redis_port = config_json["rating-redis"]["port"];
 
-  ClientPool<ThriftClient<ComposeReviewServiceClient>> compose_client_pool(
-      "compose-review-client", compose_addr, compose_port, 0, 128, 1000);
+  AffinityClientPool<ThriftClient<ComposeReviewServiceClient>>
+      compose_client_pool(
+          "compose-review-client",
+          get_service_replicas(config_json, "compose-review-service"),
+          0, 128, 1000);
 
   ClientPool<RedisClient> redis_client_pool("rating-redis",
       redis_addr, redis_port, 0, 128, 1000);
 
-  TThreadedServer server (
+  start_observability(config_json, "rating-service");
+  init_executor(config_json, "rating-service");
+  auto server = init_thrift_server(
+      config_json, "rating-service",
       std::make_shared<RatingServiceProcessor>(
           std::make_shared<RatingHandler>(
               &compose_client_pool, 
-              &redis_client_pool)),
-      std::make_shared<TServerSocket>("0.0.0.0", port),
-      std::make_shared<TFramedTransportFactory>(),
-      std::make_shared<TBinaryProtocolFactory>()
-  );
+              &redis_client_pool)));
 
   std::cout << "Starting the rating-service server..." << std::endl;
-  server.serve();
+  server->serve();
 }
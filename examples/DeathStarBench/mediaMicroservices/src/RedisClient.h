@@ -7,6 +7,8 @@
 #include "logger.h"
 #include "GenericClient.h"
 
+#define REDIS_PING_TIMEOUT_MS 1000
+
 namespace media_service {
 
 class RedisClient : public GenericClient {
@@ -26,6 +28,7 @@ class RedisClient : public GenericClient {
   void KeepAlive() override ;
   void KeepAlive(int timeout_ms) override ;
   bool IsConnected() override ;
+  bool Ping() override ;
 
  private:
   cpp_redis::client * _client;
@@ -55,6 +58,7 @@ void RedisClient::Connect() {
         throw status;
       }
     });
+    _connect_timestamp = _CurrentTimestamp();
   }
 }
 
@@ -69,11 +73,32 @@ bool RedisClient::IsConnected() {
 }
 
 void RedisClient::KeepAlive() {
-
+  if (!IsConnected()) {
+    Connect();
+  }
 }
 
 void RedisClient::KeepAlive(int timeout_ms) {
+  KeepAlive();
+}
 
+bool RedisClient::Ping() {
+  if (!IsConnected()) {
+    return false;
+  }
+  try {
+    auto reply_future = _client->ping();
+    _client->sync_commit(std::chrono::milliseconds(REDIS_PING_TIMEOUT_MS));
+    if (reply_future.wait_for(std::chrono::milliseconds(0)) !=
+        std::future_status::ready) {
+      LOG(error) << "Redis PING to " << _addr << ":" << _port << " timed out";
+      return false;
+    }
+    return !reply_future.get().is_error();
+  } catch (...) {
+    LOG(error) << "Redis PING to " << _addr << ":" << _port << " failed";
+    return false;
+  }
 }
 
 } // mediua_service
@@ -0,0 +1,447 @@
+#ifndef MEDIA_MICROSERVICES_REQUESTBREAKDOWN_H
+#define MEDIA_MICROSERVICES_REQUESTBREAKDOWN_H
+
+#include <signal.h>
+
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "RequestContext.h"
+#include "SignalAction.h"
+#include "logger.h"
+
+#define REQUEST_BREAKDOWN_CALIBRATION_MS 20
+// Timed waits kept per request for its timeline; the waits are all added up
+// regardless.
+#define REQUEST_BREAKDOWN_EVENTS 29
+#define REQUEST_EVENT_OP_LEN 16
+
+namespace media_service
+{
+
+  // Timestamp counter of the CPU, or nanoseconds of the steady clock where
+  // there is none. Assumes an invariant TSC, synchronized across cores, as
+  // on every x86 server of the last decade.
+  inline uint64_t ReadCycles()
+  {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#endif
+  }
+
+  // Measured against the steady clock on first use, which takes
+  // REQUEST_BREAKDOWN_CALIBRATION_MS; StartBreakdownReport() does it before
+  // the server starts.
+  inline double CyclesPerMicrosecond()
+  {
+    static const double cycles_per_us = []() {
+      auto start = std::chrono::steady_clock::now();
+      uint64_t start_cycles = ReadCycles();
+      std::this_thread::sleep_for(
+          std::chrono::milliseconds(REQUEST_BREAKDOWN_CALIBRATION_MS));
+      auto end = std::chrono::steady_clock::now();
+      uint64_t end_cycles = ReadCycles();
+      double us = std::chrono::duration<double, std::micro>(end - start)
+                      .count();
+      return static_cast<double>(end_cycles - start_cycles) / us;
+    }();
+    return cycles_per_us;
+  }
+
+  inline int64_t CyclesToMicroseconds(uint64_t cycles)
+  {
+    return static_cast<int64_t>(cycles / CyclesPerMicrosecond());
+  }
+
+  inline const char *RequestPhaseName(uint32_t phase)
+  {
+    static const char *names[REQUEST_PHASE_COUNT] = {
+        "idle", "handler", "pool_wait", "memcached",
+        "mongo", "redis", "thrift", "task_wait"};
+    return phase < REQUEST_PHASE_COUNT ? names[phase] : "unknown";
+  }
+
+  // One timed wait of a request.
+  struct RequestEvent
+  {
+    char op[REQUEST_EVENT_OP_LEN]; // NUL-padded, unterminated if it fills it
+    uint64_t start_cycles;
+    uint64_t end_cycles;
+    int32_t result; // as passed to CallProbe::End()
+    uint32_t phase;
+  };
+
+  /*
+   * Where the time of one request went. Every timed wait of the request
+   * adds its cycles to the phase it was in, on whatever thread it ran, so
+   * waits of Executor tasks running in parallel are all counted. own_blocked
+   * only has the waits of the thread that runs the handler: the wall time
+   * of the request minus that is the time the handler was on the CPU, or
+   * blocked somewhere untimed, e.g. on a mutex.
+   *
+   * Bytes are counted for the backend phases: exactly for Thrift and
+   * MongoDB, from keys and values for memcached, and not for Redis, whose
+   * client encodes and parses on its own threads.
+   *
+   * The first REQUEST_BREAKDOWN_EVENTS backend calls, pool waits and
+   * downstream calls are also kept one by one, as the timeline the
+   * FlightRecorder stores; num_events counts the dropped ones too.
+   *
+   * error_code is the ErrorCode of the last ServiceException the service
+   * threw for the request, set by RequestError(), or -1.
+   */
+  struct RequestBreakdown
+  {
+    RequestBreakdown()
+        : start_cycles(ReadCycles()), owner(&CurrentRequestContext())
+    {
+    }
+
+    RequestBreakdown(const RequestBreakdown &) = delete;
+    RequestBreakdown &operator=(const RequestBreakdown &) = delete;
+
+    uint64_t start_cycles;
+    const RequestContext *owner;
+    std::atomic<uint64_t> own_blocked_cycles{0};
+    std::atomic<uint64_t> blocked_cycles[REQUEST_PHASE_COUNT] = {};
+    std::atomic<uint64_t> bytes_sent[REQUEST_PHASE_COUNT] = {};
+    std::atomic<uint64_t> bytes_received[REQUEST_PHASE_COUNT] = {};
+    std::atomic<uint32_t> num_events{0};
+    std::atomic<int32_t> error_code{-1};
+    RequestEvent events[REQUEST_BREAKDOWN_EVENTS];
+  };
+
+  inline void RecordBlocked(uint32_t phase, uint64_t cycles)
+  {
+    RequestBreakdown *breakdown = CurrentRequestBreakdown();
+    if (!breakdown)
+    {
+      return;
+    }
+    breakdown->blocked_cycles[phase].fetch_add(cycles,
+                                               std::memory_order_relaxed);
+    if (breakdown->owner == &CurrentRequestContext())
+    {
+      breakdown->own_blocked_cycles.fetch_add(cycles,
+                                              std::memory_order_relaxed);
+    }
+  }
+
+  inline void RecordBackendBytes(uint32_t phase, uint64_t sent,
+                                 uint64_t received)
+  {
+    RequestBreakdown *breakdown = CurrentRequestBreakdown();
+    if (!breakdown)
+    {
+      return;
+    }
+    if (sent)
+    {
+      breakdown->bytes_sent[phase].fetch_add(sent, std::memory_order_relaxed);
+    }
+    if (received)
+    {
+      breakdown->bytes_received[phase].fetch_add(received,
+                                                 std::memory_order_relaxed);
+    }
+  }
+
+  // Notes the errorCode of a ServiceException about to be thrown for the
+  // current request, e.g. "throw RequestError(se);", so that the
+  // FlightRecorder keeps it. Works on Executor threads too.
+  template <class TException>
+  const TException &RequestError(const TException &se)
+  {
+    RequestBreakdown *breakdown = CurrentRequestBreakdown();
+    if (breakdown)
+    {
+      breakdown->error_code.store(static_cast<int32_t>(se.errorCode),
+                                  std::memory_order_relaxed);
+    }
+    return se;
+  }
+
+  inline void RecordEvent(uint32_t phase, const char *op, int64_t result,
+                          uint64_t start_cycles, uint64_t end_cycles)
+  {
+    RequestBreakdown *breakdown = CurrentRequestBreakdown();
+    if (!breakdown)
+    {
+      return;
+    }
+    uint32_t i = breakdown->num_events.fetch_add(1, std::memory_order_relaxed);
+    if (i >= REQUEST_BREAKDOWN_EVENTS)
+    {
+      return;
+    }
+    RequestEvent &event = breakdown->events[i];
+    strncpy(event.op, op, REQUEST_EVENT_OP_LEN);
+    event.start_cycles = start_cycles;
+    event.end_cycles = end_cycles;
+    event.result = static_cast<int32_t>(result);
+    event.phase = phase;
+  }
+
+  // Puts the thread in phase until it goes out of scope, and adds the time
+  // to the current request, if any.
+  class PhaseTimer
+  {
+  public:
+    explicit PhaseTimer(uint32_t phase)
+        : _phase(phase), _saved_phase(EnterRequestPhase(phase)),
+          _start(ReadCycles())
+    {
+    }
+
+    ~PhaseTimer()
+    {
+      RecordBlocked(_phase, ReadCycles() - _start);
+      EnterRequestPhase(_saved_phase);
+    }
+
+    PhaseTimer(const PhaseTimer &) = delete;
+    PhaseTimer &operator=(const PhaseTimer &) = delete;
+
+  private:
+    uint32_t _phase;
+    uint32_t _saved_phase;
+    uint64_t _start;
+  };
+
+  // Totals of all requests of an RPC method since the service started.
+  struct MethodBreakdown
+  {
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> wall_cycles{0};
+    std::atomic<uint64_t> cpu_cycles{0};
+    std::atomic<uint64_t> blocked_cycles[REQUEST_PHASE_COUNT] = {};
+    std::atomic<uint64_t> bytes_sent[REQUEST_PHASE_COUNT] = {};
+    std::atomic<uint64_t> bytes_received[REQUEST_PHASE_COUNT] = {};
+  };
+
+  class BreakdownRegistry
+  {
+  public:
+    // Never destroyed, so that threads still serving requests at exit can
+    // keep using it.
+    static BreakdownRegistry &Global()
+    {
+      static BreakdownRegistry *registry = new BreakdownRegistry();
+      return *registry;
+    }
+
+    MethodBreakdown *Get(const std::string &method)
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      auto &breakdown = _methods[method];
+      if (!breakdown)
+      {
+        breakdown.reset(new MethodBreakdown());
+      }
+      return breakdown.get();
+    }
+
+    // Adds a line to every report, e.g. the state of a shared queue.
+    void AddReporter(std::function<std::string()> reporter)
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _reporters.push_back(std::move(reporter));
+    }
+
+    // One line per method, with the mean time per request in each phase,
+    // then one per reporter.
+    std::vector<std::string> Report()
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      std::vector<std::string> lines;
+      for (const auto &method : _methods)
+      {
+        const MethodBreakdown &totals = *method.second;
+        uint64_t requests = totals.requests.load(std::memory_order_relaxed);
+        if (!requests)
+        {
+          continue;
+        }
+        double scale = 1.0 / (CyclesPerMicrosecond() * 1000.0 * requests);
+        char buf[256];
+        snprintf(buf, sizeof(buf),
+                 "%s: %" PRIu64 " requests, mean %.3f ms, cpu %.3f ms",
+                 method.first.c_str(), requests,
+                 totals.wall_cycles.load(std::memory_order_relaxed) * scale,
+                 totals.cpu_cycles.load(std::memory_order_relaxed) * scale);
+        std::string line(buf);
+        for (uint32_t phase = REQUEST_PHASE_POOL_WAIT;
+             phase < REQUEST_PHASE_COUNT; phase++)
+        {
+          uint64_t cycles =
+              totals.blocked_cycles[phase].load(std::memory_order_relaxed);
+          uint64_t sent =
+              totals.bytes_sent[phase].load(std::memory_order_relaxed);
+          uint64_t received =
+              totals.bytes_received[phase].load(std::memory_order_relaxed);
+          if (!cycles && !sent && !received)
+          {
+            continue;
+          }
+          snprintf(buf, sizeof(buf), ", %s %.3f ms", RequestPhaseName(phase),
+                   cycles * scale);
+          line += buf;
+          if (sent || received)
+          {
+            snprintf(buf, sizeof(buf), " (%" PRIu64 " B out, %" PRIu64
+                                       " B in)",
+                     sent / requests, received / requests);
+            line += buf;
+          }
+        }
+        lines.push_back(std::move(line));
+      }
+      for (const auto &reporter : _reporters)
+      {
+        lines.push_back(reporter());
+      }
+      return lines;
+    }
+
+  private:
+    BreakdownRegistry() = default;
+
+    std::mutex _mutex;
+    std::map<std::string, std::unique_ptr<MethodBreakdown>> _methods;
+    std::vector<std::function<std::string()>> _reporters;
+  };
+
+  // Looked up once per thread by the address of the method name, like
+  // GetRpcMetrics().
+  inline MethodBreakdown &GetMethodBreakdown(const char *method)
+  {
+    thread_local std::unordered_map<const char *, MethodBreakdown *> cache;
+    auto it = cache.find(method);
+    if (it == cache.end())
+    {
+      it = cache.emplace(method, BreakdownRegistry::Global().Get(method))
+               .first;
+    }
+    return *it->second;
+  }
+
+  inline void AddRequestBreakdown(MethodBreakdown &totals,
+                                  const RequestBreakdown &breakdown,
+                                  uint64_t wall_cycles)
+  {
+    uint64_t own_blocked =
+        breakdown.own_blocked_cycles.load(std::memory_order_relaxed);
+    totals.requests.fetch_add(1, std::memory_order_relaxed);
+    totals.wall_cycles.fetch_add(wall_cycles, std::memory_order_relaxed);
+    totals.cpu_cycles.fetch_add(
+        wall_cycles > own_blocked ? wall_cycles - own_blocked : 0,
+        std::memory_order_relaxed);
+    for (uint32_t phase = REQUEST_PHASE_POOL_WAIT; phase < REQUEST_PHASE_COUNT;
+         phase++)
+    {
+      uint64_t cycles =
+          breakdown.blocked_cycles[phase].load(std::memory_order_relaxed);
+      if (cycles)
+      {
+        totals.blocked_cycles[phase].fetch_add(cycles,
+                                               std::memory_order_relaxed);
+      }
+      uint64_t sent = breakdown.bytes_sent[phase].load(
+          std::memory_order_relaxed);
+      uint64_t received = breakdown.bytes_received[phase].load(
+          std::memory_order_relaxed);
+      if (sent)
+      {
+        totals.bytes_sent[phase].fetch_add(sent, std::memory_order_relaxed);
+      }
+      if (received)
+      {
+        totals.bytes_received[phase].fetch_add(received,
+                                               std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /*
+   * Calls set(key, value) with the breakdown of the request so far, in
+   * milliseconds and bytes, e.g. ("breakdown.mongo_ms", 1.2). Phases the
+   * request did not wait in are left out.
+   */
+  template <class F>
+  void ForEachBreakdownTag(const RequestBreakdown &breakdown, F set)
+  {
+    double scale = 1.0 / (CyclesPerMicrosecond() * 1000.0);
+    uint64_t wall = ReadCycles() - breakdown.start_cycles;
+    uint64_t own_blocked =
+        breakdown.own_blocked_cycles.load(std::memory_order_relaxed);
+    set("breakdown.cpu_ms",
+        (wall > own_blocked ? wall - own_blocked : 0) * scale);
+    for (uint32_t phase = REQUEST_PHASE_POOL_WAIT; phase < REQUEST_PHASE_COUNT;
+         phase++)
+    {
+      std::string prefix = std::string("breakdown.") + RequestPhaseName(phase);
+      uint64_t cycles =
+          breakdown.blocked_cycles[phase].load(std::memory_order_relaxed);
+      if (cycles)
+      {
+        set(prefix + "_ms", cycles * scale);
+      }
+      uint64_t sent = breakdown.bytes_sent[phase].load(
+          std::memory_order_relaxed);
+      uint64_t received = breakdown.bytes_received[phase].load(
+          std::memory_order_relaxed);
+      if (sent)
+      {
+        set(prefix + "_bytes_sent", static_cast<double>(sent));
+      }
+      if (received)
+      {
+        set(prefix + "_bytes_received", static_cast<double>(received));
+      }
+    }
+  }
+
+  /*
+   * Logs the per-method breakdown, one line per method, whenever the
+   * process gets SIGUSR1:
+   *
+   *   kill -USR1 $(pidof MovieIdService)
+   *
+   * Also calibrates the cycle counter.
+   */
+  inline void StartBreakdownReport()
+  {
+    CyclesPerMicrosecond();
+    OnSignal(SIGUSR1, []() {
+      auto lines = BreakdownRegistry::Global().Report();
+      LOG(info) << "Request breakdown, mean per request";
+      for (const auto &line : lines)
+      {
+        LOG(info) << line;
+      }
+    });
+  }
+
+} // namespace media_service
+
+#endif // MEDIA_MICROSERVICES_REQUESTBREAKDOWN_H
@@ -0,0 +1,228 @@
+#ifndef MEDIA_MICROSERVICES_REQUESTCONTEXT_H
+#define MEDIA_MICROSERVICES_REQUESTCONTEXT_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#ifdef MEDIA_MICROSERVICES_USDT
+#include <sys/sdt.h>
+#endif
+
+#define REQUEST_CONTEXT_ABI_VERSION 1
+#define REQUEST_CONTEXT_SERVICE_LEN 32
+
+namespace media_service
+{
+
+  // What the thread is doing for the request. Part of the ABI below: values
+  // are only ever added.
+  enum RequestPhase : uint32_t
+  {
+    REQUEST_PHASE_IDLE = 0,      // not serving a request
+    REQUEST_PHASE_HANDLER = 1,   // in the handler, none of the below
+    REQUEST_PHASE_POOL_WAIT = 2, // waiting in ClientPool::Pop()
+    REQUEST_PHASE_MEMCACHED = 3,
+    REQUEST_PHASE_MONGO = 4,
+    REQUEST_PHASE_REDIS = 5,
+    REQUEST_PHASE_THRIFT = 6,    // in a call to a downstream service
+    REQUEST_PHASE_TASK_WAIT = 7, // waiting for its own Executor tasks
+  };
+
+#define REQUEST_PHASE_COUNT 8
+
+  /*
+   * The request a thread is serving, kept in a thread-local block so that
+   * eBPF programs can read it with bpf_probe_read_user() at any kernel
+   * event of the thread, e.g. a sched_switch while blocked in recv() on a
+   * Thrift socket. ABI version 1, native byte order, 64 bytes:
+   *
+   *   offset  size  field
+   *        0     4  abi_version    REQUEST_CONTEXT_ABI_VERSION
+   *        4     4  phase          RequestPhase
+   *        8     8  req_id         0 while idle
+   *       16     8  trace_id_high  0 without a trace context
+   *       24     8  trace_id_low
+   *       32    32  service        NUL-terminated service name
+   *
+   * Fields are only appended, and a change to existing ones bumps the
+   * version. The block of a thread stays at the same address for the
+   * lifetime of the thread. Its address is passed as arg0 of the USDT probe
+   * media_service:request_context, fired whenever the thread starts working
+   * on a request; see scripts/bpftrace/offcpu_by_request.bt.
+   *
+   * Only the owning thread writes its block, with plain stores. A reader on
+   * another CPU can see a request half switched, which is fine for
+   * sampling; a reader at an event of the thread itself sees it whole.
+   */
+  struct RequestContext
+  {
+    uint32_t abi_version;
+    uint32_t phase;
+    int64_t req_id;
+    uint64_t trace_id_high;
+    uint64_t trace_id_low;
+    char service[REQUEST_CONTEXT_SERVICE_LEN];
+  };
+
+  static_assert(sizeof(RequestContext) == 64, "RequestContext ABI changed");
+  static_assert(offsetof(RequestContext, phase) == 4,
+                "RequestContext ABI changed");
+  static_assert(offsetof(RequestContext, req_id) == 8,
+                "RequestContext ABI changed");
+  static_assert(offsetof(RequestContext, trace_id_high) == 16,
+                "RequestContext ABI changed");
+  static_assert(offsetof(RequestContext, trace_id_low) == 24,
+                "RequestContext ABI changed");
+  static_assert(offsetof(RequestContext, service) == 32,
+                "RequestContext ABI changed");
+
+  struct RequestBreakdown;
+
+  struct TraceId
+  {
+    uint64_t high;
+    uint64_t low;
+  };
+
+  inline char *_RequestContextService()
+  {
+    static char service[REQUEST_CONTEXT_SERVICE_LEN];
+    return service;
+  }
+
+  // Names the service in the context blocks of threads created later. Call
+  // once in main() before the server starts; SetUpTracer() does.
+  inline void SetRequestContextService(const std::string &service)
+  {
+    char *dest = _RequestContextService();
+    size_t len = std::min(service.size(),
+                          static_cast<size_t>(REQUEST_CONTEXT_SERVICE_LEN - 1));
+    memcpy(dest, service.data(), len);
+    dest[len] = '\0';
+  }
+
+  inline RequestContext &CurrentRequestContext()
+  {
+    static thread_local RequestContext context;
+    if (context.abi_version == 0)
+    {
+      memcpy(context.service, _RequestContextService(),
+             REQUEST_CONTEXT_SERVICE_LEN);
+      context.abi_version = REQUEST_CONTEXT_ABI_VERSION;
+    }
+    return context;
+  }
+
+  // Where the blocked time of the current request is added up, see
+  // RequestBreakdown.h; nullptr while idle. Not part of the ABI block.
+  inline RequestBreakdown *&CurrentRequestBreakdown()
+  {
+    static thread_local RequestBreakdown *breakdown = nullptr;
+    return breakdown;
+  }
+
+  // Makes the thread work on a request until it goes out of scope, then
+  // restores what the thread did before, so scopes nest.
+  class RequestContextScope
+  {
+  public:
+    RequestContextScope(int64_t req_id, TraceId trace_id,
+                        RequestBreakdown *breakdown = nullptr,
+                        uint32_t phase = REQUEST_PHASE_HANDLER)
+        : _context(CurrentRequestContext()),
+          _saved_phase(_context.phase),
+          _saved_req_id(_context.req_id),
+          _saved_trace_id{_context.trace_id_high, _context.trace_id_low},
+          _saved_breakdown(CurrentRequestBreakdown())
+    {
+      CurrentRequestBreakdown() = breakdown;
+      _context.req_id = req_id;
+      _context.trace_id_high = trace_id.high;
+      _context.trace_id_low = trace_id.low;
+      _context.phase = phase;
+#ifdef MEDIA_MICROSERVICES_USDT
+      RequestContext *address = &_context;
+      DTRACE_PROBE1(media_service, request_context, address);
+#endif
+    }
+
+    ~RequestContextScope()
+    {
+      _context.phase = _saved_phase;
+      _context.req_id = _saved_req_id;
+      _context.trace_id_high = _saved_trace_id.high;
+      _context.trace_id_low = _saved_trace_id.low;
+      CurrentRequestBreakdown() = _saved_breakdown;
+    }
+
+    RequestContextScope(const RequestContextScope &) = delete;
+    RequestContextScope &operator=(const RequestContextScope &) = delete;
+
+  private:
+    RequestContext &_context;
+    uint32_t _saved_phase;
+    int64_t _saved_req_id;
+    TraceId _saved_trace_id;
+    RequestBreakdown *_saved_breakdown;
+  };
+
+  // Sets the phase of the current request, and returns the previous one to
+  // restore afterwards.
+  inline uint32_t EnterRequestPhase(uint32_t phase)
+  {
+    auto &context = CurrentRequestContext();
+    uint32_t previous = context.phase;
+    context.phase = phase;
+    return previous;
+  }
+
+  /*
+   * Wraps a task so that it runs in the request context of the thread that
+   * wrapped it, e.g.
+   *
+   *   std::async(std::launch::async, InheritRequestContext([&]() { ... }));
+   *
+   * Executor::Submit() does this for every task.
+   */
+  template <class F>
+  class RequestContextTask
+  {
+  public:
+    explicit RequestContextTask(F f)
+        : _f(std::move(f)), _phase(CurrentRequestContext().phase),
+          _req_id(CurrentRequestContext().req_id),
+          _trace_id{CurrentRequestContext().trace_id_high,
+                    CurrentRequestContext().trace_id_low},
+          _breakdown(CurrentRequestBreakdown())
+    {
+    }
+
+    auto operator()() -> decltype(std::declval<F &>()())
+    {
+      RequestContextScope scope(_req_id, _trace_id, _breakdown, _phase);
+      return _f();
+    }
+
+  private:
+    F _f;
+    uint32_t _phase;
+    int64_t _req_id;
+    TraceId _trace_id;
+    RequestBreakdown *_breakdown;
+  };
+
+  template <class F>
+  RequestContextTask<typename std::decay<F>::type> InheritRequestContext(F &&f)
+  {
+    return RequestContextTask<typename std::decay<F>::type>(
+        std::forward<F>(f));
+  }
+
+} // namespace media_service
+
+#endif // MEDIA_MICROSERVICES_REQUESTCONTEXT_H
@@ -11,8 +11,11 @@
 #include <bson/bson.h>
 
 #include "../../gen-cpp/ReviewStorageService.h"
+#include "../Executor.h"
+#include "../MemcachedPool.h"
 #include "../logger.h"
 #include "../tracing.h"
+#include "../probes.h"
 
 namespace media_service {
 
@@ -20,6 +23,8 @@ class ReviewStorageHandler : public ReviewStorageServiceIf{
  public:
   ReviewStorageHandler(memcached_pool_st *, mongoc_client_pool_t *);
   ~ReviewStorageHandler() override = default;
+
+  void Ping() override {}
   void StoreReview(int64_t, const Review &, 
       const std::map<std::string, std::string> &) override;
   void ReadReviews(std::vector<Review> &, int64_t, const std::vector<int64_t> &,
@@ -43,14 +48,8 @@ void ReviewStorageHandler::StoreReview(
     const std::map<std::string, std::string> & carrier) {
 
   // Initialize a span
-  TextMapReader reader(carrier);
-  std::map<std::string, std::string> writer_text_map;
-  TextMapWriter writer(writer_text_map);
-  auto parent_span = opentracing::Tracer::Global()->Extract(reader);
-  auto span = opentracing::Tracer::Global()->StartSpan(
-      "StoreReview",
-      { opentracing::ChildOf(parent_span->get()) });
-  opentracing::Tracer::Global()->Inject(span->context(), writer);
+  auto span = TraceSpan::Start("StoreReview", carrier);
+  RequestProbe probe(req_id, "StoreReview", span.GetTraceId());
 
   mongoc_client_t *mongodb_client = mongoc_client_pool_pop(
       _mongodb_client_pool);
@@ -58,7 +57,7 @@ void ReviewStorageHandler::StoreReview(
     ServiceException se;
     se.errorCode = ErrorCode::SE_MONGODB_ERROR;
     se.message = "Failed to pop a client from MongoDB pool";
-    throw se;
+    throw RequestError(se);
   }
 
   auto collection = mongoc_client_get_collection(
@@ -68,7 +67,7 @@ void ReviewStorageHandler::StoreReview(
     se.errorCode = ErrorCode::SE_MONGODB_ERROR;
     se.message = "Failed to create collection user from DB user";
     mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
-    throw se;
+    throw RequestError(se);
   }
 
   bson_t *new_doc = bson_new();
@@ -81,11 +80,12 @@ void ReviewStorageHandler::StoreReview(
   BSON_APPEND_INT64(new_doc, "req_id", review.req_id);
   bson_error_t error;
 
-  auto insert_span = opentracing::Tracer::Global()->StartSpan(
-      "MongoInsertReview", { opentracing::ChildOf(&span->context()) });
+  auto insert_span = span.Child("MongoInsertReview");
+  CallProbe insert_probe(ProbeBackend::mongo, req_id, "MongoInsertReview");
   bool plotinsert = mongoc_collection_insert_one (
       collection, new_doc, nullptr, nullptr, &error);
-  insert_span->Finish();
+  insert_span.Finish();
+  insert_probe.End();
 
   if (!plotinsert) {
     LOG(error) << "Error: Failed to insert review to MongoDB: "
@@ -96,14 +96,14 @@ void ReviewStorageHandler::StoreReview(
     bson_destroy(new_doc);
     mongoc_collection_destroy(collection);
     mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
-    throw se;
+    throw RequestError(se);
   }
 
   bson_destroy(new_doc);
   mongoc_collection_destroy(collection);
   mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
 
-  span->Finish();
+  span.Finish();
 }
 void ReviewStorageHandler::ReadReviews(
     std::vector<Review> & _return,
@@ -112,14 +112,8 @@ void ReviewStorageHandler::ReadReviews(
     const std::map<std::string, std::string> &carrier) {
 
   // Initialize a span
-  TextMapReader reader(carrier);
-  std::map<std::string, std::string> writer_text_map;
-  TextMapWriter writer(writer_text_map);
-  auto parent_span = opentracing::Tracer::Global()->Extract(reader);
-  auto span = opentracing::Tracer::Global()->StartSpan(
-      "ReadReviews",
-      { opentracing::ChildOf(parent_span->get()) });
-  opentracing::Tracer::Global()->Inject(span->context(), writer);
+  auto span = TraceSpan::Start("ReadReviews", carrier);
+  RequestProbe probe(req_id, "ReadReviews", span.GetTraceId());
 
   if (review_ids.empty()) {
     return;
@@ -130,17 +124,17 @@ void ReviewStorageHandler::ReadReviews(
     ServiceException se;
     se.errorCode = ErrorCode::SE_THRIFT_HANDLER_ERROR;
     se.message = "Post_ids are duplicated";
-    throw se;
+    throw RequestError(se);
   }
   std::map<int64_t, Review> return_map;
   memcached_return_t memcached_rc;
-  auto memcached_client = memcached_pool_pop(
+  auto memcached_client = MemcachedPoolPop(
       _memcached_client_pool, true, &memcached_rc);
   if (!memcached_client) {
     ServiceException se;
     se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
     se.message = "Failed to pop a client from memcached pool";
-    throw se;
+    throw RequestError(se);
   }
 
   char** keys;
@@ -148,13 +142,17 @@ void ReviewStorageHandler::ReadReviews(
   keys = new char* [review_ids.size()];
   key_sizes = new size_t [review_ids.size()];
   int idx = 0;
+  size_t keys_length = 0;
   for (auto &review_id : review_ids) {
     std::string key_str = std::to_string(review_id);
     keys[idx] = new char [key_str.length() + 1];
     strcpy(keys[idx], key_str.c_str());
     key_sizes[idx] = key_str.length();
+    keys_length += key_str.length();
     idx++;
   }
+  CallProbe get_probe(ProbeBackend::memcached, req_id, "MemcachedMget");
+  get_probe.AddBytes(keys_length, 0);
   memcached_rc = memcached_mget(
       memcached_client, keys, key_sizes, review_ids.size());
   if (memcached_rc != MEMCACHED_SUCCESS) {
@@ -163,8 +161,8 @@ void ReviewStorageHandler::ReadReviews(
     ServiceException se;
     se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
     se.message = memcached_strerror(memcached_client, memcached_rc);
-    memcached_pool_push(_memcached_client_pool, memcached_client);
-    throw se;
+    MemcachedPoolPush(_memcached_client_pool, memcached_client);
+    throw RequestError(se);
   }
 
   char return_key[MEMCACHED_MAX_KEY];
@@ -172,8 +170,7 @@ void ReviewStorageHandler::ReadReviews(
   char *return_value;
   size_t return_value_length;
   uint32_t flags;
-  auto get_span = opentracing::Tracer::Global()->StartSpan(
-      "MemcachedMget", { opentracing::ChildOf(&span->context()) });
+  auto get_span = span.Child("MemcachedMget");
 
   while (true) {
     return_value =
@@ -186,13 +183,14 @@ void ReviewStorageHandler::ReadReviews(
     if (memcached_rc != MEMCACHED_SUCCESS) {
       free(return_value);
       memcached_quit(memcached_client);
-      memcached_pool_push(_memcached_client_pool, memcached_client);
+      MemcachedPoolPush(_memcached_client_pool, memcached_client);
       LOG(error) << "Cannot get reviews of request " << req_id;
       ServiceException se;
       se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
       se.message = "Cannot get reviews of request " + std::to_string(req_id);
-      throw se;
+      throw RequestError(se);
     }
+    get_probe.AddBytes(0, return_key_length + return_value_length);
     Review new_review;
     json review_json = json::parse(std::string(
         return_value, return_value + return_value_length));
@@ -208,16 +206,17 @@ void ReviewStorageHandler::ReadReviews(
     free(return_value);
     LOG(debug) << "Review: " << new_review.review_id << " found in memcached";
   }
-  get_span->Finish();
+  get_span.Finish();
+  get_probe.End(return_map.size());
   memcached_quit(memcached_client);
-  memcached_pool_push(_memcached_client_pool, memcached_client);
+  MemcachedPoolPush(_memcached_client_pool, memcached_client);
   for (int i = 0; i < review_ids.size(); ++i) {
     delete keys[i];
   }
   delete[] keys;
   delete[] key_sizes;
 
-  std::vector<std::future<void>> set_futures;
+  std::vector<TaskFuture<void>> set_futures;
   std::map<int64_t, std::string> review_json_map;
   
   // Find the rest in MongoDB
@@ -228,7 +227,7 @@ void ReviewStorageHandler::ReadReviews(
       ServiceException se;
       se.errorCode = ErrorCode::SE_MONGODB_ERROR;
       se.message = "Failed to pop a client from MongoDB pool";
-      throw se;
+      throw RequestError(se);
     }
     auto collection = mongoc_client_get_collection(
         mongodb_client, "review", "review");
@@ -237,7 +236,7 @@ void ReviewStorageHandler::ReadReviews(
       se.errorCode = ErrorCode::SE_MONGODB_ERROR;
       se.message = "Failed to create collection user from DB user";
       mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
-      throw se;
+      throw RequestError(se);
     }
     bson_t *query = bson_new();
     bson_t query_child;
@@ -257,8 +256,8 @@ void ReviewStorageHandler::ReadReviews(
     mongoc_cursor_t *cursor = mongoc_collection_find_with_opts(
         collection, query, nullptr, nullptr);
     const bson_t *doc;
-    auto find_span = opentracing::Tracer::Global()->StartSpan(
-        "MongoFindPosts", {opentracing::ChildOf(&span->context())});
+    auto find_span = span.Child("MongoFindPosts");
+    CallProbe find_probe(ProbeBackend::mongo, req_id, "MongoFindPosts");
     while (true) {
       bool found = mongoc_cursor_next(cursor, &doc);
       if (!found) {
@@ -278,7 +277,8 @@ void ReviewStorageHandler::ReadReviews(
       return_map.insert({new_review.review_id, new_review});
       bson_free(review_json_char);
     }
-    find_span->Finish();
+    find_span.Finish();
+    find_probe.End(review_json_map.size());
     bson_error_t error;
     if (mongoc_cursor_error(cursor, &error)) {
       LOG(warning) << error.message;
@@ -289,7 +289,7 @@ void ReviewStorageHandler::ReadReviews(
       ServiceException se;
       se.errorCode = ErrorCode::SE_MONGODB_ERROR;
       se.message = error.message;
-      throw se;
+      throw RequestError(se);
     }
     bson_destroy(query);
     mongoc_cursor_destroy(cursor);
@@ -297,19 +297,19 @@ void ReviewStorageHandler::ReadReviews(
     mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
 
     // upload reviews to memcached
-    set_futures.emplace_back(std::async(std::launch::async, [&]() {
+    set_futures.emplace_back(Executor::Global().Submit([&]() {
       memcached_return_t _rc;
-      auto _memcached_client = memcached_pool_pop(
+      auto _memcached_client = MemcachedPoolPop(
           _memcached_client_pool, true, &_rc);
       if (!_memcached_client) {
         LOG(error) << "Failed to pop a client from memcached pool";
         ServiceException se;
         se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
         se.message = "Failed to pop a client from memcached pool";
-        throw se;
+        throw RequestError(se);
       }
-      auto set_span = opentracing::Tracer::Global()->StartSpan(
-          "MmcSetPost", {opentracing::ChildOf(&span->context())});
+      auto set_span = span.Child("MmcSetPost");
+      CallProbe set_probe(ProbeBackend::memcached, req_id, "MmcSetPost");
       for (auto & it : review_json_map) {
         std::string id_str = std::to_string(it.first);
         _rc = memcached_set(
@@ -320,9 +320,11 @@ void ReviewStorageHandler::ReadReviews(
             it.second.length(),
             static_cast<time_t>(0),
             static_cast<uint32_t>(0));
+        set_probe.AddBytes(id_str.length() + it.second.length(), 0);
       }
-      memcached_pool_push(_memcached_client_pool, _memcached_client);
-      set_span->Finish();
+      MemcachedPoolPush(_memcached_client_pool, _memcached_client);
+      set_span.Finish();
+      set_probe.End();
     }));
   }
 
@@ -336,7 +338,7 @@ void ReviewStorageHandler::ReadReviews(
     ServiceException se;
     se.errorCode = ErrorCode::SE_THRIFT_HANDLER_ERROR;
     se.message = "review storage service: return set incomplete";
-    throw se;
+    throw RequestError(se);
   }
 
   for (auto &review_id : review_ids) {
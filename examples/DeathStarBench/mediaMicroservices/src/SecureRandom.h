@@ -0,0 +1,266 @@
+#ifndef MEDIA_MICROSERVICES_SECURERANDOM_H
+#define MEDIA_MICROSERVICES_SECURERANDOM_H
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// ChaCha20 blocks generated per refill, the first of which rekeys.
+#define SECURE_RANDOM_BLOCKS 16
+#define SECURE_RANDOM_BLOCK_SIZE 64
+// Bytes a thread hands out before it mixes in fresh kernel entropy.
+#define SECURE_RANDOM_RESEED_BYTES (1 << 20)
+
+namespace media_service
+{
+
+  // Fills buf from the kernel CSPRNG: getrandom(2), or /dev/urandom on
+  // kernels without it. There is nothing safe to fall back to, so a
+  // failure aborts.
+  inline void _GetEntropy(void *buf, size_t len)
+  {
+    char *out = static_cast<char *>(buf);
+    size_t done = 0;
+#ifdef SYS_getrandom
+    while (done < len)
+    {
+      long n = syscall(SYS_getrandom, out + done, len - done, 0);
+      if (n > 0)
+      {
+        done += n;
+      }
+      else if (errno != EINTR)
+      {
+        break;
+      }
+    }
+#endif
+    if (done < len)
+    {
+      int fd = open("/dev/urandom", O_RDONLY | O_CLOEXEC);
+      while (fd >= 0 && done < len)
+      {
+        ssize_t n = read(fd, out + done, len - done);
+        if (n > 0)
+        {
+          done += n;
+        }
+        else if (n == 0 || errno != EINTR)
+        {
+          break;
+        }
+      }
+      if (fd >= 0)
+      {
+        close(fd);
+      }
+    }
+    if (done < len)
+    {
+      fprintf(stderr, "Failed to read entropy from the kernel\n");
+      abort();
+    }
+  }
+
+  inline uint32_t _ChaChaRotl(uint32_t x, int n)
+  {
+    return (x << n) | (x >> (32 - n));
+  }
+
+#define _CHACHA_QUARTER_ROUND(a, b, c, d) \
+  a += b; d = _ChaChaRotl(d ^ a, 16);     \
+  c += d; b = _ChaChaRotl(b ^ c, 12);     \
+  a += b; d = _ChaChaRotl(d ^ a, 8);      \
+  c += d; b = _ChaChaRotl(b ^ c, 7)
+
+  // One ChaCha20 block (RFC 8439) with a zero nonce. The key changes on
+  // every refill, so the nonce never has to.
+  inline void _ChaCha20Block(const uint32_t key[8], uint32_t counter,
+                             uint8_t out[SECURE_RANDOM_BLOCK_SIZE])
+  {
+    uint32_t input[16] = {
+        0x61707865, 0x3320646e, 0x79622d32, 0x6b206574,
+        key[0], key[1], key[2], key[3], key[4], key[5], key[6], key[7],
+        counter, 0, 0, 0};
+    uint32_t x[16];
+    memcpy(x, input, sizeof(x));
+    for (int i = 0; i < 10; i++)
+    {
+      _CHACHA_QUARTER_ROUND(x[0], x[4], x[8], x[12]);
+      _CHACHA_QUARTER_ROUND(x[1], x[5], x[9], x[13]);
+      _CHACHA_QUARTER_ROUND(x[2], x[6], x[10], x[14]);
+      _CHACHA_QUARTER_ROUND(x[3], x[7], x[11], x[15]);
+      _CHACHA_QUARTER_ROUND(x[0], x[5], x[10], x[15]);
+      _CHACHA_QUARTER_ROUND(x[1], x[6], x[11], x[12]);
+      _CHACHA_QUARTER_ROUND(x[2], x[7], x[8], x[13]);
+      _CHACHA_QUARTER_ROUND(x[3], x[4], x[9], x[14]);
+    }
+    for (int i = 0; i < 16; i++)
+    {
+      uint32_t word = x[i] + input[i];
+      out[4 * i] = static_cast<uint8_t>(word);
+      out[4 * i + 1] = static_cast<uint8_t>(word >> 8);
+      out[4 * i + 2] = static_cast<uint8_t>(word >> 16);
+      out[4 * i + 3] = static_cast<uint8_t>(word >> 24);
+    }
+  }
+
+#undef _CHACHA_QUARTER_ROUND
+
+  /*
+   * Per-thread ChaCha20 generator for salts, tokens and IDs, seeded from
+   * getrandom(2). Each refill computes SECURE_RANDOM_BLOCKS blocks at once;
+   * the first 32 bytes become the next key and every byte is wiped once it
+   * is handed out, so the state of a thread never reveals earlier output.
+   * After SECURE_RANDOM_RESEED_BYTES, and in a forked child, the key is
+   * mixed with fresh kernel entropy. No lock, and one syscall per MiB.
+   * Always go through Local(), which notices the fork.
+   */
+  class SecureRandom
+  {
+  public:
+    static SecureRandom &Local()
+    {
+      static thread_local SecureRandom generator;
+      if (generator._forks != _ForkCount().load(std::memory_order_relaxed))
+      {
+        // A forked child must not repeat what its parent hands out.
+        generator._forks = _ForkCount().load(std::memory_order_relaxed);
+        generator._Reseed();
+        generator._Refill();
+      }
+      return generator;
+    }
+
+    void Bytes(void *buf, size_t len)
+    {
+      uint8_t *out = static_cast<uint8_t *>(buf);
+      while (len > 0)
+      {
+        if (_pos == sizeof(_buf))
+        {
+          _Refill();
+        }
+        size_t n = std::min(len, sizeof(_buf) - _pos);
+        memcpy(out, _buf + _pos, n);
+        memset(_buf + _pos, 0, n);
+        _pos += n;
+        out += n;
+        len -= n;
+      }
+    }
+
+    uint64_t Uint64()
+    {
+      uint64_t value;
+      Bytes(&value, sizeof(value));
+      return value;
+    }
+
+    // len characters drawn uniformly from [0-9A-Za-z].
+    std::string Alphanumeric(size_t len)
+    {
+      static const char alphanum[] =
+          "0123456789"
+          "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+          "abcdefghijklmnopqrstuvwxyz";
+      std::string s(len, '\0');
+      size_t i = 0;
+      while (i < len)
+      {
+        if (_pos == sizeof(_buf))
+        {
+          _Refill();
+        }
+        uint8_t byte = _buf[_pos];
+        _buf[_pos++] = 0;
+        // 248 = 4 * 62: dropping the bytes above keeps every
+        // character equally likely.
+        if (byte < 248)
+        {
+          s[i++] = alphanum[byte % 62];
+        }
+      }
+      return s;
+    }
+
+  private:
+    SecureRandom()
+    {
+      static int atfork = pthread_atfork(nullptr, nullptr, []() {
+        _ForkCount().fetch_add(1, std::memory_order_relaxed);
+      });
+      (void)atfork;
+      _forks = _ForkCount().load(std::memory_order_relaxed);
+      _Reseed();
+      _Refill();
+    }
+
+    ~SecureRandom()
+    {
+      memset(_key, 0, sizeof(_key));
+      memset(_buf, 0, sizeof(_buf));
+    }
+
+    SecureRandom(const SecureRandom &) = delete;
+    SecureRandom &operator=(const SecureRandom &) = delete;
+
+    static std::atomic<unsigned> &_ForkCount()
+    {
+      static std::atomic<unsigned> forks{0};
+      return forks;
+    }
+
+    void _Reseed()
+    {
+      uint32_t entropy[8];
+      _GetEntropy(entropy, sizeof(entropy));
+      for (int i = 0; i < 8; i++)
+      {
+        _key[i] ^= entropy[i];
+      }
+      memset(entropy, 0, sizeof(entropy));
+      _until_reseed = SECURE_RANDOM_RESEED_BYTES;
+    }
+
+    void _Refill()
+    {
+      if (_until_reseed < sizeof(_buf))
+      {
+        _Reseed();
+      }
+      uint8_t block[SECURE_RANDOM_BLOCK_SIZE];
+      _ChaCha20Block(_key, 0, block);
+      for (uint32_t i = 1; i < SECURE_RANDOM_BLOCKS; i++)
+      {
+        _ChaCha20Block(_key, i, _buf + i * SECURE_RANDOM_BLOCK_SIZE -
+                                    sizeof(_key));
+      }
+      memcpy(_key, block, sizeof(_key));
+      memcpy(_buf, block + sizeof(_key), sizeof(block) - sizeof(_key));
+      memset(block, 0, sizeof(block));
+      _pos = 0;
+      _until_reseed -= sizeof(_buf);
+    }
+
+    uint32_t _key[8] = {0};
+    uint8_t _buf[SECURE_RANDOM_BLOCKS * SECURE_RANDOM_BLOCK_SIZE - 32];
+    size_t _pos = 0;
+    size_t _until_reseed = 0;
+    unsigned _forks = 0;
+  };
+
+} // namespace media_service
+
+#endif // MEDIA_MICROSERVICES_SECURERANDOM_H
@@ -0,0 +1,94 @@
+#ifndef MEDIA_MICROSERVICES_SIGNALACTION_H
+#define MEDIA_MICROSERVICES_SIGNALACTION_H
+
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <thread>
+
+#include "logger.h"
+
+namespace media_service
+{
+
+  inline int *_SignalActionPipes()
+  {
+    static int write_fds[NSIG];
+    static bool initialized = false;
+    if (!initialized)
+    {
+      for (auto &fd : write_fds)
+      {
+        fd = -1;
+      }
+      initialized = true;
+    }
+    return write_fds;
+  }
+
+  inline void _OnSignalAction(int signum)
+  {
+    int saved_errno = errno;
+    char byte = 0;
+    if (write(_SignalActionPipes()[signum], &byte, 1) < 0)
+    {
+      // The pipe is full, so the action is pending anyway.
+    }
+    errno = saved_errno;
+  }
+
+  /*
+   * Runs action on a background thread whenever the process gets signum,
+   * e.g. SIGUSR1. The signal handler itself only writes a byte to a pipe,
+   * so action may lock, allocate and log. Signals arriving while action
+   * runs are coalesced. Call from main() before the server starts, once per
+   * signal; returns false if signum already has an action.
+   */
+  inline bool OnSignal(int signum, std::function<void()> action)
+  {
+    if (_SignalActionPipes()[signum] >= 0)
+    {
+      return false;
+    }
+    int fds[2];
+    if (pipe(fds) != 0)
+    {
+      LOG(error) << "Cannot create the pipe for signal " << signum << ": "
+                 << strerror(errno);
+      return false;
+    }
+    fcntl(fds[1], F_SETFL, O_NONBLOCK);
+    _SignalActionPipes()[signum] = fds[1];
+    std::thread([](int read_fd, std::function<void()> action) {
+      char buf[64];
+      while (true)
+      {
+        ssize_t n = read(read_fd, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR)
+        {
+          continue;
+        }
+        if (n <= 0)
+        {
+          return;
+        }
+        action();
+      }
+    }, fds[0], std::move(action)).detach();
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = _OnSignalAction;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    sigaction(signum, &sa, nullptr);
+    return true;
+  }
+
+} // namespace media_service
+
+#endif // MEDIA_MICROSERVICES_SIGNALACTION_H
@@ -0,0 +1,176 @@
+#ifndef MEDIA_MICROSERVICES_SPANRING_H
+#define MEDIA_MICROSERVICES_SPANRING_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#define SPAN_RING_NAME_LEN 48
+
+namespace media_service
+{
+
+  // A finished span, as much of it as tail sampling needs to report it later.
+  struct SpanRecord
+  {
+    uint64_t trace_id_high;
+    uint64_t trace_id_low;
+    uint64_t span_id;
+    uint64_t parent_id;
+    int64_t start_us;    // system clock, microseconds since the epoch
+    int64_t duration_us;
+    uint64_t error;
+    char operation[SPAN_RING_NAME_LEN];
+  };
+
+  /*
+   * Fixed-size ring of finished spans, overwritten oldest first. Push() and
+   * Take() never block: a writer claims the next slot with a fetch_add on
+   * the head and then the slot's sequence number, which is odd while the
+   * slot is being written. Take() copies slots under that sequence number
+   * like a seqlock and claims each span it returns the same way, so a span
+   * is never returned twice.
+   *
+   * The record is stored as relaxed atomic words so readers racing a writer
+   * see torn data at worst, which the sequence check rejects. A span is
+   * dropped if its slot is still being written when the ring wraps around
+   * to it; spans are also lost once capacity newer ones have been pushed.
+   */
+  class SpanRing
+  {
+  public:
+    explicit SpanRing(size_t capacity);
+
+    SpanRing(const SpanRing &) = delete;
+    SpanRing &operator=(const SpanRing &) = delete;
+
+    void Push(const SpanRecord &record);
+    // Removes the spans for which match(record) is true from the ring and
+    // returns them. Scans every slot, so callers batch their traces into one
+    // call and keep it off the request path.
+    template <class F>
+    std::vector<SpanRecord> TakeIf(F match);
+    // Removes the spans of a trace from the ring and returns them.
+    std::vector<SpanRecord> Take(uint64_t trace_id_high,
+                                 uint64_t trace_id_low);
+
+  private:
+    static constexpr size_t kWords =
+        (sizeof(SpanRecord) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    struct Slot
+    {
+      std::atomic<uint64_t> seq;
+      std::atomic<uint64_t> words[kWords];
+    };
+
+    static void _Store(Slot *slot, const SpanRecord &record);
+    static void _Load(const Slot *slot, SpanRecord *record);
+
+    std::unique_ptr<Slot[]> _slots;
+    size_t _mask;
+    std::atomic<uint64_t> _head;
+  };
+
+  inline SpanRing::SpanRing(size_t capacity)
+  {
+    size_t size = 1;
+    while (size < capacity)
+    {
+      size <<= 1;
+    }
+    _slots.reset(new Slot[size]);
+    for (size_t i = 0; i < size; i++)
+    {
+      _slots[i].seq.store(0, std::memory_order_relaxed);
+      for (auto &word : _slots[i].words)
+      {
+        word.store(0, std::memory_order_relaxed);
+      }
+    }
+    _mask = size - 1;
+    _head.store(0);
+  }
+
+  inline void SpanRing::_Store(Slot *slot, const SpanRecord &record)
+  {
+    uint64_t words[kWords] = {0};
+    memcpy(words, &record, sizeof(record));
+    for (size_t i = 0; i < kWords; i++)
+    {
+      slot->words[i].store(words[i], std::memory_order_relaxed);
+    }
+  }
+
+  inline void SpanRing::_Load(const Slot *slot, SpanRecord *record)
+  {
+    uint64_t words[kWords];
+    for (size_t i = 0; i < kWords; i++)
+    {
+      words[i] = slot->words[i].load(std::memory_order_relaxed);
+    }
+    memcpy(record, words, sizeof(*record));
+  }
+
+  inline void SpanRing::Push(const SpanRecord &record)
+  {
+    Slot *slot = &_slots[_head.fetch_add(1, std::memory_order_relaxed) & _mask];
+    uint64_t seq = slot->seq.load(std::memory_order_relaxed);
+    if ((seq & 1) || !slot->seq.compare_exchange_strong(
+                         seq, seq + 1, std::memory_order_acquire))
+    {
+      return;
+    }
+    _Store(slot, record);
+    slot->seq.store(seq + 2, std::memory_order_release);
+  }
+
+  template <class F>
+  std::vector<SpanRecord> SpanRing::TakeIf(F match)
+  {
+    std::vector<SpanRecord> records;
+    for (size_t i = 0; i <= _mask; i++)
+    {
+      Slot *slot = &_slots[i];
+      uint64_t seq = slot->seq.load(std::memory_order_acquire);
+      if (seq == 0 || (seq & 1))
+      {
+        continue;
+      }
+      SpanRecord record;
+      _Load(slot, &record);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot->seq.load(std::memory_order_relaxed) != seq ||
+          record.span_id == 0 || !match(record))
+      {
+        continue;
+      }
+      // Claim the span by clearing its slot; losing the race means a
+      // writer or another Take() got there first.
+      if (!slot->seq.compare_exchange_strong(seq, seq + 1,
+                                             std::memory_order_acquire))
+      {
+        continue;
+      }
+      SpanRecord empty;
+      memset(&empty, 0, sizeof(empty));
+      _Store(slot, empty);
+      slot->seq.store(seq + 2, std::memory_order_release);
+      records.push_back(record);
+    }
+    return records;
+  }
+
+  inline std::vector<SpanRecord> SpanRing::Take(uint64_t trace_id_high,
+                                                uint64_t trace_id_low)
+  {
+    return TakeIf([&](const SpanRecord &record)
+                  { return record.trace_id_low == trace_id_low &&
+                           record.trace_id_high == trace_id_high; });
+  }
+
+} // namespace media_service
+
+#endif // MEDIA_MICROSERVICES_SPANRING_H
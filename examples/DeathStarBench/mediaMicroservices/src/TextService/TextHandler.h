@@ -6,10 +6,12 @@
 
 #include "../../gen-cpp/TextService.h"
 #include "../../gen-cpp/ComposeReviewService.h"
+#include "../AffinityClientPool.h"
 #include "../ClientPool.h"
 #include "../ThriftClient.h"
 #include "../logger.h"
 #include "../tracing.h"
+#include "../probes.h"
 
 namespace media_service
 {
@@ -17,18 +19,20 @@ namespace media_service
   class TextHandler : public TextServiceIf
   {
   public:
-    explicit TextHandler(ClientPool<ThriftClient<ComposeReviewServiceClient>> *);
+    explicit TextHandler(AffinityClientPool<ThriftClient<ComposeReviewServiceClient>> *);
     ~TextHandler() override = default;
 
+    void Ping() override {}
+
     void UploadText(int64_t, const std::string &,
                     const std::map<std::string, std::string> &) override;
 
   private:
-    ClientPool<ThriftClient<ComposeReviewServiceClient>> *_compose_client_pool;
+    AffinityClientPool<ThriftClient<ComposeReviewServiceClient>> *_compose_client_pool;
   };
 
   TextHandler::TextHandler(
-      ClientPool<ThriftClient<ComposeReviewServiceClient>> *compose_client_pool)
+      AffinityClientPool<ThriftClient<ComposeReviewServiceClient>> *compose_client_pool)
   {
     _compose_client_pool = compose_client_pool;
   }
@@ -40,14 +44,9 @@ namespace media_service
   {
 
     // Initialize a span
-    TextMapReader reader(carrier);
-    std::map<std::string, std::string> writer_text_map;
-    TextMapWriter writer(writer_text_map);
-    auto parent_span = opentracing::Tracer::Global()->Extract(reader);
-    auto span = opentracing::Tracer::Global()->StartSpan(
-        "UploadText",
-        {opentracing::ChildOf(parent_span->get())});
-    opentracing::Tracer::Global()->Inject(span->context(), writer);
+    auto span = TraceSpan::Start("UploadText", carrier);
+    RequestProbe probe(req_id, "UploadText", span.GetTraceId());
+    auto &writer_text_map = span.Carrier();
 
     // auto compose_client_wrapper = _compose_client_pool->Pop();
     // if (!compose_client_wrapper) {
@@ -66,13 +65,13 @@ namespace media_service
     // }
     // _compose_client_pool->Push(compose_client_wrapper);
 
-    auto compose_client_wrapper = _compose_client_pool->Pop();
+    auto compose_client_wrapper = _compose_client_pool->Pop(req_id);
     if (!compose_client_wrapper)
     {
       ServiceException se;
       se.errorCode = ErrorCode::SE_THRIFT_CONN_ERROR;
       se.message = "Failed to connect to compose-review-service";
-      throw se;
+      throw RequestError(se);
     }
     auto compose_client = compose_client_wrapper->GetClient();
     bool success = false;
@@ -94,21 +93,21 @@ namespace media_service
         if (retry_count > 0)
         {
           // Remove the problematic client from the pool and try to get a new one
-          _compose_client_pool->Remove(compose_client_wrapper);
-          compose_client_wrapper = _compose_client_pool->Pop();
+          _compose_client_pool->Remove(req_id, compose_client_wrapper);
+          compose_client_wrapper = _compose_client_pool->Pop(req_id);
           if (!compose_client_wrapper)
           {
             ServiceException se;
             se.errorCode = ErrorCode::SE_THRIFT_CONN_ERROR;
             se.message = "Failed to reconnect to compose-review-service";
-            throw se;
+            throw RequestError(se);
           }
           compose_client = compose_client_wrapper->GetClient();
         }
         else
         {
           // If no retries left, push back the client and rethrow the exception
-          _compose_client_pool->Push(compose_client_wrapper);
+          _compose_client_pool->Push(req_id, compose_client_wrapper);
           LOG(error) << "Failed to upload text to compose-review-service after retries";
           throw;
         }
@@ -117,20 +116,20 @@ namespace media_service
       {
         // Catch other standard exceptions and log them
         LOG(error) << "Standard exception: " << e.what();
-        _compose_client_pool->Push(compose_client_wrapper);
+        _compose_client_pool->Push(req_id, compose_client_wrapper);
         throw;
       }
       catch (...)
       {
         // Catch any other exceptions and log them
         LOG(error) << "Unknown exception caught";
-        _compose_client_pool->Push(compose_client_wrapper);
+        _compose_client_pool->Push(req_id, compose_client_wrapper);
         throw;
       }
     }
-    _compose_client_pool->Push(compose_client_wrapper);
+    _compose_client_pool->Push(req_id, compose_client_wrapper);
 
-    span->Finish();
+    span.Finish();
   }
 
 } // namespace media_service
@@ -0,0 +1,585 @@
+#ifndef MEDIA_MICROSERVICES_THRIFTASYNCCLIENT_H
+#define MEDIA_MICROSERVICES_THRIFTASYNCCLIENT_H
+
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <thrift/protocol/TBinaryProtocol.h>
+#include <thrift/protocol/TProtocolException.h>
+#include <thrift/transport/TSocket.h>
+#include <thrift/transport/TTransportException.h>
+#include <thrift/transport/TTransportUtils.h>
+#include <thrift/transport/TVirtualTransport.h>
+#include "RequestBreakdown.h"
+#include "logger.h"
+
+// Number of connections a call is tried on before a failure to send it is
+// handed back to the caller. Only sends that wrote nothing are tried again.
+#define THRIFT_ASYNC_CALL_ATTEMPTS 3
+// Used when a service has no "async_client" section in service-config.json.
+// A slow reply holds up every call pipelined behind it on its connection,
+// so the connections per backend bound that head-of-line blocking.
+#define THRIFT_ASYNC_DEFAULT_CONNECTIONS 8
+#define THRIFT_ASYNC_DEFAULT_TIMEOUT_MS 1000
+
+namespace media_service
+{
+
+  using apache::thrift::TException;
+  using apache::thrift::protocol::TBinaryProtocol;
+  using apache::thrift::protocol::TProtocol;
+  using apache::thrift::protocol::TProtocolException;
+  using apache::thrift::transport::TFramedTransport;
+  using apache::thrift::transport::TSocket;
+  using apache::thrift::transport::TTransport;
+  using apache::thrift::transport::TTransportException;
+  using apache::thrift::transport::TVirtualTransport;
+
+  // Sits between the framed transport and the socket of a pipelined
+  // connection and adds the bytes of each call to counters of that call.
+  // Writes come from the thread sending the call and reads from the
+  // completion thread, so each side points its own counter at the call it
+  // is working on. It also notes whether a send reached the socket at all.
+  class AsyncCountingTransport
+      : public TVirtualTransport<AsyncCountingTransport>
+  {
+  public:
+    explicit AsyncCountingTransport(std::shared_ptr<TTransport> socket)
+        : _socket(std::move(socket)) {}
+
+    bool isOpen() override { return _socket->isOpen(); }
+    bool peek() override { return _socket->peek(); }
+    void open() override { _socket->open(); }
+    void close() override { _socket->close(); }
+    void flush() override { _socket->flush(); }
+    const std::string getOrigin() override { return _socket->getOrigin(); }
+
+    uint32_t read(uint8_t *buf, uint32_t len)
+    {
+      uint32_t n = _socket->read(buf, len);
+      if (_received)
+      {
+        _received->fetch_add(n, std::memory_order_relaxed);
+      }
+      return n;
+    }
+
+    void write(const uint8_t *buf, uint32_t len)
+    {
+      _write_started = true;
+      _socket->write(buf, len);
+      if (_sent)
+      {
+        _sent->fetch_add(len, std::memory_order_relaxed);
+      }
+    }
+
+    void CountSent(std::atomic<uint64_t> *sent)
+    {
+      _sent = sent;
+      _write_started = false;
+    }
+    // Whether the send since the last CountSent() passed any bytes to the
+    // socket. If it did, the server may have the call even though the write
+    // failed.
+    bool WriteStarted() const { return _write_started; }
+    void CountReceived(std::atomic<uint64_t> *received)
+    {
+      _received = received;
+    }
+
+  private:
+    std::shared_ptr<TTransport> _socket;
+    std::atomic<uint64_t> *_sent = nullptr;
+    std::atomic<uint64_t> *_received = nullptr;
+    bool _write_started = false;
+  };
+
+  /*
+   * Pipelines many outstanding calls over a few connections to one service.
+   * TThriftClient is the generated *ConcurrentClient, whose send_X() returns
+   * the sequence id that recv_X() later waits for.
+   *
+   * Call() sends the request on the caller's thread, on the connection with
+   * the fewest calls in flight, and returns a future. A completion thread per
+   * connection reads the replies. The servers handle the calls of a
+   * connection one at a time, so replies come back in the order the calls
+   * were sent and the completion thread reads them first-in first-out.
+   *
+   * A transport or protocol error leaves the stream out of sync, so it fails
+   * the whole connection while the completion thread reconnects with
+   * exponential backoff. A call that was written may already have run on the
+   * server, and some of them (StoreReview, UploadUserReview, ...) are not
+   * idempotent, so the calls in flight on the connection fail with the
+   * transport error rather than being sent again. Only a send that wrote
+   * nothing to the socket moves on to another connection, up to
+   * THRIFT_ASYNC_CALL_ATTEMPTS times. Exceptions declared by the service
+   * fail only their own call.
+   *
+   * Senders write under send_mtx, not under the mutex the completion thread
+   * waits on, so a slow write does not hold up the reading of replies.
+   *
+   * The reply is read on the completion thread, which does not work on the
+   * caller's request. The future's get() therefore runs on the caller's thread
+   * instead: its wait counts as REQUEST_PHASE_THRIFT of the request, and the
+   * bytes the call sent and received are added to the request there.
+   */
+  template <class TThriftClient>
+  class ThriftAsyncClient
+  {
+  public:
+    using SendFn = std::function<int32_t(TThriftClient *)>;
+
+    ThriftAsyncClient(const std::string &client_type, const std::string &addr,
+                      int port, int num_connections, int timeout_ms);
+    ~ThriftAsyncClient();
+
+    ThriftAsyncClient(const ThriftAsyncClient &) = delete;
+    ThriftAsyncClient &operator=(const ThriftAsyncClient &) = delete;
+
+    // send may run more than once and after the caller stopped waiting on
+    // the future, so it must not capture anything by reference.
+    template <class TResult>
+    std::future<TResult> Call(
+        SendFn send,
+        std::function<void(TThriftClient *, int32_t, TResult &)> recv);
+    std::future<void> Call(
+        SendFn send, std::function<void(TThriftClient *, int32_t)> recv);
+
+    int InFlight() const;
+
+  private:
+    struct Request
+    {
+      SendFn send;
+      // Reads the reply and completes the future; throws what recv_X throws.
+      std::function<void(TThriftClient *, int32_t)> complete;
+      std::function<void(std::exception_ptr)> fail;
+      int attempts_left;
+      // Of all attempts, see AsyncCountingTransport.
+      std::atomic<uint64_t> bytes_sent{0};
+      std::atomic<uint64_t> bytes_received{0};
+    };
+
+    struct Connection
+    {
+      std::shared_ptr<TSocket> socket;
+      std::shared_ptr<TTransport> transport;
+      std::shared_ptr<AsyncCountingTransport> counting;
+      std::unique_ptr<TThriftClient> client;
+      std::atomic<bool> connected{false};
+      std::atomic<int> in_flight{0};
+      std::deque<std::pair<int32_t, std::shared_ptr<Request>>> pending;
+      // Serializes senders and guards the protocol stack against _Connect().
+      // Taken before mtx when both are needed.
+      std::mutex send_mtx;
+      // Guards pending and the wakeups of the completion thread.
+      std::mutex mtx;
+      std::condition_variable cv;
+      std::thread completer;
+    };
+
+    template <class TResult>
+    static std::future<TResult> _Collect(std::future<TResult> future,
+                                         std::shared_ptr<Request> request);
+    void _Submit(const std::shared_ptr<Request> &request);
+    Connection *_PickConnection();
+    bool _Connect(Connection *conn);
+    void _Shutdown(Connection *conn);
+    void _CompleterLoop(Connection *conn);
+
+    std::string _client_type;
+    std::string _addr;
+    int _port;
+    int _timeout_ms;
+    std::vector<std::unique_ptr<Connection>> _connections;
+    std::atomic<unsigned> _next_connection{0};
+    std::atomic<bool> _stop{false};
+  };
+
+  // Bounds of the reconnect backoff of a broken connection.
+  constexpr std::chrono::milliseconds THRIFT_ASYNC_MIN_BACKOFF(100);
+  constexpr std::chrono::milliseconds THRIFT_ASYNC_MAX_BACKOFF(5000);
+
+  template <class TThriftClient>
+  ThriftAsyncClient<TThriftClient>::ThriftAsyncClient(
+      const std::string &client_type, const std::string &addr, int port,
+      int num_connections, int timeout_ms)
+  {
+    _client_type = client_type;
+    _addr = addr;
+    _port = port;
+    _timeout_ms = timeout_ms;
+    for (int i = 0; i < std::max(num_connections, 1); ++i)
+    {
+      _connections.emplace_back(new Connection());
+    }
+    for (auto &conn : _connections)
+    {
+      conn->completer = std::thread(
+          &ThriftAsyncClient<TThriftClient>::_CompleterLoop, this, conn.get());
+    }
+  }
+
+  template <class TThriftClient>
+  ThriftAsyncClient<TThriftClient>::~ThriftAsyncClient()
+  {
+    _stop = true;
+    for (auto &conn : _connections)
+    {
+      {
+        std::lock_guard<std::mutex> lock(conn->mtx);
+        // Unblocks a completion thread waiting for a reply.
+        _Shutdown(conn.get());
+      }
+      conn->cv.notify_all();
+    }
+    for (auto &conn : _connections)
+    {
+      conn->completer.join();
+      for (auto &entry : conn->pending)
+      {
+        entry.second->fail(std::make_exception_ptr(TTransportException(
+            TTransportException::NOT_OPEN, _client_type + " client shut down")));
+      }
+      if (conn->transport)
+      {
+        conn->transport->close();
+      }
+    }
+  }
+
+  template <class TThriftClient>
+  template <class TResult>
+  std::future<TResult> ThriftAsyncClient<TThriftClient>::Call(
+      SendFn send,
+      std::function<void(TThriftClient *, int32_t, TResult &)> recv)
+  {
+    auto promise = std::make_shared<std::promise<TResult>>();
+    auto request = std::make_shared<Request>();
+    request->send = std::move(send);
+    request->complete = [promise, recv](TThriftClient *client, int32_t seqid)
+    {
+      TResult result;
+      recv(client, seqid, result);
+      promise->set_value(std::move(result));
+    };
+    request->fail = [promise](std::exception_ptr error)
+    {
+      promise->set_exception(error);
+    };
+    request->attempts_left = THRIFT_ASYNC_CALL_ATTEMPTS;
+    auto future = promise->get_future();
+    _Submit(request);
+    return _Collect(std::move(future), request);
+  }
+
+  template <class TThriftClient>
+  std::future<void> ThriftAsyncClient<TThriftClient>::Call(
+      SendFn send, std::function<void(TThriftClient *, int32_t)> recv)
+  {
+    auto promise = std::make_shared<std::promise<void>>();
+    auto request = std::make_shared<Request>();
+    request->send = std::move(send);
+    request->complete = [promise, recv](TThriftClient *client, int32_t seqid)
+    {
+      recv(client, seqid);
+      promise->set_value();
+    };
+    request->fail = [promise](std::exception_ptr error)
+    {
+      promise->set_exception(error);
+    };
+    request->attempts_left = THRIFT_ASYNC_CALL_ATTEMPTS;
+    auto future = promise->get_future();
+    _Submit(request);
+    return _Collect(std::move(future), request);
+  }
+
+  // A deferred future, so that its get() runs on the thread of the caller,
+  // which is working on the request that made the call.
+  template <class TThriftClient>
+  template <class TResult>
+  std::future<TResult> ThriftAsyncClient<TThriftClient>::_Collect(
+      std::future<TResult> future, std::shared_ptr<Request> request)
+  {
+    return std::async(
+        std::launch::deferred,
+        [future = std::move(future), request]() mutable -> TResult
+        {
+          {
+            PhaseTimer timer(REQUEST_PHASE_THRIFT);
+            future.wait();
+          }
+          RecordBackendBytes(
+              REQUEST_PHASE_THRIFT,
+              request->bytes_sent.load(std::memory_order_relaxed),
+              request->bytes_received.load(std::memory_order_relaxed));
+          return future.get();
+        });
+  }
+
+  template <class TThriftClient>
+  int ThriftAsyncClient<TThriftClient>::InFlight() const
+  {
+    int in_flight = 0;
+    for (auto &conn : _connections)
+    {
+      in_flight += conn->in_flight.load();
+    }
+    return in_flight;
+  }
+
+  template <class TThriftClient>
+  typename ThriftAsyncClient<TThriftClient>::Connection *
+  ThriftAsyncClient<TThriftClient>::_PickConnection()
+  {
+    // Least loaded healthy connection; the rotating start spreads ties.
+    size_t num_connections = _connections.size();
+    size_t start = _next_connection.fetch_add(1) % num_connections;
+    Connection *best = nullptr;
+    for (size_t i = 0; i < num_connections; ++i)
+    {
+      Connection *conn = _connections[(start + i) % num_connections].get();
+      if (conn->connected.load() &&
+          (!best || conn->in_flight.load() < best->in_flight.load()))
+      {
+        best = conn;
+      }
+    }
+    return best;
+  }
+
+  template <class TThriftClient>
+  void ThriftAsyncClient<TThriftClient>::_Submit(
+      const std::shared_ptr<Request> &request)
+  {
+    while (true)
+    {
+      Connection *conn = _stop.load() ? nullptr : _PickConnection();
+      if (!conn)
+      {
+        LOG(error) << "Failed to connect " << _client_type
+                   << ": no connection is up";
+        request->fail(std::make_exception_ptr(TTransportException(
+            TTransportException::NOT_OPEN,
+            "No connection to " + _client_type + " is up")));
+        return;
+      }
+
+      std::unique_lock<std::mutex> send_lock(conn->send_mtx);
+      if (!conn->connected.load())
+      {
+        continue;
+      }
+      try
+      {
+        // Only one sender writes at a time and the call is queued before the
+        // next one writes, so the pending queue is in wire order.
+        conn->counting->CountSent(&request->bytes_sent);
+        int32_t seqid = request->send(conn->client.get());
+        conn->counting->CountSent(nullptr);
+        {
+          std::lock_guard<std::mutex> lock(conn->mtx);
+          conn->pending.emplace_back(seqid, request);
+          conn->in_flight++;
+        }
+        send_lock.unlock();
+        conn->cv.notify_one();
+        return;
+      }
+      catch (const TTransportException &e)
+      {
+        bool write_started = conn->counting->WriteStarted();
+        conn->counting->CountSent(nullptr);
+        LOG(warning) << "Failed to send to " << _client_type << ": "
+                     << e.what();
+        // Breaks the connection; the completion thread fails whatever was
+        // already in flight on it and reconnects.
+        _Shutdown(conn);
+        {
+          std::lock_guard<std::mutex> lock(conn->mtx);
+          conn->connected = false;
+        }
+        send_lock.unlock();
+        conn->cv.notify_one();
+        if (write_started || --request->attempts_left <= 0)
+        {
+          request->fail(std::current_exception());
+          return;
+        }
+      }
+      catch (...)
+      {
+        conn->counting->CountSent(nullptr);
+        send_lock.unlock();
+        request->fail(std::current_exception());
+        return;
+      }
+    }
+  }
+
+  template <class TThriftClient>
+  void ThriftAsyncClient<TThriftClient>::_Shutdown(Connection *conn)
+  {
+    if (conn->socket && conn->socket->isOpen())
+    {
+      ::shutdown(conn->socket->getSocketFD(), SHUT_RDWR);
+    }
+  }
+
+  template <class TThriftClient>
+  bool ThriftAsyncClient<TThriftClient>::_Connect(Connection *conn)
+  {
+    // A concurrent client that saw a transport error refuses further calls,
+    // so every connection attempt starts from a new protocol stack.
+    auto socket = std::make_shared<TSocket>(_addr, _port);
+    socket->setKeepAlive(true);
+    socket->setConnTimeout(1000);
+    socket->setRecvTimeout(_timeout_ms);
+    socket->setSendTimeout(_timeout_ms);
+    auto counting = std::make_shared<AsyncCountingTransport>(socket);
+    std::shared_ptr<TTransport> transport =
+        std::make_shared<TFramedTransport>(counting);
+    std::shared_ptr<TProtocol> protocol =
+        std::make_shared<TBinaryProtocol>(transport);
+    try
+    {
+      transport->open();
+    }
+    catch (const TException &)
+    {
+      return false;
+    }
+
+    std::lock_guard<std::mutex> send_lock(conn->send_mtx);
+    std::lock_guard<std::mutex> lock(conn->mtx);
+    conn->socket = socket;
+    conn->transport = transport;
+    conn->counting = counting;
+    conn->client.reset(new TThriftClient(protocol));
+    conn->connected = true;
+    return true;
+  }
+
+  template <class TThriftClient>
+  void ThriftAsyncClient<TThriftClient>::_CompleterLoop(Connection *conn)
+  {
+    auto backoff = THRIFT_ASYNC_MIN_BACKOFF;
+    bool reported_down = false;
+    std::unique_lock<std::mutex> lock(conn->mtx);
+    while (!_stop.load())
+    {
+      if (!conn->connected.load())
+      {
+        // No sender is writing once send_mtx is held, so the transport can
+        // be closed and nothing is queued behind the orphans.
+        lock.unlock();
+        std::deque<std::pair<int32_t, std::shared_ptr<Request>>> orphans;
+        {
+          std::lock_guard<std::mutex> send_lock(conn->send_mtx);
+          lock.lock();
+          orphans.swap(conn->pending);
+          conn->in_flight -= static_cast<int>(orphans.size());
+          if (conn->transport)
+          {
+            conn->transport->close();
+          }
+          lock.unlock();
+        }
+
+        // These were written, so the server may have run them.
+        auto error = std::make_exception_ptr(TTransportException(
+            TTransportException::NOT_OPEN,
+            "Connection to " + _client_type + " was lost"));
+        for (auto &entry : orphans)
+        {
+          entry.second->fail(error);
+        }
+
+        if (_Connect(conn))
+        {
+          backoff = THRIFT_ASYNC_MIN_BACKOFF;
+          reported_down = false;
+          lock.lock();
+          continue;
+        }
+        if (!reported_down)
+        {
+          reported_down = true;
+          LOG(error) << "Failed to connect " << _client_type << " at "
+                     << _addr << ":" << _port << ", retrying in "
+                     << backoff.count() << " ms";
+        }
+        lock.lock();
+        conn->cv.wait_for(lock, backoff, [this]
+                          { return _stop.load(); });
+        backoff = std::min(backoff * 2, THRIFT_ASYNC_MAX_BACKOFF);
+        continue;
+      }
+
+      conn->cv.wait(lock, [this, conn]
+                    { return _stop.load() || !conn->pending.empty() ||
+                             !conn->connected.load(); });
+      if (_stop.load() || !conn->connected.load())
+      {
+        continue;
+      }
+
+      auto entry = std::move(conn->pending.front());
+      conn->pending.pop_front();
+      // Only this thread replaces the client, so it stays valid unlocked.
+      TThriftClient *client = conn->client.get();
+      AsyncCountingTransport *counting = conn->counting.get();
+      lock.unlock();
+
+      std::exception_ptr broken;
+      counting->CountReceived(&entry.second->bytes_received);
+      try
+      {
+        entry.second->complete(client, entry.first);
+      }
+      catch (const TTransportException &)
+      {
+        broken = std::current_exception();
+      }
+      catch (const TProtocolException &)
+      {
+        broken = std::current_exception();
+      }
+      catch (...)
+      {
+        entry.second->fail(std::current_exception());
+      }
+      counting->CountReceived(nullptr);
+      conn->in_flight--;
+
+      lock.lock();
+      if (broken)
+      {
+        LOG(warning) << "Connection to " << _client_type << " broke with "
+                     << conn->pending.size() + 1 << " calls in flight";
+        conn->connected = false;
+        _Shutdown(conn);
+        entry.second->fail(broken);
+      }
+    }
+  }
+
+} // namespace media_service
+
+#endif // MEDIA_MICROSERVICES_THRIFTASYNCCLIENT_H
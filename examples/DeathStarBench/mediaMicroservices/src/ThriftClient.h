@@ -1,6 +1,8 @@
 #ifndef SOCIAL_NETWORK_MICROSERVICES_THRIFTCLIENT_H
 #define SOCIAL_NETWORK_MICROSERVICES_THRIFTCLIENT_H
 
+#include <algorithm>
+#include <cstring>
 #include <string>
 #include <thread>
 #include <iostream>
@@ -8,9 +10,17 @@
 #include <thrift/protocol/TBinaryProtocol.h>
 #include <thrift/transport/TSocket.h>
 #include <thrift/transport/TTransportUtils.h>
+#include <thrift/transport/TVirtualTransport.h>
 #include <thrift/stdcxx.h>
 #include "logger.h"
 #include "GenericClient.h"
+#include "RequestBreakdown.h"
+#include "probes.h"
+
+// Receive timeout for Ping(), which runs on the pool connector thread and
+// must not hang on a half-open connection for the full request timeout.
+#define THRIFT_PING_TIMEOUT_MS 1000
+#define THRIFT_RECV_TIMEOUT_MS 30000
 
 namespace media_service
 {
@@ -21,6 +31,110 @@ namespace media_service
   using apache::thrift::transport::TFramedTransport;
   using apache::thrift::transport::TSocket;
   using apache::thrift::transport::TTransport;
+  using apache::thrift::transport::TVirtualTransport;
+
+  // Sits between the framed transport and the socket, so that the reads and
+  // writes of a call count as REQUEST_PHASE_THRIFT of the request making it,
+  // with their bytes. The framed transport writes a whole frame at once and
+  // reads the size and the body of the reply, so a call is a few timings.
+  // A call runs from its first write until the reply frame has been read
+  // and is also kept as an event of the request, named after the peer.
+  class TimedSocketTransport : public TVirtualTransport<TimedSocketTransport>
+  {
+  public:
+    TimedSocketTransport(std::shared_ptr<TTransport> socket,
+                         const std::string &peer)
+        : _socket(std::move(socket)), _peer(peer) {}
+
+    bool isOpen() override { return _socket->isOpen(); }
+    bool peek() override { return _socket->peek(); }
+    void open() override { _socket->open(); }
+    const std::string getOrigin() override { return _socket->getOrigin(); }
+
+    void close() override
+    {
+      _in_call = false;
+      _reply_header_bytes = 0;
+      _socket->close();
+    }
+
+    uint32_t read(uint8_t *buf, uint32_t len)
+    {
+      PhaseTimer timer(REQUEST_PHASE_THRIFT);
+      uint32_t n = _socket->read(buf, len);
+      RecordBackendBytes(REQUEST_PHASE_THRIFT, 0, n);
+      _ReadReply(buf, n);
+      return n;
+    }
+
+    void write(const uint8_t *buf, uint32_t len)
+    {
+      if (!_in_call)
+      {
+        _in_call = true;
+        _call_start = ReadCycles();
+      }
+      PhaseTimer timer(REQUEST_PHASE_THRIFT);
+      _socket->write(buf, len);
+      RecordBackendBytes(REQUEST_PHASE_THRIFT, len, 0);
+    }
+
+    void flush() override
+    {
+      PhaseTimer timer(REQUEST_PHASE_THRIFT);
+      _socket->flush();
+    }
+
+  private:
+    // Follows the frame of the reply through its 4-byte big-endian size.
+    void _ReadReply(const uint8_t *buf, uint32_t n)
+    {
+      while (n > 0)
+      {
+        uint32_t take;
+        if (_reply_header_bytes < sizeof(_reply_header))
+        {
+          take = std::min(n, static_cast<uint32_t>(sizeof(_reply_header)) -
+                                 _reply_header_bytes);
+          memcpy(_reply_header + _reply_header_bytes, buf, take);
+          _reply_header_bytes += take;
+          if (_reply_header_bytes < sizeof(_reply_header))
+          {
+            return;
+          }
+          _reply_remaining = static_cast<uint32_t>(_reply_header[0]) << 24 |
+                             static_cast<uint32_t>(_reply_header[1]) << 16 |
+                             static_cast<uint32_t>(_reply_header[2]) << 8 |
+                             static_cast<uint32_t>(_reply_header[3]);
+        }
+        else
+        {
+          take = std::min(n, _reply_remaining);
+          _reply_remaining -= take;
+        }
+        buf += take;
+        n -= take;
+        if (_reply_remaining == 0)
+        {
+          if (_in_call)
+          {
+            RecordEvent(REQUEST_PHASE_THRIFT, _peer.c_str(), PROBE_NO_RESULT,
+                        _call_start, ReadCycles());
+          }
+          _in_call = false;
+          _reply_header_bytes = 0;
+        }
+      }
+    }
+
+    std::shared_ptr<TTransport> _socket;
+    std::string _peer;
+    bool _in_call = false;
+    uint64_t _call_start = 0;
+    uint8_t _reply_header[4];
+    uint32_t _reply_header_bytes = 0;
+    uint32_t _reply_remaining = 0;
+  };
 
   template <class TThriftClient>
   class ThriftClient : public GenericClient
@@ -42,6 +156,7 @@ namespace media_service
     void KeepAlive() override;
     void KeepAlive(int timeout_ms) override;
     bool IsConnected() override;
+    bool Ping() override;
 
   private:
     TThriftClient *_client;
@@ -59,9 +174,11 @@ namespace media_service
     _port = port;
     _socket = std::shared_ptr<TSocket>(new TSocket(addr, port));
     _socket->setKeepAlive(true);
-    _socket->setRecvTimeout(30000); // Set receive timeout to 10 seconds
+    _socket->setConnTimeout(1000); // Bound connects made by the pool connector
+    _socket->setRecvTimeout(THRIFT_RECV_TIMEOUT_MS);
     _socket->setSendTimeout(30000); // Set send timeout to 10 seconds
-    _transport = std::shared_ptr<TTransport>(new TFramedTransport(_socket));
+    _transport = std::shared_ptr<TTransport>(new TFramedTransport(
+        std::make_shared<TimedSocketTransport>(_socket, addr)));
     _protocol = std::shared_ptr<TProtocol>(new TBinaryProtocol(_transport));
     _client = new TThriftClient(_protocol);
   }
@@ -93,6 +210,7 @@ namespace media_service
       try
       {
         _transport->open();
+        _connect_timestamp = _CurrentTimestamp();
       }
       catch (TException &tx)
       {
@@ -168,6 +286,27 @@ namespace media_service
     }
   }
 
+  template <class TThriftClient>
+  bool ThriftClient<TThriftClient>::Ping()
+  {
+    if (!IsConnected())
+    {
+      return false;
+    }
+    try
+    {
+      _socket->setRecvTimeout(THRIFT_PING_TIMEOUT_MS);
+      _client->Ping();
+      _socket->setRecvTimeout(THRIFT_RECV_TIMEOUT_MS);
+      return true;
+    }
+    catch (const TException &tx)
+    {
+      handleException(tx);
+      return false;
+    }
+  }
+
   template <class TThriftClient>
   void ThriftClient<TThriftClient>::handleException(const TException &tx)
   {
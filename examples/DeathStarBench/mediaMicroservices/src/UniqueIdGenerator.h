@@ -0,0 +1,154 @@
+#ifndef MEDIA_MICROSERVICES_UNIQUEIDGENERATOR_H
+#define MEDIA_MICROSERVICES_UNIQUEIDGENERATOR_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+// Custom Epoch (January 1, 2018 Midnight GMT = 2018-01-01T00:00:00Z)
+#define CUSTOM_EPOCH 1514764800000
+
+#define UNIQUE_ID_COUNTER_BITS 12
+#define UNIQUE_ID_TIMESTAMP_BITS 40
+#define UNIQUE_ID_MACHINE_BITS 12
+
+// Largest block NextIds() hands out at once: one millisecond worth of IDs.
+#define UNIQUE_ID_MAX_LEASE (1 << UNIQUE_ID_COUNTER_BITS)
+// How many milliseconds a burst may borrow ahead of the clock. Beyond that
+// NextIds() waits for the clock, and a new generator waits this long before
+// its first ID, so it cannot reissue IDs a predecessor with the same machine
+// ID borrowed just before it stopped.
+#define UNIQUE_ID_MAX_AHEAD_MS 8
+
+namespace media_service
+{
+
+  /*
+   * 64-bit Unique Id Generator
+   *
+   * ------------------------------------------------------------------------
+   * | 12 bit machine ID |       40-bit timestamp          | 12-bit counter |
+   * ------------------------------------------------------------------------
+   *
+   * The sign bit is cleared, so the top bit of the machine ID is dropped;
+   * this is the layout UniqueIdService and UserService have always used.
+   *
+   * The last issued (timestamp, counter) pair is kept in one atomic word and
+   * advanced with a CAS, so concurrent callers never take a lock. When more
+   * than 4096 IDs are asked for within one millisecond, the counter carries
+   * into the timestamp field: the generator borrows the next millisecond
+   * instead of wrapping around and repeating IDs, and the wall clock catches
+   * up again once the burst is over. Nothing is persisted, so the borrowing
+   * is capped at UNIQUE_ID_MAX_AHEAD_MS, and the constructor waits out that
+   * cap so a restarted process starts past every ID the old one issued.
+   *
+   * The time is the wall clock read at construction advanced by the steady
+   * clock, so a wall clock that steps backwards neither produces duplicates
+   * nor stalls NextIds() behind the cap.
+   *
+   * Because the counter carries into the timestamp, consecutive IDs are
+   * consecutive integers, and NextIds() can reserve a whole block with the
+   * same single CAS.
+   */
+  class UniqueIdGenerator
+  {
+  public:
+    explicit UniqueIdGenerator(uint16_t machine_id);
+
+    UniqueIdGenerator(const UniqueIdGenerator &) = delete;
+    UniqueIdGenerator &operator=(const UniqueIdGenerator &) = delete;
+
+    int64_t NextId();
+    // Reserves count consecutive IDs, 1 <= count <= UNIQUE_ID_MAX_LEASE, and
+    // returns the first. The caller owns [first, first + count).
+    int64_t NextIds(int count);
+
+    static int64_t Timestamp(int64_t id);
+    static int Counter(int64_t id);
+
+  private:
+    static constexpr uint64_t kStateMask =
+        (uint64_t(1) << (UNIQUE_ID_TIMESTAMP_BITS + UNIQUE_ID_COUNTER_BITS)) - 1;
+
+    uint64_t _NowMs() const;
+
+    uint64_t _machine_bits;
+    uint64_t _start_ms;
+    std::chrono::steady_clock::time_point _start;
+    // (timestamp << UNIQUE_ID_COUNTER_BITS) | counter of the last issued ID.
+    alignas(64) std::atomic<uint64_t> _state;
+  };
+
+  inline UniqueIdGenerator::UniqueIdGenerator(uint16_t machine_id)
+  {
+    uint64_t machine_mask = (uint64_t(1) << UNIQUE_ID_MACHINE_BITS) - 1;
+    _machine_bits = (uint64_t(machine_id) & machine_mask)
+                    << (UNIQUE_ID_TIMESTAMP_BITS + UNIQUE_ID_COUNTER_BITS);
+    _state.store(0);
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(UNIQUE_ID_MAX_AHEAD_MS + 1));
+    _start = std::chrono::steady_clock::now();
+    _start_ms = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch())
+            .count() -
+        CUSTOM_EPOCH);
+  }
+
+  inline uint64_t UniqueIdGenerator::_NowMs() const
+  {
+    return _start_ms + static_cast<uint64_t>(
+                           std::chrono::duration_cast<std::chrono::milliseconds>(
+                               std::chrono::steady_clock::now() - _start)
+                               .count());
+  }
+
+  inline int64_t UniqueIdGenerator::NextId()
+  {
+    return NextIds(1);
+  }
+
+  inline int64_t UniqueIdGenerator::NextIds(int count)
+  {
+    uint64_t prev = _state.load(std::memory_order_relaxed);
+    uint64_t first;
+    while (true)
+    {
+      uint64_t now_ms = _NowMs();
+      uint64_t now = now_ms << UNIQUE_ID_COUNTER_BITS;
+      // A new millisecond restarts the counter at 0; otherwise count up,
+      // letting a full counter carry into the timestamp.
+      first = now > prev ? now : prev + 1;
+      uint64_t last = first + count - 1;
+      if ((last >> UNIQUE_ID_COUNTER_BITS) > now_ms + UNIQUE_ID_MAX_AHEAD_MS)
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        prev = _state.load(std::memory_order_relaxed);
+        continue;
+      }
+      if (_state.compare_exchange_weak(prev, last, std::memory_order_relaxed))
+      {
+        break;
+      }
+    }
+    return static_cast<int64_t>((_machine_bits | (first & kStateMask)) &
+                                0x7FFFFFFFFFFFFFFFULL);
+  }
+
+  inline int64_t UniqueIdGenerator::Timestamp(int64_t id)
+  {
+    return static_cast<int64_t>(
+        (static_cast<uint64_t>(id) >> UNIQUE_ID_COUNTER_BITS) &
+        ((uint64_t(1) << UNIQUE_ID_TIMESTAMP_BITS) - 1));
+  }
+
+  inline int UniqueIdGenerator::Counter(int64_t id)
+  {
+    return static_cast<int>(static_cast<uint64_t>(id) &
+                            ((uint64_t(1) << UNIQUE_ID_COUNTER_BITS) - 1));
+  }
+
+} // namespace media_service
+
+#endif // MEDIA_MICROSERVICES_UNIQUEIDGENERATOR_H
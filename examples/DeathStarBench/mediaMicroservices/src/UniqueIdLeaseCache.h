@@ -0,0 +1,208 @@
+#ifndef MEDIA_MICROSERVICES_UNIQUEIDLEASECACHE_H
+#define MEDIA_MICROSERVICES_UNIQUEIDLEASECACHE_H
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "../gen-cpp/media_service_types.h"
+#include "ClientPool.h"
+#include "ProfiledMutex.h"
+#include "ThriftClient.h"
+#include "UniqueIdGenerator.h"
+#include "logger.h"
+
+// How long Next() waits for a refill already in flight before it leases a
+// block itself.
+#define UNIQUE_ID_LEASE_WAIT_MS 1000
+
+namespace media_service
+{
+
+  /*
+   * Hands out unique IDs from blocks leased from UniqueIdService with
+   * LeaseUniqueIds(), so a service that needs an ID per request makes one
+   * RPC per lease_size IDs instead of one per request.
+   *
+   * Two blocks are kept: the one IDs are taken from, and the next one. Once
+   * fewer than low_watermark IDs are left in the current block a refill
+   * thread leases the next one, off the request path, and Next() only
+   * blocks on the RPC if a burst drains both blocks first.
+   *
+   * TThriftClient is the generated UniqueIdServiceClient.
+   */
+  template <class TThriftClient>
+  class UniqueIdLeaseCache
+  {
+  public:
+    UniqueIdLeaseCache(ClientPool<ThriftClient<TThriftClient>> *client_pool,
+                       int lease_size, int low_watermark);
+    ~UniqueIdLeaseCache();
+
+    UniqueIdLeaseCache(const UniqueIdLeaseCache &) = delete;
+    UniqueIdLeaseCache &operator=(const UniqueIdLeaseCache &) = delete;
+
+    // Throws the ServiceException of the lease when UniqueIdService cannot
+    // be reached and no leased IDs are left.
+    int64_t Next(int64_t req_id);
+
+  private:
+    struct Block
+    {
+      int64_t next = 0;
+      int64_t end = 0;
+      int64_t Size() const { return end - next; }
+    };
+
+    Block _Lease(int64_t req_id);
+    void _RefillLoop();
+
+    ClientPool<ThriftClient<TThriftClient>> *_client_pool;
+    int _lease_size;
+    int _low_watermark;
+
+    ProfiledMutex _mtx{"unique_id_lease_cache"};
+    std::condition_variable_any _cv;
+    Block _current;
+    Block _pending;
+    bool _refill_wanted = false;
+    bool _refilling = false;
+    bool _stop = false;
+    std::thread _refill_thread;
+  };
+
+  template <class TThriftClient>
+  UniqueIdLeaseCache<TThriftClient>::UniqueIdLeaseCache(
+      ClientPool<ThriftClient<TThriftClient>> *client_pool,
+      int lease_size, int low_watermark)
+  {
+    _client_pool = client_pool;
+    _lease_size = std::max(1, std::min(lease_size, UNIQUE_ID_MAX_LEASE));
+    _low_watermark = std::max(0, std::min(low_watermark, _lease_size - 1));
+    _refill_thread = std::thread(&UniqueIdLeaseCache::_RefillLoop, this);
+  }
+
+  template <class TThriftClient>
+  UniqueIdLeaseCache<TThriftClient>::~UniqueIdLeaseCache()
+  {
+    {
+      std::lock_guard<ProfiledMutex> lock(_mtx);
+      _stop = true;
+    }
+    _cv.notify_all();
+    _refill_thread.join();
+  }
+
+  template <class TThriftClient>
+  typename UniqueIdLeaseCache<TThriftClient>::Block
+  UniqueIdLeaseCache<TThriftClient>::_Lease(int64_t req_id)
+  {
+    auto client_wrapper = _client_pool->Pop();
+    if (!client_wrapper)
+    {
+      ServiceException se;
+      se.errorCode = ErrorCode::SE_THRIFT_CONN_ERROR;
+      se.message = "Failed to connect to unique-id-service";
+      throw RequestError(se);
+    }
+    auto client = client_wrapper->GetClient();
+    Block block;
+    try
+    {
+      block.next = client->LeaseUniqueIds(
+          req_id, _lease_size, std::map<std::string, std::string>());
+    }
+    catch (const ServiceException &)
+    {
+      _client_pool->Push(client_wrapper);
+      throw;
+    }
+    catch (...)
+    {
+      _client_pool->Remove(client_wrapper);
+      LOG(error) << "Failed to lease unique IDs from unique-id-service";
+      ServiceException se;
+      se.errorCode = ErrorCode::SE_THRIFT_CONN_ERROR;
+      se.message = "Failed to lease unique IDs from unique-id-service";
+      throw RequestError(se);
+    }
+    _client_pool->Push(client_wrapper);
+    block.end = block.next + _lease_size;
+    return block;
+  }
+
+  template <class TThriftClient>
+  void UniqueIdLeaseCache<TThriftClient>::_RefillLoop()
+  {
+    std::unique_lock<ProfiledMutex> lock(_mtx);
+    while (true)
+    {
+      _cv.wait(lock, [this] { return _stop || _refill_wanted; });
+      if (_stop)
+      {
+        return;
+      }
+      _refill_wanted = false;
+      _refilling = true;
+      lock.unlock();
+      Block block;
+      try
+      {
+        block = _Lease(0);
+      }
+      catch (...)
+      {
+        // Next() leases synchronously, and reports the error, if the
+        // current block runs out before a later refill succeeds.
+      }
+      lock.lock();
+      _pending = block;
+      _refilling = false;
+      _cv.notify_all();
+    }
+  }
+
+  template <class TThriftClient>
+  int64_t UniqueIdLeaseCache<TThriftClient>::Next(int64_t req_id)
+  {
+    std::unique_lock<ProfiledMutex> lock(_mtx);
+    if (_current.Size() == 0 && _refilling)
+    {
+      _cv.wait_for(lock, std::chrono::milliseconds(UNIQUE_ID_LEASE_WAIT_MS),
+                   [this] { return !_refilling; });
+    }
+    if (_current.Size() == 0 && _pending.Size() > 0)
+    {
+      _current = _pending;
+      _pending = Block();
+    }
+    if (_current.Size() == 0)
+    {
+      lock.unlock();
+      Block block = _Lease(req_id);
+      lock.lock();
+      // Another caller may have refilled meanwhile; keep whichever block has
+      // more IDs left and drop the other, IDs are never handed out twice.
+      if (block.Size() > _current.Size())
+      {
+        _current = block;
+      }
+    }
+
+    int64_t id = _current.next++;
+    if (_current.Size() < _low_watermark && _pending.Size() == 0 &&
+        !_refilling && !_refill_wanted)
+    {
+      _refill_wanted = true;
+      _cv.notify_all();
+    }
+    return id;
+  }
+
+} // namespace media_service
+
+#endif // MEDIA_MICROSERVICES_UNIQUEIDLEASECACHE_H
@@ -3,79 +3,50 @@
 
 #include <iostream>
 #include <string>
-#include <chrono>
-#include <mutex>
-#include <sstream>
-#include <iomanip>
-#include <arpa/inet.h>
-#include <net/if.h>
-#include <sys/ioctl.h>
-#include <sys/socket.h>
 
 #include "../../gen-cpp/UniqueIdService.h"
 #include "../../gen-cpp/ComposeReviewService.h"
 #include "../../gen-cpp/media_service_types.h"
+#include "../AffinityClientPool.h"
 #include "../ClientPool.h"
 #include "../ThriftClient.h"
+#include "../UniqueIdGenerator.h"
+#include "../WorkerIdLease.h"
 #include "../logger.h"
 #include "../tracing.h"
-
-// Custom Epoch (January 1, 2018 Midnight GMT = 2018-01-01T00:00:00Z)
-#define CUSTOM_EPOCH 1514764800000
+#include "../probes.h"
 
 namespace media_service
 {
 
-  using std::chrono::duration_cast;
-  using std::chrono::milliseconds;
-  using std::chrono::system_clock;
-
-  static int64_t current_timestamp = -1;
-  static int counter = 0;
-
-  static int GetCounter(int64_t timestamp)
-  {
-    if (current_timestamp > timestamp)
-    {
-      LOG(fatal) << "Timestamps are not incremental.";
-      exit(EXIT_FAILURE);
-    }
-    if (current_timestamp == timestamp)
-    {
-      return counter++;
-    }
-    else
-    {
-      current_timestamp = timestamp;
-      counter = 0;
-      return counter++;
-    }
-  }
-
   class UniqueIdHandler : public UniqueIdServiceIf
   {
   public:
     ~UniqueIdHandler() override = default;
+
+    void Ping() override {}
     UniqueIdHandler(
-        std::mutex *,
-        const std::string &,
-        ClientPool<ThriftClient<ComposeReviewServiceClient>> *);
+        UniqueIdGenerator *,
+        const WorkerIdLease *,
+        AffinityClientPool<ThriftClient<ComposeReviewServiceClient>> *);
 
     void UploadUniqueId(int64_t, const std::map<std::string, std::string> &) override;
+    int64_t LeaseUniqueIds(int64_t, int32_t,
+                           const std::map<std::string, std::string> &) override;
 
   private:
-    std::mutex *_thread_lock;
-    std::string _machine_id;
-    ClientPool<ThriftClient<ComposeReviewServiceClient>> *_compose_client_pool;
+    UniqueIdGenerator *_id_generator;
+    const WorkerIdLease *_worker_id_lease;
+    AffinityClientPool<ThriftClient<ComposeReviewServiceClient>> *_compose_client_pool;
   };
 
   UniqueIdHandler::UniqueIdHandler(
-      std::mutex *thread_lock,
-      const std::string &machine_id,
-      ClientPool<ThriftClient<ComposeReviewServiceClient>> *compose_client_pool)
+      UniqueIdGenerator *id_generator,
+      const WorkerIdLease *worker_id_lease,
+      AffinityClientPool<ThriftClient<ComposeReviewServiceClient>> *compose_client_pool)
   {
-    _thread_lock = thread_lock;
-    _machine_id = machine_id;
+    _id_generator = id_generator;
+    _worker_id_lease = worker_id_lease;
     _compose_client_pool = compose_client_pool;
   }
 
@@ -85,54 +56,18 @@ namespace media_service
   {
 
     // Initialize a span
-    TextMapReader reader(carrier);
-    std::map<std::string, std::string> writer_text_map;
-    TextMapWriter writer(writer_text_map);
-    auto parent_span = opentracing::Tracer::Global()->Extract(reader);
-    auto span = opentracing::Tracer::Global()->StartSpan(
-        "UploadUniqueId",
-        {opentracing::ChildOf(parent_span->get())});
-    opentracing::Tracer::Global()->Inject(span->context(), writer);
+    auto span = TraceSpan::Start("UploadUniqueId", carrier);
+    RequestProbe probe(req_id, "UploadUniqueId", span.GetTraceId());
+    auto &writer_text_map = span.Carrier();
 
-    _thread_lock->lock();
-    int64_t timestamp = duration_cast<milliseconds>(
-                            system_clock::now().time_since_epoch())
-                            .count() -
-                        CUSTOM_EPOCH;
-    int counter = GetCounter(timestamp);
-    _thread_lock->unlock();
-
-    std::stringstream sstream;
-    sstream << std::hex << timestamp;
-    std::string timestamp_hex(sstream.str());
-
-    if (timestamp_hex.size() > 10)
-    {
-      timestamp_hex.erase(0, timestamp_hex.size() - 10);
-    }
-    else if (timestamp_hex.size() < 10)
+    if (_worker_id_lease && !_worker_id_lease->Valid())
     {
-      timestamp_hex = std::string(10 - timestamp_hex.size(), '0') + timestamp_hex;
-    }
-
-    // Empty the sstream buffer.
-    sstream.clear();
-    sstream.str(std::string());
-
-    sstream << std::hex << counter;
-    std::string counter_hex(sstream.str());
-
-    if (counter_hex.size() > 3)
-    {
-      counter_hex.erase(0, counter_hex.size() - 3);
-    }
-    else if (counter_hex.size() < 3)
-    {
-      counter_hex = std::string(3 - counter_hex.size(), '0') + counter_hex;
+      ServiceException se;
+      se.errorCode = ErrorCode::SE_THRIFT_HANDLER_ERROR;
+      se.message = "The worker id lease has expired";
+      throw RequestError(se);
     }
-
-    std::string review_id_str = _machine_id + timestamp_hex + counter_hex;
-    int64_t review_id = stoul(review_id_str, nullptr, 16) & 0x7FFFFFFFFFFFFFFF;
+    int64_t review_id = _id_generator->NextId();
     LOG(debug) << "The review_id of the request "
                << req_id << " is " << review_id;
 
@@ -153,13 +88,13 @@ namespace media_service
     // }
     // _compose_client_pool->Push(compose_client_wrapper);
 
-    auto compose_client_wrapper = _compose_client_pool->Pop();
+    auto compose_client_wrapper = _compose_client_pool->Pop(req_id);
     if (!compose_client_wrapper)
     {
       ServiceException se;
       se.errorCode = ErrorCode::SE_THRIFT_CONN_ERROR;
       se.message = "Failed to connect to compose-review-service";
-      throw se;
+      throw RequestError(se);
     }
     auto compose_client = compose_client_wrapper->GetClient();
     bool success = false;
@@ -181,21 +116,21 @@ namespace media_service
         if (retry_count > 0)
         {
           // Remove the problematic client from the pool and try to get a new one
-          _compose_client_pool->Remove(compose_client_wrapper);
-          compose_client_wrapper = _compose_client_pool->Pop();
+          _compose_client_pool->Remove(req_id, compose_client_wrapper);
+          compose_client_wrapper = _compose_client_pool->Pop(req_id);
           if (!compose_client_wrapper)
           {
             ServiceException se;
             se.errorCode = ErrorCode::SE_THRIFT_CONN_ERROR;
             se.message = "Failed to reconnect to compose-review-service";
-            throw se;
+            throw RequestError(se);
           }
           compose_client = compose_client_wrapper->GetClient();
         }
         else
         {
           // If no retries left, push back the client and rethrow the exception
-          _compose_client_pool->Push(compose_client_wrapper);
+          _compose_client_pool->Push(req_id, compose_client_wrapper);
           LOG(error) << "Failed to upload unique ID to compose-review-service after retries";
           throw;
         }
@@ -204,100 +139,55 @@ namespace media_service
       {
         // Catch other standard exceptions and log them
         LOG(error) << "Standard exception: " << e.what();
-        _compose_client_pool->Push(compose_client_wrapper);
+        _compose_client_pool->Push(req_id, compose_client_wrapper);
         throw;
       }
       catch (...)
       {
         // Catch any other exceptions and log them
         LOG(error) << "Unknown exception caught";
-        _compose_client_pool->Push(compose_client_wrapper);
+        _compose_client_pool->Push(req_id, compose_client_wrapper);
         throw;
       }
     }
-    _compose_client_pool->Push(compose_client_wrapper);
+    _compose_client_pool->Push(req_id, compose_client_wrapper);
 
-    span->Finish();
+    span.Finish();
   }
 
-  /*
-   * The following code which obtaines machine ID from machine's MAC address was
-   * inspired from https://stackoverflow.com/a/16859693.
-   */
-  u_int16_t HashMacAddressPid(const std::string &mac)
+  int64_t UniqueIdHandler::LeaseUniqueIds(
+      int64_t req_id,
+      int32_t count,
+      const std::map<std::string, std::string> &carrier)
   {
-    u_int16_t hash = 0;
-    std::string mac_pid = mac + std::to_string(getpid());
-    for (unsigned int i = 0; i < mac_pid.size(); i++)
-    {
-      hash += (mac[i] << ((i & 1) * 8));
-    }
-    return hash;
-  }
 
-  int GetMachineId(std::string *mac_hash)
-  {
-    std::string mac;
-    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
-    if (sock < 0)
-    {
-      LOG(error) << "Unable to obtain MAC address";
-      return -1;
-    }
+    // Initialize a span
+    auto span = TraceSpan::Start("LeaseUniqueIds", carrier);
+    RequestProbe probe(req_id, "LeaseUniqueIds", span.GetTraceId());
 
-    struct ifconf conf
-    {
-    };
-    char ifconfbuf[128 * sizeof(struct ifreq)];
-    memset(ifconfbuf, 0, sizeof(ifconfbuf));
-    conf.ifc_buf = ifconfbuf;
-    conf.ifc_len = sizeof(ifconfbuf);
-    if (ioctl(sock, SIOCGIFCONF, &conf))
+    if (count < 1 || count > UNIQUE_ID_MAX_LEASE)
     {
-      LOG(error) << "Unable to obtain MAC address";
-      return -1;
+      ServiceException se;
+      se.errorCode = ErrorCode::SE_THRIFT_HANDLER_ERROR;
+      se.message = "Cannot lease " + std::to_string(count) +
+                   " unique IDs; the limit is " +
+                   std::to_string(UNIQUE_ID_MAX_LEASE);
+      throw RequestError(se);
     }
 
-    struct ifreq *ifr;
-    for (
-        ifr = conf.ifc_req;
-        reinterpret_cast<char *>(ifr) <
-        reinterpret_cast<char *>(conf.ifc_req) + conf.ifc_len;
-        ifr++)
+    if (_worker_id_lease && !_worker_id_lease->Valid())
     {
-      if (ifr->ifr_addr.sa_data == (ifr + 1)->ifr_addr.sa_data)
-      {
-        continue; // duplicate, skip it
-      }
-
-      if (ioctl(sock, SIOCGIFFLAGS, ifr))
-      {
-        continue; // failed to get flags, skip it
-      }
-      if (ioctl(sock, SIOCGIFHWADDR, ifr) == 0)
-      {
-        mac = std::string(ifr->ifr_addr.sa_data);
-        if (!mac.empty())
-        {
-          break;
-        }
-      }
+      ServiceException se;
+      se.errorCode = ErrorCode::SE_THRIFT_HANDLER_ERROR;
+      se.message = "The worker id lease has expired";
+      throw RequestError(se);
     }
-    close(sock);
-
-    std::stringstream stream;
-    stream << std::hex << HashMacAddressPid(mac);
-    *mac_hash = stream.str();
+    int64_t first_id = _id_generator->NextIds(count);
+    LOG(debug) << "Leased unique IDs [" << first_id << ", "
+               << first_id + count << ") for request " << req_id;
 
-    if (mac_hash->size() > 3)
-    {
-      mac_hash->erase(0, mac_hash->size() - 3);
-    }
-    else if (mac_hash->size() < 3)
-    {
-      *mac_hash = std::string(3 - mac_hash->size(), '0') + *mac_hash;
-    }
-    return 0;
+    span.Finish();
+    return first_id;
   }
 
 } // namespace media_service
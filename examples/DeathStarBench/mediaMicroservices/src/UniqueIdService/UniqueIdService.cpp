@@ -5,7 +5,8 @@
  * | 12 bit machine ID |       40-bit timestamp          | 12-bit counter |
  * ------------------------------------------------------------------------
  *
- * 12-bit machine Id code by hasing the MAC address
+ * 12-bit machine Id leased from a shared store, or hashed from the MAC
+ * address and pid (see utils_worker_id.h)
  * 40-bit UNIX timestamp in millisecond precision with custom epoch
  * 12 bit counter which increases monotonically on single process
  *
@@ -13,18 +14,11 @@
 
 #include <signal.h>
 
-#include <thrift/server/TThreadedServer.h>
-#include <thrift/protocol/TBinaryProtocol.h>
-#include <thrift/transport/TServerSocket.h>
-#include <thrift/transport/TBufferTransports.h>
-
 #include "../utils.h"
+#include "../utils_thrift.h"
+#include "../utils_worker_id.h"
 #include "UniqueIdHandler.h"
 
-using apache::thrift::server::TThreadedServer;
-using apache::thrift::transport::TServerSocket;
-using apache::thrift::transport::TFramedTransportFactory;
-using apache::thrift::protocol::TBinaryProtocolFactory;
 using namespace media_service;
 
 void sigintHandler(int sig) {
@@ -44,29 +38,31 @@ int main(int argc, char *argv[]) {
   }
 
 //  std::string addr = config_json["UniqueIdService"]["addr"];
-  int port = config_json["unique-id-service"]["port"];
 
-  std::string compose_addr = config_json["compose-review-service"]["addr"];
-  int compose_port = config_json["compose-review-service"]["port"];
 
-  std::string machine_id;
-  if (GetMachineId(&machine_id) != 0) {
+  std::unique_ptr<WorkerIdLease> worker_id_lease;
+  uint16_t machine_id;
+  if (init_worker_id(config_json, "unique-id", &worker_id_lease,
+                     &machine_id) != 0) {
     exit(EXIT_FAILURE);
   }
 
-  std::mutex thread_lock;
-  ClientPool<ThriftClient<ComposeReviewServiceClient>> compose_client_pool(
-      "compose-review-client", compose_addr, compose_port, 0, 128, 1000);
+  UniqueIdGenerator id_generator(machine_id);
+
+  AffinityClientPool<ThriftClient<ComposeReviewServiceClient>>
+      compose_client_pool(
+          "compose-review-client",
+          get_service_replicas(config_json, "compose-review-service"),
+          0, 128, 1000);
 
-  TThreadedServer server (
+  start_observability(config_json, "unique-id-service");
+  auto server = init_thrift_server(
+      config_json, "unique-id-service",
       std::make_shared<UniqueIdServiceProcessor>(
           std::make_shared<UniqueIdHandler>(
-              &thread_lock, machine_id, &compose_client_pool)),
-      std::make_shared<TServerSocket>("0.0.0.0", port),
-      std::make_shared<TFramedTransportFactory>(),
-      std::make_shared<TBinaryProtocolFactory>()
-  );
+              &id_generator, worker_id_lease.get(),
+              &compose_client_pool)));
 
   std::cout << "Starting the unique-id-service server ..." << std::endl;
-  server.serve();
+  server->serve();
 }
@@ -9,8 +9,10 @@
 
 #include "../../gen-cpp/UserReviewService.h"
 #include "../../gen-cpp/ReviewStorageService.h"
+#include "../Executor.h"
 #include "../logger.h"
 #include "../tracing.h"
+#include "../probes.h"
 #include "../ClientPool.h"
 #include "../RedisClient.h"
 #include "../ThriftClient.h"
@@ -25,6 +27,8 @@ namespace media_service
         mongoc_client_pool_t *,
         ClientPool<ThriftClient<ReviewStorageServiceClient>> *);
     ~UserReviewHandler() override = default;
+
+    void Ping() override {}
     void UploadUserReview(int64_t, int64_t, int64_t, int64_t,
                           const std::map<std::string, std::string> &) override;
     void ReadUserReviews(std::vector<Review> &_return, int64_t req_id,
@@ -56,14 +60,8 @@ namespace media_service
   {
 
     // Initialize a span
-    TextMapReader reader(carrier);
-    std::map<std::string, std::string> writer_text_map;
-    TextMapWriter writer(writer_text_map);
-    auto parent_span = opentracing::Tracer::Global()->Extract(reader);
-    auto span = opentracing::Tracer::Global()->StartSpan(
-        "UploadUserReview",
-        {opentracing::ChildOf(parent_span->get())});
-    opentracing::Tracer::Global()->Inject(span->context(), writer);
+    auto span = TraceSpan::Start("UploadUserReview", carrier);
+    RequestProbe probe(req_id, "UploadUserReview", span.GetTraceId());
 
     mongoc_client_t *mongodb_client = mongoc_client_pool_pop(
         _mongodb_client_pool);
@@ -72,7 +70,7 @@ namespace media_service
       ServiceException se;
       se.errorCode = ErrorCode::SE_MONGODB_ERROR;
       se.message = "Failed to pop a client from MongoDB pool";
-      throw se;
+      throw RequestError(se);
     }
 
     auto collection = mongoc_client_get_collection(
@@ -83,17 +81,18 @@ namespace media_service
       se.errorCode = ErrorCode::SE_MONGODB_ERROR;
       se.message = "Failed to create collection user-review from DB user-review";
       mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
-      throw se;
+      throw RequestError(se);
     }
 
     bson_t *query = bson_new();
     BSON_APPEND_INT64(query, "user_id", user_id);
-    auto find_span = opentracing::Tracer::Global()->StartSpan(
-        "MongoFindUser", {opentracing::ChildOf(&span->context())});
+    auto find_span = span.Child("MongoFindUser");
+    CallProbe find_probe(ProbeBackend::mongo, req_id, "MongoFindUser");
     mongoc_cursor_t *cursor = mongoc_collection_find_with_opts(
         collection, query, nullptr, nullptr);
     const bson_t *doc;
     bool found = mongoc_cursor_next(cursor, &doc);
+    find_probe.End(found);
     if (!found)
     {
       bson_t *new_doc = BCON_NEW(
@@ -102,11 +101,12 @@ namespace media_service
           "[", "{", "review_id", BCON_INT64(review_id),
           "timestamp", BCON_INT64(timestamp), "}", "]");
       bson_error_t error;
-      auto insert_span = opentracing::Tracer::Global()->StartSpan(
-          "MongoInsert", {opentracing::ChildOf(&span->context())});
+      auto insert_span = span.Child("MongoInsert");
+      CallProbe insert_probe(ProbeBackend::mongo, req_id, "MongoInsert");
       bool plotinsert = mongoc_collection_insert_one(
           collection, new_doc, nullptr, nullptr, &error);
-      insert_span->Finish();
+      insert_span.Finish();
+      insert_probe.End();
       if (!plotinsert)
       {
         LOG(error) << "Failed to insert user review of user " << user_id
@@ -119,7 +119,7 @@ namespace media_service
         mongoc_cursor_destroy(cursor);
         mongoc_collection_destroy(collection);
         mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
-        throw se;
+        throw RequestError(se);
       }
       bson_destroy(new_doc);
     }
@@ -137,12 +137,13 @@ namespace media_service
           "}");
       bson_error_t error;
       bson_t reply;
-      auto update_span = opentracing::Tracer::Global()->StartSpan(
-          "MongoUpdate", {opentracing::ChildOf(&span->context())});
+      auto update_span = span.Child("MongoUpdate");
+      CallProbe update_probe(ProbeBackend::mongo, req_id, "MongoUpdate");
       bool plotupdate = mongoc_collection_find_and_modify(
           collection, query, nullptr, update, nullptr, false, false,
           true, &reply, &error);
-      update_span->Finish();
+      update_span.Finish();
+      update_probe.End();
       if (!plotupdate)
       {
         LOG(error) << "Failed to update user-review for user " << user_id
@@ -156,7 +157,7 @@ namespace media_service
         mongoc_cursor_destroy(cursor);
         mongoc_collection_destroy(collection);
         mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
-        throw se;
+        throw RequestError(se);
       }
       bson_destroy(update);
       bson_destroy(&reply);
@@ -172,11 +173,11 @@ namespace media_service
       ServiceException se;
       se.errorCode = ErrorCode::SE_REDIS_ERROR;
       se.message = "Cannot connected to Redis server";
-      throw se;
+      throw RequestError(se);
     }
     auto redis_client = redis_client_wrapper->GetClient();
-    auto redis_span = opentracing::Tracer::Global()->StartSpan(
-        "RedisUpdate", {opentracing::ChildOf(&span->context())});
+    auto redis_span = span.Child("RedisUpdate");
+    CallProbe redis_probe(ProbeBackend::redis, req_id, "RedisUpdate");
     auto num_reviews = redis_client->zcard(std::to_string(user_id));
     redis_client->sync_commit();
     auto num_reviews_reply = num_reviews.get();
@@ -188,8 +189,9 @@ namespace media_service
       redis_client->sync_commit();
     }
     _redis_client_pool->Push(redis_client_wrapper);
-    redis_span->Finish();
-    span->Finish();
+    redis_span.Finish();
+    redis_probe.End();
+    span.Finish();
   }
 
   void UserReviewHandler::ReadUserReviews(
@@ -199,14 +201,9 @@ namespace media_service
   {
 
     // Initialize a span
-    TextMapReader reader(carrier);
-    std::map<std::string, std::string> writer_text_map;
-    TextMapWriter writer(writer_text_map);
-    auto parent_span = opentracing::Tracer::Global()->Extract(reader);
-    auto span = opentracing::Tracer::Global()->StartSpan(
-        "ReadUserReviews",
-        {opentracing::ChildOf(parent_span->get())});
-    opentracing::Tracer::Global()->Inject(span->context(), writer);
+    auto span = TraceSpan::Start("ReadUserReviews", carrier);
+    RequestProbe probe(req_id, "ReadUserReviews", span.GetTraceId());
+    auto &writer_text_map = span.Carrier();
 
     if (stop <= start || start < 0)
     {
@@ -219,20 +216,23 @@ namespace media_service
       ServiceException se;
       se.errorCode = ErrorCode::SE_REDIS_ERROR;
       se.message = "Cannot connected to Redis server";
-      throw se;
+      throw RequestError(se);
     }
     auto redis_client = redis_client_wrapper->GetClient();
-    auto redis_span = opentracing::Tracer::Global()->StartSpan(
-        "RedisFind", {opentracing::ChildOf(&span->context())});
+    auto redis_span = span.Child("RedisFind");
+    CallProbe redis_probe(ProbeBackend::redis, req_id, "RedisFind");
     auto review_ids_future = redis_client->zrevrange(
         std::to_string(user_id), start, stop - 1);
     redis_client->commit();
-    redis_span->Finish();
+    redis_span.Finish();
 
     cpp_redis::reply review_ids_reply;
     try
     {
       review_ids_reply = review_ids_future.get();
+      redis_probe.End(review_ids_reply.is_array()
+                          ? review_ids_reply.as_array().size()
+                          : 0);
     }
     catch (...)
     {
@@ -260,7 +260,7 @@ namespace media_service
         ServiceException se;
         se.errorCode = ErrorCode::SE_MONGODB_ERROR;
         se.message = "Failed to pop a client from MongoDB pool";
-        throw se;
+        throw RequestError(se);
       }
       auto collection = mongoc_client_get_collection(
           mongodb_client, "user-review", "user-review");
@@ -269,7 +269,7 @@ namespace media_service
         ServiceException se;
         se.errorCode = ErrorCode::SE_MONGODB_ERROR;
         se.message = "Failed to create collection user-review from MongoDB";
-        throw se;
+        throw RequestError(se);
       }
 
       bson_t *query = BCON_NEW("user_id", BCON_INT64(user_id));
@@ -279,13 +279,14 @@ namespace media_service
           "$slice", "[",
           BCON_INT32(0), BCON_INT32(stop),
           "]", "}", "}");
-      auto find_span = opentracing::Tracer::Global()->StartSpan(
-          "MongoFindUserReviews", {opentracing::ChildOf(&span->context())});
+      auto find_span = span.Child("MongoFindUserReviews");
+      CallProbe find_probe(ProbeBackend::mongo, req_id, "MongoFindUserReviews");
       mongoc_cursor_t *cursor = mongoc_collection_find_with_opts(
           collection, query, opts, nullptr);
-      find_span->Finish();
+      find_span.Finish();
       const bson_t *doc;
       bool found = mongoc_cursor_next(cursor, &doc);
+      find_probe.End(found);
       if (found)
       {
         bson_iter_t iter_0;
@@ -313,7 +314,7 @@ namespace media_service
           idx++;
         }
       }
-      find_span->Finish();
+      find_span.Finish();
       bson_destroy(opts);
       bson_destroy(query);
       mongoc_cursor_destroy(cursor);
@@ -344,15 +345,15 @@ namespace media_service
     //       return _return_reviews;
     //     });
 
-    std::future<std::vector<Review>> review_future = std::async(
-        std::launch::async, [&]()
+    TaskFuture<std::vector<Review>> review_future = Executor::Global().Submit(
+        [&]()
         {
         auto review_client_wrapper = _review_client_pool->Pop();
         if (!review_client_wrapper) {
             ServiceException se;
             se.errorCode = ErrorCode::SE_THRIFT_CONN_ERROR;
             se.message = "Failed to connect to review-storage-service";
-            throw se;
+            throw RequestError(se);
         }
         std::vector<Review> _return_reviews;
         auto review_client = review_client_wrapper->GetClient();
@@ -377,7 +378,7 @@ namespace media_service
                         ServiceException se;
                         se.errorCode = ErrorCode::SE_THRIFT_CONN_ERROR;
                         se.message = "Failed to reconnect to review-storage-service";
-                        throw se;
+                        throw RequestError(se);
                     }
                     review_client = review_client_wrapper->GetClient();
                 } else {
@@ -411,17 +412,18 @@ namespace media_service
         ServiceException se;
         se.errorCode = ErrorCode::SE_REDIS_ERROR;
         se.message = "Cannot connected to Redis server";
-        throw se;
+        throw RequestError(se);
       }
       redis_client = redis_client_wrapper->GetClient();
-      auto redis_update_span = opentracing::Tracer::Global()->StartSpan(
-          "RedisUpdate", {opentracing::ChildOf(&span->context())});
+      auto redis_update_span = span.Child("RedisUpdate");
+      CallProbe redis_update_probe(ProbeBackend::redis, req_id, "RedisUpdate");
       redis_client->del(std::vector<std::string>{std::to_string(user_id)});
       std::vector<std::string> options{"NX"};
       zadd_reply_future = redis_client->zadd(
           std::to_string(user_id), options, redis_update_map);
       redis_client->commit();
-      redis_update_span->Finish();
+      redis_update_span.Finish();
+      redis_update_probe.End();
     }
 
     try
@@ -461,7 +463,7 @@ namespace media_service
       _redis_client_pool->Push(redis_client_wrapper);
     }
 
-    span->Finish();
+    span.Finish();
   }
 
 } // namespace media_service
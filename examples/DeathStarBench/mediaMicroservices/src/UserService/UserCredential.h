@@ -0,0 +1,95 @@
+#ifndef MEDIA_MICROSERVICES_USERCREDENTIAL_H
+#define MEDIA_MICROSERVICES_USERCREDENTIAL_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "../PasswordHash.h"
+
+#define USER_CREDENTIAL_VERSION 1
+#define USER_CREDENTIAL_HEADER_SIZE 48
+#define USER_CREDENTIAL_MAX_SALT 255
+
+namespace media_service
+{
+
+  /*
+   * What Login and UploadUserWithUsername need of a user, cached in
+   * memcached as one value under <username>:credential, so that it is read
+   * in one round trip and written with one set, never half populated.
+   *
+   *   offset  size  field
+   *        0     1  version   USER_CREDENTIAL_VERSION
+   *        1     1  salt_len
+   *        2     6  reserved, 0
+   *        8     8  user_id   little-endian
+   *       16    32  password  SHA-256(password + salt), binary
+   *       48     n  salt      salt_len bytes
+   *
+   * A value of another version or length decodes as a miss and is
+   * overwritten from MongoDB.
+   */
+  struct UserCredential
+  {
+    int64_t user_id = 0;
+    PasswordDigest password;
+    std::string salt;
+  };
+
+  inline std::string UserCredentialKey(const std::string &username)
+  {
+    return username + ":credential";
+  }
+
+  // Returns false if the salt does not fit into the record.
+  inline bool EncodeUserCredential(const UserCredential &credential,
+                                   std::string *out)
+  {
+    if (credential.salt.size() > USER_CREDENTIAL_MAX_SALT)
+    {
+      return false;
+    }
+    out->assign(USER_CREDENTIAL_HEADER_SIZE + credential.salt.size(), '\0');
+    char *data = &(*out)[0];
+    data[0] = USER_CREDENTIAL_VERSION;
+    data[1] = static_cast<char>(credential.salt.size());
+    uint64_t user_id = static_cast<uint64_t>(credential.user_id);
+    for (int i = 0; i < 8; i++)
+    {
+      data[8 + i] = static_cast<char>(user_id >> (8 * i));
+    }
+    memcpy(data + 16, credential.password.bytes, PASSWORD_DIGEST_SIZE);
+    memcpy(data + USER_CREDENTIAL_HEADER_SIZE, credential.salt.data(),
+           credential.salt.size());
+    return true;
+  }
+
+  inline bool DecodeUserCredential(const char *data, size_t len,
+                                   UserCredential *credential)
+  {
+    if (len < USER_CREDENTIAL_HEADER_SIZE ||
+        data[0] != USER_CREDENTIAL_VERSION)
+    {
+      return false;
+    }
+    size_t salt_len = static_cast<uint8_t>(data[1]);
+    if (len != USER_CREDENTIAL_HEADER_SIZE + salt_len)
+    {
+      return false;
+    }
+    uint64_t user_id = 0;
+    for (int i = 0; i < 8; i++)
+    {
+      user_id |= static_cast<uint64_t>(static_cast<uint8_t>(data[8 + i]))
+                 << (8 * i);
+    }
+    credential->user_id = static_cast<int64_t>(user_id);
+    memcpy(credential->password.bytes, data + 16, PASSWORD_DIGEST_SIZE);
+    credential->salt.assign(data + USER_CREDENTIAL_HEADER_SIZE, salt_len);
+    return true;
+  }
+
+} // namespace media_service
+
+#endif // MEDIA_MICROSERVICES_USERCREDENTIAL_H
@@ -3,7 +3,6 @@
 
 #include <iostream>
 #include <string>
-#include <random>
 #include <mongoc.h>
 #include <bson/bson.h>
 #include <libmemcached/memcached.h>
@@ -14,19 +13,35 @@
 #include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <nlohmann/json.hpp>
-#include <jwt/jwt.hpp>
 
 #include "../tracing.h"
+#include "../probes.h"
 #include "../../gen-cpp/UserService.h"
 #include "../../gen-cpp/media_service_types.h"
+#include "../AffinityClientPool.h"
 #include "../ClientPool.h"
 #include "../ThriftClient.h"
+#include "../UniqueIdGenerator.h"
+#include "../UniqueIdLeaseCache.h"
+#include "../WorkerIdLease.h"
 #include "../../gen-cpp/ComposeReviewService.h"
-#include "../../third_party/PicoSHA2/picosha2.h"
+#include "../../gen-cpp/UniqueIdService.h"
+#include "../MemcachedPool.h"
+#include "../PasswordHash.h"
+#include "../SecureRandom.h"
+#include "../LruCache.h"
+#include "../Metrics.h"
 #include "../logger.h"
+#include "UserCredential.h"
+#include "UserToken.h"
 
-// Custom Epoch (January 1, 2018 Midnight GMT = 2018-01-01T00:00:00Z)
-#define CUSTOM_EPOCH 1514764800000
+// Usernames UserService remembers the user_id of, or the absence of.
+#define USER_ID_CACHE_DEFAULT_SIZE 100000
+// How long a replica keeps believing a username is not registered.
+#define USER_ID_CACHE_DEFAULT_NEGATIVE_TTL_MS 1000
+// How long a replica keeps a user_id without asking memcached or MongoDB
+// again, which bounds how stale it gets if the user is changed elsewhere.
+#define USER_ID_CACHE_DEFAULT_POSITIVE_TTL_MS 300000
 
 namespace media_service
 {
@@ -34,59 +49,37 @@ namespace media_service
   using std::chrono::duration_cast;
   using std::chrono::milliseconds;
   using std::chrono::system_clock;
-  // using namespace jwt::params;
 
-  static int64_t current_timestamp = -1;
-  static int counter = 0;
-
-  static int GetCounter(int64_t timestamp)
+  std::string GenRandomString(const int len)
   {
-    if (current_timestamp > timestamp)
-    {
-      LOG(fatal) << "Timestamps are not incremental.";
-      exit(EXIT_FAILURE);
-    }
-    if (current_timestamp == timestamp)
-    {
-      return counter++;
-    }
-    else
-    {
-      current_timestamp = timestamp;
-      counter = 0;
-      return counter++;
-    }
+    return SecureRandom::Local().Alphanumeric(len);
   }
 
-  std::string GenRandomString(const int len)
+  inline int64_t SteadyMilliseconds()
   {
-    static const std::string alphanum =
-        "0123456789"
-        "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-        "abcdefghijklmnopqrstuvwxyz";
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<int> dist(
-        0, static_cast<int>(alphanum.length() - 1));
-    std::string s;
-    for (int i = 0; i < len; ++i)
-    {
-      s += alphanum[dist(gen)];
-    }
-    return s;
+    return duration_cast<milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
   }
 
   class UserHandler : public UserServiceIf
   {
   public:
     UserHandler(
-        std::mutex *,
-        const std::string &,
+        UniqueIdGenerator *,
+        const WorkerIdLease *,
+        UniqueIdLeaseCache<UniqueIdServiceClient> *,
         const std::string &,
         memcached_pool_st *,
         mongoc_client_pool_t *,
-        ClientPool<ThriftClient<ComposeReviewServiceClient>> *);
+        AffinityClientPool<ThriftClient<ComposeReviewServiceClient>> *,
+        size_t token_cache_size,
+        size_t user_id_cache_size,
+        int64_t user_id_negative_ttl_ms,
+        int64_t user_id_positive_ttl_ms);
     ~UserHandler() override = default;
+
+    void Ping() override {}
     void RegisterUser(
         int64_t,
         const std::string &,
@@ -112,30 +105,99 @@ namespace media_service
         const std::string &,
         const std::string &,
         const std::map<std::string, std::string> &) override;
+    int64_t VerifyToken(
+        int64_t,
+        const std::string &,
+        const std::map<std::string, std::string> &) override;
 
   private:
-    std::string _machine_id;
-    std::string _secret;
-    std::mutex *_thread_lock;
+    // The packed credential of a user in memcached; see UserCredential.h.
+    bool _GetCachedCredential(int64_t, const std::string &, const TraceSpan &,
+                              UserCredential *);
+    void _SetCachedCredential(int64_t, const std::string &, const TraceSpan &,
+                              const UserCredential &);
+    enum class UserLookup
+    {
+      not_registered,
+      // Only the user_id is set: the password or salt is missing or
+      // malformed.
+      incomplete,
+      complete
+    };
+    UserLookup _FindUser(int64_t, const std::string &, const TraceSpan &,
+                         UserCredential *);
+
+    struct UserIdCacheEntry
+    {
+      bool registered;
+      int64_t user_id;
+    };
+
+    UniqueIdGenerator *_id_generator;
+    const WorkerIdLease *_worker_id_lease;
+    UniqueIdLeaseCache<UniqueIdServiceClient> *_id_lease_cache;
+    UserTokenSigner _token_signer;
+    // Tokens that passed VerifyToken, until they expire.
+    LruCache<UserTokenClaims> _token_cache;
+    Counter *_token_cache_hits;
+    Counter *_token_cache_misses;
+    // username -> user_id, and usernames found not to be registered. A
+    // user_id never changes, so only the negative entries expire.
+    LruCache<UserIdCacheEntry> _user_id_cache;
+    int64_t _user_id_negative_ttl_ms;
+    int64_t _user_id_positive_ttl_ms;
+    Counter *_user_id_cache_hits;
+    Counter *_user_id_cache_negative_hits;
+    Counter *_user_id_cache_misses;
     memcached_pool_st *_memcached_client_pool;
     mongoc_client_pool_t *_mongodb_client_pool;
-    ClientPool<ThriftClient<ComposeReviewServiceClient>> *_compose_client_pool;
+    AffinityClientPool<ThriftClient<ComposeReviewServiceClient>> *_compose_client_pool;
   };
 
   UserHandler::UserHandler(
-      std::mutex *thread_lock,
-      const std::string &machine_id,
+      UniqueIdGenerator *id_generator,
+      const WorkerIdLease *worker_id_lease,
+      UniqueIdLeaseCache<UniqueIdServiceClient> *id_lease_cache,
       const std::string &secret,
       memcached_pool_st *memcached_client_pool,
       mongoc_client_pool_t *mongodb_client_pool,
-      ClientPool<ThriftClient<ComposeReviewServiceClient>> *compose_client_pool)
+      AffinityClientPool<ThriftClient<ComposeReviewServiceClient>> *compose_client_pool,
+      size_t token_cache_size,
+      size_t user_id_cache_size,
+      int64_t user_id_negative_ttl_ms,
+      int64_t user_id_positive_ttl_ms)
+      : _token_signer(secret),
+        _token_cache("token_cache", token_cache_size),
+        _user_id_cache("user_id_cache", user_id_cache_size),
+        _user_id_negative_ttl_ms(user_id_negative_ttl_ms),
+        _user_id_positive_ttl_ms(user_id_positive_ttl_ms)
   {
-    _thread_lock = thread_lock;
-    _machine_id = machine_id;
+    _id_generator = id_generator;
+    _worker_id_lease = worker_id_lease;
+    _id_lease_cache = id_lease_cache;
     _memcached_client_pool = memcached_client_pool;
     _mongodb_client_pool = mongodb_client_pool;
     _compose_client_pool = compose_client_pool;
-    _secret = secret;
+    _token_cache_hits = Metrics::Global().GetCounter(
+        "media_token_cache_lookups_total",
+        "VerifyToken calls by whether the token was cached.",
+        MetricLabels({{"result", "hit"}}));
+    _token_cache_misses = Metrics::Global().GetCounter(
+        "media_token_cache_lookups_total",
+        "VerifyToken calls by whether the token was cached.",
+        MetricLabels({{"result", "miss"}}));
+    _user_id_cache_hits = Metrics::Global().GetCounter(
+        "media_user_id_cache_lookups_total",
+        "UploadUserWithUsername calls by what the user_id cache held.",
+        MetricLabels({{"result", "hit"}}));
+    _user_id_cache_negative_hits = Metrics::Global().GetCounter(
+        "media_user_id_cache_lookups_total",
+        "UploadUserWithUsername calls by what the user_id cache held.",
+        MetricLabels({{"result", "negative_hit"}}));
+    _user_id_cache_misses = Metrics::Global().GetCounter(
+        "media_user_id_cache_lookups_total",
+        "UploadUserWithUsername calls by what the user_id cache held.",
+        MetricLabels({{"result", "miss"}}));
   }
 
   void UserHandler::RegisterUser(
@@ -148,55 +210,28 @@ namespace media_service
   {
 
     // Initialize a span
-    TextMapReader reader(carrier);
-    std::map<std::string, std::string> writer_text_map;
-    TextMapWriter writer(writer_text_map);
-    auto parent_span = opentracing::Tracer::Global()->Extract(reader);
-    auto span = opentracing::Tracer::Global()->StartSpan(
-        "RegisterUser",
-        {opentracing::ChildOf(parent_span->get())});
-    opentracing::Tracer::Global()->Inject(span->context(), writer);
+    auto span = TraceSpan::Start("RegisterUser", carrier);
+    RequestProbe probe(req_id, "RegisterUser", span.GetTraceId());
 
     // Compose user_id
 
-    _thread_lock->lock();
-    int64_t timestamp = duration_cast<milliseconds>(
-                            system_clock::now().time_since_epoch())
-                            .count() -
-                        CUSTOM_EPOCH;
-    int counter = GetCounter(timestamp);
-    _thread_lock->unlock();
-
-    std::stringstream sstream;
-    sstream << std::hex << timestamp;
-    std::string timestamp_hex(sstream.str());
-    if (timestamp_hex.size() > 10)
-    {
-      timestamp_hex.erase(0, timestamp_hex.size() - 10);
-    }
-    else if (timestamp_hex.size() < 10)
-    {
-      timestamp_hex =
-          std::string(10 - timestamp_hex.size(), '0') + timestamp_hex;
-    }
-
-    // Empty the sstream buffer.
-    sstream.clear();
-    sstream.str(std::string());
-
-    sstream << std::hex << counter;
-    std::string counter_hex(sstream.str());
-
-    if (counter_hex.size() > 3)
+    // With an ID lease the user_ids come from unique-id-service, in blocks.
+    int64_t user_id;
+    if (_id_lease_cache)
     {
-      counter_hex.erase(0, counter_hex.size() - 3);
+      user_id = _id_lease_cache->Next(req_id);
     }
-    else if (counter_hex.size() < 3)
+    else
     {
-      counter_hex = std::string(3 - counter_hex.size(), '0') + counter_hex;
+      if (_worker_id_lease && !_worker_id_lease->Valid())
+      {
+        ServiceException se;
+        se.errorCode = ErrorCode::SE_THRIFT_HANDLER_ERROR;
+        se.message = "The worker id lease has expired";
+        throw RequestError(se);
+      }
+      user_id = _id_generator->NextId();
     }
-    std::string user_id_str = _machine_id + timestamp_hex + counter_hex;
-    int64_t user_id = stoul(user_id_str, nullptr, 16) & 0x7FFFFFFFFFFFFFFF;
     LOG(debug) << "The user_id of the request " << req_id << " is " << user_id;
 
     mongoc_client_t *mongodb_client = mongoc_client_pool_pop(
@@ -206,7 +241,7 @@ namespace media_service
       ServiceException se;
       se.errorCode = ErrorCode::SE_MONGODB_ERROR;
       se.message = "Failed to pop a client from MongoDB pool";
-      throw se;
+      throw RequestError(se);
     }
     auto collection = mongoc_client_get_collection(
         mongodb_client, "user", "user");
@@ -230,7 +265,7 @@ namespace media_service
         ServiceException se;
         se.errorCode = ErrorCode::SE_MONGODB_ERROR;
         se.message = error.message;
-        throw se;
+        throw RequestError(se);
       }
       else
       {
@@ -242,7 +277,7 @@ namespace media_service
         mongoc_cursor_destroy(cursor);
         mongoc_collection_destroy(collection);
         mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
-        throw se;
+        throw RequestError(se);
       }
     }
     else
@@ -254,12 +289,13 @@ namespace media_service
       BSON_APPEND_UTF8(new_doc, "username", username.c_str());
       std::string salt = GenRandomString(32);
       BSON_APPEND_UTF8(new_doc, "salt", salt.c_str());
-      std::string password_hashed = picosha2::hash256_hex_string(password + salt);
+      std::string password_hashed =
+          PasswordHasher::Global().HashHex(password, salt);
       BSON_APPEND_UTF8(new_doc, "password", password_hashed.c_str());
 
       bson_error_t error;
-      auto user_insert_span = opentracing::Tracer::Global()->StartSpan(
-          "MongoInsertUser", {opentracing::ChildOf(&span->context())});
+      auto user_insert_span = span.Child("MongoInsertUser");
+      CallProbe user_insert_probe(ProbeBackend::mongo, req_id, "MongoInsertUser");
       if (!mongoc_collection_insert_one(
               collection, new_doc, nullptr, nullptr, &error))
       {
@@ -272,20 +308,23 @@ namespace media_service
         mongoc_cursor_destroy(cursor);
         mongoc_collection_destroy(collection);
         mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
-        throw se;
+        throw RequestError(se);
       }
       else
       {
         LOG(debug) << "User: " << username << " registered";
+        // Forget that this replica found the username unregistered.
+        _user_id_cache.Erase(username);
       }
-      user_insert_span->Finish();
+      user_insert_span.Finish();
+      user_insert_probe.End();
       bson_destroy(new_doc);
     }
     mongoc_cursor_destroy(cursor);
     mongoc_collection_destroy(collection);
     mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
 
-    span->Finish();
+    span.Finish();
   }
 
   void UserHandler::RegisterUserWithId(
@@ -296,14 +335,8 @@ namespace media_service
   {
 
     // Initialize a span
-    TextMapReader reader(carrier);
-    std::map<std::string, std::string> writer_text_map;
-    TextMapWriter writer(writer_text_map);
-    auto parent_span = opentracing::Tracer::Global()->Extract(reader);
-    auto span = opentracing::Tracer::Global()->StartSpan(
-        "RegisterUserWithId",
-        {opentracing::ChildOf(parent_span->get())});
-    opentracing::Tracer::Global()->Inject(span->context(), writer);
+    auto span = TraceSpan::Start("RegisterUserWithId", carrier);
+    RequestProbe probe(req_id, "RegisterUserWithId", span.GetTraceId());
 
     mongoc_client_t *mongodb_client = mongoc_client_pool_pop(
         _mongodb_client_pool);
@@ -312,7 +345,7 @@ namespace media_service
       ServiceException se;
       se.errorCode = ErrorCode::SE_MONGODB_ERROR;
       se.message = "Failed to pop a client from MongoDB pool";
-      throw se;
+      throw RequestError(se);
     }
     auto collection = mongoc_client_get_collection(
         mongodb_client, "user", "user");
@@ -336,7 +369,7 @@ namespace media_service
         ServiceException se;
         se.errorCode = ErrorCode::SE_MONGODB_ERROR;
         se.message = error.message;
-        throw se;
+        throw RequestError(se);
       }
       else
       {
@@ -348,7 +381,7 @@ namespace media_service
         mongoc_cursor_destroy(cursor);
         mongoc_collection_destroy(collection);
         mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
-        throw se;
+        throw RequestError(se);
       }
     }
     else
@@ -360,12 +393,13 @@ namespace media_service
       BSON_APPEND_UTF8(new_doc, "username", username.c_str());
       std::string salt = GenRandomString(32);
       BSON_APPEND_UTF8(new_doc, "salt", salt.c_str());
-      std::string password_hashed = picosha2::hash256_hex_string(password + salt);
+      std::string password_hashed =
+          PasswordHasher::Global().HashHex(password, salt);
       BSON_APPEND_UTF8(new_doc, "password", password_hashed.c_str());
 
       bson_error_t error;
-      auto user_insert_span = opentracing::Tracer::Global()->StartSpan(
-          "MongoInsertUser", {opentracing::ChildOf(&span->context())});
+      auto user_insert_span = span.Child("MongoInsertUser");
+      CallProbe user_insert_probe(ProbeBackend::mongo, req_id, "MongoInsertUser");
       if (!mongoc_collection_insert_one(
               collection, new_doc, nullptr, nullptr, &error))
       {
@@ -378,20 +412,23 @@ namespace media_service
         mongoc_cursor_destroy(cursor);
         mongoc_collection_destroy(collection);
         mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
-        throw se;
+        throw RequestError(se);
       }
       else
       {
         LOG(debug) << "User: " << username << " registered";
+        // Forget that this replica found the username unregistered.
+        _user_id_cache.Erase(username);
       }
-      user_insert_span->Finish();
+      user_insert_span.Finish();
+      user_insert_probe.End();
       bson_destroy(new_doc);
     }
     mongoc_cursor_destroy(cursor);
     mongoc_collection_destroy(collection);
     mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
 
-    span->Finish();
+    span.Finish();
   }
 
   void UserHandler::UploadUserWithUsername(
@@ -400,146 +437,55 @@ namespace media_service
       const std::map<std::string, std::string> &carrier)
   {
 
-    TextMapReader reader(carrier);
-    std::map<std::string, std::string> writer_text_map;
-    TextMapWriter writer(writer_text_map);
-    auto parent_span = opentracing::Tracer::Global()->Extract(reader);
-    auto span = opentracing::Tracer::Global()->StartSpan(
-        "UploadUserWithUsername",
-        {opentracing::ChildOf(parent_span->get())});
-    opentracing::Tracer::Global()->Inject(span->context(), writer);
-
-    size_t user_id_size;
-    uint32_t memcached_flags;
-
-    memcached_return_t memcached_rc;
-    memcached_st *memcached_client = memcached_pool_pop(
-        _memcached_client_pool, true, &memcached_rc);
-    if (!memcached_client)
-    {
-      ServiceException se;
-      se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
-      se.message = "Failed to pop a client from memcached pool";
-      throw se;
-    }
-
-    auto id_get_span = opentracing::Tracer::Global()->StartSpan(
-        "MmcGetUserId", {opentracing::ChildOf(&span->context())});
-    char *user_id_mmc = memcached_get(
-        memcached_client,
-        (username + ":user_id").c_str(),
-        (username + ":user_id").length(),
-        &user_id_size,
-        &memcached_flags,
-        &memcached_rc);
-    id_get_span->Finish();
-    if (!user_id_mmc && memcached_rc != MEMCACHED_NOTFOUND)
-    {
-      ServiceException se;
-      se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
-      se.message = memcached_strerror(memcached_client, memcached_rc);
-      memcached_pool_push(_memcached_client_pool, memcached_client);
-      throw se;
-    }
-    memcached_pool_push(_memcached_client_pool, memcached_client);
-
-    int64_t user_id = 0;
+    auto span = TraceSpan::Start("UploadUserWithUsername", carrier);
+    RequestProbe probe(req_id, "UploadUserWithUsername", span.GetTraceId());
+    auto &writer_text_map = span.Carrier();
 
-    if (user_id_mmc)
+    int64_t user_id;
+    UserCredential credential;
+    bool cacheable = false;
+    UserIdCacheEntry entry;
+    if (_user_id_cache.Get(username, SteadyMilliseconds(), &entry))
     {
-      LOG(debug) << "Found password, salt and ID are cached in Memcached";
-      user_id = std::stoul(user_id_mmc);
-    }
-
-    // If not cached in memcached
-    else
-    {
-      LOG(debug) << "User_id not cached in Memcached";
-      mongoc_client_t *mongodb_client = mongoc_client_pool_pop(
-          _mongodb_client_pool);
-      if (!mongodb_client)
+      if (!entry.registered)
       {
+        _user_id_cache_negative_hits->Add();
         ServiceException se;
-        se.errorCode = ErrorCode::SE_MONGODB_ERROR;
-        se.message = "Failed to pop a client from MongoDB pool";
-        free(user_id_mmc);
-        throw se;
+        se.errorCode = ErrorCode::SE_THRIFT_HANDLER_ERROR;
+        se.message = "User: " + username + " is not registered";
+        throw RequestError(se);
       }
-      auto collection = mongoc_client_get_collection(
-          mongodb_client, "user", "user");
-      if (!collection)
+      _user_id_cache_hits->Add();
+      user_id = entry.user_id;
+    }
+    else
+    {
+      _user_id_cache_misses->Add();
+      if (_GetCachedCredential(req_id, username, span, &credential))
       {
-        ServiceException se;
-        se.errorCode = ErrorCode::SE_MONGODB_ERROR;
-        se.message = "Failed to create collection user from DB user";
-        free(user_id_mmc);
-        throw se;
-      }
-      bson_t *query = bson_new();
-      BSON_APPEND_UTF8(query, "username", username.c_str());
-
-      auto find_span = opentracing::Tracer::Global()->StartSpan(
-          "MongoFindUser", {opentracing::ChildOf(&span->context())});
-      mongoc_cursor_t *cursor = mongoc_collection_find_with_opts(
-          collection, query, nullptr, nullptr);
-      const bson_t *doc;
-      bool found = mongoc_cursor_next(cursor, &doc);
-      find_span->Finish();
-
-      if (!found)
-      {
-        bson_error_t error;
-        if (mongoc_cursor_error(cursor, &error))
-        {
-          LOG(warning) << error.message;
-          mongoc_collection_destroy(collection);
-          mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
-          ServiceException se;
-          se.errorCode = ErrorCode::SE_MONGODB_ERROR;
-          se.message = error.message;
-          free(user_id_mmc);
-          throw se;
-        }
-        else
-        {
-          LOG(warning) << "User: " << username << " doesn't exist in MongoDB";
-          mongoc_collection_destroy(collection);
-          mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
-          ServiceException se;
-          se.errorCode = ErrorCode::SE_THRIFT_HANDLER_ERROR;
-          se.message = "User: " + username + " is not registered";
-          free(user_id_mmc);
-          throw se;
-        }
+        LOG(debug) << "Found the user_id of user " << username
+                   << " in Memcached";
       }
+
+      // If not cached in memcached
       else
       {
-        LOG(debug) << "User: " << username << " found in MongoDB";
-        bson_iter_t iter;
-        if (bson_iter_init_find(&iter, doc, "user_id"))
-        {
-          user_id = bson_iter_value(&iter)->value.v_int64;
-        }
-        else
+        LOG(debug) << "User_id not cached in Memcached";
+        UserLookup lookup = _FindUser(req_id, username, span, &credential);
+        if (lookup == UserLookup::not_registered)
         {
-          LOG(error) << "user_id attribute of user "
-                     << username << " was not found in the User object";
-          bson_destroy(query);
-          mongoc_cursor_destroy(cursor);
-          mongoc_collection_destroy(collection);
-          mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
+          _user_id_cache.Put(username, UserIdCacheEntry{false, 0},
+                             SteadyMilliseconds() + _user_id_negative_ttl_ms);
           ServiceException se;
           se.errorCode = ErrorCode::SE_THRIFT_HANDLER_ERROR;
-          se.message = "user_id attribute of user: " + username +
-                       " was not found in the User object";
-          free(user_id_mmc);
-          throw se;
+          se.message = "User: " + username + " is not registered";
+          throw RequestError(se);
         }
+        cacheable = lookup == UserLookup::complete;
       }
-      bson_destroy(query);
-      mongoc_cursor_destroy(cursor);
-      mongoc_collection_destroy(collection);
-      mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
+      user_id = credential.user_id;
+      _user_id_cache.Put(username, UserIdCacheEntry{true, user_id},
+                         SteadyMilliseconds() + _user_id_positive_ttl_ms);
     }
 
     // if (user_id) {
@@ -563,13 +509,13 @@ namespace media_service
 
     if (user_id)
     {
-      auto compose_client_wrapper = _compose_client_pool->Pop();
+      auto compose_client_wrapper = _compose_client_pool->Pop(req_id);
       if (!compose_client_wrapper)
       {
         ServiceException se;
         se.errorCode = ErrorCode::SE_THRIFT_CONN_ERROR;
         se.message = "Failed to connect to compose-review-service";
-        throw se;
+        throw RequestError(se);
       }
       auto compose_client = compose_client_wrapper->GetClient();
       bool success = false;
@@ -591,21 +537,21 @@ namespace media_service
           if (retry_count > 0)
           {
             // Remove the problematic client from the pool and try to get a new one
-            _compose_client_pool->Remove(compose_client_wrapper);
-            compose_client_wrapper = _compose_client_pool->Pop();
+            _compose_client_pool->Remove(req_id, compose_client_wrapper);
+            compose_client_wrapper = _compose_client_pool->Pop(req_id);
             if (!compose_client_wrapper)
             {
               ServiceException se;
               se.errorCode = ErrorCode::SE_THRIFT_CONN_ERROR;
               se.message = "Failed to reconnect to compose-review-service";
-              throw se;
+              throw RequestError(se);
             }
             compose_client = compose_client_wrapper->GetClient();
           }
           else
           {
             // If no retries left, push back the client and rethrow the exception
-            _compose_client_pool->Push(compose_client_wrapper);
+            _compose_client_pool->Push(req_id, compose_client_wrapper);
             LOG(error) << "Failed to upload user_id to compose-review-service after retries";
             throw;
           }
@@ -614,57 +560,26 @@ namespace media_service
         {
           // Catch other standard exceptions and log them
           LOG(error) << "Standard exception: " << e.what();
-          _compose_client_pool->Push(compose_client_wrapper);
+          _compose_client_pool->Push(req_id, compose_client_wrapper);
           throw;
         }
         catch (...)
         {
           // Catch any other exceptions and log them
           LOG(error) << "Unknown exception caught";
-          _compose_client_pool->Push(compose_client_wrapper);
+          _compose_client_pool->Push(req_id, compose_client_wrapper);
           throw;
         }
       }
-      _compose_client_pool->Push(compose_client_wrapper);
-    }
-
-    memcached_client = memcached_pool_pop(
-        _memcached_client_pool, true, &memcached_rc);
-    if (!memcached_client)
-    {
-      ServiceException se;
-      se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
-      se.message = "Failed to pop a client from memcached pool";
-      free(user_id_mmc);
-      throw se;
+      _compose_client_pool->Push(req_id, compose_client_wrapper);
     }
 
-    if (user_id && !user_id_mmc)
+    if (cacheable)
     {
-      auto id_set_span = opentracing::Tracer::Global()->StartSpan(
-          "MmcSetUserId", {opentracing::ChildOf(&span->context())});
-      std::string user_id_str = std::to_string(user_id);
-      memcached_rc = memcached_set(
-          memcached_client,
-          (username + ":user_id").c_str(),
-          (username + ":user_id").length(),
-          user_id_str.c_str(),
-          user_id_str.length(),
-          static_cast<time_t>(0),
-          static_cast<uint32_t>(0));
-      id_set_span->Finish();
-      if (memcached_rc != MEMCACHED_SUCCESS)
-      {
-        LOG(warning)
-            << "Failed to set the user_id of user "
-            << username << " to Memcached: "
-            << memcached_strerror(memcached_client, memcached_rc);
-      }
+      _SetCachedCredential(req_id, username, span, credential);
     }
-    memcached_pool_push(_memcached_client_pool, memcached_client);
 
-    free(user_id_mmc);
-    span->Finish();
+    span.Finish();
   }
 
   void UserHandler::UploadUserWithUserId(
@@ -673,14 +588,9 @@ namespace media_service
       const std::map<std::string, std::string> &carrier)
   {
 
-    TextMapReader reader(carrier);
-    std::map<std::string, std::string> writer_text_map;
-    TextMapWriter writer(writer_text_map);
-    auto parent_span = opentracing::Tracer::Global()->Extract(reader);
-    auto span = opentracing::Tracer::Global()->StartSpan(
-        "UploadUserWithUserId",
-        {opentracing::ChildOf(parent_span->get())});
-    opentracing::Tracer::Global()->Inject(span->context(), writer);
+    auto span = TraceSpan::Start("UploadUserWithUserId", carrier);
+    RequestProbe probe(req_id, "UploadUserWithUserId", span.GetTraceId());
+    auto &writer_text_map = span.Carrier();
 
     // auto compose_client_wrapper = _compose_client_pool->Pop();
     // if (!compose_client_wrapper)
@@ -703,13 +613,13 @@ namespace media_service
     // }
     // _compose_client_pool->Push(compose_client_wrapper);
 
-    auto compose_client_wrapper = _compose_client_pool->Pop();
+    auto compose_client_wrapper = _compose_client_pool->Pop(req_id);
     if (!compose_client_wrapper)
     {
       ServiceException se;
       se.errorCode = ErrorCode::SE_THRIFT_CONN_ERROR;
       se.message = "Failed to connect to compose-review-service";
-      throw se;
+      throw RequestError(se);
     }
     auto compose_client = compose_client_wrapper->GetClient();
     bool success = false;
@@ -731,21 +641,21 @@ namespace media_service
         if (retry_count > 0)
         {
           // Remove the problematic client from the pool and try to get a new one
-          _compose_client_pool->Remove(compose_client_wrapper);
-          compose_client_wrapper = _compose_client_pool->Pop();
+          _compose_client_pool->Remove(req_id, compose_client_wrapper);
+          compose_client_wrapper = _compose_client_pool->Pop(req_id);
           if (!compose_client_wrapper)
           {
             ServiceException se;
             se.errorCode = ErrorCode::SE_THRIFT_CONN_ERROR;
             se.message = "Failed to reconnect to compose-review-service";
-            throw se;
+            throw RequestError(se);
           }
           compose_client = compose_client_wrapper->GetClient();
         }
         else
         {
           // If no retries left, push back the client and rethrow the exception
-          _compose_client_pool->Push(compose_client_wrapper);
+          _compose_client_pool->Push(req_id, compose_client_wrapper);
           LOG(error) << "Failed to upload user_id to compose-review-service after retries";
           throw;
         }
@@ -754,20 +664,20 @@ namespace media_service
       {
         // Catch other standard exceptions and log them
         LOG(error) << "Standard exception: " << e.what();
-        _compose_client_pool->Push(compose_client_wrapper);
+        _compose_client_pool->Push(req_id, compose_client_wrapper);
         throw;
       }
       catch (...)
       {
         // Catch any other exceptions and log them
         LOG(error) << "Unknown exception caught";
-        _compose_client_pool->Push(compose_client_wrapper);
+        _compose_client_pool->Push(req_id, compose_client_wrapper);
         throw;
       }
     }
-    _compose_client_pool->Push(compose_client_wrapper);
+    _compose_client_pool->Push(req_id, compose_client_wrapper);
 
-    span->Finish();
+    span.Finish();
   }
 
   void UserHandler::Login(
@@ -778,459 +688,303 @@ namespace media_service
       const std::map<std::string, std::string> &carrier)
   {
 
-    TextMapReader reader(carrier);
-    std::map<std::string, std::string> writer_text_map;
-    TextMapWriter writer(writer_text_map);
-    auto parent_span = opentracing::Tracer::Global()->Extract(reader);
-    auto span = opentracing::Tracer::Global()->StartSpan(
-        "Login",
-        {opentracing::ChildOf(parent_span->get())});
-    opentracing::Tracer::Global()->Inject(span->context(), writer);
-
-    size_t password_size;
-    size_t salt_size;
-    size_t user_id_size;
-    uint32_t memcached_flags;
+    auto span = TraceSpan::Start("Login", carrier);
+    RequestProbe probe(req_id, "Login", span.GetTraceId());
 
-    memcached_return_t memcached_rc;
-    memcached_st *memcached_client = memcached_pool_pop(
-        _memcached_client_pool, true, &memcached_rc);
-    if (!memcached_client)
-    {
-      ServiceException se;
-      se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
-      se.message = "Failed to pop a client from memcached pool";
-      throw se;
-    }
-
-    auto pswd_get_span = opentracing::Tracer::Global()->StartSpan(
-        "MmcGetPassword", {opentracing::ChildOf(&span->context())});
-    char *password_mmc = memcached_get(
-        memcached_client,
-        (username + ":password").c_str(),
-        (username + ":password").length(),
-        &password_size,
-        &memcached_flags,
-        &memcached_rc);
-    pswd_get_span->Finish();
-    if (!password_mmc && memcached_rc != MEMCACHED_NOTFOUND)
-    {
-      ServiceException se;
-      se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
-      se.message = memcached_strerror(memcached_client, memcached_rc);
-      memcached_pool_push(_memcached_client_pool, memcached_client);
-      throw se;
-    }
-
-    auto salt_get_span = opentracing::Tracer::Global()->StartSpan(
-        "MmcGetSalt", {opentracing::ChildOf(&span->context())});
-    char *salt_mmc = memcached_get(
-        memcached_client,
-        (username + ":salt").c_str(),
-        (username + ":salt").length(),
-        &salt_size,
-        &memcached_flags,
-        &memcached_rc);
-    salt_get_span->Finish();
-    if (!salt_mmc && memcached_rc != MEMCACHED_NOTFOUND)
-    {
-      ServiceException se;
-      se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
-      se.message = memcached_strerror(memcached_client, memcached_rc);
-      memcached_pool_push(_memcached_client_pool, memcached_client);
-      free(password_mmc);
-      throw se;
-    }
-
-    auto id_get_span = opentracing::Tracer::Global()->StartSpan(
-        "MmcGetUserId", {opentracing::ChildOf(&span->context())});
-    char *user_id_mmc = memcached_get(
-        memcached_client,
-        (username + ":user_id").c_str(),
-        (username + ":user_id").length(),
-        &user_id_size,
-        &memcached_flags,
-        &memcached_rc);
-    id_get_span->Finish();
-    if (!user_id_mmc && memcached_rc != MEMCACHED_NOTFOUND)
-    {
-      ServiceException se;
-      se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
-      se.message = memcached_strerror(memcached_client, memcached_rc);
-      memcached_pool_push(_memcached_client_pool, memcached_client);
-      free(salt_mmc);
-      free(password_mmc);
-      throw se;
-    }
-
-    memcached_pool_push(_memcached_client_pool, memcached_client);
-
-    int64_t user_id = 0;
-    const char *salt_str = nullptr;
-    const char *password_str = nullptr;
-
-    if (password_mmc && salt_mmc && user_id_mmc)
+    UserCredential credential;
+    if (_GetCachedCredential(req_id, username, span, &credential))
     {
       LOG(debug) << "Found password, salt and ID are cached in Memcached";
-      user_id = std::stoul(user_id_mmc);
-      password_str = password_mmc;
-      salt_str = salt_mmc;
     }
 
     // If not cached in memcached
     else
     {
-      LOG(debug) << "Password or salt or ID not cached in Memcached";
-      mongoc_client_t *mongodb_client = mongoc_client_pool_pop(
-          _mongodb_client_pool);
-      if (!mongodb_client)
+      LOG(debug) << "Password, salt and ID not cached in Memcached";
+      UserLookup lookup = _FindUser(req_id, username, span, &credential);
+      if (lookup == UserLookup::not_registered)
       {
         ServiceException se;
-        se.errorCode = ErrorCode::SE_MONGODB_ERROR;
-        se.message = "Failed to pop a client from MongoDB pool";
-        free(salt_mmc);
-        free(password_mmc);
-        free(user_id_mmc);
-        throw se;
+        se.errorCode = ErrorCode::SE_UNAUTHORIZED;
+        se.message = "User: " + username + " is not registered";
+        throw RequestError(se);
       }
-      auto collection = mongoc_client_get_collection(
-          mongodb_client, "user", "user");
-      if (!collection)
+      if (lookup == UserLookup::incomplete)
       {
+        LOG(error) << "Password or salt attribute of user "
+                   << username << " was not found in the User object";
         ServiceException se;
-        se.errorCode = ErrorCode::SE_MONGODB_ERROR;
-        se.message = "Failed to create collection user from DB user";
-        free(salt_mmc);
-        free(password_mmc);
-        free(user_id_mmc);
-        throw se;
-      }
-      bson_t *query = bson_new();
-      BSON_APPEND_UTF8(query, "username", username.c_str());
-
-      auto find_span = opentracing::Tracer::Global()->StartSpan(
-          "MongoFindUser", {opentracing::ChildOf(&span->context())});
-      mongoc_cursor_t *cursor = mongoc_collection_find_with_opts(
-          collection, query, nullptr, nullptr);
-      const bson_t *doc;
-      bool found = mongoc_cursor_next(cursor, &doc);
-      find_span->Finish();
-
-      if (!found)
-      {
-        bson_error_t error;
-        if (mongoc_cursor_error(cursor, &error))
-        {
-          LOG(warning) << error.message;
-          mongoc_collection_destroy(collection);
-          mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
-          ServiceException se;
-          se.errorCode = ErrorCode::SE_MONGODB_ERROR;
-          se.message = error.message;
-          free(salt_mmc);
-          free(password_mmc);
-          free(user_id_mmc);
-          throw se;
-        }
-        else
-        {
-          LOG(warning) << "User: " << username << " doesn't exist in MongoDB";
-          mongoc_collection_destroy(collection);
-          mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
-          ServiceException se;
-          se.errorCode = ErrorCode::SE_UNAUTHORIZED;
-          se.message = "User: " + username + " is not registered";
-          free(salt_mmc);
-          free(password_mmc);
-          free(user_id_mmc);
-          throw se;
-        }
+        se.errorCode = ErrorCode::SE_THRIFT_HANDLER_ERROR;
+        se.message = "Password or salt attribute of user: " + username +
+                     " was not found in the User object";
+        throw RequestError(se);
       }
-      else
-      {
-        LOG(debug) << "User: " << username << " found in MongoDB";
-        if (!password_mmc)
-        {
-          bson_iter_t iter;
-          if (bson_iter_init_find(&iter, doc, "password"))
-          {
-            password_str = bson_iter_value(&iter)->value.v_utf8.str;
-          }
-          else
-          {
-            LOG(error) << "Password attribute of user "
-                       << username << " was not found in the User object";
-            bson_destroy(query);
-            mongoc_cursor_destroy(cursor);
-            mongoc_collection_destroy(collection);
-            mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
-            ServiceException se;
-            se.errorCode = ErrorCode::SE_THRIFT_HANDLER_ERROR;
-            se.message = "Password attribute of user: " + username +
-                         " was not found in the User object";
-            free(salt_mmc);
-            free(password_mmc);
-            free(user_id_mmc);
-            throw se;
-          }
-        }
+      _SetCachedCredential(req_id, username, span, credential);
+    }
 
-        if (!salt_mmc)
-        {
-          bson_iter_t iter;
-          if (bson_iter_init_find(&iter, doc, "salt"))
-          {
-            salt_str = bson_iter_value(&iter)->value.v_utf8.str;
-          }
-          else
-          {
-            LOG(error) << "Salt attribute of user "
-                       << username << " was not found in the User object";
-            bson_destroy(query);
-            mongoc_cursor_destroy(cursor);
-            mongoc_collection_destroy(collection);
-            mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
-            ServiceException se;
-            se.errorCode = ErrorCode::SE_THRIFT_HANDLER_ERROR;
-            se.message = "Salt attribute of user: " + username +
-                         " was not found in the User object";
-            free(salt_mmc);
-            free(password_mmc);
-            free(user_id_mmc);
-            throw se;
-          }
-        }
+    if (!PasswordHasher::Global().Verify(
+            password, credential.salt.data(), credential.salt.size(),
+            credential.password))
+    {
+      ServiceException se;
+      se.errorCode = ErrorCode::SE_UNAUTHORIZED;
+      se.message = "Incorrect username or password";
+      throw RequestError(se);
+    }
 
-        if (!user_id_mmc)
-        {
-          bson_iter_t iter;
-          if (bson_iter_init_find(&iter, doc, "user_id"))
-          {
-            user_id = bson_iter_value(&iter)->value.v_int64;
-          }
-          else
-          {
-            LOG(error) << "user_Id attribute of user "
-                       << username << " was not found in the User object";
-            bson_destroy(query);
-            mongoc_cursor_destroy(cursor);
-            mongoc_collection_destroy(collection);
-            mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
-            ServiceException se;
-            se.errorCode = ErrorCode::SE_THRIFT_HANDLER_ERROR;
-            se.message = "User_id attribute of user: " + username +
-                         " was not found in the User object";
-            free(salt_mmc);
-            free(password_mmc);
-            free(user_id_mmc);
-            throw se;
-          }
-        }
-      }
+    UserTokenClaims claims;
+    claims.user_id = credential.user_id;
+    claims.timestamp = duration_cast<milliseconds>(
+                           system_clock::now().time_since_epoch())
+                           .count();
+    claims.ttl = USER_TOKEN_TTL_MS;
+    _return = _token_signer.Sign(claims);
 
-      bson_destroy(query);
-      mongoc_cursor_destroy(cursor);
-      mongoc_collection_destroy(collection);
-      mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
+    span.Finish();
+  }
+
+  int64_t UserHandler::VerifyToken(
+      int64_t req_id,
+      const std::string &token,
+      const std::map<std::string, std::string> &carrier)
+  {
+
+    auto span = TraceSpan::Start("VerifyToken", carrier);
+    RequestProbe probe(req_id, "VerifyToken", span.GetTraceId());
+
+    int64_t now = duration_cast<milliseconds>(
+                      system_clock::now().time_since_epoch())
+                      .count();
+    UserTokenClaims claims;
+    if (_token_cache.Get(token, now, &claims))
+    {
+      _token_cache_hits->Add();
+      span.Finish();
+      return claims.user_id;
     }
+    _token_cache_misses->Add();
 
-    if (user_id && salt_str && password_str)
+    UserTokenStatus status = _token_signer.Verify(token, &claims);
+    if (status != UserTokenStatus::ok)
     {
-      bool auth = picosha2::hash256_hex_string(password + std::string(salt_str)) == std::string(password_str);
-      if (auth)
-      {
-        auto user_id_str = std::to_string(user_id);
-        auto timestamp_str = std::to_string(duration_cast<milliseconds>(
-                                                system_clock::now().time_since_epoch())
-                                                .count());
-
-        jwt::jwt_object obj{
-            jwt::params::algorithm("HS256"),
-            jwt::params::secret(_secret),
-            jwt::params::payload({{"user_id", user_id_str},
-                                  {"timestamp", timestamp_str},
-                                  {"TTL", "60000"}})};
-        _return = obj.signature();
-      }
-      else
-      {
-        ServiceException se;
-        se.errorCode = ErrorCode::SE_UNAUTHORIZED;
-        se.message = "Incorrect username or password";
-        free(salt_mmc);
-        free(password_mmc);
-        free(user_id_mmc);
-        throw se;
-      }
+      ServiceException se;
+      se.errorCode = ErrorCode::SE_UNAUTHORIZED;
+      se.message = status == UserTokenStatus::bad_signature
+                       ? "Invalid token signature"
+                       : "Malformed token";
+      throw RequestError(se);
     }
+    if (claims.Expiry() <= now)
+    {
+      ServiceException se;
+      se.errorCode = ErrorCode::SE_UNAUTHORIZED;
+      se.message = "Token expired";
+      throw RequestError(se);
+    }
+    _token_cache.Put(token, claims, claims.Expiry());
+
+    span.Finish();
+    return claims.user_id;
+  }
 
-    memcached_client = memcached_pool_pop(
+  bool UserHandler::_GetCachedCredential(
+      int64_t req_id,
+      const std::string &username,
+      const TraceSpan &span,
+      UserCredential *credential)
+  {
+    memcached_return_t memcached_rc;
+    memcached_st *memcached_client = MemcachedPoolPop(
         _memcached_client_pool, true, &memcached_rc);
     if (!memcached_client)
     {
       ServiceException se;
       se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
       se.message = "Failed to pop a client from memcached pool";
-      free(salt_mmc);
-      free(password_mmc);
-      free(user_id_mmc);
-      throw se;
+      throw RequestError(se);
     }
 
-    if (salt_str && !salt_mmc)
+    std::string key = UserCredentialKey(username);
+    size_t value_size;
+    uint32_t memcached_flags;
+    auto get_span = span.Child("MmcGetCredential");
+    CallProbe get_probe(ProbeBackend::memcached, req_id, "MmcGetCredential");
+    char *value = memcached_get(
+        memcached_client,
+        key.c_str(),
+        key.length(),
+        &value_size,
+        &memcached_flags,
+        &memcached_rc);
+    get_span.Finish();
+    get_probe.AddBytes(key.length(), value ? value_size : 0);
+    get_probe.End(value != nullptr);
+    if (!value && memcached_rc != MEMCACHED_NOTFOUND)
     {
-      auto salt_set_span = opentracing::Tracer::Global()->StartSpan(
-          "MmcSetSalt", {opentracing::ChildOf(&span->context())});
-      memcached_rc = memcached_set(
-          memcached_client,
-          (username + ":salt").c_str(),
-          (username + ":salt").length(),
-          salt_str,
-          std::strlen(salt_str),
-          0,
-          0);
-      salt_set_span->Finish();
-
-      if (memcached_rc != MEMCACHED_SUCCESS)
-      {
-        LOG(warning)
-            << "Failed to set the salt of user "
-            << username << " to Memcached: "
-            << memcached_strerror(memcached_client, memcached_rc);
-      }
+      ServiceException se;
+      se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
+      se.message = memcached_strerror(memcached_client, memcached_rc);
+      MemcachedPoolPush(_memcached_client_pool, memcached_client);
+      throw RequestError(se);
     }
+    MemcachedPoolPush(_memcached_client_pool, memcached_client);
 
-    if (password_str && !password_mmc)
+    bool found = value && DecodeUserCredential(value, value_size, credential);
+    if (value && !found)
     {
-      auto pswd_set_span = opentracing::Tracer::Global()->StartSpan(
-          "MmcSetPassword", {opentracing::ChildOf(&span->context())});
-      memcached_rc = memcached_set(
-          memcached_client,
-          (username + ":password").c_str(),
-          (username + ":password").length(),
-          password_str,
-          std::strlen(password_str),
-          static_cast<time_t>(0),
-          static_cast<uint32_t>(0));
-      pswd_set_span->Finish();
-      if (memcached_rc != MEMCACHED_SUCCESS)
-      {
-        LOG(warning)
-            << "Failed to set the password of user "
-            << username << " to Memcached: "
-            << memcached_strerror(memcached_client, memcached_rc);
-      }
+      LOG(warning) << "Ignoring the malformed credential of user "
+                   << username << " in Memcached";
     }
+    free(value);
+    return found;
+  }
 
-    if (user_id && !user_id_mmc)
+  void UserHandler::_SetCachedCredential(
+      int64_t req_id,
+      const std::string &username,
+      const TraceSpan &span,
+      const UserCredential &credential)
+  {
+    std::string value;
+    if (!EncodeUserCredential(credential, &value))
     {
-      auto id_set_span = opentracing::Tracer::Global()->StartSpan(
-          "MmcSetUserId", {opentracing::ChildOf(&span->context())});
-      std::string user_id_str = std::to_string(user_id);
-      memcached_rc = memcached_set(
-          memcached_client,
-          (username + ":user_id").c_str(),
-          (username + ":user_id").length(),
-          user_id_str.c_str(),
-          user_id_str.length(),
-          static_cast<time_t>(0),
-          static_cast<uint32_t>(0));
-      id_set_span->Finish();
-      if (memcached_rc != MEMCACHED_SUCCESS)
-      {
-        LOG(warning)
-            << "Failed to set the user_id of user "
-            << username << " to Memcached: "
-            << memcached_strerror(memcached_client, memcached_rc);
-      }
+      LOG(warning) << "The salt of user " << username
+                   << " is too long to be cached";
+      return;
     }
-    memcached_pool_push(_memcached_client_pool, memcached_client);
 
-    free(salt_mmc);
-    free(password_mmc);
-    free(user_id_mmc);
-    span->Finish();
-  }
-
-  /*
-   * The following code which obtaines machine ID from machine's MAC address was
-   * inspired from https://stackoverflow.com/a/16859693.
-   */
-  u_int16_t HashMacAddressPid(const std::string &mac)
-  {
-    u_int16_t hash = 0;
-    std::string mac_pid = mac + std::to_string(getpid());
-    for (unsigned int i = 0; i < mac_pid.size(); i++)
+    memcached_return_t memcached_rc;
+    memcached_st *memcached_client = MemcachedPoolPop(
+        _memcached_client_pool, true, &memcached_rc);
+    if (!memcached_client)
     {
-      hash += (mac[i] << ((i & 1) * 8));
+      ServiceException se;
+      se.errorCode = ErrorCode::SE_MEMCACHED_ERROR;
+      se.message = "Failed to pop a client from memcached pool";
+      throw RequestError(se);
     }
-    return hash;
+
+    std::string key = UserCredentialKey(username);
+    auto set_span = span.Child("MmcSetCredential");
+    CallProbe set_probe(ProbeBackend::memcached, req_id, "MmcSetCredential");
+    memcached_rc = memcached_set(
+        memcached_client,
+        key.c_str(),
+        key.length(),
+        value.data(),
+        value.size(),
+        static_cast<time_t>(0),
+        static_cast<uint32_t>(0));
+    set_span.Finish();
+    set_probe.AddBytes(key.length() + value.size(), 0);
+    set_probe.End();
+    if (memcached_rc != MEMCACHED_SUCCESS)
+    {
+      LOG(warning)
+          << "Failed to set the credential of user "
+          << username << " to Memcached: "
+          << memcached_strerror(memcached_client, memcached_rc);
+    }
+    MemcachedPoolPush(_memcached_client_pool, memcached_client);
   }
 
-  int GetMachineId(std::string *mac_hash)
+  UserHandler::UserLookup UserHandler::_FindUser(
+      int64_t req_id,
+      const std::string &username,
+      const TraceSpan &span,
+      UserCredential *credential)
   {
-    std::string mac;
-    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
-    if (sock < 0)
+    mongoc_client_t *mongodb_client = mongoc_client_pool_pop(
+        _mongodb_client_pool);
+    if (!mongodb_client)
     {
-      LOG(error) << "Unable to obtain MAC address";
-      return -1;
+      ServiceException se;
+      se.errorCode = ErrorCode::SE_MONGODB_ERROR;
+      se.message = "Failed to pop a client from MongoDB pool";
+      throw RequestError(se);
     }
-
-    struct ifconf conf
-    {
-    };
-    char ifconfbuf[128 * sizeof(struct ifreq)];
-    memset(ifconfbuf, 0, sizeof(ifconfbuf));
-    conf.ifc_buf = ifconfbuf;
-    conf.ifc_len = sizeof(ifconfbuf);
-    if (ioctl(sock, SIOCGIFCONF, &conf))
+    auto collection = mongoc_client_get_collection(
+        mongodb_client, "user", "user");
+    if (!collection)
     {
-      LOG(error) << "Unable to obtain MAC address";
-      return -1;
+      mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
+      ServiceException se;
+      se.errorCode = ErrorCode::SE_MONGODB_ERROR;
+      se.message = "Failed to create collection user from DB user";
+      throw RequestError(se);
     }
+    bson_t *query = bson_new();
+    BSON_APPEND_UTF8(query, "username", username.c_str());
+
+    auto find_span = span.Child("MongoFindUser");
+    CallProbe find_probe(ProbeBackend::mongo, req_id, "MongoFindUser");
+    mongoc_cursor_t *cursor = mongoc_collection_find_with_opts(
+        collection, query, nullptr, nullptr);
+    const bson_t *doc;
+    bool found = mongoc_cursor_next(cursor, &doc);
+    find_span.Finish();
+    find_probe.End(found);
 
-    struct ifreq *ifr;
-    for (
-        ifr = conf.ifc_req;
-        reinterpret_cast<char *>(ifr) <
-        reinterpret_cast<char *>(conf.ifc_req) + conf.ifc_len;
-        ifr++)
+    if (!found)
     {
-      if (ifr->ifr_addr.sa_data == (ifr + 1)->ifr_addr.sa_data)
+      bson_error_t error;
+      bool failed = mongoc_cursor_error(cursor, &error);
+      bson_destroy(query);
+      mongoc_cursor_destroy(cursor);
+      mongoc_collection_destroy(collection);
+      mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
+      if (failed)
       {
-        continue; // duplicate, skip it
+        LOG(warning) << error.message;
+        ServiceException se;
+        se.errorCode = ErrorCode::SE_MONGODB_ERROR;
+        se.message = error.message;
+        throw RequestError(se);
       }
+      LOG(warning) << "User: " << username << " doesn't exist in MongoDB";
+      return UserLookup::not_registered;
+    }
 
-      if (ioctl(sock, SIOCGIFFLAGS, ifr))
-      {
-        continue; // failed to get flags, skip it
-      }
-      if (ioctl(sock, SIOCGIFHWADDR, ifr) == 0)
+    LOG(debug) << "User: " << username << " found in MongoDB";
+    bson_iter_t iter;
+    bool has_user_id = bson_iter_init_find(&iter, doc, "user_id");
+    if (has_user_id)
+    {
+      credential->user_id = bson_iter_value(&iter)->value.v_int64;
+    }
+    bool complete = false;
+    uint32_t len;
+    if (bson_iter_init_find(&iter, doc, "password") &&
+        BSON_ITER_HOLDS_UTF8(&iter))
+    {
+      const char *password_hex = bson_iter_utf8(&iter, &len);
+      if (ParsePasswordDigestHex(password_hex, len, &credential->password) &&
+          bson_iter_init_find(&iter, doc, "salt") &&
+          BSON_ITER_HOLDS_UTF8(&iter))
       {
-        mac = std::string(ifr->ifr_addr.sa_data);
-        if (!mac.empty())
-        {
-          break;
-        }
+        const char *salt = bson_iter_utf8(&iter, &len);
+        credential->salt.assign(salt, len);
+        complete = true;
       }
     }
-    close(sock);
-
-    std::stringstream stream;
-    stream << std::hex << HashMacAddressPid(mac);
-    *mac_hash = stream.str();
+    bson_destroy(query);
+    mongoc_cursor_destroy(cursor);
+    mongoc_collection_destroy(collection);
+    mongoc_client_pool_push(_mongodb_client_pool, mongodb_client);
 
-    if (mac_hash->size() > 3)
+    if (!has_user_id)
     {
-      mac_hash->erase(0, mac_hash->size() - 3);
-    }
-    else if (mac_hash->size() < 3)
-    {
-      *mac_hash = std::string(3 - mac_hash->size(), '0') + *mac_hash;
+      LOG(error) << "user_id attribute of user "
+                 << username << " was not found in the User object";
+      ServiceException se;
+      se.errorCode = ErrorCode::SE_THRIFT_HANDLER_ERROR;
+      se.message = "user_id attribute of user: " + username +
+                   " was not found in the User object";
+      throw RequestError(se);
     }
-    return 0;
+    return complete ? UserLookup::complete : UserLookup::incomplete;
   }
+
 } // namespace media_service
 
 #endif // MEDIA_MICROSERVICES_USERHANDLER_H
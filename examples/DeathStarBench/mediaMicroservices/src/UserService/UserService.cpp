@@ -1,19 +1,12 @@
-#include <thrift/protocol/TBinaryProtocol.h>
-#include <thrift/server/TThreadedServer.h>
-#include <thrift/transport/TServerSocket.h>
-#include <thrift/transport/TBufferTransports.h>
 #include <signal.h>
 
-
 #include "../utils.h"
+#include "../utils_thrift.h"
 #include "../utils_memcached.h"
 #include "../utils_mongodb.h"
+#include "../utils_worker_id.h"
 #include "UserHandler.h"
 
-using apache::thrift::server::TThreadedServer;
-using apache::thrift::transport::TServerSocket;
-using apache::thrift::transport::TFramedTransportFactory;
-using apache::thrift::protocol::TBinaryProtocolFactory;
 using media_service::UserHandler;
 using namespace media_service;
 
@@ -34,9 +27,6 @@ int main(int argc, char *argv[]) {
 
   std::string secret = config_json["secret"];
 
-  int port = config_json["user-service"]["port"];
-  std::string compose_addr = config_json["compose-review-service"]["addr"];
-  int compose_port = config_json["compose-review-service"]["port"];
 
   memcached_pool_st *memcached_client_pool =
       init_memcached_client_pool(config_json, "user", 32, 128);
@@ -47,29 +37,88 @@ int main(int argc, char *argv[]) {
     return EXIT_FAILURE;
   }
 
-  std::string machine_id;
-  if (GetMachineId(&machine_id) != 0) {
+  std::unique_ptr<WorkerIdLease> worker_id_lease;
+  uint16_t machine_id;
+  if (init_worker_id(config_json, "user", &worker_id_lease, &machine_id) != 0) {
+    exit(EXIT_FAILURE);
+  }
+
+  UniqueIdGenerator id_generator(machine_id);
+
+  json service_json = config_json["user-service"];
+  std::string password_hash =
+      service_json.value("password_hash", std::string("auto"));
+  if (!PasswordHasher::Global().SetBackend(password_hash)) {
+    LOG(fatal) << "Unknown or unsupported password_hash " << password_hash;
     exit(EXIT_FAILURE);
   }
+  LOG(info) << "Hashing passwords with "
+            << PasswordHasher::Global().BackendName();
 
-  std::mutex thread_lock;
+  // With "id_lease" enabled user_ids are leased from unique-id-service in
+  // blocks instead of being generated from this replica's machine id.
+  std::unique_ptr<ClientPool<ThriftClient<UniqueIdServiceClient>>>
+      unique_id_client_pool;
+  std::unique_ptr<UniqueIdLeaseCache<UniqueIdServiceClient>> id_lease_cache;
+  if (service_json.contains("id_lease") &&
+      service_json["id_lease"].value("enabled", false)) {
+    std::string unique_id_addr = config_json["unique-id-service"]["addr"];
+    int unique_id_port = config_json["unique-id-service"]["port"];
+    unique_id_client_pool.reset(
+        new ClientPool<ThriftClient<UniqueIdServiceClient>>(
+            "unique-id-client", unique_id_addr, unique_id_port, 0, 8, 1000));
+    id_lease_cache.reset(new UniqueIdLeaseCache<UniqueIdServiceClient>(
+        unique_id_client_pool.get(),
+        service_json["id_lease"].value("size", 1024),
+        service_json["id_lease"].value("low_watermark", 256)));
+    LOG(info) << "Leasing user_ids from unique-id-service";
+  }
+
+  // Verified tokens are remembered until they expire; "size": 0 turns the
+  // cache off.
+  size_t token_cache_size = USER_TOKEN_CACHE_DEFAULT_SIZE;
+  if (service_json.contains("token_cache")) {
+    token_cache_size = service_json["token_cache"].value(
+        "size", token_cache_size);
+  }
+
+  // A user_id is kept for positive_ttl_ms; that a username is not
+  // registered is only believed for negative_ttl_ms, since another replica
+  // may register it meanwhile.
+  size_t user_id_cache_size = USER_ID_CACHE_DEFAULT_SIZE;
+  int64_t user_id_negative_ttl_ms = USER_ID_CACHE_DEFAULT_NEGATIVE_TTL_MS;
+  int64_t user_id_positive_ttl_ms = USER_ID_CACHE_DEFAULT_POSITIVE_TTL_MS;
+  if (service_json.contains("user_id_cache")) {
+    user_id_cache_size = service_json["user_id_cache"].value(
+        "size", user_id_cache_size);
+    user_id_negative_ttl_ms = service_json["user_id_cache"].value(
+        "negative_ttl_ms", user_id_negative_ttl_ms);
+    user_id_positive_ttl_ms = service_json["user_id_cache"].value(
+        "positive_ttl_ms", user_id_positive_ttl_ms);
+  }
 
-  ClientPool<ThriftClient<ComposeReviewServiceClient>> compose_client_pool(
-      "compose-review-client", compose_addr, compose_port, 0, 128, 1000);
+  AffinityClientPool<ThriftClient<ComposeReviewServiceClient>>
+      compose_client_pool(
+          "compose-review-client",
+          get_service_replicas(config_json, "compose-review-service"),
+          0, 128, 1000);
 
-  TThreadedServer server(
+  start_observability(config_json, "user-service");
+  auto server = init_thrift_server(
+      config_json, "user-service",
       std::make_shared<UserServiceProcessor>(
           std::make_shared<UserHandler>(
-              &thread_lock,
-              machine_id,
+              &id_generator,
+              worker_id_lease.get(),
+              id_lease_cache.get(),
               secret,
               memcached_client_pool,
               mongodb_client_pool,
-              &compose_client_pool)),
-      std::make_shared<TServerSocket>("0.0.0.0", port),
-      std::make_shared<TFramedTransportFactory>(),
-      std::make_shared<TBinaryProtocolFactory>()
-  );
+              &compose_client_pool,
+              token_cache_size,
+              user_id_cache_size,
+              user_id_negative_ttl_ms,
+              user_id_positive_ttl_ms)));
   std::cout << "Starting the user-service server ..." << std::endl;
-  server.serve();
+  server->serve();
 }
\ No newline at end of file
@@ -0,0 +1,344 @@
+#ifndef MEDIA_MICROSERVICES_USERTOKEN_H
+#define MEDIA_MICROSERVICES_USERTOKEN_H
+
+#include <cerrno>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <nlohmann/json.hpp>
+#include <openssl/crypto.h>
+#include <openssl/sha.h>
+
+#define HMAC_SHA256_SIZE 32
+// Lifetime of the tokens Login issues.
+#define USER_TOKEN_TTL_MS 60000
+// Tokens UserService keeps verified by default.
+#define USER_TOKEN_CACHE_DEFAULT_SIZE 65536
+
+namespace media_service
+{
+
+  /*
+   * HMAC-SHA256 with the key absorbed once: the SHA-256 states after the
+   * inner and outer key pads are kept, so a MAC costs copying them plus the
+   * compressions of the message, instead of rehashing the key every time.
+   */
+  class HmacSha256
+  {
+  public:
+    explicit HmacSha256(const std::string &key)
+    {
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+      uint8_t block[SHA256_CBLOCK] = {0};
+      if (key.size() > SHA256_CBLOCK)
+      {
+        SHA256(reinterpret_cast<const uint8_t *>(key.data()), key.size(),
+               block);
+      }
+      else
+      {
+        memcpy(block, key.data(), key.size());
+      }
+      uint8_t pad[SHA256_CBLOCK];
+      for (int i = 0; i < SHA256_CBLOCK; i++)
+      {
+        pad[i] = block[i] ^ 0x36;
+      }
+      SHA256_Init(&_inner);
+      SHA256_Update(&_inner, pad, sizeof(pad));
+      for (int i = 0; i < SHA256_CBLOCK; i++)
+      {
+        pad[i] = block[i] ^ 0x5c;
+      }
+      SHA256_Init(&_outer);
+      SHA256_Update(&_outer, pad, sizeof(pad));
+      OPENSSL_cleanse(block, sizeof(block));
+      OPENSSL_cleanse(pad, sizeof(pad));
+#pragma GCC diagnostic pop
+    }
+
+    // Continues the inner hash with a fixed prefix of every message.
+    HmacSha256 WithPrefix(const char *prefix, size_t len) const
+    {
+      HmacSha256 hmac(*this);
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+      SHA256_Update(&hmac._inner, prefix, len);
+#pragma GCC diagnostic pop
+      return hmac;
+    }
+
+    void Sign(const char *data, size_t len,
+              uint8_t mac[HMAC_SHA256_SIZE]) const
+    {
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+      SHA256_CTX ctx = _inner;
+      SHA256_Update(&ctx, data, len);
+      SHA256_Final(mac, &ctx);
+      ctx = _outer;
+      SHA256_Update(&ctx, mac, HMAC_SHA256_SIZE);
+      SHA256_Final(mac, &ctx);
+#pragma GCC diagnostic pop
+    }
+
+  private:
+    SHA256_CTX _inner;
+    SHA256_CTX _outer;
+  };
+
+  inline std::string Base64UrlEncode(const uint8_t *data, size_t len)
+  {
+    static const char alphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+    std::string out;
+    out.reserve((len * 4 + 2) / 3);
+    size_t i = 0;
+    for (; i + 3 <= len; i += 3)
+    {
+      uint32_t v = (data[i] << 16) | (data[i + 1] << 8) | data[i + 2];
+      out += alphabet[v >> 18];
+      out += alphabet[(v >> 12) & 63];
+      out += alphabet[(v >> 6) & 63];
+      out += alphabet[v & 63];
+    }
+    if (i < len)
+    {
+      uint32_t v = data[i] << 16;
+      if (i + 1 < len)
+      {
+        v |= data[i + 1] << 8;
+      }
+      out += alphabet[v >> 18];
+      out += alphabet[(v >> 12) & 63];
+      if (i + 1 < len)
+      {
+        out += alphabet[(v >> 6) & 63];
+      }
+    }
+    return out;
+  }
+
+  // Decodes unpadded base64url; false on any other character.
+  inline bool Base64UrlDecode(const char *data, size_t len, std::string *out)
+  {
+    if (len % 4 == 1)
+    {
+      return false;
+    }
+    out->clear();
+    out->reserve(len * 3 / 4);
+    uint32_t v = 0;
+    int bits = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+      char c = data[i];
+      int d;
+      if (c >= 'A' && c <= 'Z')
+      {
+        d = c - 'A';
+      }
+      else if (c >= 'a' && c <= 'z')
+      {
+        d = c - 'a' + 26;
+      }
+      else if (c >= '0' && c <= '9')
+      {
+        d = c - '0' + 52;
+      }
+      else if (c == '-')
+      {
+        d = 62;
+      }
+      else if (c == '_')
+      {
+        d = 63;
+      }
+      else
+      {
+        return false;
+      }
+      v = (v << 6) | d;
+      bits += 6;
+      if (bits >= 8)
+      {
+        bits -= 8;
+        *out += static_cast<char>((v >> bits) & 0xff);
+      }
+    }
+    return true;
+  }
+
+  struct UserTokenClaims
+  {
+    int64_t user_id = 0;
+    // Milliseconds since the epoch.
+    int64_t timestamp = 0;
+    int64_t ttl = 0;
+
+    int64_t Expiry() const
+    {
+      return timestamp + ttl;
+    }
+  };
+
+  enum class UserTokenStatus
+  {
+    ok,
+    malformed,
+    bad_signature
+  };
+
+  /*
+   * HS256 JSON Web Tokens as issued by Login, with the same claims as
+   * before: {"TTL":"<ms>","timestamp":"<ms>","user_id":"<id>"}, all strings.
+   * The HMAC key and the encoded header are prepared once, so signing is
+   * one snprintf, one base64 pass and the MAC. Verification requires the
+   * exact header Sign() writes, checks the signature in constant time and
+   * parses the claims; expiry is left to the caller.
+   */
+  class UserTokenSigner
+  {
+  public:
+    explicit UserTokenSigner(const std::string &secret)
+        : _header(_EncodedHeader() + "."),
+          _header_hmac(HmacSha256(secret).WithPrefix(_header.data(),
+                                                     _header.size())) {}
+
+    std::string Sign(const UserTokenClaims &claims) const
+    {
+      char payload[128];
+      int len = snprintf(
+          payload, sizeof(payload),
+          "{\"TTL\":\"%" PRId64 "\",\"timestamp\":\"%" PRId64
+          "\",\"user_id\":\"%" PRId64 "\"}",
+          claims.ttl, claims.timestamp, claims.user_id);
+      std::string token = _header;
+      token += Base64UrlEncode(reinterpret_cast<const uint8_t *>(payload),
+                               len);
+      uint8_t mac[HMAC_SHA256_SIZE];
+      _header_hmac.Sign(token.data() + _header.size(),
+                        token.size() - _header.size(), mac);
+      token += '.';
+      token += Base64UrlEncode(mac, sizeof(mac));
+      return token;
+    }
+
+    UserTokenStatus Verify(const std::string &token,
+                           UserTokenClaims *claims) const
+    {
+      size_t header_end = token.find('.');
+      size_t payload_end = token.rfind('.');
+      if (header_end == std::string::npos || payload_end == header_end)
+      {
+        return UserTokenStatus::malformed;
+      }
+      std::string signature;
+      if (!Base64UrlDecode(token.data() + payload_end + 1,
+                           token.size() - payload_end - 1, &signature) ||
+          signature.size() != HMAC_SHA256_SIZE)
+      {
+        return UserTokenStatus::malformed;
+      }
+
+      // Every token checked here was issued by Sign(), so anything but its
+      // exact header is rejected rather than parsed.
+      if (header_end + 1 != _header.size() ||
+          token.compare(0, _header.size(), _header) != 0)
+      {
+        return UserTokenStatus::malformed;
+      }
+      uint8_t mac[HMAC_SHA256_SIZE];
+      _header_hmac.Sign(token.data() + _header.size(),
+                        payload_end - _header.size(), mac);
+      if (CRYPTO_memcmp(mac, signature.data(), HMAC_SHA256_SIZE) != 0)
+      {
+        return UserTokenStatus::bad_signature;
+      }
+
+      std::string payload;
+      if (!Base64UrlDecode(token.data() + header_end + 1,
+                           payload_end - header_end - 1, &payload))
+      {
+        return UserTokenStatus::malformed;
+      }
+      if (_ParseOwnPayload(payload, claims))
+      {
+        return UserTokenStatus::ok;
+      }
+      auto json = nlohmann::json::parse(payload, nullptr, false);
+      if (!json.is_object() ||
+          !_GetInt(json, "user_id", &claims->user_id) ||
+          !_GetInt(json, "timestamp", &claims->timestamp) ||
+          !_GetInt(json, "TTL", &claims->ttl))
+      {
+        return UserTokenStatus::malformed;
+      }
+      return UserTokenStatus::ok;
+    }
+
+  private:
+    static std::string _EncodedHeader()
+    {
+      static const char header[] = "{\"alg\":\"HS256\",\"typ\":\"JWT\"}";
+      return Base64UrlEncode(reinterpret_cast<const uint8_t *>(header),
+                             sizeof(header) - 1);
+    }
+
+    // The exact layout Sign() writes, without a JSON parser.
+    static bool _ParseOwnPayload(const std::string &payload,
+                                 UserTokenClaims *claims)
+    {
+      int end = 0;
+      long long ttl, timestamp, user_id;
+      if (sscanf(payload.c_str(),
+                 "{\"TTL\":\"%lld\",\"timestamp\":\"%lld\","
+                 "\"user_id\":\"%lld\"}%n",
+                 &ttl, &timestamp, &user_id, &end) != 3 ||
+          static_cast<size_t>(end) != payload.size())
+      {
+        return false;
+      }
+      claims->ttl = ttl;
+      claims->timestamp = timestamp;
+      claims->user_id = user_id;
+      return true;
+    }
+
+    // Claims are strings holding integers, or plain integers.
+    static bool _GetInt(const nlohmann::json &json, const char *key,
+                        int64_t *value)
+    {
+      auto it = json.find(key);
+      if (it == json.end())
+      {
+        return false;
+      }
+      if (it->is_number_integer())
+      {
+        *value = it->get<int64_t>();
+        return true;
+      }
+      if (!it->is_string())
+      {
+        return false;
+      }
+      const std::string &str = it->get_ref<const std::string &>();
+      char *end;
+      errno = 0;
+      *value = strtoll(str.c_str(), &end, 10);
+      return !str.empty() && *end == '\0' && errno == 0;
+    }
+
+    std::string _header;
+    HmacSha256 _header_hmac;
+  };
+
+} // namespace media_service
+
+#endif // MEDIA_MICROSERVICES_USERTOKEN_H
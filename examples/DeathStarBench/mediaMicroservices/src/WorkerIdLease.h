@@ -0,0 +1,509 @@
+#ifndef MEDIA_MICROSERVICES_WORKERIDLEASE_H
+#define MEDIA_MICROSERVICES_WORKERIDLEASE_H
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <mongoc.h>
+#include <bson/bson.h>
+
+#include "UniqueIdGenerator.h"
+#include "logger.h"
+
+// The sign bit of an ID overlaps the top machine bit, so only the lower
+// half of the machine ID space tells replicas apart.
+#define WORKER_ID_LEASE_MAX_IDS (1 << (UNIQUE_ID_MACHINE_BITS - 1))
+// Renew this many times per TTL, so one or two failed renewals in a row do
+// not lose the lease.
+#define WORKER_ID_LEASE_RENEWALS_PER_TTL 3
+// WorkerIdStore::TryAcquire() results other than a fencing token.
+#define WORKER_ID_HELD -1
+#define WORKER_ID_STORE_ERROR -2
+
+namespace media_service
+{
+
+  /*
+   * Shared record of which replica holds which worker ID. Every lease
+   * carries a fencing token that the store increments each time the ID
+   * changes hands; Renew() and Release() only succeed with the token of the
+   * current holder, so a replica that lost its lease cannot extend it again
+   * after another replica has taken the ID over.
+   *
+   * Expiry times are wall-clock milliseconds, compared across replicas, so
+   * the TTL has to be well above the clock skew between them.
+   */
+  class WorkerIdStore
+  {
+  public:
+    virtual ~WorkerIdStore() = default;
+
+    // Takes worker_id if it is free, its lease has expired or owner already
+    // holds it (a take whose reply was lost to a store error). Returns the
+    // new fencing token, WORKER_ID_HELD if another owner holds it, or
+    // WORKER_ID_STORE_ERROR if the store could not be read or written.
+    virtual int64_t TryAcquire(int worker_id, const std::string &owner,
+                               int64_t now_ms, int64_t ttl_ms) = 0;
+    virtual bool Renew(int worker_id, const std::string &owner, int64_t token,
+                       int64_t now_ms, int64_t ttl_ms) = 0;
+    virtual void Release(int worker_id, const std::string &owner,
+                         int64_t token) = 0;
+  };
+
+  /*
+   * Keeps one "<owner> <token> <expires_at_ms>" file per worker ID in a
+   * directory, serialised with flock() on a lock file next to them. This
+   * stands in for a shared store when all replicas run on one host or share
+   * the directory over a file system with working flock().
+   */
+  class FileWorkerIdStore : public WorkerIdStore
+  {
+  public:
+    explicit FileWorkerIdStore(const std::string &dir);
+    ~FileWorkerIdStore() override;
+
+    int64_t TryAcquire(int worker_id, const std::string &owner,
+                       int64_t now_ms, int64_t ttl_ms) override;
+    bool Renew(int worker_id, const std::string &owner, int64_t token,
+               int64_t now_ms, int64_t ttl_ms) override;
+    void Release(int worker_id, const std::string &owner,
+                 int64_t token) override;
+
+  private:
+    struct Record
+    {
+      std::string owner;
+      int64_t token = 0;
+      int64_t expires_at_ms = 0;
+    };
+
+    std::string _PathOf(int worker_id) const;
+    Record _Read(int worker_id) const;
+    bool _Write(int worker_id, const Record &record) const;
+
+    std::string _dir;
+    int _lock_fd;
+  };
+
+  /*
+   * Keeps one document {_id: worker_id, owner, token, expires_at} per worker
+   * ID. Acquisition is a single upserting findAndModify that only matches an
+   * expired document or one of the same owner, so two replicas racing for
+   * the same free ID are decided by the unique _id index.
+   */
+  class MongoWorkerIdStore : public WorkerIdStore
+  {
+  public:
+    MongoWorkerIdStore(mongoc_client_pool_t *client_pool,
+                       const std::string &db_name);
+
+    int64_t TryAcquire(int worker_id, const std::string &owner,
+                       int64_t now_ms, int64_t ttl_ms) override;
+    bool Renew(int worker_id, const std::string &owner, int64_t token,
+               int64_t now_ms, int64_t ttl_ms) override;
+    void Release(int worker_id, const std::string &owner,
+                 int64_t token) override;
+
+  private:
+    // Runs findAndModify and returns the token of the matched document,
+    // WORKER_ID_HELD if nothing matched or WORKER_ID_STORE_ERROR.
+    int64_t _FindAndModify(const bson_t *query, const bson_t *update,
+                           bool upsert);
+
+    mongoc_client_pool_t *_client_pool;
+    std::string _db_name;
+  };
+
+  /*
+   * A worker ID held by this process. Acquire() probes the store for a free
+   * ID, starting at a hint so replicas spread out, and then a thread renews
+   * the lease WORKER_ID_LEASE_RENEWALS_PER_TTL times per TTL.
+   *
+   * Valid() is false once a quarter of the TTL is left without a successful
+   * renewal, measured on the local monotonic clock from before the last
+   * renewal was sent; callers must stop issuing IDs with the worker ID then.
+   * While the store cannot be reached the lease stays invalid and the
+   * renewal thread keeps retrying. Only if the store reports that the ID
+   * went to another owner does the process exit, since the worker ID it
+   * generates with may now be in use elsewhere.
+   */
+  class WorkerIdLease
+  {
+  public:
+    WorkerIdLease(std::unique_ptr<WorkerIdStore> store,
+                  const std::string &owner, int ttl_ms);
+    ~WorkerIdLease();
+
+    WorkerIdLease(const WorkerIdLease &) = delete;
+    WorkerIdLease &operator=(const WorkerIdLease &) = delete;
+
+    // Returns false if every worker ID is taken.
+    bool Acquire(int hint);
+
+    int WorkerId() const { return _worker_id; }
+    bool Valid() const;
+
+  private:
+    static int64_t _WallMs();
+    static int64_t _SteadyMs();
+    void _RenewLoop();
+
+    std::unique_ptr<WorkerIdStore> _store;
+    std::string _owner;
+    int64_t _ttl_ms;
+    int _worker_id = -1;
+    std::atomic<int64_t> _token{-1};
+    std::atomic<int64_t> _valid_until_ms{0};
+
+    std::mutex _mtx;
+    std::condition_variable _cv;
+    bool _stop = false;
+    std::thread _renew_thread;
+  };
+
+  FileWorkerIdStore::FileWorkerIdStore(const std::string &dir)
+  {
+    _dir = dir;
+    std::string lock_path = _dir + "/worker-ids.lock";
+    _lock_fd = open(lock_path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (_lock_fd < 0)
+    {
+      LOG(error) << "Cannot open " << lock_path;
+    }
+  }
+
+  FileWorkerIdStore::~FileWorkerIdStore()
+  {
+    if (_lock_fd >= 0)
+    {
+      close(_lock_fd);
+    }
+  }
+
+  std::string FileWorkerIdStore::_PathOf(int worker_id) const
+  {
+    return _dir + "/worker-id-" + std::to_string(worker_id);
+  }
+
+  FileWorkerIdStore::Record FileWorkerIdStore::_Read(int worker_id) const
+  {
+    Record record;
+    std::ifstream file(_PathOf(worker_id));
+    if (file.is_open())
+    {
+      file >> record.owner >> record.token >> record.expires_at_ms;
+    }
+    return record;
+  }
+
+  bool FileWorkerIdStore::_Write(int worker_id, const Record &record) const
+  {
+    // Write a temporary file and rename it over the record, so a crash
+    // never leaves a half written record behind.
+    std::string path = _PathOf(worker_id);
+    std::string tmp_path = path + ".tmp";
+    {
+      std::ofstream file(tmp_path, std::ios::trunc);
+      file << record.owner << " " << record.token << " "
+           << record.expires_at_ms << "\n";
+      if (!file.good())
+      {
+        return false;
+      }
+    }
+    return rename(tmp_path.c_str(), path.c_str()) == 0;
+  }
+
+  int64_t FileWorkerIdStore::TryAcquire(int worker_id,
+                                        const std::string &owner,
+                                        int64_t now_ms, int64_t ttl_ms)
+  {
+    if (_lock_fd < 0 || flock(_lock_fd, LOCK_EX) != 0)
+    {
+      return WORKER_ID_STORE_ERROR;
+    }
+    Record record = _Read(worker_id);
+    int64_t token = WORKER_ID_HELD;
+    if (record.expires_at_ms <= now_ms || record.owner == owner)
+    {
+      record.owner = owner;
+      record.token++;
+      record.expires_at_ms = now_ms + ttl_ms;
+      token = _Write(worker_id, record) ? record.token : WORKER_ID_STORE_ERROR;
+    }
+    flock(_lock_fd, LOCK_UN);
+    return token;
+  }
+
+  bool FileWorkerIdStore::Renew(int worker_id, const std::string &owner,
+                                int64_t token, int64_t now_ms, int64_t ttl_ms)
+  {
+    if (_lock_fd < 0 || flock(_lock_fd, LOCK_EX) != 0)
+    {
+      return false;
+    }
+    Record record = _Read(worker_id);
+    bool renewed = false;
+    if (record.owner == owner && record.token == token)
+    {
+      record.expires_at_ms = now_ms + ttl_ms;
+      renewed = _Write(worker_id, record);
+    }
+    flock(_lock_fd, LOCK_UN);
+    return renewed;
+  }
+
+  void FileWorkerIdStore::Release(int worker_id, const std::string &owner,
+                                  int64_t token)
+  {
+    if (_lock_fd < 0 || flock(_lock_fd, LOCK_EX) != 0)
+    {
+      return;
+    }
+    Record record = _Read(worker_id);
+    if (record.owner == owner && record.token == token)
+    {
+      record.expires_at_ms = 0;
+      _Write(worker_id, record);
+    }
+    flock(_lock_fd, LOCK_UN);
+  }
+
+  MongoWorkerIdStore::MongoWorkerIdStore(mongoc_client_pool_t *client_pool,
+                                         const std::string &db_name)
+  {
+    _client_pool = client_pool;
+    _db_name = db_name;
+  }
+
+  int64_t MongoWorkerIdStore::_FindAndModify(const bson_t *query,
+                                             const bson_t *update,
+                                             bool upsert)
+  {
+    mongoc_client_t *mongodb_client = mongoc_client_pool_pop(_client_pool);
+    if (!mongodb_client)
+    {
+      LOG(error) << "Failed to pop a client from MongoDB pool";
+      return WORKER_ID_STORE_ERROR;
+    }
+    auto collection = mongoc_client_get_collection(
+        mongodb_client, _db_name.c_str(), "worker-id");
+    bson_t reply;
+    bson_error_t error;
+    bool ok = mongoc_collection_find_and_modify(
+        collection, query, nullptr, update, nullptr, false, upsert, true,
+        &reply, &error);
+    int64_t token = WORKER_ID_HELD;
+    if (!ok)
+    {
+      // A duplicate _id on upsert means the ID is held and not expired.
+      if (error.code != 11000)
+      {
+        LOG(warning) << "Failed to update worker-id lease: " << error.message;
+        token = WORKER_ID_STORE_ERROR;
+      }
+    }
+    else
+    {
+      bson_iter_t iter;
+      bson_iter_t token_iter;
+      if (bson_iter_init(&iter, &reply) &&
+          bson_iter_find_descendant(&iter, "value.token", &token_iter))
+      {
+        token = bson_iter_as_int64(&token_iter);
+      }
+    }
+    bson_destroy(&reply);
+    mongoc_collection_destroy(collection);
+    mongoc_client_pool_push(_client_pool, mongodb_client);
+    return token;
+  }
+
+  int64_t MongoWorkerIdStore::TryAcquire(int worker_id,
+                                         const std::string &owner,
+                                         int64_t now_ms, int64_t ttl_ms)
+  {
+    bson_t *query = BCON_NEW(
+        "_id", BCON_INT32(worker_id),
+        "$or", "[",
+            "{", "expires_at", "{", "$lte", BCON_INT64(now_ms), "}", "}",
+            "{", "owner", BCON_UTF8(owner.c_str()), "}",
+        "]");
+    bson_t *update = BCON_NEW(
+        "$set", "{",
+            "owner", BCON_UTF8(owner.c_str()),
+            "expires_at", BCON_INT64(now_ms + ttl_ms),
+        "}",
+        "$inc", "{", "token", BCON_INT64(1), "}");
+    int64_t token = _FindAndModify(query, update, true);
+    bson_destroy(update);
+    bson_destroy(query);
+    return token;
+  }
+
+  bool MongoWorkerIdStore::Renew(int worker_id, const std::string &owner,
+                                 int64_t token, int64_t now_ms,
+                                 int64_t ttl_ms)
+  {
+    bson_t *query = BCON_NEW(
+        "_id", BCON_INT32(worker_id),
+        "owner", BCON_UTF8(owner.c_str()),
+        "token", BCON_INT64(token));
+    bson_t *update = BCON_NEW(
+        "$set", "{", "expires_at", BCON_INT64(now_ms + ttl_ms), "}");
+    bool renewed = _FindAndModify(query, update, false) == token;
+    bson_destroy(update);
+    bson_destroy(query);
+    return renewed;
+  }
+
+  void MongoWorkerIdStore::Release(int worker_id, const std::string &owner,
+                                   int64_t token)
+  {
+    bson_t *query = BCON_NEW(
+        "_id", BCON_INT32(worker_id),
+        "owner", BCON_UTF8(owner.c_str()),
+        "token", BCON_INT64(token));
+    bson_t *update = BCON_NEW(
+        "$set", "{", "expires_at", BCON_INT64(0), "}");
+    _FindAndModify(query, update, false);
+    bson_destroy(update);
+    bson_destroy(query);
+  }
+
+  WorkerIdLease::WorkerIdLease(std::unique_ptr<WorkerIdStore> store,
+                               const std::string &owner, int ttl_ms)
+  {
+    _store = std::move(store);
+    _owner = owner;
+    _ttl_ms = std::max(ttl_ms, WORKER_ID_LEASE_RENEWALS_PER_TTL);
+  }
+
+  WorkerIdLease::~WorkerIdLease()
+  {
+    {
+      std::lock_guard<std::mutex> lock(_mtx);
+      _stop = true;
+    }
+    _cv.notify_all();
+    if (_renew_thread.joinable())
+    {
+      _renew_thread.join();
+      _store->Release(_worker_id, _owner, _token);
+    }
+  }
+
+  int64_t WorkerIdLease::_WallMs()
+  {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+  }
+
+  int64_t WorkerIdLease::_SteadyMs()
+  {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  bool WorkerIdLease::Acquire(int hint)
+  {
+    int store_errors = 0;
+    for (int i = 0; i < WORKER_ID_LEASE_MAX_IDS; ++i)
+    {
+      int worker_id = (hint + i) % WORKER_ID_LEASE_MAX_IDS;
+      int64_t sent_ms = _SteadyMs();
+      int64_t token = _store->TryAcquire(worker_id, _owner, _WallMs(), _ttl_ms);
+      if (token == WORKER_ID_STORE_ERROR)
+      {
+        store_errors++;
+      }
+      if (token < 0)
+      {
+        continue;
+      }
+      _worker_id = worker_id;
+      _token = token;
+      _valid_until_ms.store(sent_ms + _ttl_ms - _ttl_ms / 4);
+      _renew_thread = std::thread(&WorkerIdLease::_RenewLoop, this);
+      LOG(info) << "Leased worker id " << _worker_id << " with token "
+                << _token << " for " << _owner;
+      return true;
+    }
+    if (store_errors > 0)
+    {
+      LOG(error) << "No worker id leased, the store failed " << store_errors
+                 << " times";
+    }
+    else
+    {
+      LOG(error) << "No free worker id left";
+    }
+    return false;
+  }
+
+  bool WorkerIdLease::Valid() const
+  {
+    return _SteadyMs() < _valid_until_ms.load(std::memory_order_relaxed);
+  }
+
+  void WorkerIdLease::_RenewLoop()
+  {
+    auto interval = std::chrono::milliseconds(
+        _ttl_ms / WORKER_ID_LEASE_RENEWALS_PER_TTL);
+    std::unique_lock<std::mutex> lock(_mtx);
+    while (!_cv.wait_for(lock, interval, [this] { return _stop; }))
+    {
+      lock.unlock();
+      int64_t sent_ms = _SteadyMs();
+      if (_store->Renew(_worker_id, _owner, _token, _WallMs(), _ttl_ms))
+      {
+        _valid_until_ms.store(sent_ms + _ttl_ms - _ttl_ms / 4);
+      }
+      else if (Valid())
+      {
+        LOG(warning) << "Failed to renew the lease on worker id "
+                     << _worker_id;
+      }
+      else
+      {
+        // No IDs have been issued since the lease went invalid, so the ID
+        // can be taken again if it expired without changing hands.
+        int64_t token =
+            _store->TryAcquire(_worker_id, _owner, _WallMs(), _ttl_ms);
+        if (token == WORKER_ID_HELD)
+        {
+          LOG(fatal) << "Lost the lease on worker id " << _worker_id;
+          exit(EXIT_FAILURE);
+        }
+        if (token == WORKER_ID_STORE_ERROR)
+        {
+          // Whether the ID changed hands is unknown; stay invalid and retry.
+          _valid_until_ms.store(0);
+          LOG(warning) << "Cannot reach the worker id store, worker id "
+                       << _worker_id << " stays invalid until it can";
+        }
+        else
+        {
+          _token = token;
+          _valid_until_ms.store(sent_ms + _ttl_ms - _ttl_ms / 4);
+        }
+      }
+      lock.lock();
+    }
+  }
+
+} // namespace media_service
+
+#endif // MEDIA_MICROSERVICES_WORKERIDLEASE_H
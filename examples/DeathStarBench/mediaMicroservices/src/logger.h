@@ -1,29 +1,419 @@
 #ifndef MEDIA_MICROSERVICES_LOGGER_H
 #define MEDIA_MICROSERVICES_LOGGER_H
 
-#include <boost/log/trivial.hpp>
-#include <boost/log/utility/setup/console.hpp>
-#include <boost/log/utility/setup/common_attributes.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 #include <string.h>
 
+// LOG statements below this level are compiled out: 0 trace, 1 debug,
+// 2 info, 3 warning, 4 error, 5 fatal.
+#ifndef MEDIA_MICROSERVICES_LOG_MIN_LEVEL
+#define MEDIA_MICROSERVICES_LOG_MIN_LEVEL 0
+#endif
+
+// Every thread that logs owns a ring of LOG_RING_SLOTS lines of at most
+// LOG_LINE_MAX bytes; longer lines are truncated.
+#define LOG_RING_SLOTS 128
+#define LOG_LINE_MAX 512
+#define LOG_FLUSH_INTERVAL_MS 10
+
 namespace media_service {
-#define __FILENAME__ \
-    (strrchr(__FILE__, '/') ? strrchr(__FILE__, '/') + 1 : __FILE__)
+
+enum class LogLevel : int {
+  trace = 0, debug, info, warning, error, fatal
+};
+
+inline const char *LogLevelName(LogLevel level) {
+  static const char *kNames[] = {
+      "trace", "debug", "info", "warning", "error", "fatal"};
+  return kNames[static_cast<int>(level)];
+}
+
+constexpr size_t LogBasenameOffset(const char *path) {
+  size_t offset = 0;
+  for (size_t i = 0; path[i]; i++) {
+    if (path[i] == '/') {
+      offset = i + 1;
+    }
+  }
+  return offset;
+}
+
+#define __FILENAME__ (__FILE__ + std::integral_constant<size_t, \
+    ::media_service::LogBasenameOffset(__FILE__)>::value)
+
+/*
+ * Asynchronous logger behind LOG(severity).
+ *
+ * A LOG statement formats its line straight into the next slot of a
+ * single-producer single-consumer ring owned by the calling thread, so the
+ * request path takes no lock, does not allocate and never writes to stderr
+ * itself. A writer thread drains all rings every LOG_FLUSH_INTERVAL_MS,
+ * orders the lines by time and writes them with one fwrite per batch. When a
+ * ring is full the line is dropped and counted; the writer reports the count.
+ * LOG(fatal) drains the rings and writes synchronously, since a fatal error
+ * is usually followed by exit().
+ *
+ * Levels below MEDIA_MICROSERVICES_LOG_MIN_LEVEL are compiled out; the
+ * runtime level is set by SetLogLevel() or the LOG_LEVEL environment
+ * variable read by init_logger().
+ */
+class Logger {
+ public:
+  struct Line {
+    int64_t time_us;
+    LogLevel level;
+    uint16_t len;
+    char text[LOG_LINE_MAX];
+  };
+
+  struct Ring {
+    Line lines[LOG_RING_SLOTS];
+    std::atomic<uint64_t> head{0};   // next slot the owner writes
+    std::atomic<uint64_t> tail{0};   // next slot the writer reads
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<bool> closed{false};
+  };
+
+  static Logger &Instance() {
+    // Never destroyed: threads may still log while the process exits.
+    static Logger *logger = new Logger();
+    return *logger;
+  }
+
+  static std::atomic<int> &Level() {
+    static std::atomic<int> level{static_cast<int>(LogLevel::debug)};
+    return level;
+  }
+
+  // The calling thread's ring, registered with the writer on first use.
+  static Ring *ThreadRing() {
+    thread_local RingHolder holder;
+    return holder.ring.get();
+  }
+
+  // Drains every ring and writes it out on the calling thread.
+  void Flush() {
+    std::lock_guard<std::mutex> lock(_drain_mutex);
+    _Drain();
+  }
+
+  // Flushes, then writes line right away.
+  void WriteNow(const Line &line) {
+    std::lock_guard<std::mutex> lock(_drain_mutex);
+    _Drain();
+    _out.clear();
+    _Format(line);
+    _Write();
+  }
+
+  void Stop() {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (_stop) {
+        return;
+      }
+      _stop = true;
+    }
+    _cv.notify_all();
+    _writer.join();
+    Flush();
+  }
+
+ private:
+  struct RingHolder {
+    std::shared_ptr<Ring> ring;
+    RingHolder() : ring(std::make_shared<Ring>()) {
+      Instance()._Register(ring);
+    }
+    ~RingHolder() {
+      ring->closed.store(true, std::memory_order_release);
+    }
+  };
+
+  Logger() {
+    _writer = std::thread(&Logger::_WriterLoop, this);
+    std::atexit([] { Logger::Instance().Stop(); });
+  }
+
+  void _Register(const std::shared_ptr<Ring> &ring) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _rings.push_back(ring);
+  }
+
+  void _WriterLoop() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (!_stop) {
+      _cv.wait_for(lock, std::chrono::milliseconds(LOG_FLUSH_INTERVAL_MS));
+      lock.unlock();
+      Flush();
+      lock.lock();
+    }
+  }
+
+  // Caller holds _drain_mutex, the one consumer of every ring.
+  void _Drain() {
+    std::vector<std::shared_ptr<Ring>> rings;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      // Rings of exited threads are dropped once they have been drained.
+      _rings.erase(std::remove_if(_rings.begin(), _rings.end(),
+          [](const std::shared_ptr<Ring> &ring) {
+            return ring->closed.load(std::memory_order_acquire) &&
+                ring->tail.load() == ring->head.load(std::memory_order_acquire);
+          }), _rings.end());
+      rings = _rings;
+    }
+
+    _batch.clear();
+    _heads.clear();
+    uint64_t dropped = 0;
+    for (auto &ring : rings) {
+      uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+      uint64_t head = ring->head.load(std::memory_order_acquire);
+      for (; tail != head; tail++) {
+        _batch.push_back(&ring->lines[tail % LOG_RING_SLOTS]);
+      }
+      _heads.push_back(head);
+      dropped += ring->dropped.exchange(0, std::memory_order_relaxed);
+    }
+    std::stable_sort(_batch.begin(), _batch.end(),
+        [](const Line *a, const Line *b) { return a->time_us < b->time_us; });
+
+    _out.clear();
+    for (const Line *line : _batch) {
+      _Format(*line);
+    }
+    if (dropped) {
+      _out += "<warning>: logger dropped " + std::to_string(dropped) +
+          " lines, the ring of a thread was full\n";
+    }
+    _Write();
+
+    // Only now hand the slots back to their owners.
+    for (size_t i = 0; i < rings.size(); i++) {
+      rings[i]->tail.store(_heads[i], std::memory_order_release);
+    }
+  }
+
+  void _Write() {
+    if (!_out.empty()) {
+      fwrite(_out.data(), 1, _out.size(), stderr);
+      fflush(stderr);
+    }
+  }
+
+  // Same layout as the Boost.Log console format this logger replaced:
+  // [%TimeStamp%] <%Severity%>: %Message%
+  void _Format(const Line &line) {
+    time_t secs = static_cast<time_t>(line.time_us / 1000000);
+    struct tm tm_time;
+    localtime_r(&secs, &tm_time);
+    char prefix[64];
+    size_t n = strftime(prefix, sizeof(prefix), "[%Y-%m-%d %H:%M:%S", &tm_time);
+    snprintf(prefix + n, sizeof(prefix) - n, ".%06d] <%s>: ",
+             static_cast<int>(line.time_us % 1000000),
+             LogLevelName(line.level));
+    _out += prefix;
+    _out.append(line.text, line.len);
+    _out += '\n';
+  }
+
+  std::mutex _mutex;
+  std::condition_variable _cv;
+  bool _stop = false;
+  std::vector<std::shared_ptr<Ring>> _rings;
+  std::thread _writer;
+
+  std::mutex _drain_mutex;
+  std::vector<const Line *> _batch;
+  std::vector<uint64_t> _heads;
+  std::string _out;
+};
+
+inline void SetLogLevel(LogLevel level) {
+  Logger::Level().store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+inline bool LogEnabled(LogLevel level) {
+  return static_cast<int>(level) >=
+      Logger::Level().load(std::memory_order_relaxed);
+}
+
+/*
+ * One LOG statement. The text goes directly into the ring slot, which is
+ * published when the statement ends. If the ring is full it goes to a
+ * scratch line and is dropped. Fatal lines, and lines logged while another
+ * LOG statement of the same thread is still being built, are written
+ * synchronously instead.
+ */
+class LogLine {
+ public:
+  LogLine(LogLevel level, const char *file, int line, const char *function) {
+    _ring = Logger::ThreadRing();
+    int depth = _Depth()++;
+    uint64_t head = _ring->head.load(std::memory_order_relaxed);
+    if (level == LogLevel::fatal || depth > 0) {
+      _line = &_Scratch(depth);
+      _sync = true;
+    } else if (head - _ring->tail.load(std::memory_order_acquire) >=
+        LOG_RING_SLOTS) {
+      _line = &_Scratch(0);
+      _dropped = true;
+    } else {
+      _line = &_ring->lines[head % LOG_RING_SLOTS];
+    }
+    _line->time_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    _line->level = level;
+    _line->len = 0;
+    *this << '(' << file << ':' << line << ':' << function << ") ";
+  }
+
+  ~LogLine() {
+    _Depth()--;
+    if (_sync) {
+      Logger::Instance().WriteNow(*_line);
+    } else if (_dropped) {
+      _ring->dropped.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      _ring->head.fetch_add(1, std::memory_order_release);
+    }
+  }
+
+  LogLine(const LogLine &) = delete;
+  LogLine &operator=(const LogLine &) = delete;
+
+  LogLine &operator<<(const char *s) {
+    _Append(s ? s : "(null)", s ? strlen(s) : 6);
+    return *this;
+  }
+  LogLine &operator<<(const std::string &s) {
+    _Append(s.data(), s.size());
+    return *this;
+  }
+  LogLine &operator<<(char c) {
+    _Append(&c, 1);
+    return *this;
+  }
+  LogLine &operator<<(bool b) {
+    return *this << (b ? "true" : "false");
+  }
+  LogLine &operator<<(const void *p) {
+    return _Printf("%p", p);
+  }
+  LogLine &operator<<(int v) { return _Integer(v); }
+  LogLine &operator<<(unsigned v) { return _Integer(v); }
+  LogLine &operator<<(long v) { return _Integer(v); }
+  LogLine &operator<<(unsigned long v) { return _Integer(v); }
+  LogLine &operator<<(long long v) { return _Integer(v); }
+  LogLine &operator<<(unsigned long long v) { return _Integer(v); }
+  LogLine &operator<<(double v) { return _Printf("%g", v); }
+  // std::endl and other manipulators; every line ends with a newline anyway.
+  LogLine &operator<<(std::ostream &(*)(std::ostream &)) { return *this; }
+
+  // Anything else that can be written to an ostream. This path allocates.
+  template <class T>
+  typename std::enable_if<!std::is_arithmetic<T>::value, LogLine &>::type
+  operator<<(const T &value) {
+    std::ostringstream stream;
+    stream << value;
+    return *this << stream.str();
+  }
+
+ private:
+  static int &_Depth() {
+    thread_local int depth = 0;
+    return depth;
+  }
+
+  static Logger::Line &_Scratch(int depth) {
+    thread_local Logger::Line lines[4];
+    return lines[std::min(depth, 3)];
+  }
+
+  void _Append(const char *s, size_t n) {
+    n = std::min(n, LOG_LINE_MAX - static_cast<size_t>(_line->len));
+    memcpy(_line->text + _line->len, s, n);
+    _line->len += n;
+  }
+
+  template <class T>
+  LogLine &_Integer(T value) {
+    char buf[24];
+    char *end = buf + sizeof(buf);
+    char *p = end;
+    bool negative = value < 0;
+    // Negating the most negative value overflows; go through unsigned.
+    unsigned long long u = negative ?
+        0ULL - static_cast<unsigned long long>(value) :
+        static_cast<unsigned long long>(value);
+    do {
+      *--p = static_cast<char>('0' + u % 10);
+      u /= 10;
+    } while (u);
+    if (negative) {
+      *--p = '-';
+    }
+    _Append(p, end - p);
+    return *this;
+  }
+
+  template <class T>
+  LogLine &_Printf(const char *format, T value) {
+    char buf[32];
+    int n = snprintf(buf, sizeof(buf), format, value);
+    _Append(buf, n > 0 ? static_cast<size_t>(n) : 0);
+    return *this;
+  }
+
+  Logger::Ring *_ring;
+  Logger::Line *_line;
+  bool _sync = false;
+  bool _dropped = false;
+};
+
+// Turns the LOG expression into void so it fits the conditional operator.
+struct LogVoidify {
+  void operator&(const LogLine &) {}
+};
+
 #define LOG(severity) \
-    BOOST_LOG_TRIVIAL(severity) << "(" << __FILENAME__ << ":" \
-    << __LINE__ << ":" << __FUNCTION__ << ") "
+    (static_cast<int>(::media_service::LogLevel::severity) < \
+        MEDIA_MICROSERVICES_LOG_MIN_LEVEL || \
+     !::media_service::LogEnabled(::media_service::LogLevel::severity)) ? \
+        (void)0 : ::media_service::LogVoidify() & \
+        ::media_service::LogLine(::media_service::LogLevel::severity, \
+            __FILENAME__, __LINE__, __FUNCTION__)
 
+// Sets the runtime level from the LOG_LEVEL environment variable, e.g.
+// LOG_LEVEL=info; the default is debug.
 void init_logger() {
-  boost::log::register_simple_formatter_factory
-      <boost::log::trivial::severity_level, char>("Severity");
-  boost::log::add_common_attributes();
-  boost::log::add_console_log(
-      std::cerr, boost::log::keywords::format =
-          "[%TimeStamp%] <%Severity%>: %Message%");
-  boost::log::core::get()->set_filter (
-      boost::log::trivial::severity >= boost::log::trivial::debug
-  );
+  const char *env = getenv("LOG_LEVEL");
+  if (env) {
+    for (int i = 0; i <= static_cast<int>(LogLevel::fatal); i++) {
+      if (strcmp(env, LogLevelName(static_cast<LogLevel>(i))) == 0) {
+        SetLogLevel(static_cast<LogLevel>(i));
+      }
+    }
+  }
+  Logger::Instance();
 }
 
 
@@ -0,0 +1,244 @@
+#ifndef MEDIA_MICROSERVICES_PROBES_H
+#define MEDIA_MICROSERVICES_PROBES_H
+
+#include <cstdint>
+#include <exception>
+
+#ifdef MEDIA_MICROSERVICES_USDT
+#include <sys/sdt.h>
+#endif
+
+#include "FlightRecorder.h"
+#include "Metrics.h"
+#include "RequestBreakdown.h"
+
+/*
+ * USDT probes of the services, provider "media_service". They give eBPF
+ * tools stable attach points instead of uprobes on mangled template
+ * symbols, e.g.
+ *
+ *   bpftrace -l 'usdt:/usr/local/bin/MovieIdService:media_service:*'
+ *
+ * An unattached probe is a single nop; its arguments are plain integers
+ * and pointers that are already in registers. Without sys/sdt.h at build
+ * time (MEDIA_MICROSERVICES_USDT undefined) every probe compiles to
+ * nothing. Scripts using them are in scripts/bpftrace.
+ *
+ *   request_context    (context)
+ *   request_start      (req_id, method)
+ *   request_end        (req_id, method, status)
+ *   pool_wait_start    (pool)
+ *   pool_wait_end      (pool, acquired)
+ *   pool_connect_retry (pool, addr, port, backoff_ms)
+ *   memcached_start    (req_id, op)
+ *   memcached_end      (req_id, op, result)
+ *   mongo_start        (req_id, op)
+ *   mongo_end          (req_id, op, result)
+ *   redis_start        (req_id, op)
+ *   redis_end          (req_id, op, result)
+ *
+ * Strings are NUL terminated. method is the RPC name and op the name of
+ * the trace span of the call, e.g. "MmcGetMovieId". status is 0, or 1 if
+ * the handler threw. result is the number of values found by a read, 0
+ * being a miss, PROBE_NO_RESULT for writes and PROBE_ERROR if the call
+ * threw. request_context passes the address of the RequestContext block
+ * of the thread.
+ *
+ * The guards below also keep that block up to date: RequestProbe sets the
+ * request, CallProbe and the pool wait probes its phase. RequestProbe and
+ * CallProbe time what they guard for the metrics of Metrics.h, and the
+ * waits for the RequestBreakdown of the request. RequestProbe also hands
+ * the timeline of the request to the FlightRecorder when it ends.
+ */
+
+#define PROBE_NO_RESULT -1
+#define PROBE_ERROR -2
+
+namespace media_service
+{
+
+  // Fires request_start when constructed and request_end when it goes out
+  // of scope, and makes the thread work on the request in between. method
+  // must outlive the probe.
+  class RequestProbe
+  {
+  public:
+    RequestProbe(int64_t req_id, const char *method,
+                 TraceId trace_id = TraceId{0, 0})
+        : _context(req_id, trace_id, &_breakdown), _req_id(req_id),
+          _method(method)
+    {
+#ifdef MEDIA_MICROSERVICES_USDT
+      DTRACE_PROBE2(media_service, request_start, _req_id, _method);
+#endif
+    }
+
+    ~RequestProbe()
+    {
+      int status = std::uncaught_exception() ? 1 : 0;
+      uint64_t end = ReadCycles();
+      uint64_t cycles = end - _breakdown.start_cycles;
+      FlightRecorder *recorder =
+          FlightRecorder::Global().load(std::memory_order_acquire);
+      if (recorder)
+      {
+        recorder->Record(_method, _req_id, status, CurrentRequestContext(),
+                         _breakdown, end);
+      }
+      AddRequestBreakdown(GetMethodBreakdown(_method), _breakdown, cycles);
+      auto &metrics = GetRpcMetrics(_method);
+      metrics.duration->Record(CyclesToMicroseconds(cycles));
+      if (status)
+      {
+        metrics.errors->Add();
+      }
+#ifdef MEDIA_MICROSERVICES_USDT
+      DTRACE_PROBE3(media_service, request_end, _req_id, _method, status);
+#endif
+    }
+
+    RequestProbe(const RequestProbe &) = delete;
+    RequestProbe &operator=(const RequestProbe &) = delete;
+
+  private:
+    RequestBreakdown _breakdown;
+    RequestContextScope _context;
+    int64_t _req_id;
+    const char *_method;
+  };
+
+  enum class ProbeBackend
+  {
+    memcached,
+    mongo,
+    redis
+  };
+
+  // Fires <backend>_start when constructed and <backend>_end on End(), or
+  // with PROBE_ERROR if it goes out of scope because of an exception.
+  class CallProbe
+  {
+  public:
+    CallProbe(ProbeBackend backend, int64_t req_id, const char *op)
+        : _backend(backend), _req_id(req_id), _op(op),
+          _phase(backend == ProbeBackend::memcached ? REQUEST_PHASE_MEMCACHED
+                 : backend == ProbeBackend::mongo   ? REQUEST_PHASE_MONGO
+                                                    : REQUEST_PHASE_REDIS),
+          _saved_phase(EnterRequestPhase(_phase)), _start(ReadCycles())
+    {
+#ifdef MEDIA_MICROSERVICES_USDT
+      switch (_backend)
+      {
+      case ProbeBackend::memcached:
+        DTRACE_PROBE2(media_service, memcached_start, _req_id, _op);
+        break;
+      case ProbeBackend::mongo:
+        DTRACE_PROBE2(media_service, mongo_start, _req_id, _op);
+        break;
+      case ProbeBackend::redis:
+        DTRACE_PROBE2(media_service, redis_start, _req_id, _op);
+        break;
+      }
+#endif
+    }
+
+    ~CallProbe()
+    {
+      if (!_ended)
+      {
+        End(std::uncaught_exception() ? PROBE_ERROR : PROBE_NO_RESULT);
+      }
+    }
+
+    CallProbe(const CallProbe &) = delete;
+    CallProbe &operator=(const CallProbe &) = delete;
+
+    // For calls whose bytes are not counted elsewhere, i.e. memcached.
+    void AddBytes(uint64_t sent, uint64_t received)
+    {
+      RecordBackendBytes(_phase, sent, received);
+    }
+
+    void End(int64_t result = PROBE_NO_RESULT)
+    {
+      _ended = true;
+      uint64_t end = ReadCycles();
+      uint64_t cycles = end - _start;
+      RecordBlocked(_phase, cycles);
+      RecordEvent(_phase, _op, result, _start, end);
+      EnterRequestPhase(_saved_phase);
+      auto &metrics = GetBackendCallMetrics(
+          _backend == ProbeBackend::memcached ? "memcached"
+          : _backend == ProbeBackend::mongo   ? "mongo"
+                                              : "redis",
+          _op);
+      metrics.duration->Record(CyclesToMicroseconds(cycles));
+      if (result == PROBE_ERROR)
+      {
+        metrics.errors->Add();
+      }
+      else if (result >= 0 && metrics.hits)
+      {
+        (result > 0 ? metrics.hits : metrics.misses)->Add();
+      }
+#ifdef MEDIA_MICROSERVICES_USDT
+      switch (_backend)
+      {
+      case ProbeBackend::memcached:
+        DTRACE_PROBE3(media_service, memcached_end, _req_id, _op, result);
+        break;
+      case ProbeBackend::mongo:
+        DTRACE_PROBE3(media_service, mongo_end, _req_id, _op, result);
+        break;
+      case ProbeBackend::redis:
+        DTRACE_PROBE3(media_service, redis_end, _req_id, _op, result);
+        break;
+      }
+#endif
+    }
+
+  private:
+    ProbeBackend _backend;
+    int64_t _req_id;
+    const char *_op;
+    uint32_t _phase;
+    uint32_t _saved_phase;
+    uint64_t _start;
+    bool _ended = false;
+  };
+
+  // Returns the phase to pass to ProbePoolWaitEnd().
+  inline uint32_t ProbePoolWaitStart(const char *pool)
+  {
+#ifdef MEDIA_MICROSERVICES_USDT
+    DTRACE_PROBE1(media_service, pool_wait_start, pool);
+#endif
+    return EnterRequestPhase(REQUEST_PHASE_POOL_WAIT);
+  }
+
+  inline void ProbePoolWaitEnd(const char *pool, bool acquired,
+                               uint32_t saved_phase, uint64_t wait_start,
+                               uint64_t wait_end)
+  {
+    RecordBlocked(REQUEST_PHASE_POOL_WAIT, wait_end - wait_start);
+    RecordEvent(REQUEST_PHASE_POOL_WAIT, pool, acquired ? 1 : 0, wait_start,
+                wait_end);
+    EnterRequestPhase(saved_phase);
+#ifdef MEDIA_MICROSERVICES_USDT
+    int acquired_int = acquired ? 1 : 0;
+    DTRACE_PROBE2(media_service, pool_wait_end, pool, acquired_int);
+#endif
+  }
+
+  inline void ProbePoolConnectRetry(const char *pool, const char *addr,
+                                    int port, int64_t backoff_ms)
+  {
+#ifdef MEDIA_MICROSERVICES_USDT
+    DTRACE_PROBE4(media_service, pool_connect_retry, pool, addr, port,
+                  backoff_ms);
+#endif
+  }
+
+} // namespace media_service
+
+#endif // MEDIA_MICROSERVICES_PROBES_H
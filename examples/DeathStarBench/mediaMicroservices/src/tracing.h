@@ -5,11 +5,34 @@
 
 #include <string>
 #include <yaml-cpp/yaml.h>
+#include <jaegertracing/Span.h>
 #include <jaegertracing/Tracer.h>
 
 #include <opentracing/propagation.h>
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <random>
 #include <string>
 #include <map>
+#include <thread>
+#include <vector>
+
+#include "RequestBreakdown.h"
+#include "SpanRing.h"
+
+#define TAIL_SAMPLING_DEFAULT_BUFFER_SPANS 16384
+#define TAIL_SAMPLING_DEFAULT_LATENCY_THRESHOLD_MS 100
+// Kept traces waiting for the flusher to collect their spans from the ring;
+// more are dropped until it catches up.
+#define TAIL_SAMPLING_MAX_PENDING_TRACES 4096
 
 namespace media_service {
 
@@ -49,15 +72,547 @@ class TextMapWriter : public opentracing::TextMapWriter {
   std::map<std::string, std::string>& _text_map;
 };
 
+// The tracer and the name of the trace context entry in a carrier, set once
+// by SetUpTracer() before the server starts. Caching the tracer saves the
+// lock opentracing::Tracer::Global() takes on every call.
+inline std::shared_ptr<opentracing::Tracer> &GlobalTracer() {
+  static std::shared_ptr<opentracing::Tracer> tracer =
+      opentracing::Tracer::Global();
+  return tracer;
+}
+
+inline std::string &TraceContextHeader() {
+  static std::string header = "uber-trace-id";
+  return header;
+}
+
+/*
+ * Reads the sampling flag of the upstream span from a carrier without
+ * extracting a span context. The Jaeger trace context is
+ * "trace-id:span-id:parent-span-id:flags", possibly URL-encoded, and bit 0
+ * of the flags is the sampling decision. Returns -1 if the carrier has no
+ * trace context this can parse; the caller then has to ask the tracer.
+ */
+inline int CarrierSampled(const std::map<std::string, std::string> &carrier) {
+  auto it = carrier.find(TraceContextHeader());
+  if (it == carrier.end()) {
+    return -1;
+  }
+  const std::string &value = it->second;
+  size_t start;
+  size_t pos = value.rfind(':');
+  if (pos != std::string::npos) {
+    start = pos + 1;
+  } else if ((pos = value.rfind("%3A")) != std::string::npos ||
+      (pos = value.rfind("%3a")) != std::string::npos) {
+    start = pos + 3;
+  } else {
+    return -1;
+  }
+  if (start >= value.size()) {
+    return -1;
+  }
+  char *end;
+  unsigned long flags = strtoul(value.c_str() + start, &end, 16);
+  if (*end != '\0') {
+    return -1;
+  }
+  return (flags & 1) ? 1 : 0;
+}
+
+struct TraceContext {
+  uint64_t trace_id_high;
+  uint64_t trace_id_low;
+  uint64_t span_id;
+  unsigned flags;
+};
+
+// Parses the whole Jaeger trace context of a carrier. Returns false if
+// there is none or it is malformed.
+inline bool ParseTraceContext(
+    const std::map<std::string, std::string> &carrier,
+    TraceContext *context) {
+  auto it = carrier.find(TraceContextHeader());
+  if (it == carrier.end()) {
+    return false;
+  }
+  std::string value = it->second;
+  for (size_t pos; (pos = value.find('%')) != std::string::npos;) {
+    if (value.compare(pos, 3, "%3A") && value.compare(pos, 3, "%3a")) {
+      return false;
+    }
+    value.replace(pos, 3, ":");
+  }
+  std::string fields[4];
+  size_t begin = 0;
+  for (int i = 0; i < 4; i++) {
+    size_t colon = value.find(':', begin);
+    if ((colon == std::string::npos) != (i == 3)) {
+      return false;
+    }
+    fields[i] = value.substr(begin, colon - begin);
+    if (fields[i].empty() || fields[i].size() > (i == 0 ? 32 : 16) ||
+        fields[i].find_first_not_of("0123456789abcdefABCDEF") !=
+            std::string::npos) {
+      return false;
+    }
+    begin = colon + 1;
+  }
+  const std::string &trace_id = fields[0];
+  size_t low_begin = trace_id.size() > 16 ? trace_id.size() - 16 : 0;
+  context->trace_id_high = low_begin ?
+      strtoull(trace_id.substr(0, low_begin).c_str(), nullptr, 16) : 0;
+  context->trace_id_low =
+      strtoull(trace_id.substr(low_begin).c_str(), nullptr, 16);
+  context->span_id = strtoull(fields[1].c_str(), nullptr, 16);
+  context->flags = strtoul(fields[3].c_str(), nullptr, 16);
+  return context->trace_id_low || context->trace_id_high;
+}
+
+inline TraceId CarrierTraceId(
+    const std::map<std::string, std::string> &carrier) {
+  TraceContext context;
+  if (!ParseTraceContext(carrier, &context)) {
+    return TraceId{0, 0};
+  }
+  return TraceId{context.trace_id_high, context.trace_id_low};
+}
+
+inline std::string FormatTraceContext(const TraceContext &context) {
+  char buf[80];
+  if (context.trace_id_high) {
+    snprintf(buf, sizeof(buf), "%" PRIx64 "%016" PRIx64 ":%" PRIx64 ":0:%x",
+             context.trace_id_high, context.trace_id_low, context.span_id,
+             context.flags);
+  } else {
+    snprintf(buf, sizeof(buf), "%" PRIx64 ":%" PRIx64 ":0:%x",
+             context.trace_id_low, context.span_id, context.flags);
+  }
+  return buf;
+}
+
+inline uint64_t RandomSpanId() {
+  thread_local std::mt19937_64 generator(std::random_device{}());
+  uint64_t id;
+  do {
+    id = generator();
+  } while (id == 0);
+  return id;
+}
+
+/*
+ * Tail sampling, enabled by a "tailSampling" section in the Jaeger config:
+ *
+ *   tailSampling:
+ *     enabled: true
+ *     latencyThresholdMs: 100
+ *     bufferSpans: 16384
+ *
+ * Every RPC is then traced, but its finished spans only go to a SpanRing.
+ * When an RPC took latencyThresholdMs or longer, or ended with an exception,
+ * its span is reported and the flusher thread hands the spans of its trace
+ * still in this process's ring to the Jaeger reporter.
+ *
+ * The decision is local to each service: it is taken when the RPC finishes,
+ * after the carrier has gone downstream, so the downstream services do not
+ * learn about it and drop their spans unless they keep the trace
+ * themselves. Only a trace that arrives already sampled (by the head
+ * sampler of nginx) is kept by every service it reaches.
+ */
+struct TailSampling {
+  std::unique_ptr<SpanRing> ring;  // null if tail sampling is off
+  int64_t latency_threshold_us = 0;
+
+  std::mutex mtx;
+  std::condition_variable cv;
+  std::vector<TraceId> pending;
+};
+
+inline TailSampling &GetTailSampling() {
+  static TailSampling tail_sampling;
+  return tail_sampling;
+}
+
+// Reports a span that finished earlier with its original ids and timing.
+// The opentracing API cannot set span ids, so this builds the Jaeger span
+// directly.
+inline void ReportSpanRecord(const SpanRecord &record) {
+  auto tracer = std::dynamic_pointer_cast<const jaegertracing::Tracer>(
+      GlobalTracer());
+  if (!tracer) {
+    return;
+  }
+  jaegertracing::SpanContext context(
+      jaegertracing::TraceID(record.trace_id_high, record.trace_id_low),
+      record.span_id, record.parent_id,
+      static_cast<unsigned char>(jaegertracing::SpanContext::Flag::kSampled),
+      jaegertracing::SpanContext::StrMap());
+  std::vector<jaegertracing::Tag> tags;
+  if (record.error) {
+    tags.emplace_back("error", true);
+  }
+  auto finish_steady = opentracing::SteadyClock::now();
+  jaegertracing::Span span(
+      tracer, context, record.operation,
+      opentracing::SystemTime(std::chrono::microseconds(record.start_us)),
+      finish_steady - std::chrono::microseconds(record.duration_us), tags);
+  opentracing::FinishSpanOptions options;
+  options.finish_steady_timestamp = finish_steady;
+  span.FinishWithOptions(options);
+}
+
+// Queues a kept trace for RunTailFlusher().
+inline void FlushTailTrace(uint64_t trace_id_high, uint64_t trace_id_low) {
+  auto &tail_sampling = GetTailSampling();
+  {
+    std::lock_guard<std::mutex> lock(tail_sampling.mtx);
+    if (tail_sampling.pending.size() >= TAIL_SAMPLING_MAX_PENDING_TRACES) {
+      return;
+    }
+    tail_sampling.pending.push_back(TraceId{trace_id_high, trace_id_low});
+  }
+  tail_sampling.cv.notify_one();
+}
+
+// Reports the spans of the queued traces that are still in the ring. Every
+// SpanRing::TakeIf() scans the whole ring, so this runs on its own thread
+// and takes all traces queued meanwhile in one scan.
+inline void RunTailFlusher() {
+  auto &tail_sampling = GetTailSampling();
+  auto less = [](const TraceId &a, const TraceId &b) {
+    return a.low != b.low ? a.low < b.low : a.high < b.high;
+  };
+  std::vector<TraceId> traces;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(tail_sampling.mtx);
+      tail_sampling.cv.wait(lock, [&] {
+        return !tail_sampling.pending.empty();
+      });
+      traces.swap(tail_sampling.pending);
+    }
+    std::sort(traces.begin(), traces.end(), less);
+    for (const auto &record : tail_sampling.ring->TakeIf(
+             [&](const SpanRecord &record) {
+               return std::binary_search(
+                   traces.begin(), traces.end(),
+                   TraceId{record.trace_id_high, record.trace_id_low}, less);
+             })) {
+      ReportSpanRecord(record);
+    }
+    traces.clear();
+  }
+}
+
+#ifndef MEDIA_MICROSERVICES_NO_TRACING
+
+/*
+ * The span of one RPC and its children. The sampling decision is taken once,
+ * in Start(): for a request whose upstream span was not sampled no span is
+ * created at all, Child() returns an empty span, tags are not formatted, and
+ * Carrier() forwards the incoming carrier unchanged, which passes the "not
+ * sampled" decision on to the next tier without re-injecting it.
+ *
+ * With tail sampling every span is recorded, without tags, and only
+ * reported if its trace is kept; see TailSampling. A span destroyed by an
+ * exception before Finish() is marked as an error. A head sampled span of
+ * an RPC gets the RequestBreakdown of the request so far as "breakdown.*"
+ * tags when it finishes.
+ *
+ * Building with MEDIA_MICROSERVICES_NO_TRACING compiles all of it out.
+ */
+class TraceSpan {
+ public:
+  TraceSpan() = default;
+  TraceSpan(TraceSpan &&other);
+  TraceSpan &operator=(TraceSpan &&) = delete;
+  ~TraceSpan();
+
+  // Starts the server span of an RPC, a child of the context in carrier.
+  static TraceSpan Start(
+      string_view operation,
+      const std::map<std::string, std::string> &carrier);
+
+  // A child span for one step of the RPC, e.g. a memcached or MongoDB call.
+  // Its Carrier() is the one of the span it was started from.
+  TraceSpan Child(string_view operation) const;
+
+  bool Sampled() const { return _span != nullptr || _tail; }
+
+  // The trace of the RPC, or zeros if it has none.
+  TraceId GetTraceId() const;
+
+  // The carrier to send to the next tier.
+  const std::map<std::string, std::string> &Carrier() const {
+    return _text_map ? *_text_map : *_carrier;
+  }
+
+  void SetTag(string_view key, const opentracing::Value &value) {
+    if (_span) _span->SetTag(key, value);
+  }
+
+  // Only calls format() if the span is sampled.
+  template <class F>
+  void SetTagWith(string_view key, F format) {
+    if (_span) _span->SetTag(key, format());
+  }
+
+  void Finish() { _Finish(false); }
+
+ private:
+  static const std::map<std::string, std::string> &_EmptyCarrier() {
+    static const std::map<std::string, std::string> carrier;
+    return carrier;
+  }
+
+  static TraceSpan _StartTail(
+      string_view operation,
+      const std::map<std::string, std::string> &carrier);
+  void _InitRecord(string_view operation, uint64_t trace_id_high,
+                   uint64_t trace_id_low, uint64_t parent_id);
+  void _Finish(bool error);
+
+  std::unique_ptr<opentracing::Span> _span;
+  const std::map<std::string, std::string> *_carrier = &_EmptyCarrier();
+  // Only set for a sampled span started by Start(); held by pointer so that
+  // references from Carrier() and children survive moving the span.
+  std::unique_ptr<std::map<std::string, std::string>> _text_map;
+  bool _finished = false;
+
+  // Tail sampling state.
+  bool _tail = false;
+  bool _server = false;
+  bool _keep = false;
+  SpanRecord _record;
+  std::chrono::steady_clock::time_point _start;
+};
+
+inline TraceSpan::TraceSpan(TraceSpan &&other)
+    : _span(std::move(other._span)),
+      _carrier(other._carrier),
+      _text_map(std::move(other._text_map)),
+      _finished(other._finished),
+      _tail(other._tail),
+      _server(other._server),
+      _keep(other._keep),
+      _start(other._start) {
+  if (_tail) {
+    _record = other._record;
+  }
+  other._finished = true;
+}
+
+inline TraceSpan::~TraceSpan() {
+  if (!_finished) {
+    _Finish(std::uncaught_exception());
+  }
+}
+
+inline TraceSpan TraceSpan::Start(
+    string_view operation,
+    const std::map<std::string, std::string> &carrier) {
+  if (GetTailSampling().ring) {
+    return _StartTail(operation, carrier);
+  }
+  TraceSpan span;
+  span._carrier = &carrier;
+  if (CarrierSampled(carrier) == 0) {
+    return span;
+  }
+
+  // Sampled upstream, or no upstream decision: a root span, or one from a
+  // client that does not speak the Jaeger format, asks the sampler.
+  auto &tracer = GlobalTracer();
+  TextMapReader reader(carrier);
+  auto parent_span = tracer->Extract(reader);
+  auto started = tracer->StartSpan(
+      operation,
+      {opentracing::ChildOf(parent_span ? parent_span->get() : nullptr)});
+  // Injected even if the sampler said no, the next tier needs the decision.
+  span._text_map.reset(new std::map<std::string, std::string>());
+  TextMapWriter writer(*span._text_map);
+  tracer->Inject(started->context(), writer);
+  auto context = dynamic_cast<const jaegertracing::SpanContext *>(
+      &started->context());
+  if (!context || context->isSampled()) {
+    span._span = std::move(started);
+    span._server = true;
+  }
+  return span;
+}
+
+inline TraceSpan TraceSpan::_StartTail(
+    string_view operation,
+    const std::map<std::string, std::string> &carrier) {
+  TraceSpan span;
+  span._carrier = &carrier;
+  span._tail = true;
+  span._server = true;
+  TraceContext context;
+  if (!ParseTraceContext(carrier, &context)) {
+    context.trace_id_high = 0;
+    context.trace_id_low = RandomSpanId();
+    context.span_id = 0;
+    context.flags = 0;
+  }
+  span._keep = context.flags & 1;
+  span._InitRecord(operation, context.trace_id_high, context.trace_id_low,
+                   context.span_id);
+
+  // The next tier needs this span as its parent, so unlike the head
+  // sampled path the carrier is always rewritten.
+  context.span_id = span._record.span_id;
+  context.flags = span._keep ? 1 : 0;
+  span._text_map.reset(new std::map<std::string, std::string>(carrier));
+  (*span._text_map)[TraceContextHeader()] = FormatTraceContext(context);
+  return span;
+}
+
+inline TraceSpan TraceSpan::Child(string_view operation) const {
+  TraceSpan child;
+  child._carrier = &Carrier();
+  if (_span) {
+    child._span = GlobalTracer()->StartSpan(
+        operation, {opentracing::ChildOf(&_span->context())});
+  } else if (_tail) {
+    child._tail = true;
+    child._keep = _keep;
+    child._InitRecord(operation, _record.trace_id_high, _record.trace_id_low,
+                      _record.span_id);
+  }
+  return child;
+}
+
+inline TraceId TraceSpan::GetTraceId() const {
+  if (_tail) {
+    return TraceId{_record.trace_id_high, _record.trace_id_low};
+  }
+  if (_span) {
+    auto context = dynamic_cast<const jaegertracing::SpanContext *>(
+        &_span->context());
+    if (context) {
+      return TraceId{context->traceID().high(), context->traceID().low()};
+    }
+  }
+  return CarrierTraceId(*_carrier);
+}
+
+inline void TraceSpan::_InitRecord(
+    string_view operation, uint64_t trace_id_high, uint64_t trace_id_low,
+    uint64_t parent_id) {
+  memset(&_record, 0, sizeof(_record));
+  _record.trace_id_high = trace_id_high;
+  _record.trace_id_low = trace_id_low;
+  _record.span_id = RandomSpanId();
+  _record.parent_id = parent_id;
+  memcpy(_record.operation, operation.data(),
+         std::min(operation.size(), sizeof(_record.operation) - 1));
+  _record.start_us = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+  _start = std::chrono::steady_clock::now();
+}
+
+inline void TraceSpan::_Finish(bool error) {
+  if (_finished) {
+    return;
+  }
+  _finished = true;
+  if (_span) {
+    if (error) {
+      _span->SetTag("error", true);
+    }
+    if (_server && CurrentRequestBreakdown()) {
+      ForEachBreakdownTag(*CurrentRequestBreakdown(),
+                          [this](const std::string &key, double value) {
+        _span->SetTag(key, value);
+      });
+    }
+    _span->Finish();
+    return;
+  }
+  if (!_tail) {
+    return;
+  }
+
+  auto &tail_sampling = GetTailSampling();
+  _record.duration_us = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - _start).count();
+  _record.error = error ? 1 : 0;
+  bool keep = _server && (_keep || error ||
+      _record.duration_us >= tail_sampling.latency_threshold_us);
+  if (!keep) {
+    tail_sampling.ring->Push(_record);
+    return;
+  }
+  // The children of this RPC, and earlier RPCs of the same trace served by
+  // this process, are still in the ring.
+  ReportSpanRecord(_record);
+  FlushTailTrace(_record.trace_id_high, _record.trace_id_low);
+}
+
+#else
+
+class TraceSpan {
+ public:
+  static TraceSpan Start(
+      string_view,
+      const std::map<std::string, std::string> &carrier) {
+    TraceSpan span;
+    span._carrier = &carrier;
+    return span;
+  }
+
+  TraceSpan Child(string_view) const { return *this; }
+
+  constexpr bool Sampled() const { return false; }
+
+  TraceId GetTraceId() const { return CarrierTraceId(*_carrier); }
+
+  const std::map<std::string, std::string> &Carrier() const {
+    return *_carrier;
+  }
+
+  template <class T>
+  void SetTag(string_view, const T &) {}
+
+  template <class F>
+  void SetTagWith(string_view, F) {}
+
+  void Finish() {}
+
+ private:
+  const std::map<std::string, std::string> *_carrier = nullptr;
+};
+
+#endif // MEDIA_MICROSERVICES_NO_TRACING
+
 void SetUpTracer(
     const std::string &config_file_path,
     const std::string &service) {
+  // Every service calls this first thing, so it also names the service in
+  // the RequestContext blocks.
+  SetRequestContextService(service);
+#ifndef MEDIA_MICROSERVICES_NO_TRACING
   auto configYAML = YAML::LoadFile(config_file_path);
   auto config = jaegertracing::Config::parse(configYAML);
   auto tracer = jaegertracing::Tracer::make(
       service, config, jaegertracing::logging::consoleLogger());
   opentracing::Tracer::InitGlobal(
       std::static_pointer_cast<opentracing::Tracer>(tracer));
+  GlobalTracer() = opentracing::Tracer::Global();
+  TraceContextHeader() = config.headers().traceContextHeaderName();
+
+  const YAML::Node tail_yaml = configYAML["tailSampling"];
+  if (tail_yaml && tail_yaml["enabled"].as<bool>(false)) {
+    auto &tail_sampling = GetTailSampling();
+    tail_sampling.ring.reset(new SpanRing(tail_yaml["bufferSpans"].as<size_t>(
+        TAIL_SAMPLING_DEFAULT_BUFFER_SPANS)));
+    tail_sampling.latency_threshold_us = 1000 *
+        tail_yaml["latencyThresholdMs"].as<int64_t>(
+            TAIL_SAMPLING_DEFAULT_LATENCY_THRESHOLD_MS);
+    std::thread(RunTailFlusher).detach();
+  }
+#endif
 }
 
 
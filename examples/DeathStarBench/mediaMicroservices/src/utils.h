@@ -3,10 +3,14 @@
 
 #include <string>
 #include <fstream>
+#include <set>
+#include <utility>
+#include <vector>
 #include <iostream>
 #include <nlohmann/json.hpp>
 
 #include "logger.h"
+#include "Executor.h"
 
 namespace media_service{
 using json = nlohmann::json;
@@ -25,6 +29,55 @@ int load_config_file(const std::string &file_name, json *config_json) {
   }
 };
 
+// Addresses of the replicas of a service: the entries of its optional
+// "replicas" list, or just its own addr and port. The callers hash requests
+// onto this list, so an empty list or a replica listed twice is a config
+// error rather than something to guess around.
+std::vector<std::pair<std::string, int>> get_service_replicas(
+    const json &config_json, const std::string &service_name) {
+  std::vector<std::pair<std::string, int>> replicas;
+  auto &service_json = config_json[service_name];
+  if (!service_json.contains("replicas")) {
+    replicas.emplace_back(service_json["addr"].get<std::string>(),
+                          service_json["port"].get<int>());
+    return replicas;
+  }
+  if (!service_json["replicas"].is_array() ||
+      service_json["replicas"].empty()) {
+    LOG(fatal) << "\"replicas\" of " << service_name
+               << " must be a non-empty list";
+    exit(EXIT_FAILURE);
+  }
+  std::set<std::pair<std::string, int>> seen;
+  for (auto &replica : service_json["replicas"]) {
+    std::pair<std::string, int> addr(replica["addr"].get<std::string>(),
+                                     replica["port"].get<int>());
+    if (!seen.insert(addr).second) {
+      LOG(fatal) << "Replica " << addr.first << ":" << addr.second
+                 << " of " << service_name << " is listed twice";
+      exit(EXIT_FAILURE);
+    }
+    replicas.push_back(std::move(addr));
+  }
+  return replicas;
+}
+
+// Sizes the process-wide Executor from the optional "executor" object of a
+// service, e.g. {"threads": 64, "queue_capacity": 4096}. Call it before the
+// server starts.
+void init_executor(const json &config_json, const std::string &service_name) {
+  auto executor_json =
+      config_json[service_name].value("executor", json::object());
+  int threads = executor_json.value("threads", DefaultExecutorThreads());
+  int queue_capacity = executor_json.value("queue_capacity",
+                                           EXECUTOR_DEFAULT_QUEUE_CAPACITY);
+  if (threads <= 0 || queue_capacity <= 0) {
+    LOG(fatal) << "Invalid executor settings for " << service_name;
+    exit(EXIT_FAILURE);
+  }
+  InitExecutor(threads, queue_capacity);
+}
+
 } //namespace media_service
 
 #endif //MEDIA_MICROSERVICES_UTILS_H
@@ -4,10 +4,24 @@
 #include <mongoc.h>
 #include <bson/bson.h>
 
+#include "RequestBreakdown.h"
+
 #define SERVER_SELECTION_TIMEOUT_MS 300
 #define MONGODB_POOL_MAX_SIZE 128
 
 namespace media_service {
+// Monitoring callbacks, run on the thread that sends the command, that count
+// the BSON sizes of commands and replies as MongoDB bytes of the request.
+void _MongoCommandStarted(const mongoc_apm_command_started_t *event) {
+  RecordBackendBytes(REQUEST_PHASE_MONGO,
+      mongoc_apm_command_started_get_command(event)->len, 0);
+}
+
+void _MongoCommandSucceeded(const mongoc_apm_command_succeeded_t *event) {
+  RecordBackendBytes(REQUEST_PHASE_MONGO, 0,
+      mongoc_apm_command_succeeded_get_reply(event)->len);
+}
+
 mongoc_client_pool_t* init_mongodb_client_pool(
     const json &config_json,
     const std::string &service_name,
@@ -34,6 +48,11 @@ mongoc_client_pool_t* init_mongodb_client_pool(
   } else {
     mongoc_client_pool_t *client_pool= mongoc_client_pool_new(mongodb_uri);
     mongoc_client_pool_max_size(client_pool, max_size);
+    mongoc_apm_callbacks_t *callbacks = mongoc_apm_callbacks_new();
+    mongoc_apm_set_command_started_cb(callbacks, _MongoCommandStarted);
+    mongoc_apm_set_command_succeeded_cb(callbacks, _MongoCommandSucceeded);
+    mongoc_client_pool_set_apm_callbacks(client_pool, callbacks, nullptr);
+    mongoc_apm_callbacks_destroy(callbacks);
     return client_pool;
   }
 }
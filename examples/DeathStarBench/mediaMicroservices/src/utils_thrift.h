@@ -0,0 +1,164 @@
+#ifndef MEDIA_MICROSERVICES_SRC_UTILS_THRIFT_H_
+#define MEDIA_MICROSERVICES_SRC_UTILS_THRIFT_H_
+
+#include <memory>
+#include <string>
+
+#include <thrift/concurrency/PlatformThreadFactory.h>
+#include <thrift/concurrency/ThreadManager.h>
+#include <thrift/protocol/TBinaryProtocol.h>
+#include <thrift/server/TNonblockingServer.h>
+#include <thrift/server/TThreadPoolServer.h>
+#include <thrift/server/TThreadedServer.h>
+#include <thrift/transport/TBufferTransports.h>
+#include <thrift/transport/TNonblockingServerSocket.h>
+#include <thrift/transport/TServerSocket.h>
+
+#include "FlightRecorder.h"
+#include "Metrics.h"
+#include "RequestBreakdown.h"
+#include "logger.h"
+
+// Used when a service has no "server" section in service-config.json.
+#define THRIFT_SERVER_DEFAULT_TYPE "threaded"
+#define THRIFT_SERVER_DEFAULT_IO_THREADS 4
+#define THRIFT_SERVER_DEFAULT_WORKER_THREADS 64
+#define THRIFT_SERVER_DEFAULT_BACKLOG 1024
+
+namespace media_service {
+
+using apache::thrift::TProcessor;
+using apache::thrift::concurrency::PlatformThreadFactory;
+using apache::thrift::concurrency::ThreadManager;
+using apache::thrift::protocol::TBinaryProtocolFactory;
+using apache::thrift::server::TNonblockingServer;
+using apache::thrift::server::TServer;
+using apache::thrift::server::TThreadPoolServer;
+using apache::thrift::server::TThreadedServer;
+using apache::thrift::transport::TFramedTransportFactory;
+using apache::thrift::transport::TNonblockingServerSocket;
+using apache::thrift::transport::TServerSocket;
+
+/*
+ * Starts the process-wide observability of a service; call it once from
+ * main(). The service's metrics are served on its "metrics_port"
+ * (METRICS_DEFAULT_PORT if unset, 0 to turn them off); see Metrics.h.
+ * SIGUSR1 logs where the time of each method went; see RequestBreakdown.h.
+ * The last requests are kept in a flight recorder file unless the optional
+ * "flight_recorder" object turns it off:
+ *
+ *   "flight_recorder": {
+ *     "enabled": true,
+ *     "path": "/tmp/movie-id-service.flight",  // default /tmp/<service>.flight
+ *     "requests": 4096                         // ring size, 1 KiB each
+ *   }
+ *
+ * SIGUSR2 dumps it as text next to the file; see FlightRecorder.h.
+ */
+void start_observability(const json &config_json,
+                         const std::string &service_name) {
+  int metrics_port = config_json[service_name].value(
+      "metrics_port", METRICS_DEFAULT_PORT);
+  if (metrics_port > 0) {
+    StartMetricsServer(metrics_port);
+  }
+  StartBreakdownReport();
+  json recorder_json = json::object();
+  if (config_json[service_name].contains("flight_recorder")) {
+    recorder_json = config_json[service_name]["flight_recorder"];
+  }
+  if (recorder_json.value("enabled", true)) {
+    StartFlightRecorder(
+        recorder_json.value("path", "/tmp/" + service_name + ".flight"),
+        service_name,
+        recorder_json.value("requests", FLIGHT_RECORDER_DEFAULT_REQUESTS));
+  }
+}
+
+/*
+ * Builds the Thrift server of a service from its entry in
+ * service-config.json. The optional "server" object selects the engine:
+ *
+ *   "server": {
+ *     "type": "nonblocking",     // "threaded", "threadpool" or "nonblocking"
+ *     "io_threads": 4,           // nonblocking: epoll loops
+ *     "worker_threads": 64,      // threadpool and nonblocking: handler threads
+ *     "backlog": 1024            // listen backlog
+ *   }
+ *
+ * "threaded" keeps a thread per connection, as before. "threadpool" caps
+ * the thread count, but a connection still holds a worker until it closes,
+ * so worker_threads must cover every connection peers keep pooled; extra
+ * connections wait for a free worker. "nonblocking" multiplexes all
+ * connections over io_threads event loops and hands requests to
+ * worker_threads, so idle pooled connections cost no thread at all. All
+ * engines speak framed binary protocol, which is what the clients use, and
+ * all of them process the calls of one connection in order.
+ *
+ * It only builds the server; start_observability() starts the process-wide
+ * metrics endpoint, breakdown report and flight recorder, once per process.
+ */
+std::shared_ptr<TServer> init_thrift_server(
+    const json &config_json,
+    const std::string &service_name,
+    const std::shared_ptr<TProcessor> &processor
+) {
+  int port = config_json[service_name]["port"];
+  json server_json = json::object();
+  if (config_json[service_name].contains("server")) {
+    server_json = config_json[service_name]["server"];
+  }
+  std::string type =
+      server_json.value("type", std::string(THRIFT_SERVER_DEFAULT_TYPE));
+  int io_threads =
+      server_json.value("io_threads", THRIFT_SERVER_DEFAULT_IO_THREADS);
+  int worker_threads =
+      server_json.value("worker_threads", THRIFT_SERVER_DEFAULT_WORKER_THREADS);
+  int backlog = server_json.value("backlog", THRIFT_SERVER_DEFAULT_BACKLOG);
+
+  auto protocol_factory = std::make_shared<TBinaryProtocolFactory>();
+  std::shared_ptr<TServer> server;
+
+  if (type == "nonblocking" || type == "threadpool") {
+    auto thread_manager = ThreadManager::newSimpleThreadManager(worker_threads);
+    thread_manager->threadFactory(std::make_shared<PlatformThreadFactory>());
+    thread_manager->start();
+
+    if (type == "nonblocking") {
+      auto server_socket = std::make_shared<TNonblockingServerSocket>(port);
+      server_socket->setAcceptBacklog(backlog);
+      auto nonblocking_server = std::make_shared<TNonblockingServer>(
+          processor, protocol_factory, server_socket, thread_manager);
+      nonblocking_server->setNumIOThreads(io_threads);
+      server = nonblocking_server;
+    } else {
+      auto server_socket = std::make_shared<TServerSocket>("0.0.0.0", port);
+      server_socket->setAcceptBacklog(backlog);
+      server = std::make_shared<TThreadPoolServer>(
+          processor, server_socket,
+          std::make_shared<TFramedTransportFactory>(), protocol_factory,
+          thread_manager);
+    }
+  } else {
+    if (type != "threaded") {
+      LOG(warning) << "Unknown server type " << type << " for "
+                   << service_name << ", using threaded";
+      type = "threaded";
+    }
+    auto server_socket = std::make_shared<TServerSocket>("0.0.0.0", port);
+    server_socket->setAcceptBacklog(backlog);
+    server = std::make_shared<TThreadedServer>(
+        processor, server_socket,
+        std::make_shared<TFramedTransportFactory>(), protocol_factory);
+  }
+
+  LOG(info) << service_name << " uses the " << type << " server on port "
+            << port << " (io_threads=" << io_threads
+            << ", worker_threads=" << worker_threads
+            << ", backlog=" << backlog << ")";
+  return server;
+}
+
+} // namespace media_service
+
+#endif //MEDIA_MICROSERVICES_SRC_UTILS_THRIFT_H_
@@ -0,0 +1,147 @@
+#ifndef MEDIA_MICROSERVICES_UTILS_WORKER_ID_H
+#define MEDIA_MICROSERVICES_UTILS_WORKER_ID_H
+
+#include <net/if.h>
+#include <netinet/in.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+
+#include "utils.h"
+#include "utils_mongodb.h"
+#include "WorkerIdLease.h"
+
+#define MAC_ADDRESS_LEN 6
+#define WORKER_ID_LEASE_DEFAULT_TTL_MS 10000
+
+namespace media_service {
+
+/*
+ * The following code which obtaines machine ID from machine's MAC address was
+ * inspired from https://stackoverflow.com/a/16859693.
+ *
+ * FNV-1a over the MAC address and the pid, so that replicas on one host get
+ * different IDs too, folded to the worker ID range.
+ */
+uint16_t HashMacAddressPid(const std::string &mac) {
+  std::string mac_pid = mac + std::to_string(getpid());
+  uint32_t hash = 2166136261u;
+  for (unsigned char c : mac_pid) {
+    hash ^= c;
+    hash *= 16777619u;
+  }
+  return (hash ^ (hash >> 16)) % WORKER_ID_LEASE_MAX_IDS;
+}
+
+int GetMachineId(uint16_t *machine_id) {
+  int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+  if (sock < 0) {
+    LOG(error) << "Unable to obtain MAC address";
+    return -1;
+  }
+
+  struct ifconf conf{};
+  char ifconfbuf[128 * sizeof(struct ifreq)];
+  memset(ifconfbuf, 0, sizeof(ifconfbuf));
+  conf.ifc_buf = ifconfbuf;
+  conf.ifc_len = sizeof(ifconfbuf);
+  if (ioctl(sock, SIOCGIFCONF, &conf)) {
+    LOG(error) << "Unable to obtain MAC address";
+    close(sock);
+    return -1;
+  }
+
+  // The first interface that is not a loopback and has a non-zero hardware
+  // address. The address is binary and may contain zero bytes.
+  std::string mac;
+  int num_ifs = conf.ifc_len / sizeof(struct ifreq);
+  for (int i = 0; i < num_ifs && mac.empty(); i++) {
+    struct ifreq ifr = conf.ifc_req[i];
+    if (ioctl(sock, SIOCGIFFLAGS, &ifr) || (ifr.ifr_flags & IFF_LOOPBACK)) {
+      continue;
+    }
+    if (ioctl(sock, SIOCGIFHWADDR, &ifr) == 0) {
+      std::string hwaddr(ifr.ifr_hwaddr.sa_data, MAC_ADDRESS_LEN);
+      if (hwaddr != std::string(MAC_ADDRESS_LEN, '\0')) {
+        mac = hwaddr;
+      }
+    }
+  }
+  close(sock);
+
+  if (mac.empty()) {
+    LOG(warning) << "No MAC address found, the machine id only depends on "
+                    "the pid";
+  }
+  *machine_id = HashMacAddressPid(mac);
+  return 0;
+}
+
+/*
+ * Picks the worker ID a service generates unique IDs with. With a
+ * "worker_id_lease" object in the service's config the ID is leased from a
+ * shared store and renewed in the background:
+ *   {"store": "mongodb", "ttl_ms": 10000} uses the service's -mongodb entry,
+ *   {"store": "file", "path": "/var/lib/worker-ids"} a local directory.
+ * Otherwise it is hashed from the MAC address and pid, which can collide
+ * once there are more than a few replicas. *lease is left empty then.
+ */
+int init_worker_id(
+    const json &config_json,
+    const std::string &service_name,
+    std::unique_ptr<WorkerIdLease> *lease,
+    uint16_t *worker_id) {
+  uint16_t machine_id;
+  if (GetMachineId(&machine_id) != 0) {
+    return -1;
+  }
+  auto &service_json = config_json[service_name + "-service"];
+  if (!service_json.contains("worker_id_lease")) {
+    *worker_id = machine_id;
+    return 0;
+  }
+
+  auto &lease_json = service_json["worker_id_lease"];
+  std::string store_type = lease_json.value("store", "mongodb");
+  std::unique_ptr<WorkerIdStore> store;
+  if (store_type == "file") {
+    store.reset(new FileWorkerIdStore(lease_json.value("path", ".")));
+  } else if (store_type == "mongodb") {
+    mongoc_client_pool_t *mongodb_client_pool =
+        init_mongodb_client_pool(config_json, service_name, 4);
+    if (mongodb_client_pool == nullptr) {
+      return -1;
+    }
+    store.reset(new MongoWorkerIdStore(mongodb_client_pool, service_name));
+  } else {
+    LOG(error) << "Unknown worker_id_lease store " << store_type;
+    return -1;
+  }
+
+  // Unique per process, so a restarted replica never renews the lease of
+  // its previous incarnation.
+  char hostname[256] = {0};
+  gethostname(hostname, sizeof(hostname) - 1);
+  std::random_device rd;
+  std::string owner = std::string(hostname) + ":" +
+      std::to_string(getpid()) + ":" + std::to_string(rd());
+
+  lease->reset(new WorkerIdLease(
+      std::move(store), owner,
+      lease_json.value("ttl_ms", WORKER_ID_LEASE_DEFAULT_TTL_MS)));
+  // Start probing at the hashed ID so replicas rarely contend for one ID.
+  if (!(*lease)->Acquire(machine_id)) {
+    return -1;
+  }
+  *worker_id = static_cast<uint16_t>((*lease)->WorkerId());
+  return 0;
+}
+
+} // namespace media_service
+
+#endif // MEDIA_MICROSERVICES_UTILS_WORKER_ID_H
@@ -0,0 +1,151 @@
+// Contention microbenchmark for ClientPool. Worker threads repeatedly Pop()
+// and Push() a mock client, so the numbers isolate the pool's own overhead.
+// A mutex + deque pool equivalent to the previous implementation is measured
+// alongside as the baseline.
+//
+// Usage: benchClientPool [max_threads] [ops_per_thread] [pool_size]
+
+#include "../src/ClientPool.h"
+#include "../src/GenericClient.h"
+#include "../src/logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <thread>
+#include <vector>
+
+using namespace media_service;
+
+class MockClient : public GenericClient {
+ public:
+  MockClient(const std::string &addr, int port) {}
+  void Connect() override { _connect_timestamp = _CurrentTimestamp(); }
+  void Disconnect() override {}
+  bool IsConnected() override { return true; }
+  bool Ping() override { return true; }
+  void KeepAlive() override {}
+  void KeepAlive(int timeout_ms) override {}
+};
+
+class MutexClientPool {
+ public:
+  MutexClientPool(int max_size) : _max_pool_size(max_size) {}
+  ~MutexClientPool() {
+    for (auto client : _pool) {
+      delete client;
+    }
+  }
+
+  MockClient *Pop() {
+    std::unique_lock<std::mutex> cv_lock(_mtx);
+    while (_pool.empty() && _curr_pool_size >= _max_pool_size) {
+      _cv.wait(cv_lock);
+    }
+    MockClient *client;
+    if (!_pool.empty()) {
+      client = _pool.front();
+      _pool.pop_front();
+    } else {
+      client = new MockClient("", 0);
+      _curr_pool_size++;
+    }
+    cv_lock.unlock();
+    client->Connect();
+    return client;
+  }
+
+  void Push(MockClient *client) {
+    std::unique_lock<std::mutex> cv_lock(_mtx);
+    client->KeepAlive();
+    _pool.push_back(client);
+    cv_lock.unlock();
+    _cv.notify_one();
+  }
+
+ private:
+  std::deque<MockClient *> _pool;
+  int _max_pool_size;
+  int _curr_pool_size = 0;
+  std::mutex _mtx;
+  std::condition_variable _cv;
+};
+
+struct Result {
+  double ops_per_sec;
+  double p50_ns;
+  double p99_ns;
+};
+
+template <class TPool>
+Result Run(TPool *pool, int num_threads, int ops_per_thread) {
+  std::vector<std::vector<uint32_t>> latencies(num_threads);
+  std::vector<std::thread> threads;
+  std::atomic<bool> start{false};
+
+  for (int t = 0; t < num_threads; t++) {
+    latencies[t].reserve(ops_per_thread);
+    threads.emplace_back([&, t]() {
+      while (!start.load()) {
+        std::this_thread::yield();
+      }
+      for (int i = 0; i < ops_per_thread; i++) {
+        auto begin = std::chrono::steady_clock::now();
+        auto client = pool->Pop();
+        pool->Push(client);
+        auto end = std::chrono::steady_clock::now();
+        latencies[t].push_back(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                end - begin).count());
+      }
+    });
+  }
+
+  auto begin = std::chrono::steady_clock::now();
+  start.store(true);
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  std::vector<uint32_t> all;
+  for (auto &l : latencies) {
+    all.insert(all.end(), l.begin(), l.end());
+  }
+  std::sort(all.begin(), all.end());
+  double secs = std::chrono::duration<double>(end - begin).count();
+
+  Result result;
+  result.ops_per_sec = all.size() / secs;
+  result.p50_ns = all[all.size() / 2];
+  result.p99_ns = all[all.size() * 99 / 100];
+  return result;
+}
+
+int main(int argc, char *argv[]) {
+  init_logger();
+  int max_threads = argc > 1 ? atoi(argv[1]) :
+      std::max(2 * std::thread::hardware_concurrency(), 2u);
+  int ops_per_thread = argc > 2 ? atoi(argv[2]) : 200000;
+  int pool_size = argc > 3 ? atoi(argv[3]) : 128;
+
+  printf("%-8s %-8s %14s %10s %10s\n",
+         "pool", "threads", "ops/s", "p50(ns)", "p99(ns)");
+  for (int threads = 1; threads <= max_threads; threads *= 2) {
+    {
+      MutexClientPool pool(pool_size);
+      auto r = Run(&pool, threads, ops_per_thread);
+      printf("%-8s %-8d %14.0f %10.0f %10.0f\n",
+             "mutex", threads, r.ops_per_sec, r.p50_ns, r.p99_ns);
+    }
+    {
+      ClientPool<MockClient> pool("mock", "", 0, 0, pool_size, 1000);
+      auto r = Run(&pool, threads, ops_per_thread);
+      printf("%-8s %-8d %14.0f %10.0f %10.0f\n",
+             "sharded", threads, r.ops_per_sec, r.p50_ns, r.p99_ns);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,189 @@
+// Per-component latency of the memcached writes ComposeReviewHandler makes
+// for each uploaded review component, against a live memcached server.
+// "sequential" is the add counter / add component / increment sequence,
+// "pipelined" the quiet buffered set plus increment_with_initial of
+// ComposeReviewHandler::_UploadComponentPipelined(). Both must compose every
+// review exactly once, i.e. see its counter reach NUM_COMPONENTS once; the
+// benchmark fails otherwise.
+//
+// Usage: benchComposeUpload [addr] [port] [threads] [reviews_per_thread]
+
+#include <libmemcached/memcached.h>
+#include <libmemcached/util.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Returned by an upload whose memcached calls failed.
+#define UPLOAD_FAILED UINT64_MAX
+
+#define NUM_COMPONENTS 5
+#define MMC_EXP_TIME 10
+
+static const char *kComponents[NUM_COMPONENTS] = {
+    "review_id", "movie_id", "user_id", "text", "rating"};
+
+static uint64_t UploadSequential(memcached_st *client, int64_t req_id,
+                                 const std::string &component,
+                                 const std::string &value) {
+  std::string key_counter = std::to_string(req_id) + ":counter";
+  std::string key_component = std::to_string(req_id) + ":" + component;
+  memcached_return_t rc = memcached_add(
+      client, key_counter.c_str(), key_counter.size(), "0", 1, MMC_EXP_TIME,
+      0);
+  if (rc != MEMCACHED_SUCCESS && rc != MEMCACHED_NOTSTORED) {
+    return UPLOAD_FAILED;
+  }
+  rc = memcached_add(client, key_component.c_str(), key_component.size(),
+                     value.c_str(), value.size(), MMC_EXP_TIME, 0);
+  if (rc != MEMCACHED_SUCCESS) {
+    return UPLOAD_FAILED;
+  }
+  uint64_t counter_value = 0;
+  rc = memcached_increment(client, key_counter.c_str(), key_counter.size(), 1,
+                           &counter_value);
+  return rc == MEMCACHED_SUCCESS ? counter_value : UPLOAD_FAILED;
+}
+
+static uint64_t UploadPipelined(memcached_st *client, int64_t req_id,
+                                const std::string &component,
+                                const std::string &value) {
+  std::string key_counter = std::to_string(req_id) + ":counter";
+  std::string key_component = std::to_string(req_id) + ":" + component;
+  memcached_behavior_set(client, MEMCACHED_BEHAVIOR_NOREPLY, 1);
+  memcached_behavior_set(client, MEMCACHED_BEHAVIOR_BUFFER_REQUESTS, 1);
+  memcached_return_t rc = memcached_set(
+      client, key_component.c_str(), key_component.size(), value.c_str(),
+      value.size(), MMC_EXP_TIME, 0);
+  memcached_behavior_set(client, MEMCACHED_BEHAVIOR_BUFFER_REQUESTS, 0);
+  memcached_behavior_set(client, MEMCACHED_BEHAVIOR_NOREPLY, 0);
+  if (rc != MEMCACHED_BUFFERED && rc != MEMCACHED_SUCCESS) {
+    return UPLOAD_FAILED;
+  }
+  uint64_t counter_value = 0;
+  rc = memcached_increment_with_initial(client, key_counter.c_str(),
+                                        key_counter.size(), 1, 1,
+                                        MMC_EXP_TIME, &counter_value);
+  if (rc != MEMCACHED_SUCCESS) {
+    memcached_quit(client);
+    return UPLOAD_FAILED;
+  }
+  return counter_value;
+}
+
+struct Result {
+  double p50_us;
+  double p99_us;
+  long completed;
+  long failed;
+  // Reviews whose counter did not reach NUM_COMPONENTS exactly once.
+  long not_composed_once;
+};
+
+template <class TUpload>
+Result Run(memcached_pool_st *pool, TUpload upload, int num_threads,
+           int reviews_per_thread, int64_t req_id_base) {
+  std::vector<std::vector<uint32_t>> latencies(num_threads);
+  std::vector<std::thread> threads;
+  std::atomic<long> completed{0};
+  std::atomic<long> failed{0};
+  std::vector<int> composes(int64_t(num_threads) * reviews_per_thread, 0);
+  std::string text(256, 'x');
+
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t]() {
+      memcached_return_t rc;
+      auto client = memcached_pool_pop(pool, true, &rc);
+      for (int i = 0; i < reviews_per_thread; i++) {
+        int64_t review = int64_t(t) * reviews_per_thread + i;
+        int64_t req_id = req_id_base + review;
+        for (int c = 0; c < NUM_COMPONENTS; c++) {
+          auto begin = std::chrono::steady_clock::now();
+          uint64_t counter = upload(client, req_id, kComponents[c],
+                                    c == 3 ? text : std::to_string(req_id));
+          auto end = std::chrono::steady_clock::now();
+          latencies[t].push_back(
+              std::chrono::duration_cast<std::chrono::microseconds>(
+                  end - begin).count());
+          if (counter == UPLOAD_FAILED) {
+            failed++;
+          } else if (counter == NUM_COMPONENTS) {
+            composes[review]++;
+            completed++;
+          }
+        }
+      }
+      memcached_pool_push(pool, client);
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  std::vector<uint32_t> all;
+  for (auto &l : latencies) {
+    all.insert(all.end(), l.begin(), l.end());
+  }
+  std::sort(all.begin(), all.end());
+  Result result;
+  result.p50_us = all[all.size() / 2];
+  result.p99_us = all[all.size() * 99 / 100];
+  result.completed = completed.load();
+  result.failed = failed.load();
+  result.not_composed_once = std::count_if(
+      composes.begin(), composes.end(), [](int n) { return n != 1; });
+  return result;
+}
+
+int main(int argc, char *argv[]) {
+  std::string addr = argc > 1 ? argv[1] : "127.0.0.1";
+  int port = argc > 2 ? atoi(argv[2]) : 11211;
+  int num_threads = argc > 3 ? atoi(argv[3]) : 8;
+  int reviews_per_thread = argc > 4 ? atoi(argv[4]) : 2000;
+
+  std::string config_str = "--SERVER=" + addr + ":" + std::to_string(port);
+  auto memcached_client = memcached(config_str.c_str(), config_str.length());
+  memcached_behavior_set(memcached_client, MEMCACHED_BEHAVIOR_NO_BLOCK, 1);
+  memcached_behavior_set(memcached_client, MEMCACHED_BEHAVIOR_TCP_NODELAY, 1);
+  memcached_behavior_set(
+      memcached_client, MEMCACHED_BEHAVIOR_BINARY_PROTOCOL, 1);
+  auto pool = memcached_pool_create(memcached_client, num_threads,
+                                    num_threads);
+
+  // Distinct req_id ranges so the runs do not see each other's counters.
+  int64_t base = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count() << 16;
+  printf("%-12s %10s %10s %12s %8s\n", "upload", "p50(us)", "p99(us)",
+         "composed", "failed");
+  auto seq = Run(pool, UploadSequential, num_threads, reviews_per_thread,
+                 base);
+  printf("%-12s %10.0f %10.0f %12ld %8ld\n", "sequential", seq.p50_us,
+         seq.p99_us, seq.completed, seq.failed);
+  auto pip = Run(pool, UploadPipelined, num_threads, reviews_per_thread,
+                 base + (int64_t(1) << 40));
+  printf("%-12s %10.0f %10.0f %12ld %8ld\n", "pipelined", pip.p50_us,
+         pip.p99_us, pip.completed, pip.failed);
+
+  memcached_pool_destroy(pool);
+  memcached_free(memcached_client);
+
+  int status = EXIT_SUCCESS;
+  for (auto &run : {std::make_pair("sequential", seq),
+                    std::make_pair("pipelined", pip)}) {
+    if (run.second.failed > 0 || run.second.not_composed_once > 0) {
+      fprintf(stderr, "%s: %ld uploads failed, %ld reviews not composed "
+              "exactly once\n", run.first, run.second.failed,
+              run.second.not_composed_once);
+      status = EXIT_FAILURE;
+    }
+  }
+  return status;
+}
@@ -0,0 +1,133 @@
+// Fan-out microbenchmark for Executor. Each simulated request submits a few
+// short sub-calls and waits for all of them, like the handlers do. The same
+// fan-out through std::async(std::launch::async, ...), which starts a thread
+// per sub-call, is measured alongside as the baseline.
+//
+// Usage: benchExecutor [max_threads] [requests_per_thread] [fan_out]
+
+#include "../src/Executor.h"
+#include "../src/logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <thread>
+#include <vector>
+
+using namespace media_service;
+
+// Stands in for a short blocking backend call.
+static void SubCall() {
+  std::this_thread::sleep_for(std::chrono::microseconds(50));
+}
+
+struct AsyncFanOut {
+  void Request(int fan_out) {
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < fan_out; i++) {
+      futures.emplace_back(std::async(std::launch::async, SubCall));
+    }
+    for (auto &future : futures) {
+      future.get();
+    }
+  }
+};
+
+struct ExecutorFanOut {
+  void Request(int fan_out) {
+    std::vector<TaskFuture<void>> futures;
+    for (int i = 0; i < fan_out; i++) {
+      futures.emplace_back(Executor::Global().Submit(SubCall));
+    }
+    for (auto &future : futures) {
+      future.get();
+    }
+  }
+};
+
+struct Result {
+  double reqs_per_sec;
+  double p50_us;
+  double p99_us;
+};
+
+template <class TFanOut>
+Result Run(TFanOut *fan_out_impl, int num_threads, int requests_per_thread,
+           int fan_out) {
+  std::vector<std::vector<uint32_t>> latencies(num_threads);
+  std::vector<std::thread> threads;
+  std::atomic<bool> start{false};
+
+  for (int t = 0; t < num_threads; t++) {
+    latencies[t].reserve(requests_per_thread);
+    threads.emplace_back([&, t]() {
+      while (!start.load()) {
+        std::this_thread::yield();
+      }
+      for (int i = 0; i < requests_per_thread; i++) {
+        auto begin = std::chrono::steady_clock::now();
+        fan_out_impl->Request(fan_out);
+        auto end = std::chrono::steady_clock::now();
+        latencies[t].push_back(
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                end - begin).count());
+      }
+    });
+  }
+
+  auto begin = std::chrono::steady_clock::now();
+  start.store(true);
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  std::vector<uint32_t> all;
+  for (auto &l : latencies) {
+    all.insert(all.end(), l.begin(), l.end());
+  }
+  std::sort(all.begin(), all.end());
+  double secs = std::chrono::duration<double>(end - begin).count();
+
+  Result result;
+  result.reqs_per_sec = all.size() / secs;
+  result.p50_us = all[all.size() / 2];
+  result.p99_us = all[all.size() * 99 / 100];
+  return result;
+}
+
+int main(int argc, char *argv[]) {
+  init_logger();
+  int max_threads = argc > 1 ? atoi(argv[1]) :
+      std::max(4 * std::thread::hardware_concurrency(), 4u);
+  int requests_per_thread = argc > 2 ? atoi(argv[2]) : 2000;
+  int fan_out = argc > 3 ? atoi(argv[3]) : 3;
+
+  printf("%-8s %-8s %14s %10s %10s\n",
+         "impl", "threads", "reqs/s", "p50(us)", "p99(us)");
+  for (int threads = 1; threads <= max_threads; threads *= 2) {
+    {
+      AsyncFanOut impl;
+      auto r = Run(&impl, threads, requests_per_thread, fan_out);
+      printf("%-8s %-8d %14.0f %10.0f %10.0f\n",
+             "async", threads, r.reqs_per_sec, r.p50_us, r.p99_us);
+    }
+    {
+      ExecutorFanOut impl;
+      auto r = Run(&impl, threads, requests_per_thread, fan_out);
+      printf("%-8s %-8d %14.0f %10.0f %10.0f\n",
+             "executor", threads, r.reqs_per_sec, r.p50_us, r.p99_us);
+    }
+  }
+
+  auto stats = Executor::Global().GetStats();
+  printf("executor: %d threads, %ld tasks, %ld stolen, %ld inline, "
+         "max queue %ld, mean wait %.1f us, max wait %ld us\n",
+         stats.num_threads, stats.submitted, stats.stolen, stats.ran_inline,
+         stats.max_queue_depth,
+         stats.completed ? double(stats.total_wait_us) / stats.completed : 0.0,
+         stats.max_wait_us);
+  return 0;
+}
@@ -0,0 +1,64 @@
+// Cost of a ProfiledMutex against a plain std::mutex, with N threads taking
+// the same lock around a short critical section, and what the profile saw:
+// how many acquisitions were contended and the p99 wait and hold.
+//
+// Usage: benchLockProfile [max_threads] [locks_per_thread]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/ProfiledMutex.h"
+
+using namespace media_service;
+
+template <class TMutex>
+static double NsPerLock(TMutex *mutex, int num_threads, int locks_per_thread) {
+  std::vector<std::thread> threads;
+  uint64_t shared = 0;
+  auto begin = std::chrono::steady_clock::now();
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&]() {
+      for (int i = 0; i < locks_per_thread; i++) {
+        std::lock_guard<TMutex> lock(*mutex);
+        shared += i;
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - begin).count() /
+      (static_cast<double>(num_threads) * locks_per_thread);
+}
+
+int main(int argc, char *argv[]) {
+  int max_threads = argc > 1 ? atoi(argv[1]) :
+      std::max(1u, std::thread::hardware_concurrency());
+  int locks_per_thread = argc > 2 ? atoi(argv[2]) : 1000000;
+
+  printf("%8s %14s %16s %12s %12s %12s\n", "threads", "mutex_ns/lock",
+         "profiled_ns/lock", "contended", "p99_wait_us", "p99_hold_us");
+  for (int n = 1; n <= max_threads; n *= 2) {
+    std::mutex mutex;
+    std::string name = "bench" + std::to_string(n);
+    ProfiledMutex profiled(name);
+    double mutex_ns = NsPerLock(&mutex, n, locks_per_thread);
+    double profiled_ns = NsPerLock(&profiled, n, locks_per_thread);
+    LockProfile profile = GetLockProfile(name);
+    auto wait = profile.wait->Read();
+    auto hold = profile.hold->Read();
+    printf("%8d %14.1f %16.1f %11.1f%% %12lu %12lu\n", n, mutex_ns,
+           profiled_ns,
+           100.0 * profile.contentions->Value() / std::max<uint64_t>(
+               wait.count, 1),
+           wait.Quantile(0.99), hold.Quantile(0.99));
+  }
+  return 0;
+}
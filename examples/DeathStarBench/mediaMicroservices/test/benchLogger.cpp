@@ -0,0 +1,78 @@
+// Cost of a LOG(debug) statement on the calling thread, with N threads
+// logging at once. "boost" is the Boost.Log console sink logger.h used
+// before, "async" is the current logger. Both write to stderr, so run with
+// stderr redirected, e.g. benchLogger 2>/dev/null. "async" drops lines
+// when a thread logs faster than the writer drains and reports how many on
+// stderr.
+//
+// Usage: benchLogger [max_threads] [lines_per_thread]
+
+#include <boost/log/trivial.hpp>
+#include <boost/log/utility/setup/common_attributes.hpp>
+#include <boost/log/utility/setup/console.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "../src/logger.h"
+
+#define BOOST_LOG_LINE(severity) \
+    BOOST_LOG_TRIVIAL(severity) << "(" \
+    << (strrchr(__FILE__, '/') ? strrchr(__FILE__, '/') + 1 : __FILE__) \
+    << ":" << __LINE__ << ":" << __FUNCTION__ << ") "
+
+static void InitBoostLog() {
+  boost::log::register_simple_formatter_factory
+      <boost::log::trivial::severity_level, char>("Severity");
+  boost::log::add_common_attributes();
+  boost::log::add_console_log(
+      std::cerr, boost::log::keywords::format =
+          "[%TimeStamp%] <%Severity%>: %Message%");
+  boost::log::core::get()->set_filter(
+      boost::log::trivial::severity >= boost::log::trivial::debug);
+}
+
+template <class F>
+static double NsPerLine(F log_line, int num_threads, int lines_per_thread) {
+  std::vector<std::thread> threads;
+  auto begin = std::chrono::steady_clock::now();
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < lines_per_thread; i++) {
+        log_line(t, i);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - begin).count() /
+      lines_per_thread;
+}
+
+int main(int argc, char *argv[]) {
+  int max_threads = argc > 1 ? atoi(argv[1]) :
+      std::max(1u, std::thread::hardware_concurrency());
+  int lines_per_thread = argc > 2 ? atoi(argv[2]) : 100000;
+
+  InitBoostLog();
+  media_service::init_logger();
+
+  printf("%-8s %8s %12s\n", "logger", "threads", "ns/line");
+  for (int n = 1; n <= max_threads; n *= 2) {
+    printf("%-8s %8d %12.0f\n", "boost", n, NsPerLine([](int t, int i) {
+      BOOST_LOG_LINE(debug) << "req_id " << i << " from thread " << t
+                       << " cache hit from Memcached";
+    }, n, lines_per_thread));
+    printf("%-8s %8d %12.0f\n", "async", n, NsPerLine([](int t, int i) {
+      LOG(debug) << "req_id " << i << " from thread " << t
+                 << " cache hit from Memcached";
+    }, n, lines_per_thread));
+  }
+  return 0;
+}
@@ -0,0 +1,83 @@
+// Cost of recording into an HdrHistogram with N threads recording into the
+// same one at once, and of the metrics a handler records per request: one
+// RequestProbe around three CallProbes. Also prints how far the histogram's
+// quantiles are from the exact ones of the recorded values.
+//
+// Usage: benchMetrics [max_threads] [records_per_thread]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "../src/probes.h"
+
+using namespace media_service;
+
+template <class F>
+static double NsPerOp(F op, int num_threads, int ops_per_thread) {
+  std::vector<std::thread> threads;
+  auto begin = std::chrono::steady_clock::now();
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < ops_per_thread; i++) {
+        op(t, i);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - begin).count() /
+      ops_per_thread;
+}
+
+int main(int argc, char *argv[]) {
+  int max_threads = argc > 1 ? atoi(argv[1]) :
+      std::max(1u, std::thread::hardware_concurrency());
+  int ops_per_thread = argc > 2 ? atoi(argv[2]) : 1000000;
+
+  // Log-uniform values from 1 us to about 3 s.
+  std::mt19937_64 generator(1);
+  std::uniform_real_distribution<double> exponent(0, 15);
+  std::vector<uint64_t> values(ops_per_thread);
+  for (auto &value : values) {
+    value = static_cast<uint64_t>(std::exp(exponent(generator)));
+  }
+
+  HdrHistogram accuracy;
+  for (auto value : values) {
+    accuracy.Record(value);
+  }
+  auto sorted = values;
+  std::sort(sorted.begin(), sorted.end());
+  auto snapshot = accuracy.Read();
+  printf("%-10s %12s %12s %8s\n", "quantile", "exact_us", "hdr_us", "error");
+  for (double q : METRICS_QUANTILES) {
+    uint64_t exact = sorted[static_cast<size_t>(q * sorted.size()) - 1];
+    uint64_t hdr = snapshot.Quantile(q);
+    printf("%-10g %12lu %12lu %7.2f%%\n", q, exact, hdr,
+           100.0 * (static_cast<double>(hdr) / exact - 1));
+  }
+
+  printf("\n%-10s %8s %12s\n", "op", "threads", "ns/op");
+  for (int n = 1; n <= max_threads; n *= 2) {
+    HdrHistogram histogram;
+    printf("%-10s %8d %12.1f\n", "record", n, NsPerOp([&](int, int i) {
+      histogram.Record(values[i]);
+    }, n, ops_per_thread));
+    printf("%-10s %8d %12.1f\n", "request", n, NsPerOp([](int, int i) {
+      RequestProbe probe(i, "ReadPlot");
+      for (int call = 0; call < 3; call++) {
+        CallProbe call_probe(ProbeBackend::memcached, i, "MmcGetPlot");
+        call_probe.End(i & 1);
+      }
+    }, n, ops_per_thread / 10));
+  }
+  return 0;
+}
@@ -0,0 +1,100 @@
+// Password hashing throughput of UserService: the picosha2 hex string
+// Login used to build and compare, against PasswordHasher::Verify() with
+// each backend, with N threads verifying at once. Every backend is first
+// checked against picosha2 for passwords of 0 to 100 bytes.
+//
+// Usage: benchPasswordHash [max_threads] [verifications_per_thread]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/PasswordHash.h"
+
+using namespace media_service;
+
+template <class F>
+static double NsPerOp(F op, int num_threads, int ops_per_thread) {
+  std::vector<std::thread> threads;
+  auto begin = std::chrono::steady_clock::now();
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < ops_per_thread; i++) {
+        op(t, i);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - begin).count() /
+      (static_cast<double>(num_threads) * ops_per_thread);
+}
+
+int main(int argc, char *argv[]) {
+  int max_threads = argc > 1 ? atoi(argv[1]) :
+      std::max(1u, std::thread::hardware_concurrency());
+  int ops_per_thread = argc > 2 ? atoi(argv[2]) : 200000;
+
+  std::vector<std::string> backends = {"openssl", "picosha2"};
+  if (PasswordHasher::Global().SetBackend("avx2")) {
+    backends.push_back("avx2");
+  }
+  PasswordHasher::Global().SetBackend("auto");
+  printf("auto backend: %s\n", PasswordHasher::Global().BackendName());
+
+  std::string salt = "0123456789abcdefghijklmnopqrstuv";
+  for (auto &backend : backends) {
+    PasswordHasher::Global().SetBackend(backend);
+    for (size_t len = 0; len <= 100; len++) {
+      std::string password(len, 'p');
+      std::string expected = picosha2::hash256_hex_string(password + salt);
+      std::string hex = PasswordHasher::Global().HashHex(password, salt);
+      bool ok = PasswordHasher::Global().Verify(
+          password, salt.data(), salt.size(), expected.data(),
+          expected.size());
+      if (hex != expected || !ok) {
+        printf("%s: wrong digest for a %zu byte password\n", backend.c_str(),
+               len);
+        return 1;
+      }
+    }
+  }
+
+  // Passwords of the register_users.sh dataset.
+  std::vector<std::string> passwords;
+  std::vector<std::string> stored;
+  for (int i = 0; i < 1000; i++) {
+    passwords.push_back("password_" + std::to_string(i));
+    stored.push_back(picosha2::hash256_hex_string(passwords.back() + salt));
+  }
+
+  printf("\n%-10s %8s %12s\n", "backend", "threads", "ns/verify");
+  for (int n = 1; n <= max_threads; n *= 2) {
+    printf("%-10s %8d %12.1f\n", "hex", n, NsPerOp([&](int, int i) {
+      size_t user = i % passwords.size();
+      bool auth = picosha2::hash256_hex_string(
+          passwords[user] + std::string(salt.c_str())) == stored[user];
+      if (!auth) {
+        abort();
+      }
+    }, n, ops_per_thread));
+    for (auto &backend : backends) {
+      PasswordHasher::Global().SetBackend(backend);
+      printf("%-10s %8d %12.1f\n", backend.c_str(), n, NsPerOp([&](int, int i) {
+        size_t user = i % passwords.size();
+        if (!PasswordHasher::Global().Verify(
+                passwords[user], salt.data(), salt.size(),
+                stored[user].data(), stored[user].size())) {
+          abort();
+        }
+      }, n, ops_per_thread));
+    }
+  }
+  return 0;
+}
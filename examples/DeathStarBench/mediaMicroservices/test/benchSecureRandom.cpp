@@ -0,0 +1,125 @@
+// Random salt generation of UserService: the random_device + mt19937 pair
+// GenRandomString() used to construct on every call, against the
+// per-thread ChaCha20 generator of SecureRandom.h, with N threads drawing
+// at once. Also measures raw bytes and 64-bit IDs. ChaCha20 is first
+// checked against the RFC 8439 test vector.
+//
+// Usage: benchSecureRandom [max_threads] [calls_per_thread]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/SecureRandom.h"
+
+using namespace media_service;
+
+template <class F>
+static double NsPerOp(F op, int num_threads, int ops_per_thread) {
+  std::vector<std::thread> threads;
+  auto begin = std::chrono::steady_clock::now();
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < ops_per_thread; i++) {
+        op(t, i);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - begin).count() /
+      (static_cast<double>(num_threads) * ops_per_thread);
+}
+
+static std::string OldGenRandomString(const int len) {
+  static const std::string alphanum =
+      "0123456789"
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+      "abcdefghijklmnopqrstuvwxyz";
+  std::random_device rd;
+  std::mt19937 gen(rd());
+  std::uniform_int_distribution<int> dist(
+      0, static_cast<int>(alphanum.length() - 1));
+  std::string s;
+  for (int i = 0; i < len; ++i) {
+    s += alphanum[dist(gen)];
+  }
+  return s;
+}
+
+int main(int argc, char *argv[]) {
+  int max_threads = argc > 1 ? atoi(argv[1]) :
+      std::max(1u, std::thread::hardware_concurrency());
+  int ops_per_thread = argc > 2 ? atoi(argv[2]) : 200000;
+
+  // RFC 8439 A.1, test vector 1: zero key, nonce and counter.
+  static const uint8_t expected[16] = {
+      0x76, 0xb8, 0xe0, 0xad, 0xa0, 0xf1, 0x3d, 0x90,
+      0x40, 0x5d, 0x6a, 0xe5, 0x53, 0x86, 0xbd, 0x28};
+  uint32_t key[8] = {0};
+  uint8_t block[SECURE_RANDOM_BLOCK_SIZE];
+  _ChaCha20Block(key, 0, block);
+  if (memcmp(block, expected, sizeof(expected)) != 0) {
+    printf("ChaCha20 does not match the RFC 8439 test vector\n");
+    return 1;
+  }
+
+  // Every character should come up about equally often.
+  std::vector<long> counts(256, 0);
+  std::string sample = SecureRandom::Local().Alphanumeric(62 * 100000);
+  for (char c : sample) {
+    counts[static_cast<uint8_t>(c)]++;
+  }
+  long distinct = 0, min_count = sample.size(), max_count = 0;
+  for (long count : counts) {
+    if (count > 0) {
+      distinct++;
+      min_count = std::min(min_count, count);
+      max_count = std::max(max_count, count);
+    }
+  }
+  printf("alphanumeric: %ld distinct characters, %ld to %ld of each\n",
+         distinct, min_count, max_count);
+  if (distinct != 62) {
+    return 1;
+  }
+
+  printf("\n%-22s %8s %12s\n", "generator", "threads", "ns/call");
+  for (int n = 1; n <= max_threads; n *= 2) {
+    printf("%-22s %8d %12.1f\n", "mt19937 salt(32)", n,
+           NsPerOp([](int, int) {
+      std::string salt = OldGenRandomString(32);
+      if (salt.size() != 32) {
+        abort();
+      }
+    }, n, ops_per_thread / 10));
+    printf("%-22s %8d %12.1f\n", "SecureRandom salt(32)", n,
+           NsPerOp([](int, int) {
+      std::string salt = SecureRandom::Local().Alphanumeric(32);
+      if (salt.size() != 32) {
+        abort();
+      }
+    }, n, ops_per_thread));
+    printf("%-22s %8d %12.1f\n", "SecureRandom uint64", n,
+           NsPerOp([](int, int) {
+      if (SecureRandom::Local().Uint64() == 0) {
+        abort();
+      }
+    }, n, ops_per_thread));
+    double ns = NsPerOp([](int, int) {
+      uint8_t buf[4096];
+      SecureRandom::Local().Bytes(buf, sizeof(buf));
+    }, n, ops_per_thread / 10);
+    printf("%-22s %8d %12.1f  (%.0f MB/s per thread)\n",
+           "SecureRandom bytes(4K)", n, ns, 4096 * 1e3 / ns);
+  }
+  return 0;
+}
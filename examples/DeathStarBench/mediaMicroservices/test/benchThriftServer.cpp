@@ -0,0 +1,167 @@
+// Compares the Thrift server engines selectable in service-config.json.
+// Each run starts a BaseService server on localhost with one engine, opens
+// idle_conns connections that are never used (like the idle connections
+// peers keep pooled), and has num_clients threads call Ping() for
+// duration_s seconds, each on its own connection. Reports throughput,
+// p50/p99 latency and the number of threads in the process.
+//
+// Usage: benchThriftServer [num_clients] [idle_conns] [duration_s]
+
+#include "../gen-cpp/BaseService.h"
+#include "../src/utils.h"
+#include "../src/utils_thrift.h"
+
+#include <thrift/transport/TSocket.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+using namespace media_service;
+using apache::thrift::protocol::TBinaryProtocol;
+using apache::thrift::transport::TFramedTransport;
+using apache::thrift::transport::TSocket;
+using apache::thrift::transport::TTransport;
+
+class BenchHandler : public BaseServiceIf {
+ public:
+  void Ping() override {}
+};
+
+struct Connection {
+  std::shared_ptr<TTransport> transport;
+  std::unique_ptr<BaseServiceClient> client;
+};
+
+static Connection Connect(int port) {
+  Connection conn;
+  auto socket = std::make_shared<TSocket>("127.0.0.1", port);
+  conn.transport = std::make_shared<TFramedTransport>(socket);
+  conn.client.reset(new BaseServiceClient(
+      std::make_shared<TBinaryProtocol>(conn.transport)));
+  for (int i = 0; ; i++) {
+    try {
+      conn.transport->open();
+      break;
+    } catch (...) {
+      if (i == 50) {
+        throw;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+  }
+  return conn;
+}
+
+static int NumThreads() {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.compare(0, 8, "Threads:") == 0) {
+      return atoi(line.c_str() + 8);
+    }
+  }
+  return -1;
+}
+
+struct Result {
+  double ops_per_sec;
+  double p50_us;
+  double p99_us;
+  int threads;
+};
+
+Result Run(const std::string &type, int port, int num_clients,
+           int idle_conns, int duration_s) {
+  json config_json;
+  config_json["bench-service"]["port"] = port;
+  config_json["bench-service"]["server"]["type"] = type;
+  if (type == "threadpool") {
+    // Each connection pins a pool worker, so the pool must fit all of them.
+    config_json["bench-service"]["server"]["worker_threads"] =
+        num_clients + idle_conns;
+  }
+  auto server = init_thrift_server(
+      config_json, "bench-service",
+      std::make_shared<BaseServiceProcessor>(
+          std::make_shared<BenchHandler>()));
+  std::thread server_thread([&]() { server->serve(); });
+
+  std::vector<Connection> idle;
+  for (int i = 0; i < idle_conns; i++) {
+    idle.emplace_back(Connect(port));
+  }
+
+  std::vector<std::vector<uint32_t>> latencies(num_clients);
+  std::vector<std::thread> clients;
+  std::atomic<bool> start{false};
+  std::atomic<bool> stop{false};
+  for (int t = 0; t < num_clients; t++) {
+    clients.emplace_back([&, t]() {
+      auto conn = Connect(port);
+      while (!start.load()) {
+        std::this_thread::yield();
+      }
+      while (!stop.load()) {
+        auto begin = std::chrono::steady_clock::now();
+        conn.client->Ping();
+        auto end = std::chrono::steady_clock::now();
+        latencies[t].push_back(
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                end - begin).count());
+      }
+      conn.transport->close();
+    });
+  }
+
+  auto begin = std::chrono::steady_clock::now();
+  start.store(true);
+  std::this_thread::sleep_for(std::chrono::seconds(duration_s));
+  int threads = NumThreads();
+  stop.store(true);
+  for (auto &client : clients) {
+    client.join();
+  }
+  auto end = std::chrono::steady_clock::now();
+  for (auto &conn : idle) {
+    conn.transport->close();
+  }
+  server->stop();
+  server_thread.join();
+
+  std::vector<uint32_t> all;
+  for (auto &l : latencies) {
+    all.insert(all.end(), l.begin(), l.end());
+  }
+  std::sort(all.begin(), all.end());
+  double secs = std::chrono::duration<double>(end - begin).count();
+
+  Result result;
+  result.ops_per_sec = all.size() / secs;
+  result.p50_us = all.empty() ? 0 : all[all.size() / 2];
+  result.p99_us = all.empty() ? 0 : all[all.size() * 99 / 100];
+  result.threads = threads;
+  return result;
+}
+
+int main(int argc, char *argv[]) {
+  init_logger();
+  int num_clients = argc > 1 ? atoi(argv[1]) : 32;
+  int idle_conns = argc > 2 ? atoi(argv[2]) : 512;
+  int duration_s = argc > 3 ? atoi(argv[3]) : 5;
+
+  printf("%-12s %14s %10s %10s %10s\n",
+         "server", "ops/s", "p50(us)", "p99(us)", "threads");
+  int port = 19090;
+  for (auto type : {"threaded", "threadpool", "nonblocking"}) {
+    auto r = Run(type, port++, num_clients, idle_conns, duration_s);
+    printf("%-12s %14.0f %10.0f %10.0f %10d\n",
+           type, r.ops_per_sec, r.p50_us, r.p99_us, r.threads);
+  }
+  return 0;
+}
@@ -0,0 +1,125 @@
+// Tracing overhead of one RPC: the server span, CHILDREN child spans for
+// the memcached/MongoDB calls, and the carrier handed to the next tier.
+// "legacy" is what every handler did before TraceSpan: Extract, StartSpan
+// and Inject into a new carrier, and a child span per call, whatever the
+// sampling decision. "facade" is TraceSpan. "tail" is TraceSpan with tail
+// sampling: an unsampled upstream only buffers the spans, a sampled one
+// keeps the trace and reports them. Each runs once with a sampled and once
+// with an unsampled upstream trace. benchTracingDisabled is this
+// program built with MEDIA_MICROSERVICES_NO_TRACING and only has the
+// "disabled" row.
+//
+// Sampled spans go to the UDP reporter; no Jaeger agent needs to listen.
+//
+// Usage: benchTracing [rpcs] [children]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+
+#include "../src/tracing.h"
+
+using namespace media_service;
+
+static const char *SAMPLED_CONTEXT = "4bf92f3577b34da6:a3ce929d0e0e4736:0:1";
+static const char *UNSAMPLED_CONTEXT = "4bf92f3577b34da6:a3ce929d0e0e4736:0:0";
+
+static volatile size_t sink;
+
+#ifndef MEDIA_MICROSERVICES_NO_TRACING
+static void LegacyRpc(const std::map<std::string, std::string> &carrier,
+                      int children) {
+  TextMapReader reader(carrier);
+  std::map<std::string, std::string> writer_text_map;
+  TextMapWriter writer(writer_text_map);
+  auto parent_span = opentracing::Tracer::Global()->Extract(reader);
+  auto span = opentracing::Tracer::Global()->StartSpan(
+      "Rpc", {opentracing::ChildOf(parent_span->get())});
+  opentracing::Tracer::Global()->Inject(span->context(), writer);
+  for (int i = 0; i < children; i++) {
+    auto child_span = opentracing::Tracer::Global()->StartSpan(
+        "MmcGet", {opentracing::ChildOf(&span->context())});
+    child_span->Finish();
+  }
+  sink = writer_text_map.size();
+  span->Finish();
+}
+#endif
+
+static void FacadeRpc(const std::map<std::string, std::string> &carrier,
+                      int children) {
+  auto span = TraceSpan::Start("Rpc", carrier);
+  auto &writer_text_map = span.Carrier();
+  for (int i = 0; i < children; i++) {
+    auto child_span = span.Child("MmcGet");
+    child_span.Finish();
+  }
+  sink = writer_text_map.size();
+  span.Finish();
+}
+
+template <class F>
+static double NsPerRpc(F rpc, const char *context, int rpcs, int children) {
+  std::map<std::string, std::string> carrier;
+  carrier[TraceContextHeader()] = context;
+  for (int i = 0; i < rpcs / 10; i++) {
+    rpc(carrier, children);
+  }
+  auto begin = std::chrono::steady_clock::now();
+  for (int i = 0; i < rpcs; i++) {
+    rpc(carrier, children);
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - begin).count() / rpcs;
+}
+
+int main(int argc, char *argv[]) {
+  int rpcs = argc > 1 ? atoi(argv[1]) : 100000;
+  int children = argc > 2 ? atoi(argv[2]) : 3;
+
+#ifndef MEDIA_MICROSERVICES_NO_TRACING
+  auto config = jaegertracing::Config::parse(YAML::Load(
+      "disabled: false\n"
+      "reporter:\n"
+      "  logSpans: false\n"
+      "sampler:\n"
+      "  type: const\n"
+      "  param: 1\n"));
+  auto tracer = jaegertracing::Tracer::make(
+      "bench-tracing", config, jaegertracing::logging::nullLogger());
+  opentracing::Tracer::InitGlobal(
+      std::static_pointer_cast<opentracing::Tracer>(tracer));
+  GlobalTracer() = opentracing::Tracer::Global();
+#endif
+
+  printf("%-10s %-10s %12s\n", "mode", "upstream", "ns/rpc");
+#ifndef MEDIA_MICROSERVICES_NO_TRACING
+  printf("%-10s %-10s %12.0f\n", "legacy", "sampled",
+         NsPerRpc(LegacyRpc, SAMPLED_CONTEXT, rpcs, children));
+  printf("%-10s %-10s %12.0f\n", "legacy", "unsampled",
+         NsPerRpc(LegacyRpc, UNSAMPLED_CONTEXT, rpcs, children));
+  printf("%-10s %-10s %12.0f\n", "facade", "sampled",
+         NsPerRpc(FacadeRpc, SAMPLED_CONTEXT, rpcs, children));
+  printf("%-10s %-10s %12.0f\n", "facade", "unsampled",
+         NsPerRpc(FacadeRpc, UNSAMPLED_CONTEXT, rpcs, children));
+  GetTailSampling().ring.reset(
+      new SpanRing(TAIL_SAMPLING_DEFAULT_BUFFER_SPANS));
+  GetTailSampling().latency_threshold_us =
+      1000 * TAIL_SAMPLING_DEFAULT_LATENCY_THRESHOLD_MS;
+  printf("%-10s %-10s %12.0f\n", "tail", "sampled",
+         NsPerRpc(FacadeRpc, SAMPLED_CONTEXT, rpcs, children));
+  printf("%-10s %-10s %12.0f\n", "tail", "unsampled",
+         NsPerRpc(FacadeRpc, UNSAMPLED_CONTEXT, rpcs, children));
+  GetTailSampling().ring.reset();
+#else
+  printf("%-10s %-10s %12.0f\n", "disabled", "any",
+         NsPerRpc(FacadeRpc, SAMPLED_CONTEXT, rpcs, children));
+#endif
+
+#ifndef MEDIA_MICROSERVICES_NO_TRACING
+  tracer->Close();
+#endif
+  return 0;
+}
@@ -0,0 +1,159 @@
+// Throughput of unique ID generation with N threads issuing IDs as fast as
+// they can. "mutex" is the scheme UniqueIdHandler and UserHandler used
+// before: a global lock around the counter, then stringstream hex
+// formatting and stoul. "atomic" is UniqueIdGenerator::NextId(). "leased"
+// takes blocks of LEASE_SIZE IDs with NextIds() and hands them out locally,
+// as UniqueIdLeaseCache does with LeaseUniqueIds(). Every run also checks
+// that no ID was handed out twice.
+//
+// Usage: benchUniqueId [max_threads] [ids_per_thread]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/UniqueIdGenerator.h"
+
+#define LEASE_SIZE 1024
+
+using media_service::UniqueIdGenerator;
+
+class MutexIdGenerator {
+ public:
+  explicit MutexIdGenerator(const std::string &machine_id)
+      : _machine_id(machine_id) {}
+
+  int64_t NextId() {
+    _thread_lock.lock();
+    int64_t timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count() -
+        CUSTOM_EPOCH;
+    int counter = GetCounter(timestamp);
+    _thread_lock.unlock();
+
+    std::stringstream sstream;
+    sstream << std::hex << timestamp;
+    std::string timestamp_hex(sstream.str());
+    if (timestamp_hex.size() > 10) {
+      timestamp_hex.erase(0, timestamp_hex.size() - 10);
+    } else if (timestamp_hex.size() < 10) {
+      timestamp_hex =
+          std::string(10 - timestamp_hex.size(), '0') + timestamp_hex;
+    }
+    sstream.clear();
+    sstream.str(std::string());
+    sstream << std::hex << counter;
+    std::string counter_hex(sstream.str());
+    if (counter_hex.size() > 3) {
+      counter_hex.erase(0, counter_hex.size() - 3);
+    } else if (counter_hex.size() < 3) {
+      counter_hex = std::string(3 - counter_hex.size(), '0') + counter_hex;
+    }
+    std::string id_str = _machine_id + timestamp_hex + counter_hex;
+    return stoul(id_str, nullptr, 16) & 0x7FFFFFFFFFFFFFFF;
+  }
+
+ private:
+  int GetCounter(int64_t timestamp) {
+    if (_current_timestamp == timestamp) {
+      return _counter++;
+    }
+    _current_timestamp = timestamp;
+    _counter = 0;
+    return _counter++;
+  }
+
+  std::string _machine_id;
+  std::mutex _thread_lock;
+  int64_t _current_timestamp = -1;
+  int _counter = 0;
+};
+
+class LeasedIdGenerator {
+ public:
+  explicit LeasedIdGenerator(UniqueIdGenerator *generator)
+      : _generator(generator) {}
+
+  int64_t NextId() {
+    thread_local int64_t next = 0;
+    thread_local int64_t end = 0;
+    if (next == end) {
+      next = _generator->NextIds(LEASE_SIZE);
+      end = next + LEASE_SIZE;
+    }
+    return next++;
+  }
+
+ private:
+  UniqueIdGenerator *_generator;
+};
+
+struct Result {
+  double ids_per_sec;
+  size_t duplicates;
+};
+
+template <class TGenerator>
+Result Run(TGenerator *generator, int num_threads, int ids_per_thread) {
+  std::vector<std::vector<int64_t>> ids(num_threads);
+  for (auto &v : ids) {
+    v.reserve(ids_per_thread);
+  }
+  std::vector<std::thread> threads;
+  auto begin = std::chrono::steady_clock::now();
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < ids_per_thread; i++) {
+        ids[t].push_back(generator->NextId());
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  std::vector<int64_t> all;
+  for (auto &v : ids) {
+    all.insert(all.end(), v.begin(), v.end());
+  }
+  std::sort(all.begin(), all.end());
+  size_t unique = std::unique(all.begin(), all.end()) - all.begin();
+
+  Result result;
+  double secs = std::chrono::duration<double>(end - begin).count();
+  result.ids_per_sec = all.size() / secs;
+  result.duplicates = all.size() - unique;
+  return result;
+}
+
+int main(int argc, char *argv[]) {
+  int max_threads = argc > 1 ? atoi(argv[1]) :
+      std::max(1u, std::thread::hardware_concurrency());
+  int ids_per_thread = argc > 2 ? atoi(argv[2]) : 200000;
+
+  printf("%-8s %8s %14s %11s\n", "scheme", "threads", "ids/s",
+         "duplicates");
+  for (int n = 1; n <= max_threads; n *= 2) {
+    MutexIdGenerator mutex_generator("abc");
+    auto m = Run(&mutex_generator, n, ids_per_thread);
+    printf("%-8s %8d %14.0f %11zu\n", "mutex", n, m.ids_per_sec,
+           m.duplicates);
+    UniqueIdGenerator atomic_generator(0xabc);
+    auto a = Run(&atomic_generator, n, ids_per_thread);
+    printf("%-8s %8d %14.0f %11zu\n", "atomic", n, a.ids_per_sec,
+           a.duplicates);
+    UniqueIdGenerator lease_generator(0xabc);
+    LeasedIdGenerator leased_generator(&lease_generator);
+    auto l = Run(&leased_generator, n, ids_per_thread);
+    printf("%-8s %8d %14.0f %11zu\n", "leased", n, l.ids_per_sec,
+           l.duplicates);
+  }
+  return 0;
+}